@@ -0,0 +1,289 @@
+"""
+Shared HTTP client for talking to agent APIs.
+
+Routes and services used to open a fresh httpx.AsyncClient per call, paying
+TCP setup (and TLS for remote servers) every time. This module keeps one
+long-lived connection pool per agent origin, coalesces identical concurrent
+GETs into a single request, optionally caches responses that rarely change
+(adapter types, manifests) for a short TTL, and records per-agent latency.
+"""
+
+import asyncio
+import importlib.util
+import logging
+import time
+from collections import OrderedDict
+from dataclasses import dataclass
+from typing import Any, Dict, Optional, Set, Tuple
+from urllib.parse import urlsplit
+
+import httpx
+
+from ciris_manager.utils.coalesce import Coalescer, TTLCache
+
+logger = logging.getLogger(__name__)
+
+DEFAULT_TIMEOUT = 30.0
+
+# Agents with an open pool; the least recently used pool is closed beyond this
+MAX_POOLS = 512
+
+# Cached responses kept across all agents and credentials
+MAX_CACHED_RESPONSES = 1024
+
+# Keep-alive limits for each agent's pool
+POOL_LIMITS = httpx.Limits(max_connections=10, max_keepalive_connections=4, keepalive_expiry=60.0)
+
+# HTTP/2 needs the optional h2 package; agents without TLS keep using HTTP/1.1
+HTTP2_AVAILABLE = importlib.util.find_spec("h2") is not None
+
+# Weight of the newest sample in the moving latency average
+LATENCY_EWMA_ALPHA = 0.2
+
+RequestKey = Tuple[str, Tuple[Tuple[str, str], ...], Tuple[Tuple[str, str], ...]]
+
+
+@dataclass
+class AgentLatency:
+    """Request latency for one agent origin."""
+
+    requests: int = 0
+    errors: int = 0
+    last_ms: float = 0.0
+    avg_ms: float = 0.0
+    max_ms: float = 0.0
+
+    def record(self, elapsed_ms: float, failed: bool) -> None:
+        """Add one request sample."""
+        self.requests += 1
+        if failed:
+            self.errors += 1
+        self.last_ms = elapsed_ms
+        self.max_ms = max(self.max_ms, elapsed_ms)
+        if self.requests == 1:
+            self.avg_ms = elapsed_ms
+        else:
+            self.avg_ms += LATENCY_EWMA_ALPHA * (elapsed_ms - self.avg_ms)
+
+    def to_dict(self) -> Dict[str, Any]:
+        """Serialize for API responses."""
+        return {
+            "requests": self.requests,
+            "errors": self.errors,
+            "last_ms": round(self.last_ms, 1),
+            "avg_ms": round(self.avg_ms, 1),
+            "max_ms": round(self.max_ms, 1),
+        }
+
+
+def _origin(url: str) -> str:
+    parts = urlsplit(url)
+    return f"{parts.scheme}://{parts.netloc}"
+
+
+def _request_key(
+    url: str, headers: Optional[Dict[str, str]], params: Optional[Dict[str, Any]]
+) -> RequestKey:
+    return (
+        url,
+        tuple(sorted((headers or {}).items())),
+        tuple(sorted((k, str(v)) for k, v in (params or {}).items())),
+    )
+
+
+class AgentHTTPClient:
+    """
+    Pooled client for agent APIs.
+
+    Can be used directly or as `async with get_agent_http_client() as client:`;
+    leaving the block does not close the shared pools.
+    """
+
+    def __init__(self, timeout: float = DEFAULT_TIMEOUT, max_pools: int = MAX_POOLS):
+        """
+        Initialize agent HTTP client.
+
+        Args:
+            timeout: Default request timeout in seconds
+            max_pools: Maximum number of agent origins with an open pool
+        """
+        self.timeout = timeout
+        self.max_pools = max_pools
+        self._pools: "OrderedDict[str, httpx.AsyncClient]" = OrderedDict()
+        # Requests running on each pool; an evicted pool is closed once it has none
+        self._in_use: Dict[httpx.AsyncClient, int] = {}
+        self._retired: Set[httpx.AsyncClient] = set()
+        self._inflight: Coalescer[RequestKey, httpx.Response] = Coalescer()
+        self._cache: TTLCache[RequestKey, httpx.Response] = TTLCache(MAX_CACHED_RESPONSES)
+        self._latency: Dict[str, AgentLatency] = {}
+
+    async def __aenter__(self) -> "AgentHTTPClient":
+        return self
+
+    async def __aexit__(self, *exc_info: Any) -> None:
+        return None
+
+    def _pool(self, origin: str) -> httpx.AsyncClient:
+        client = self._pools.get(origin)
+        if client is not None and getattr(client, "is_closed", False) is not True:
+            self._pools.move_to_end(origin)
+            return client
+
+        client = httpx.AsyncClient(
+            timeout=self.timeout, limits=POOL_LIMITS, http2=HTTP2_AVAILABLE
+        )
+        self._pools[origin] = client
+        while len(self._pools) > self.max_pools:
+            _, evicted = self._pools.popitem(last=False)
+            if self._in_use.get(evicted):
+                self._retired.add(evicted)
+            else:
+                self._close_later(evicted)
+        return client
+
+    @staticmethod
+    def _close_later(client: httpx.AsyncClient) -> None:
+        task = asyncio.get_running_loop().create_task(client.aclose())
+        task.add_done_callback(lambda t: t.cancelled() or t.exception())
+
+    async def _send(self, method: str, url: str, **kwargs: Any) -> httpx.Response:
+        origin = _origin(url)
+        client = self._pool(origin)
+        kwargs = {k: v for k, v in kwargs.items() if v is not None}
+
+        self._in_use[client] = self._in_use.get(client, 0) + 1
+        start = time.perf_counter()
+        failed = True
+        try:
+            response: httpx.Response = await getattr(client, method)(url, **kwargs)
+            failed = response.status_code >= 500
+            return response
+        finally:
+            elapsed_ms = (time.perf_counter() - start) * 1000
+            self._latency.setdefault(origin, AgentLatency()).record(elapsed_ms, failed)
+            self._in_use[client] -= 1
+            if not self._in_use[client]:
+                del self._in_use[client]
+                if client in self._retired:
+                    self._retired.discard(client)
+                    self._close_later(client)
+
+    async def get(
+        self,
+        url: str,
+        headers: Optional[Dict[str, str]] = None,
+        params: Optional[Dict[str, Any]] = None,
+        timeout: Optional[float] = None,
+        cache_ttl: float = 0.0,
+    ) -> httpx.Response:
+        """
+        GET from an agent, sharing the response with identical concurrent GETs.
+
+        Args:
+            url: Full agent URL
+            headers: Request headers (part of the coalescing/cache key)
+            params: Query parameters
+            timeout: Override the default timeout
+            cache_ttl: Seconds to reuse a 200 response; 0 disables caching
+
+        Returns:
+            The agent's response
+        """
+        key = _request_key(url, headers, params)
+        if cache_ttl > 0:
+            cached = self._cache.get(key)
+            if cached is not None:
+                return cached
+
+        def remember(response: httpx.Response) -> None:
+            if cache_ttl > 0 and response.status_code == 200:
+                self._cache.put(key, response, cache_ttl)
+
+        return await self._inflight.run(
+            key,
+            lambda: self._send("get", url, headers=headers, params=params, timeout=timeout),
+            on_result=remember,
+        )
+
+    async def post(
+        self,
+        url: str,
+        headers: Optional[Dict[str, str]] = None,
+        json: Any = None,
+        timeout: Optional[float] = None,
+    ) -> httpx.Response:
+        """POST to an agent over its pooled connection."""
+        return await self._send("post", url, headers=headers, json=json, timeout=timeout)
+
+    async def put(
+        self,
+        url: str,
+        headers: Optional[Dict[str, str]] = None,
+        json: Any = None,
+        timeout: Optional[float] = None,
+    ) -> httpx.Response:
+        """PUT to an agent over its pooled connection."""
+        return await self._send("put", url, headers=headers, json=json, timeout=timeout)
+
+    async def delete(
+        self,
+        url: str,
+        headers: Optional[Dict[str, str]] = None,
+        timeout: Optional[float] = None,
+    ) -> httpx.Response:
+        """DELETE on an agent over its pooled connection."""
+        return await self._send("delete", url, headers=headers, timeout=timeout)
+
+    def invalidate(self, base_url: Optional[str] = None) -> None:
+        """
+        Drop cached responses.
+
+        Args:
+            base_url: Only drop responses from this agent (all agents if None)
+        """
+        if base_url is None:
+            self._cache.clear()
+            return
+        origin = _origin(base_url)
+        self._cache.discard(lambda key: _origin(key[0]) == origin)
+
+    def latency_stats(self) -> Dict[str, Dict[str, Any]]:
+        """Per-agent request latency, keyed by agent origin (scheme://host:port)."""
+        return {origin: stats.to_dict() for origin, stats in self._latency.items()}
+
+    async def close(self) -> None:
+        """Close all pooled connections."""
+        pools = list(self._pools.values()) + list(self._retired)
+        self._pools.clear()
+        self._retired.clear()
+        self._cache.clear()
+        for client in pools:
+            try:
+                await client.aclose()
+            except Exception as e:
+                logger.debug(f"Error closing agent connection pool: {e}")
+
+
+_agent_http_client: Optional[AgentHTTPClient] = None
+
+
+def get_agent_http_client() -> AgentHTTPClient:
+    """Get the shared agent HTTP client."""
+    global _agent_http_client
+    if _agent_http_client is None:
+        _agent_http_client = AgentHTTPClient()
+    return _agent_http_client
+
+
+async def close_agent_http_client() -> None:
+    """Close the shared agent HTTP client's pools."""
+    global _agent_http_client
+    if _agent_http_client is not None:
+        await _agent_http_client.close()
+        _agent_http_client = None
+
+
+def reset_agent_http_client() -> None:
+    """Forget the shared client without closing it (for tests)."""
+    global _agent_http_client
+    _agent_http_client = None
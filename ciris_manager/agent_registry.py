@@ -8,7 +8,7 @@ import json
 import logging
 from datetime import datetime, timezone
 from pathlib import Path
-from typing import Dict, List, Optional, Any
+from typing import Dict, List, Optional, Any, Tuple
 from threading import Lock
 
 logger = logging.getLogger(__name__)
@@ -132,12 +132,14 @@ class AgentRegistry:
     Key format: "agent_id-occurrence_id-server_id" (e.g., "scout-scout_lb_1-scout")
     """
 
-    def __init__(self, metadata_path: Path):
+    def __init__(self, metadata_path: Path, entries: Optional[Dict[str, Dict[str, Any]]] = None):
         """
         Initialize agent registry.
 
         Args:
             metadata_path: Path to metadata.json file
+            entries: Agents by composite key from export_entries() of a validated
+                startup snapshot; skips parsing metadata.json
         """
         self.metadata_path = metadata_path
         # Key format: "agent_id-occurrence_id-server_id" for composite key support
@@ -147,8 +149,15 @@ class AgentRegistry:
         # Ensure directory exists
         self.metadata_path.parent.mkdir(parents=True, exist_ok=True)
 
-        # Load existing metadata
-        self._load_metadata()
+        if entries is not None:
+            self.agents = {
+                key: RegisteredAgent.from_dict(data["agent_id"], data)
+                for key, data in entries.items()
+            }
+            logger.info(f"Loaded {len(self.agents)} agents from startup snapshot")
+        else:
+            # Load existing metadata
+            self._load_metadata()
 
     @staticmethod
     def _make_key(agent_id: str, occurrence_id: Optional[str], server_id: str) -> str:
@@ -272,6 +281,14 @@ class AgentRegistry:
         except Exception as e:
             logger.error(f"Failed to load metadata: {e}")
 
+    def export_entries(self) -> Dict[str, Dict[str, Any]]:
+        """Agents by composite key, with agent_id, for a startup snapshot."""
+        with self._lock:
+            return {
+                key: {**agent.to_dict(), "agent_id": agent.agent_id}
+                for key, agent in self.agents.items()
+            }
+
     def _save_metadata(self) -> None:
         """Save metadata to disk."""
         try:
@@ -551,6 +568,75 @@ class AgentRegistry:
         logger.info(f"Set canary group for {agent_id} to {group}")
         return True
 
+    def next_config_version(
+        self,
+        agent_id: str,
+        occurrence_id: Optional[str] = None,
+        server_id: Optional[str] = None,
+    ) -> Optional[int]:
+        """Increment and return the agent's live config version.
+
+        Args:
+            agent_id: Agent identifier
+            occurrence_id: Occurrence ID (optional, for composite key lookup)
+            server_id: Server ID (optional, for composite key lookup)
+
+        Returns:
+            New config version, or None if agent not found
+        """
+        agent = self.get_agent(agent_id, occurrence_id, server_id)
+        if not agent:
+            return None
+
+        version = int(agent.metadata.get("config_version", 0)) + 1
+        agent.metadata["config_version"] = version
+        self._save_metadata()
+        return version
+
+    def mark_live_config_applied(
+        self,
+        agent_id: str,
+        occurrence_id: Optional[str] = None,
+        server_id: Optional[str] = None,
+    ) -> bool:
+        """Record that config was pushed live to the agent's running container.
+
+        Pushed values are not in the container's own environment, so a
+        container created before this time must be recreated, not restarted.
+
+        Args:
+            agent_id: Agent identifier
+            occurrence_id: Occurrence ID (optional, for composite key lookup)
+            server_id: Server ID (optional, for composite key lookup)
+
+        Returns:
+            True if successful, False if agent not found
+        """
+        agent = self.get_agent(agent_id, occurrence_id, server_id)
+        if not agent:
+            return False
+
+        agent.metadata["live_config_applied_at"] = datetime.now(timezone.utc).isoformat()
+        self._save_metadata()
+        return True
+
+    def clear_live_config_applied(
+        self,
+        agent_id: str,
+        occurrence_id: Optional[str] = None,
+        server_id: Optional[str] = None,
+    ) -> None:
+        """Forget a live config push once the container has been recreated.
+
+        Args:
+            agent_id: Agent identifier
+            occurrence_id: Occurrence ID (optional, for composite key lookup)
+            server_id: Server ID (optional, for composite key lookup)
+        """
+        agent = self.get_agent(agent_id, occurrence_id, server_id)
+        if agent and agent.metadata.pop("live_config_applied_at", None) is not None:
+            self._save_metadata()
+
     def set_deployment(
         self,
         agent_id: str,
@@ -775,6 +861,37 @@ class AgentRegistry:
             logger.info(f"Updated adapter config for {adapter_type} on agent {agent_id}")
             return True
 
+    def set_adapter_configs_bulk(
+        self, changes: List[Tuple[str, Optional[str], Optional[str], str, Dict[str, Any]]]
+    ) -> List[Tuple[str, Optional[str], Optional[str], str]]:
+        """
+        Set adapter configurations for many agents with a single metadata write.
+
+        Args:
+            changes: (agent_id, occurrence_id, server_id, adapter_type, config) tuples
+
+        Returns:
+            The (agent_id, occurrence_id, server_id, adapter_type) entries that were
+            not applied because the agent is not registered
+        """
+        missing: List[Tuple[str, Optional[str], Optional[str], str]] = []
+        with self._lock:
+            now = datetime.now(timezone.utc).isoformat()
+            applied = 0
+            for agent_id, occurrence_id, server_id, adapter_type, config in changes:
+                agent = self.get_agent(agent_id, occurrence_id, server_id)
+                if not agent:
+                    missing.append((agent_id, occurrence_id, server_id, adapter_type))
+                    continue
+                config.setdefault("configured_at", now)
+                agent.adapter_configs[adapter_type] = config
+                applied += 1
+
+            if applied:
+                self._save_metadata()
+            logger.info(f"Applied {applied} adapter config(s) in one registry update")
+        return missing
+
     def remove_adapter_config(
         self,
         agent_id: str,
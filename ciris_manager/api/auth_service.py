@@ -4,11 +4,14 @@ OAuth authentication service for CIRISManager.
 Separates OAuth logic from route handlers for better testability.
 """
 
-from typing import Optional, Dict, Any, Protocol, Generator
+from typing import Optional, Dict, Any, Protocol, Generator, Tuple
 from datetime import datetime, timedelta, timezone
 from pathlib import Path
+import hashlib
 import secrets
 import logging
+import threading
+import time
 import jwt
 import sqlite3
 from contextlib import contextmanager
@@ -18,6 +21,13 @@ from ciris_manager.models import OAuthToken, OAuthUser, OAuthSession
 
 logger = logging.getLogger(__name__)
 
+# Longest a verified session is trusted before the user store is asked again
+# (bounds how long changes made outside this process take to apply)
+AUTH_CACHE_TTL_SECONDS = 60
+
+# Verified sessions kept at once
+MAX_AUTH_CACHE_ENTRIES = 1024
+
 
 class TokenResponse(BaseModel):
     """OAuth token response."""
@@ -98,10 +108,20 @@ class InMemorySessionStore:
 
 
 class SQLiteUserStore:
-    """SQLite user storage implementation."""
+    """
+    SQLite user storage implementation.
+
+    Uses one long-lived connection shared across threads (FastAPI runs sync
+    dependencies in a thread pool) and serialized by a lock, instead of
+    opening a connection per query.
+    """
 
     def __init__(self, db_path: Path) -> None:
         self.db_path = db_path
+        self._conn: Optional[sqlite3.Connection] = None
+        self._lock = threading.RLock()
+        # Bumped whenever a user's authorization may have changed
+        self.authorization_version = 0
         self._init_db()
 
     def _init_db(self) -> None:
@@ -138,13 +158,24 @@ class SQLiteUserStore:
 
     @contextmanager
     def _get_db(self) -> Generator[sqlite3.Connection, None, None]:
-        """Get database connection."""
-        conn = sqlite3.connect(self.db_path)
-        conn.row_factory = sqlite3.Row
-        try:
-            yield conn
-        finally:
-            conn.close()
+        """Get the shared database connection, held exclusively for the block."""
+        with self._lock:
+            if self._conn is None:
+                self._conn = sqlite3.connect(self.db_path, check_same_thread=False)
+                self._conn.row_factory = sqlite3.Row
+            try:
+                yield self._conn
+            except (sqlite3.OperationalError, sqlite3.ProgrammingError):
+                # Drop a connection that may be broken; the next call reconnects
+                self.close()
+                raise
+
+    def close(self) -> None:
+        """Close the shared database connection."""
+        with self._lock:
+            if self._conn is not None:
+                self._conn.close()
+                self._conn = None
 
     def create_or_update_user(self, email: str, user_info: Dict[str, Any]) -> int:
         """Create or update user."""
@@ -162,6 +193,8 @@ class SQLiteUserStore:
                 (email, user_info.get("name"), user_info.get("picture")),
             )
             conn.commit()
+            # New users are authorized by default
+            self.authorization_version += 1
 
             # Get user ID
             cursor.execute("SELECT id FROM users WHERE email = ?", (email,))
@@ -181,6 +214,25 @@ class SQLiteUserStore:
         user = self.get_user_by_email(email)
         return user is not None and user.get("is_authorized", False)
 
+    def set_user_authorized(self, email: str, authorized: bool) -> bool:
+        """
+        Grant or revoke a user's access.
+
+        Args:
+            email: User email
+            authorized: Whether the user may use the API
+
+        Returns:
+            True if the user exists
+        """
+        with self._get_db() as conn:
+            cursor = conn.execute(
+                "UPDATE users SET is_authorized = ? WHERE email = ?", (int(authorized), email)
+            )
+            conn.commit()
+            self.authorization_version += 1
+            return cursor.rowcount > 0
+
 
 class AuthService:
     """Authentication service."""
@@ -200,6 +252,9 @@ class AuthService:
         self.jwt_secret = jwt_secret
         self.jwt_algorithm = jwt_algorithm
         self.jwt_expiration_hours = jwt_expiration_hours
+        # Verified sessions: token hash -> (valid until epoch, store version, payload)
+        self._verified_sessions: Dict[str, Tuple[float, Any, Dict[str, Any]]] = {}
+        self._sessions_lock = threading.Lock()
 
     def generate_state_token(self) -> str:
         """Generate CSRF state token."""
@@ -291,11 +346,28 @@ class AuthService:
             return None
 
     def get_current_user(self, authorization: Optional[str]) -> Optional[Dict[str, Any]]:
-        """Get current user from authorization header."""
+        """
+        Get current user from authorization header.
+
+        Tokens that passed verification and the authorization check are cached
+        by hash until the earlier of their expiry and AUTH_CACHE_TTL_SECONDS,
+        and dropped as soon as the user store reports an authorization change.
+        Rejections are never cached.
+        """
         if not authorization or not authorization.startswith("Bearer "):
             return None
 
         token = authorization.replace("Bearer ", "")
+        key = hashlib.sha256(token.encode()).hexdigest()
+        version = getattr(self.user_store, "authorization_version", None)
+
+        cached = self._verified_sessions.get(key)
+        if cached is not None:
+            valid_until, cached_version, cached_payload = cached
+            if time.time() < valid_until and cached_version == version:
+                return dict(cached_payload)
+            self._verified_sessions.pop(key, None)
+
         payload = self.verify_jwt_token(token)
 
         if not payload:
@@ -306,8 +378,28 @@ class AuthService:
         if not email or not self.user_store.is_user_authorized(email):
             return None
 
+        valid_until = time.time() + AUTH_CACHE_TTL_SECONDS
+        if isinstance(payload.get("exp"), (int, float)):
+            valid_until = min(valid_until, float(payload["exp"]))
+        self._cache_verified_session(key, (valid_until, version, dict(payload)))
         return payload
 
+    def _cache_verified_session(self, key: str, entry: Tuple[float, Any, Dict[str, Any]]) -> None:
+        """Store a verified session, evicting expired then oldest entries when full."""
+        with self._sessions_lock:
+            if len(self._verified_sessions) >= MAX_AUTH_CACHE_ENTRIES:
+                now = time.time()
+                for stale in [k for k, v in self._verified_sessions.items() if v[0] <= now]:
+                    del self._verified_sessions[stale]
+                while len(self._verified_sessions) >= MAX_AUTH_CACHE_ENTRIES:
+                    del self._verified_sessions[next(iter(self._verified_sessions))]
+            self._verified_sessions[key] = entry
+
+    def invalidate_sessions(self) -> None:
+        """Forget all verified sessions (e.g. after changing the JWT secret)."""
+        with self._sessions_lock:
+            self._verified_sessions.clear()
+
 
 class MockOAuthProvider:
     """Mock OAuth provider for local development."""
@@ -14,7 +14,7 @@ This package contains route modules organized by domain:
 """
 
 import logging
-from typing import Any
+from typing import Any, Optional
 
 from fastapi import APIRouter
 
@@ -55,7 +55,7 @@ __all__ = [
 ]
 
 
-def create_routes(manager: Any) -> APIRouter:
+def create_routes(manager: Any, deployment_orchestrator: Optional[Any] = None) -> APIRouter:
     """
     Create API routes with manager instance.
 
@@ -63,6 +63,7 @@ def create_routes(manager: Any) -> APIRouter:
 
     Args:
         manager: CIRISManager instance
+        deployment_orchestrator: Shared orchestrator (created if not given)
 
     Returns:
         Configured APIRouter with all routes
@@ -74,9 +75,12 @@ def create_routes(manager: Any) -> APIRouter:
     router = APIRouter()
 
     # Initialize deployment orchestrator
-    logger.info(f"[{time.time() - start_time:.2f}s] Creating DeploymentOrchestrator...")
-    deployment_orchestrator = DeploymentOrchestrator(manager)
-    logger.info(f"[{time.time() - start_time:.2f}s] DeploymentOrchestrator created successfully")
+    if deployment_orchestrator is None:
+        logger.info(f"[{time.time() - start_time:.2f}s] Creating DeploymentOrchestrator...")
+        deployment_orchestrator = DeploymentOrchestrator(manager)
+        logger.info(
+            f"[{time.time() - start_time:.2f}s] DeploymentOrchestrator created successfully"
+        )
 
     # Setup deployment tokens
     logger.info(f"[{time.time() - start_time:.2f}s] Setting up deployment tokens...")
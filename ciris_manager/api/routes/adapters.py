@@ -8,14 +8,18 @@ This module provides endpoints for managing adapters on agents:
 - Persisted adapter configs
 """
 
+import asyncio
 import logging
 from datetime import datetime, timezone
 from typing import Any, Dict, Optional
 
 import httpx
-from fastapi import APIRouter, Depends, HTTPException, Request
+from fastapi import APIRouter, Depends, HTTPException, Query, Request
 from pydantic import BaseModel
 
+from ciris_manager.agent_http import get_agent_http_client
+from ciris_manager.manifest_cache import get_manifest_cache
+
 from .dependencies import get_manager, auth_dependency
 
 logger = logging.getLogger(__name__)
@@ -45,7 +49,6 @@ async def _get_agent_client_info(
         HTTPException: If agent not found or auth fails
     """
     from ciris_manager.docker_discovery import DockerAgentDiscovery
-    from ciris_manager.agent_auth import get_agent_auth
 
     # Find the agent
     discovery = DockerAgentDiscovery(
@@ -69,17 +72,31 @@ async def _get_agent_client_info(
     if not agent:
         raise HTTPException(status_code=404, detail=f"Agent {agent_id} not found")
 
-    # Get auth headers
     try:
-        auth = get_agent_auth()
-        headers = auth.get_auth_headers(
-            agent.agent_id,
-            occurrence_id=agent.occurrence_id,
-            server_id=agent.server_id,
-        )
+        base_url, headers = _agent_endpoint(manager, agent)
     except ValueError as e:
         raise HTTPException(status_code=401, detail=str(e))
 
+    return base_url, headers, agent
+
+
+def _agent_endpoint(manager: Any, agent: Any) -> tuple[str, Dict[str, str]]:
+    """
+    Get the base URL and auth headers for a discovered agent.
+
+    Raises:
+        ValueError: If no auth headers are available for the agent
+    """
+    from ciris_manager.agent_auth import get_agent_auth
+
+    # Get auth headers
+    auth = get_agent_auth()
+    headers = auth.get_auth_headers(
+        agent.agent_id,
+        occurrence_id=agent.occurrence_id,
+        server_id=agent.server_id,
+    )
+
     # Get base URL
     try:
         server_config = manager.docker_client.get_server_config(agent.server_id)
@@ -90,7 +107,47 @@ async def _get_agent_client_info(
     except Exception:
         base_url = f"http://localhost:{agent.api_port}"
 
-    return base_url, headers, agent
+    return base_url, headers
+
+
+async def _get_adapter_metadata(
+    client: Any,
+    agent_info: Any,
+    key: str,
+    url: str,
+    headers: Dict[str, str],
+    required: bool = True,
+) -> Optional[Dict[str, Any]]:
+    """
+    Fetch an adapter document that depends only on the agent image.
+
+    Adapter types and manifests are served from the shared manifest cache, so
+    agents running the same image are only asked once.
+
+    Args:
+        client: Agent HTTP client
+        agent_info: Discovered agent (its image_id keys the cache)
+        key: Cache key for the document
+        url: Agent URL to fetch on a cache miss
+        headers: Agent auth headers
+        required: Raise on error responses instead of returning None
+
+    Returns:
+        The agent's JSON response, or None if not required and unavailable
+    """
+
+    async def fetch() -> Optional[Dict[str, Any]]:
+        response = await client.get(url, headers=headers)
+        if not required and response.status_code != 200:
+            return None
+        response.raise_for_status()
+        result: Dict[str, Any] = response.json()
+        return result
+
+    image_id = getattr(agent_info, "image_id", None)
+    return await get_manifest_cache().get_or_fetch(
+        image_id if isinstance(image_id, str) else None, key, fetch
+    )
 
 
 @router.get("/agents/{agent_id}/adapters")
@@ -110,7 +167,7 @@ async def list_agent_adapters(
         manager, agent_id, server_id=server_id, occurrence_id=occurrence_id
     )
 
-    async with httpx.AsyncClient(timeout=30.0) as client:
+    async with get_agent_http_client() as client:
         try:
             response = await client.get(
                 f"{base_url}/v1/system/adapters",
@@ -144,19 +201,16 @@ async def list_agent_adapter_types(
 
     Proxies to agent's GET /v1/system/adapters/types endpoint.
     """
-    base_url, headers, _ = await _get_agent_client_info(
+    base_url, headers, agent_info = await _get_agent_client_info(
         manager, agent_id, server_id=server_id, occurrence_id=occurrence_id
     )
 
-    async with httpx.AsyncClient(timeout=30.0) as client:
+    async with get_agent_http_client() as client:
         try:
-            response = await client.get(
-                f"{base_url}/v1/system/adapters/types",
-                headers=headers,
+            result = await _get_adapter_metadata(
+                client, agent_info, "types", f"{base_url}/v1/system/adapters/types", headers
             )
-            response.raise_for_status()
-            result: Dict[str, Any] = response.json()
-            return result
+            return result or {}
         except httpx.HTTPStatusError as e:
             raise HTTPException(
                 status_code=e.response.status_code,
@@ -190,14 +244,11 @@ async def list_adapter_manifests(
     )
 
     # Get available adapter types from agent
-    async with httpx.AsyncClient(timeout=30.0) as client:
+    async with get_agent_http_client() as client:
         try:
-            response = await client.get(
-                f"{base_url}/v1/system/adapters/types",
-                headers=headers,
+            types_data = await _get_adapter_metadata(
+                client, agent_info, "types", f"{base_url}/v1/system/adapters/types", headers
             )
-            response.raise_for_status()
-            types_data = response.json()
         except Exception as e:
             logger.warning(f"Failed to get adapter types from agent {agent_id}: {e}")
             types_data = {"data": {"types": []}}
@@ -227,7 +278,7 @@ async def list_adapter_manifests(
         # Build adapter list with status
         # Agent returns core_modules and adapters, not "types"
         adapters = []
-        data = types_data.get("data", {})
+        data = (types_data or {}).get("data", {})
         adapter_types = data.get("core_modules", []) + data.get("adapters", [])
 
         for adapter_type in adapter_types:
@@ -249,12 +300,16 @@ async def list_adapter_manifests(
             # Try to get manifest info
             manifest_info = {}
             try:
-                manifest_response = await client.get(
+                manifest_body = await _get_adapter_metadata(
+                    client,
+                    agent_info,
+                    f"manifest:{type_name}",
                     f"{base_url}/v1/system/adapters/{type_name}/manifest",
-                    headers=headers,
+                    headers,
+                    required=False,
                 )
-                if manifest_response.status_code == 200:
-                    manifest = manifest_response.json().get("data", {})
+                if manifest_body is not None:
+                    manifest = manifest_body.get("data", {})
                     module = manifest.get("module", {})
                     interactive = manifest.get("interactive_config", {})
                     manifest_info = {
@@ -343,7 +398,7 @@ async def get_agent_adapter(
         manager, agent_id, server_id=server_id, occurrence_id=occurrence_id
     )
 
-    async with httpx.AsyncClient(timeout=30.0) as client:
+    async with get_agent_http_client() as client:
         try:
             response = await client.get(
                 f"{base_url}/v1/system/adapters/{adapter_id}",
@@ -413,7 +468,7 @@ async def load_agent_adapter(
     if adapter_id:
         params["adapter_id"] = adapter_id
 
-    async with httpx.AsyncClient(timeout=30.0) as client:
+    async with get_agent_http_client() as client:
         try:
             response = await client.post(
                 f"{base_url}/v1/system/adapters/{adapter_type}",
@@ -504,7 +559,7 @@ async def reload_agent_adapter(
     except Exception:
         body = {"auto_start": True}
 
-    async with httpx.AsyncClient(timeout=30.0) as client:
+    async with get_agent_http_client() as client:
         try:
             response = await client.put(
                 f"{base_url}/v1/system/adapters/{adapter_id}/reload",
@@ -544,7 +599,7 @@ async def unload_agent_adapter(
         manager, agent_id, server_id=server_id, occurrence_id=occurrence_id
     )
 
-    async with httpx.AsyncClient(timeout=30.0) as client:
+    async with get_agent_http_client() as client:
         try:
             response = await client.delete(
                 f"{base_url}/v1/system/adapters/{adapter_id}",
@@ -622,15 +677,13 @@ async def get_adapter_manifest(
         manager, agent_id, server_id=server_id, occurrence_id=occurrence_id
     )
 
-    async with httpx.AsyncClient(timeout=30.0) as client:
+    async with get_agent_http_client() as client:
         # Get all adapter types - this contains the manifest info
         try:
-            response = await client.get(
-                f"{base_url}/v1/system/adapters/types",
-                headers=headers,
+            types_body = await _get_adapter_metadata(
+                client, agent_info, "types", f"{base_url}/v1/system/adapters/types", headers
             )
-            response.raise_for_status()
-            types_data = response.json().get("data", {})
+            types_data = (types_body or {}).get("data", {})
         except httpx.HTTPStatusError as e:
             raise HTTPException(
                 status_code=e.response.status_code,
@@ -663,12 +716,16 @@ async def get_adapter_manifest(
 
         # Try to get wizard/interactive config from configurable endpoint
         try:
-            config_response = await client.get(
+            configurable = await _get_adapter_metadata(
+                client,
+                agent_info,
+                "configurable",
                 f"{base_url}/v1/system/adapters/configurable",
-                headers=headers,
+                headers,
+                required=False,
             )
-            if config_response.status_code == 200:
-                config_data = config_response.json().get("data", {})
+            if configurable is not None:
+                config_data = configurable.get("data", {})
                 for adapter in config_data.get("adapters", []):
                     if adapter.get("adapter_type") == adapter_type:
                         manifest["interactive_config"] = {
@@ -716,7 +773,7 @@ async def start_adapter_wizard(
         manager, agent_id, server_id=server_id, occurrence_id=occurrence_id
     )
 
-    async with httpx.AsyncClient(timeout=30.0) as client:
+    async with get_agent_http_client() as client:
         try:
             # Proxy to agent's configure/start endpoint
             response = await client.post(
@@ -781,7 +838,7 @@ async def execute_wizard_step(
         manager, agent_id, server_id=server_id, occurrence_id=occurrence_id
     )
 
-    async with httpx.AsyncClient(timeout=30.0) as client:
+    async with get_agent_http_client() as client:
         try:
             # Proxy to agent's step endpoint
             response = await client.post(
@@ -858,7 +915,7 @@ async def complete_adapter_wizard(
         manager, agent_id, server_id=server_id, occurrence_id=occurrence_id
     )
 
-    async with httpx.AsyncClient(timeout=30.0) as client:
+    async with get_agent_http_client() as client:
         try:
             # Proxy to agent's complete endpoint
             response = await client.post(
@@ -922,15 +979,19 @@ async def complete_adapter_wizard(
         except Exception as e:
             logger.warning(f"Failed to store adapter config in registry: {e}")
 
-        # Regenerate compose file with new adapter env vars
+        # Regenerate compose file with new adapter env vars and push them live,
+        # so the agent does not need a restart to pick them up
         compose_regenerated = False
+        live_applied = False
         try:
-            await manager.regenerate_agent_compose(
+            regen = await manager.regenerate_agent_compose(
                 agent_id=agent_id,
                 occurrence_id=agent_info.occurrence_id,
                 server_id=agent_info.server_id,
+                apply_live=True,
             )
             compose_regenerated = True
+            live_applied = bool(regen and regen.get("live_applied"))
             logger.info(f"Regenerated compose file for agent {agent_id} with {adapter_type} config")
         except Exception as e:
             logger.warning(f"Failed to regenerate compose file for {agent_id}: {e}")
@@ -941,8 +1002,9 @@ async def complete_adapter_wizard(
         "adapter_type": adapter_type,
         "config_applied": result.get("config_applied", True),
         "compose_regenerated": compose_regenerated,
+        "live_applied": live_applied,
         "adapter_loaded": result.get("adapter_loaded", False),
-        "restart_required": not result.get("adapter_loaded", False),
+        "restart_required": not (result.get("adapter_loaded", False) or live_applied),
         "message": result.get("message", f"{adapter_type} adapter configured successfully"),
     }
 
@@ -981,7 +1043,7 @@ async def remove_adapter_config(
 
     # Try to unload from agent
     adapter_unloaded = False
-    async with httpx.AsyncClient(timeout=30.0) as client:
+    async with get_agent_http_client() as client:
         try:
             response = await client.delete(
                 f"{base_url}/v1/system/adapters/{adapter_type}",
@@ -999,6 +1061,102 @@ async def remove_adapter_config(
     }
 
 
+async def _collect_adapter_sync(
+    client: Any, base_url: str, headers: Dict[str, str], persisted_configs: Dict[str, Any]
+) -> tuple[list[Dict[str, Any]], list[Dict[str, Any]], int]:
+    """
+    Diff an agent's running adapters against its persisted registry configs.
+
+    Args:
+        client: Agent HTTP client
+        base_url: Agent API base URL
+        headers: Agent auth headers
+        persisted_configs: Adapter configs currently in the registry
+
+    Returns:
+        Tuple of (configs to persist, skipped adapters, number of running adapters)
+
+    Raises:
+        Exception: If the running adapters could not be fetched
+    """
+    response = await client.get(f"{base_url}/v1/system/adapters", headers=headers)
+    response.raise_for_status()
+    running_adapters = response.json().get("data", {}).get("adapters", [])
+
+    to_persist = []
+    skipped = []
+    for adapter in running_adapters:
+        adapter_type = adapter.get("adapter_type", adapter.get("id", "unknown"))
+
+        # Skip if already in registry
+        if adapter_type in persisted_configs:
+            skipped.append(
+                {
+                    "adapter_type": adapter_type,
+                    "reason": "already_persisted",
+                }
+            )
+            continue
+
+        # Try to get adapter config from agent
+        try:
+            config_response = await client.get(
+                f"{base_url}/v1/system/adapters/{adapter_type}",
+                headers=headers,
+            )
+            if config_response.status_code == 200:
+                adapter_data = config_response.json().get("data", {})
+                adapter_config_raw = adapter_data.get("adapter_config", {})
+            else:
+                adapter_config_raw = {}
+        except Exception:
+            adapter_config_raw = {}
+
+        # Build config to store
+        adapter_config = {
+            "enabled": True,
+            "configured_at": datetime.now(timezone.utc).isoformat(),
+            "synced_from_agent": True,
+            "config": adapter_config_raw,
+            "settings": adapter.get("settings", {}),
+        }
+
+        # Check for consent in config
+        if adapter_config_raw.get("consent_given"):
+            adapter_config["consent_given"] = True
+            adapter_config["consent_timestamp"] = adapter_config_raw.get(
+                "consent_timestamp", datetime.now(timezone.utc).isoformat()
+            )
+
+        to_persist.append({"adapter_type": adapter_type, "config": adapter_config})
+
+    return to_persist, skipped, len(running_adapters)
+
+
+def _sync_summary(
+    agent_info: Any,
+    synced: list[Dict[str, Any]],
+    skipped: list[Dict[str, Any]],
+    errors: list[Dict[str, Any]],
+    total_running: int,
+) -> Dict[str, Any]:
+    """Build the per-agent adapter sync result."""
+    return {
+        "agent_id": agent_info.agent_id,
+        "server_id": agent_info.server_id,
+        "occurrence_id": agent_info.occurrence_id,
+        "synced": synced,
+        "skipped": skipped,
+        "errors": errors,
+        "summary": {
+            "total_running": total_running,
+            "synced_count": len(synced),
+            "skipped_count": len(skipped),
+            "error_count": len(errors),
+        },
+    }
+
+
 @router.post("/agents/{agent_id}/adapters/sync")
 async def sync_adapter_configs(
     agent_id: str,
@@ -1022,116 +1180,164 @@ async def sync_adapter_configs(
         manager, agent_id, server_id=server_id, occurrence_id=occurrence_id
     )
 
-    synced = []
-    skipped = []
-    errors = []
+    # Get current registry configs
+    persisted_configs = manager.agent_registry.get_adapter_configs(
+        agent_id,
+        occurrence_id=agent_info.occurrence_id,
+        server_id=agent_info.server_id,
+    )
 
-    async with httpx.AsyncClient(timeout=30.0) as client:
-        # Get running adapters from agent
+    async with get_agent_http_client() as client:
         try:
-            response = await client.get(
-                f"{base_url}/v1/system/adapters",
-                headers=headers,
+            to_persist, skipped, total_running = await _collect_adapter_sync(
+                client, base_url, headers, persisted_configs
             )
-            response.raise_for_status()
-            running_data = response.json()
-            running_adapters = running_data.get("data", {}).get("adapters", [])
         except Exception as e:
             raise HTTPException(
                 status_code=502,
                 detail=f"Failed to get running adapters from agent: {str(e)}",
             )
 
-        # Get current registry configs
-        persisted_configs = manager.agent_registry.get_adapter_configs(
-            agent_id,
-            occurrence_id=agent_info.occurrence_id,
-            server_id=agent_info.server_id,
+    # Store all new configs in one registry write
+    synced = []
+    errors = []
+    try:
+        missing = manager.agent_registry.set_adapter_configs_bulk(
+            [
+                (
+                    agent_id,
+                    agent_info.occurrence_id,
+                    agent_info.server_id,
+                    item["adapter_type"],
+                    item["config"],
+                )
+                for item in to_persist
+            ]
+        )
+        missing_types = {entry[3] for entry in missing}
+        for item in to_persist:
+            if item["adapter_type"] in missing_types:
+                errors.append({"adapter_type": item["adapter_type"], "error": "Agent not found"})
+            else:
+                synced.append(item)
+                logger.info(
+                    f"Synced adapter {item['adapter_type']} from agent {agent_id} to registry "
+                    f"(server={agent_info.server_id}, occurrence={agent_info.occurrence_id})"
+                )
+    except Exception as e:
+        errors.extend(
+            {"adapter_type": item["adapter_type"], "error": str(e)} for item in to_persist
         )
+        logger.warning(f"Failed to sync adapters for {agent_id}: {e}")
 
-        # Sync each running adapter
-        for adapter in running_adapters:
-            adapter_type = adapter.get("adapter_type", adapter.get("id", "unknown"))
+    return _sync_summary(agent_info, synced, skipped, errors, total_running)
 
-            # Skip if already in registry
-            if adapter_type in persisted_configs:
-                skipped.append(
-                    {
-                        "adapter_type": adapter_type,
-                        "reason": "already_persisted",
-                    }
-                )
-                continue
 
-            # Try to get adapter config from agent
-            try:
-                config_response = await client.get(
-                    f"{base_url}/v1/system/adapters/{adapter_type}",
-                    headers=headers,
-                )
-                if config_response.status_code == 200:
-                    adapter_data = config_response.json().get("data", {})
-                    adapter_config_raw = adapter_data.get("adapter_config", {})
-                else:
-                    adapter_config_raw = {}
-            except Exception:
-                adapter_config_raw = {}
+@router.post("/adapters/sync")
+async def sync_fleet_adapter_configs(
+    server_id: Optional[str] = None,
+    concurrency: int = Query(10, ge=1, le=50, description="Agents queried at once"),
+    dry_run: bool = Query(False, description="Report differences without persisting"),
+    manager: Any = Depends(get_manager),
+    _user: Dict[str, str] = auth_dependency,
+) -> Dict[str, Any]:
+    """
+    Reconcile running adapters with the registry for every agent.
 
-            # Build config to store
-            adapter_config = {
-                "enabled": True,
-                "configured_at": datetime.now(timezone.utc).isoformat(),
-                "synced_from_agent": True,
-                "config": adapter_config_raw,
-                "settings": adapter.get("settings", {}),
-            }
+    Agents are queried concurrently (bounded by `concurrency`), diffed against
+    the registry, and all new configs are committed in a single registry write.
 
-            # Check for consent in config
-            if adapter_config_raw.get("consent_given"):
-                adapter_config["consent_given"] = True
-                adapter_config["consent_timestamp"] = adapter_config_raw.get(
-                    "consent_timestamp", datetime.now(timezone.utc).isoformat()
-                )
+    Returns a per-agent summary.
+    """
+    from ciris_manager.docker_discovery import DockerAgentDiscovery
+
+    discovery = DockerAgentDiscovery(
+        manager.agent_registry, docker_client_manager=manager.docker_client
+    )
+    agents = [
+        a
+        for a in discovery.discover_agents()
+        if a.is_running and a.api_port and (not server_id or a.server_id == server_id)
+    ]
+
+    semaphore = asyncio.Semaphore(concurrency)
+    client = get_agent_http_client()
 
-            # Store in registry
+    async def collect(agent_info: Any) -> Dict[str, Any]:
+        async with semaphore:
             try:
-                manager.agent_registry.set_adapter_config(
-                    agent_id,
-                    adapter_type,
-                    adapter_config,
+                base_url, headers = _agent_endpoint(manager, agent_info)
+                persisted = manager.agent_registry.get_adapter_configs(
+                    agent_info.agent_id,
                     occurrence_id=agent_info.occurrence_id,
                     server_id=agent_info.server_id,
                 )
-                synced.append(
-                    {
-                        "adapter_type": adapter_type,
-                        "config": adapter_config,
-                    }
-                )
-                logger.info(
-                    f"Synced adapter {adapter_type} from agent {agent_id} to registry "
-                    f"(server={agent_info.server_id}, occurrence={agent_info.occurrence_id})"
+                to_persist, skipped, total = await _collect_adapter_sync(
+                    client, base_url, headers, persisted
                 )
+                return {
+                    "agent": agent_info,
+                    "to_persist": to_persist,
+                    "skipped": skipped,
+                    "total_running": total,
+                    "error": None,
+                }
             except Exception as e:
-                errors.append(
-                    {
-                        "adapter_type": adapter_type,
-                        "error": str(e),
-                    }
-                )
-                logger.warning(f"Failed to sync adapter {adapter_type}: {e}")
+                logger.warning(f"Adapter sync failed for agent {agent_info.agent_id}: {e}")
+                return {
+                    "agent": agent_info,
+                    "to_persist": [],
+                    "skipped": [],
+                    "total_running": 0,
+                    "error": str(e),
+                }
+
+    collected = await asyncio.gather(*(collect(agent) for agent in agents))
+
+    changes = [
+        (
+            item["agent"].agent_id,
+            item["agent"].occurrence_id,
+            item["agent"].server_id,
+            adapter["adapter_type"],
+            adapter["config"],
+        )
+        for item in collected
+        for adapter in item["to_persist"]
+    ]
+    missing: set = set()
+    if changes and not dry_run:
+        missing = set(manager.agent_registry.set_adapter_configs_bulk(changes))
+
+    results = []
+    for item in collected:
+        agent_info = item["agent"]
+        key = (agent_info.agent_id, agent_info.occurrence_id, agent_info.server_id)
+        synced: list[Dict[str, Any]] = []
+        errors: list[Dict[str, Any]] = []
+        if item["error"]:
+            errors.append({"adapter_type": None, "error": item["error"]})
+        for adapter in item["to_persist"]:
+            if (*key, adapter["adapter_type"]) in missing:
+                errors.append({"adapter_type": adapter["adapter_type"], "error": "Agent not found"})
+            else:
+                synced.append(adapter)
+        results.append(
+            _sync_summary(agent_info, synced, item["skipped"], errors, item["total_running"])
+        )
 
+    synced_total = sum(r["summary"]["synced_count"] for r in results)
+    logger.info(
+        f"Fleet adapter sync{' (dry run)' if dry_run else ''}: {len(agents)} agent(s), "
+        f"{synced_total} adapter config(s) {'to persist' if dry_run else 'persisted'}"
+    )
     return {
-        "agent_id": agent_id,
-        "server_id": agent_info.server_id,
-        "occurrence_id": agent_info.occurrence_id,
-        "synced": synced,
-        "skipped": skipped,
-        "errors": errors,
+        "dry_run": dry_run,
+        "agents": results,
         "summary": {
-            "total_running": len(running_adapters),
-            "synced_count": len(synced),
-            "skipped_count": len(skipped),
-            "error_count": len(errors),
+            "agents_checked": len(agents),
+            "agents_failed": sum(1 for item in collected if item["error"]),
+            "synced_count": synced_total,
+            "skipped_count": sum(r["summary"]["skipped_count"] for r in results),
         },
     }
@@ -18,6 +18,8 @@ from enum import Enum
 from fastapi import APIRouter, Depends, HTTPException
 from pydantic import BaseModel
 
+from ciris_manager.utils.agent_host import AgentHostUnavailableError, get_agent_host
+
 from .dependencies import get_manager, auth_dependency
 
 logger = logging.getLogger(__name__)
@@ -192,6 +194,59 @@ async def execute_admin_action(
         raise HTTPException(status_code=500, detail=f"Action failed: {str(e)}")
 
 
+async def _read_remote_compose(docker_client: Any, server_id: str, compose_file_path: str) -> str:
+    """
+    Read a remote compose file through the server's agent-host sidecar.
+
+    Falls back to a temporary container with the agents directory mounted when
+    the server has no sidecar or it cannot be reached.
+    """
+    host = get_agent_host(server_id)
+    if host:
+        try:
+            return (await host.read_file(Path(compose_file_path))).decode()
+        except AgentHostUnavailableError as e:
+            logger.warning(f"{e}, falling back to a temporary container")
+
+    result = docker_client.containers.run(
+        "alpine:latest",
+        f"cat {compose_file_path}",
+        volumes={"/opt/ciris/agents": {"bind": "/opt/ciris/agents", "mode": "ro"}},
+        remove=True,
+        detach=False,
+    )
+    return result.decode() if result else ""
+
+
+async def _write_remote_compose(
+    docker_client: Any, server_id: str, compose_file_path: str, compose_yaml: str
+) -> None:
+    """
+    Replace a remote compose file through the server's agent-host sidecar.
+
+    Falls back to a temporary container with the agents directory mounted when
+    the server has no sidecar or it cannot be reached.
+    """
+    host = get_agent_host(server_id)
+    if host:
+        try:
+            await host.write_file(Path(compose_file_path), compose_yaml.encode())
+            return
+        except AgentHostUnavailableError as e:
+            logger.warning(f"{e}, falling back to a temporary container")
+
+    import base64
+
+    encoded = base64.b64encode(compose_yaml.encode()).decode()
+    docker_client.containers.run(
+        "alpine:latest",
+        f"sh -c 'echo {encoded} | base64 -d > {compose_file_path}'",
+        volumes={"/opt/ciris/agents": {"bind": "/opt/ciris/agents", "mode": "rw"}},
+        remove=True,
+        detach=False,
+    )
+
+
 async def _handle_identity_update(
     manager: Any, agent: Any, params: Dict[str, Any], force: bool
 ) -> AdminActionResponse:
@@ -230,18 +285,11 @@ async def _handle_identity_update(
         with open(compose_path) as f:
             compose_config = yaml.safe_load(f)
     else:
-        # Remote: read compose file using a temporary container with host filesystem access
+        compose_file_path = f"/opt/ciris/agents/{agent_id}/docker-compose.yml"
         try:
-            compose_file_path = f"/opt/ciris/agents/{agent_id}/docker-compose.yml"
-            # Run a temporary alpine container with the agents directory mounted
-            result = docker_client.containers.run(
-                "alpine:latest",
-                f"cat {compose_file_path}",
-                volumes={"/opt/ciris/agents": {"bind": "/opt/ciris/agents", "mode": "ro"}},
-                remove=True,
-                detach=False,
+            compose_content = await _read_remote_compose(
+                docker_client, server_id, compose_file_path
             )
-            compose_content = result.decode() if result else ""
             compose_config = yaml.safe_load(compose_content)
             if not compose_config:
                 raise HTTPException(
@@ -289,18 +337,12 @@ async def _handle_identity_update(
             with open(compose_path, "w") as f:
                 yaml.dump(compose_config, f, default_flow_style=False, sort_keys=False)
         else:
-            # Remote: write via temporary container with host filesystem access
-            import base64
-
             compose_yaml = yaml.dump(compose_config, default_flow_style=False, sort_keys=False)
-            encoded = base64.b64encode(compose_yaml.encode()).decode()
-            compose_file_path = f"/opt/ciris/agents/{agent_id}/docker-compose.yml"
-            docker_client.containers.run(
-                "alpine:latest",
-                f"sh -c 'echo {encoded} | base64 -d > {compose_file_path}'",
-                volumes={"/opt/ciris/agents": {"bind": "/opt/ciris/agents", "mode": "rw"}},
-                remove=True,
-                detach=False,
+            await _write_remote_compose(
+                docker_client,
+                server_id,
+                f"/opt/ciris/agents/{agent_id}/docker-compose.yml",
+                compose_yaml,
             )
 
     # Pull latest image
@@ -361,18 +403,12 @@ async def _handle_identity_update(
                     yaml.dump(compose_config, f, default_flow_style=False, sort_keys=False)
                 logger.info(f"Removed --identity-update flag from {compose_path}")
             else:
-                # Remote: write via temporary container with host filesystem access
-                import base64
-
                 compose_yaml = yaml.dump(compose_config, default_flow_style=False, sort_keys=False)
-                encoded = base64.b64encode(compose_yaml.encode()).decode()
-                compose_file_path = f"/opt/ciris/agents/{agent_id}/docker-compose.yml"
-                docker_client.containers.run(
-                    "alpine:latest",
-                    f"sh -c 'echo {encoded} | base64 -d > {compose_file_path}'",
-                    volumes={"/opt/ciris/agents": {"bind": "/opt/ciris/agents", "mode": "rw"}},
-                    remove=True,
-                    detach=False,
+                await _write_remote_compose(
+                    docker_client,
+                    server_id,
+                    f"/opt/ciris/agents/{agent_id}/docker-compose.yml",
+                    compose_yaml,
                 )
                 logger.info("Removed --identity-update flag from remote compose file")
         except Exception as e:
@@ -14,7 +14,9 @@ import yaml
 from fastapi import APIRouter, Depends, HTTPException, Request
 from fastapi.responses import PlainTextResponse
 
+from ciris_manager.agent_http import get_agent_http_client
 from ciris_manager.models import CreateAgentRequest
+from ciris_manager.utils.agent_host import AgentHostError, get_agent_host
 from ciris_manager.utils.compose_command import compose_cmd
 from ciris_manager.utils.log_sanitizer import sanitize_agent_id
 
@@ -634,8 +636,10 @@ async def get_agent_logs(
                     if source == "docker":
                         raise
 
-            # Get application log files
-            if source in ("file", "all"):
+            # Get application log files (read on the host when it runs an agent-host sidecar)
+            if source in ("file", "all") and not await _tail_host_logs(
+                manager, discovered_agent, lines, all_logs
+            ):
                 try:
                     # Find the latest ciris_agent log file
                     exit_code, output = container.exec_run(
@@ -700,6 +704,43 @@ async def get_agent_logs(
         raise HTTPException(status_code=500, detail=str(e))
 
 
+async def _tail_host_logs(manager: Any, agent: Any, lines: int, all_logs: List[str]) -> bool:
+    """
+    Append an agent's application logs read through its server's agent-host sidecar.
+
+    Returns:
+        False if the server has no sidecar or it failed (the caller falls back to exec)
+    """
+    host = get_agent_host(agent.server_id)
+    if not host:
+        return False
+    registered = manager.agent_registry.get_agent(
+        agent.agent_id, occurrence_id=agent.occurrence_id, server_id=agent.server_id
+    )
+    if not registered or not registered.compose_file:
+        return False
+
+    logs_dir = Path(registered.compose_file).parent / "logs"
+    try:
+        content = await host.tail_log(logs_dir / "latest.log", lines)
+    except AgentHostError as e:
+        logger.warning(f"Agent host could not tail logs for {agent.agent_id}: {e}")
+        return False
+    if content.strip():
+        all_logs.append(f"=== APPLICATION LOG ({logs_dir / 'latest.log'}) ===\n" + content)
+
+    try:
+        content = await host.tail_log(logs_dir / "incidents_latest.log", lines)
+    except AgentHostError:
+        # Agents without incidents have no incidents log
+        return True
+    if content.strip():
+        all_logs.append(
+            f"=== INCIDENTS LOG ({logs_dir / 'incidents_latest.log'}) ===\n" + content
+        )
+    return True
+
+
 @router.get("/agents/{agent_id}/logs/file/{filename}")
 async def get_agent_log_file(
     agent_id: str,
@@ -725,6 +766,15 @@ async def get_agent_log_file(
         else:
             container_name = f"ciris-{agent_id}"
 
+        host = get_agent_host(agent.server_id)
+        if host and agent.compose_file:
+            try:
+                log_path = Path(agent.compose_file).parent / "logs" / filename
+                content = (await host.read_file(log_path)).decode("utf-8", errors="replace")
+                return PlainTextResponse(content=content)
+            except AgentHostError as e:
+                logger.warning(f"Agent host could not read {filename} for {agent_id}: {e}")
+
         client = manager.docker_client.get_client(agent.server_id)
 
         try:
@@ -988,7 +1038,7 @@ async def request_shutdown_agent(
 
         auth = get_agent_auth()
 
-        async with httpx.AsyncClient(timeout=30.0) as client:
+        async with get_agent_http_client() as client:
             try:
                 headers = auth.get_auth_headers(agent_id)
 
@@ -1038,6 +1088,20 @@ async def request_shutdown_agent(
         raise HTTPException(status_code=500, detail=f"Failed to request shutdown: {str(e)}")
 
 
+async def _restart_container(
+    manager: Any, container: Any, agent_id: str, occurrence_id: Optional[str], server_id: str
+) -> None:
+    """Restart an agent's container, recreating it if that would revert live config."""
+    agent = manager.agent_registry.get_agent(
+        agent_id, occurrence_id=occurrence_id, server_id=server_id
+    )
+    if agent and manager.needs_recreate_for_live_config(agent, container):
+        if not await manager.recreate_agent_container(agent):
+            raise HTTPException(status_code=500, detail="Failed to recreate container")
+        return
+    container.restart(timeout=30)
+
+
 @router.post("/agents/{agent_id}/restart")
 async def restart_agent(
     agent_id: str,
@@ -1077,7 +1141,9 @@ async def restart_agent(
 
         try:
             container = client.containers.get(container_name)
-            container.restart(timeout=30)
+            await _restart_container(
+                manager, container, agent_id, discovered_agent.occurrence_id, server_id
+            )
 
             logger.info(f"Agent {agent_id} restarted by {user['email']}")
 
@@ -1090,7 +1156,9 @@ async def restart_agent(
         except docker.errors.NotFound:
             try:
                 container = client.containers.get(f"ciris-{agent_id}")
-                container.restart(timeout=30)
+                await _restart_container(
+                    manager, container, agent_id, discovered_agent.occurrence_id, server_id
+                )
 
                 logger.info(f"Agent {agent_id} restarted by {user['email']}")
 
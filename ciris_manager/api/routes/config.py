@@ -15,6 +15,7 @@ import aiofiles  # type: ignore
 import yaml
 from fastapi import APIRouter, Depends, HTTPException
 
+from ciris_manager.compose_generator import normalize_compose_env
 from ciris_manager.utils.compose_command import compose_cmd
 from .dependencies import get_manager, get_auth_dependency
 
@@ -111,8 +112,14 @@ async def update_agent_config(
     config_update: Dict[str, Any],
     manager: Any = Depends(get_manager),
     user: dict = auth_dependency,
-) -> Dict[str, str]:
-    """Update agent configuration by modifying docker-compose.yml."""
+) -> Dict[str, Any]:
+    """
+    Update agent configuration by modifying docker-compose.yml.
+
+    The compose file is always written first. When a restart is requested the
+    changed env vars are pushed to the running agent, and the container is only
+    recreated if the agent does not acknowledge them.
+    """
     try:
         # Validate agent_id to prevent directory traversal
         if not re.match(r"^[a-zA-Z0-9][a-zA-Z0-9\-_]{0,63}$", agent_id):
@@ -136,6 +143,8 @@ async def update_agent_config(
             content = await f.read()
             compose_data = yaml.safe_load(content)
 
+        previous_env = _service_environment(compose_data)
+
         # Update environment variables
         if "environment" in config_update:
             if "services" in compose_data:
@@ -215,6 +224,28 @@ async def update_agent_config(
             if not agent:
                 raise HTTPException(status_code=404, detail=f"Agent '{agent_id}' not found")
 
+            # This route only edits env vars, which a running agent can apply live
+            current_env = _service_environment(compose_data)
+            env_changes = {
+                key: current_env.get(key)
+                for key in set(previous_env) | set(current_env)
+                if previous_env.get(key) != current_env.get(key)
+            }
+            if env_changes:
+                push = await manager.apply_config_live(agent, env_changes, compose_data)
+                if push is not None and push.acknowledged:
+                    logger.info(
+                        f"Agent {agent_id} config updated and applied live by {user['email']}"
+                    )
+                    return {
+                        "status": "updated",
+                        "agent_id": agent_id,
+                        "config_version": push.version,
+                        "message": (
+                            f"Configuration updated and version {push.version} applied live"
+                        ),
+                    }
+
             server_id = agent.server_id if hasattr(agent, "server_id") else "main"
 
             if server_id != "main":
@@ -258,3 +289,11 @@ async def update_agent_config(
     except Exception as e:
         logger.error(f"Failed to update agent config: {e}")
         raise HTTPException(status_code=500, detail=str(e))
+
+
+def _service_environment(compose_data: Dict[str, Any]) -> Dict[str, str]:
+    """Environment of the first compose service that defines one."""
+    for service in (compose_data.get("services") or {}).values():
+        if "environment" in service:
+            return normalize_compose_env(service["environment"])
+    return {}
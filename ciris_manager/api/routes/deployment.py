@@ -8,7 +8,7 @@ import logging
 import os
 from typing import Any, Dict, List, Optional
 
-from fastapi import APIRouter, Depends, HTTPException
+from fastapi import APIRouter, Depends, HTTPException, Response
 from fastapi.responses import StreamingResponse
 
 from ciris_manager.models import DeploymentStatus, UpdateNotification
@@ -394,14 +394,15 @@ async def preview_deployment(
     deployment_id: str,
     deployment_orchestrator: Any = Depends(get_deployment_orchestrator),
     _user: Dict[str, str] = auth_dependency,
-) -> Dict[str, Any]:
+) -> Response:
     """
     Get a preview of what a deployment will do.
     Shows which agents need updates and which are already current.
-    Designed for scale - efficiently checks all agents.
+    Designed for scale - served pre-serialized from the preview cache while
+    the fleet is unchanged, re-checking only agents whose state changed.
     """
-    preview = await deployment_orchestrator.get_deployment_preview(deployment_id)
-    return preview  # type: ignore[no-any-return]
+    content = await deployment_orchestrator.get_deployment_preview_json(deployment_id)
+    return Response(content=content, media_type="application/json")
 
 
 @router.get("/updates/shutdown-reasons/{deployment_id}")
@@ -623,12 +624,25 @@ async def get_current_images(
 @router.get("/updates/history")
 async def get_deployment_history(
     limit: int = 10,
+    offset: int = 0,
+    status: Optional[str] = None,
+    agent_id: Optional[str] = None,
+    since: Optional[str] = None,
+    until: Optional[str] = None,
     deployment_orchestrator: Any = Depends(get_deployment_orchestrator),
     _user: Dict[str, str] = auth_dependency,
 ) -> Dict[str, Any]:
-    """Get deployment history."""
-    history = await deployment_orchestrator.get_deployment_history(limit)
-    return {"deployments": history}
+    """
+    Get deployment history, newest first.
+
+    Pages with limit/offset and filters by status, agent and ISO time range
+    (since inclusive, until exclusive). Older deployments come from the
+    history archive.
+    """
+    history = await deployment_orchestrator.get_deployment_history(
+        limit, offset=offset, status=status, agent_id=agent_id, since=since, until=until
+    )
+    return {"deployments": history, "limit": limit, "offset": offset}
 
 
 @router.get("/updates/rollback-options")
@@ -21,7 +21,13 @@ from ciris_manager.models.llm import (
     redact_llm_config,
     LLMProviderConfig,
 )
-from ciris_manager.llm_validator import validate_llm_config
+from ciris_manager.llm_validator import (
+    DEFAULT_VALIDATION_CONCURRENCY,
+    LLMProbe,
+    validate_llm_config,
+    validate_llm_configs,
+    validate_stored_llm_configs,
+)
 from .dependencies import get_manager, auth_dependency, resolve_agent
 
 logger = logging.getLogger(__name__)
@@ -29,6 +35,43 @@ logger = logging.getLogger(__name__)
 router = APIRouter(tags=["llm"])
 
 
+async def _apply_config_change(manager: Any, agent: Any, result: Dict[str, Any]) -> None:
+    """
+    Regenerate the agent's compose file and apply the change.
+
+    Env-only changes are pushed to the running agent; otherwise the container is
+    recreated from the compose file, even if that file was already up to date.
+
+    Args:
+        manager: CIRISManager instance
+        agent: Resolved agent
+        result: Response dict to update with the outcome
+    """
+    regen = await manager.regenerate_agent_compose(
+        agent.agent_id,
+        occurrence_id=agent.occurrence_id,
+        server_id=agent.server_id,
+        apply_live=True,
+    )
+    if regen and regen.get("live_applied") is True:
+        result["restarted"] = False
+        result["live_applied"] = True
+        result["config_version"] = regen.get("config_version")
+        result["message"] += " and applied live"
+        return
+
+    # An unchanged compose file only means nothing was rewritten: the running
+    # container may still be stale (e.g. an earlier restart failed), so the
+    # requested restart always happens. A plain restart would keep the
+    # container's old environment, so it is recreated from the compose file.
+    restarted = await manager.recreate_agent_container(agent)
+    result["restarted"] = restarted
+    if restarted:
+        result["message"] += " and container restarted"
+    else:
+        result["warning"] = "Config saved but container restart failed"
+
+
 @router.get("/agents/{agent_id}/llm")
 async def get_llm_configuration(
     agent_id: str,
@@ -124,46 +167,42 @@ async def set_llm_configuration(
 
     validation_results = {}
 
-    # Validate primary if requested
+    # Validate primary and backup concurrently if requested
     if validate:
-        logger.info(f"Validating primary LLM config for {agent_id}")
-        is_valid, error, models = await validate_llm_config(
-            provider=config.primary_provider,
-            api_key=config.primary_api_key,
-            model=config.primary_model,
-            api_base=config.primary_api_base,
-        )
-        validation_results["primary"] = {
-            "valid": is_valid,
-            "error": error,
-            "models_available": models[:10] if models else None,  # Limit to 10 models
-        }
-
-        if not is_valid and error and "valid" not in error.lower():
-            raise HTTPException(
-                status_code=400,
-                detail=f"Primary LLM validation failed: {error}",
+        probes = [
+            LLMProbe(
+                provider=config.primary_provider,
+                api_key=config.primary_api_key,
+                model=config.primary_model,
+                api_base=config.primary_api_base,
             )
-
-        # Validate backup if provided
+        ]
+        roles = ["primary"]
         if config.backup_provider and config.backup_api_key and config.backup_model:
-            logger.info(f"Validating backup LLM config for {agent_id}")
-            is_valid, error, models = await validate_llm_config(
-                provider=config.backup_provider,
-                api_key=config.backup_api_key,
-                model=config.backup_model,
-                api_base=config.backup_api_base,
+            probes.append(
+                LLMProbe(
+                    provider=config.backup_provider,
+                    api_key=config.backup_api_key,
+                    model=config.backup_model,
+                    api_base=config.backup_api_base,
+                )
             )
-            validation_results["backup"] = {
+            roles.append("backup")
+
+        logger.info(f"Validating {' and '.join(roles)} LLM config for {agent_id}")
+        results = await validate_llm_configs(probes)
+
+        for role, (is_valid, error, models) in zip(roles, results):
+            validation_results[role] = {
                 "valid": is_valid,
                 "error": error,
-                "models_available": models[:10] if models else None,
+                "models_available": models[:10] if models else None,  # Limit to 10 models
             }
 
             if not is_valid and error and "valid" not in error.lower():
                 raise HTTPException(
                     status_code=400,
-                    detail=f"Backup LLM validation failed: {error}",
+                    detail=f"{role.capitalize()} LLM validation failed: {error}",
                 )
 
     # Convert to storage format
@@ -207,17 +246,8 @@ async def set_llm_configuration(
     # Restart container if requested
     if restart:
         try:
-            # Regenerate compose file with new LLM config
-            await manager.regenerate_agent_compose(agent.agent_id)
-
-            # Restart the container
-            container_name = f"ciris-agent-{agent.name}"
-            restarted = await manager.restart_container(container_name, server_id=agent.server_id)
-            result["restarted"] = restarted
-            if restarted:
-                result["message"] += " and container restarted"
-            else:
-                result["warning"] = "Config saved but container restart failed"
+            # Regenerate compose file with new LLM config, applying it live if possible
+            await _apply_config_change(manager, agent, result)
         except Exception as e:
             logger.error(f"Failed to restart container for {agent_id}: {e}")
             result["warning"] = f"Config saved but restart failed: {str(e)}"
@@ -331,14 +361,7 @@ async def patch_llm_configuration(
     # Restart container if requested
     if restart:
         try:
-            await manager.regenerate_agent_compose(agent.agent_id)
-            container_name = f"ciris-agent-{agent.name}"
-            restarted = await manager.restart_container(container_name, server_id=agent.server_id)
-            result["restarted"] = restarted
-            if restarted:
-                result["message"] += " and container restarted"
-            else:
-                result["warning"] = "Config saved but container restart failed"
+            await _apply_config_change(manager, agent, result)
         except Exception as e:
             logger.error(f"Failed to restart container for {agent_id}: {e}")
             result["warning"] = f"Config saved but restart failed: {str(e)}"
@@ -395,10 +418,7 @@ async def delete_llm_configuration(
     # Restart container if requested
     if restart:
         try:
-            await manager.regenerate_agent_compose(agent.agent_id)
-            container_name = f"ciris-agent-{agent.name}"
-            restarted = await manager.restart_container(container_name, server_id=agent.server_id)
-            result["restarted"] = restarted
+            await _apply_config_change(manager, agent, result)
         except Exception as e:
             logger.error(f"Failed to restart container for {agent_id}: {e}")
             result["warning"] = f"Config deleted but restart failed: {str(e)}"
@@ -446,3 +466,66 @@ async def validate_llm_config_endpoint(
         error=error,
         models_available=models[:20] if models else None,  # Limit to 20 models
     )
+
+
+@router.post("/llm/validate-all")
+async def validate_all_llm_configs(
+    server_id: Optional[str] = Query(None, description="Only validate agents on this server"),
+    concurrency: int = Query(
+        DEFAULT_VALIDATION_CONCURRENCY, ge=1, le=32, description="Provider probes at once"
+    ),
+    manager: Any = Depends(get_manager),
+    _user: Dict[str, str] = auth_dependency,
+) -> Dict[str, Any]:
+    """
+    Validate the stored LLM configuration of every agent.
+
+    Primary and backup configs are probed concurrently (bounded by
+    `concurrency`); agents sharing a provider key and model are probed once.
+    Nothing is saved and no agent is restarted.
+
+    Args:
+        server_id: Optional server ID to restrict the check to
+        concurrency: Maximum provider probes in flight
+
+    Returns:
+        Per-agent validation results (without API keys) and totals
+    """
+    agents = {}
+    configs = {}
+    for agent in manager.agent_registry.list_agents():
+        if server_id and agent.server_id != server_id:
+            continue
+        config = manager.agent_registry.get_llm_config(
+            agent.agent_id,
+            occurrence_id=agent.occurrence_id,
+            server_id=agent.server_id,
+        )
+        if not config:
+            continue
+        label = f"{agent.agent_id}:{agent.occurrence_id or ''}:{agent.server_id}"
+        agents[label] = agent
+        configs[label] = config
+
+    report = await validate_stored_llm_configs(configs, concurrency=concurrency)
+
+    results = []
+    invalid = 0
+    for label, roles in report.items():
+        agent = agents[label]
+        if any(not result["valid"] for result in roles.values()):
+            invalid += 1
+        results.append(
+            {
+                "agent_id": agent.agent_id,
+                "occurrence_id": agent.occurrence_id,
+                "server_id": agent.server_id,
+                **roles,
+            }
+        )
+
+    logger.info(f"Validated LLM configs for {len(results)} agent(s); {invalid} invalid")
+    return {
+        "agents": results,
+        "summary": {"agents_checked": len(results), "agents_invalid": invalid},
+    }
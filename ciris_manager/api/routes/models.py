@@ -39,6 +39,7 @@ class StatusResponse(BaseModel):
     uptime_seconds: Optional[int] = None
     start_time: Optional[str] = None
     system_metrics: Optional[Dict[str, Any]] = None
+    startup: Optional[Dict[str, Any]] = None
 
 
 class TemplateListResponse(BaseModel):
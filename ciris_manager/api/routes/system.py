@@ -8,7 +8,9 @@ from typing import Any, Dict
 
 from fastapi import APIRouter, Depends
 
-from .dependencies import get_manager
+from ciris_manager.agent_http import get_agent_http_client
+
+from .dependencies import auth_dependency, get_manager
 from .models import StatusResponse
 
 logger = logging.getLogger(__name__)
@@ -36,4 +38,13 @@ async def get_status(
         uptime_seconds=status.get("uptime_seconds"),
         start_time=status.get("start_time"),
         system_metrics=status.get("system_metrics"),
+        startup=status.get("startup"),
     )
+
+
+@router.get("/agent-latency")
+async def get_agent_latency(
+    _user: Dict[str, str] = auth_dependency,
+) -> Dict[str, Any]:
+    """Per-agent latency of requests the manager has made to agent APIs."""
+    return {"agents": get_agent_http_client().latency_stats()}
@@ -236,6 +236,15 @@ async def restart_agent(
         # Find container
         container_name = f"ciris-agent-{agent_id}"
         container = client.containers.get(container_name)
+
+        # Restarting would revert config pushed live; recreate from compose instead
+        manager = get_manager()
+        registry_agent = manager.agent_registry.get_agent(agent_id)
+        if registry_agent and manager.needs_recreate_for_live_config(registry_agent, container):
+            if not await manager.recreate_agent_container(registry_agent):
+                raise RuntimeError(f"Failed to recreate container for {agent_id}")
+            return {"status": "recreated", "agent_id": agent_id}
+
         container.restart()
 
         return {"status": "restarted", "agent_id": agent_id}
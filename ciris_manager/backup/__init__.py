@@ -0,0 +1,8 @@
+"""
+Incremental, deduplicated backups of manager configuration and agent data.
+"""
+
+from ciris_manager.backup.engine import BackupEngine
+from ciris_manager.backup.repository import BackupRepository, RepositoryError
+
+__all__ = ["BackupEngine", "BackupRepository", "RepositoryError"]
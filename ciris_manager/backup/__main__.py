@@ -0,0 +1,105 @@
+"""
+Backup command line.
+
+    python -m ciris_manager.backup create /opt/ciris/agents /etc/ciris-manager
+    python -m ciris_manager.backup list
+    python -m ciris_manager.backup verify [--snapshot ID] [--full]
+    python -m ciris_manager.backup prune --keep-days 30
+    python -m ciris_manager.backup contents ID
+    python -m ciris_manager.backup restore ID /
+    python -m ciris_manager.backup restore latest / --agent datum
+"""
+
+import argparse
+import json
+import logging
+import sys
+from pathlib import Path
+from typing import List, Optional
+
+from ciris_manager.backup.engine import BackupEngine
+from ciris_manager.backup.repository import BackupRepository, RepositoryError
+
+DEFAULT_REPOSITORY = "/var/backups/ciris-manager/repository"
+DEFAULT_AGENTS_DIR = "/opt/ciris/agents"
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    """Command-line entry point."""
+    parser = argparse.ArgumentParser(description="Incremental CIRIS Manager backups")
+    parser.add_argument("--repo", default=DEFAULT_REPOSITORY, help="Backup repository directory")
+    parser.add_argument(
+        "--workers", type=int, default=None, help="Worker processes (default: CPU count)"
+    )
+    parser.add_argument("--verbose", action="store_true", help="Show progress logs")
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    create = commands.add_parser("create", help="Back up paths into a new snapshot")
+    create.add_argument("paths", nargs="+", type=Path)
+    create.add_argument("--label", default=None)
+
+    commands.add_parser("list", help="List snapshots")
+
+    verify = commands.add_parser("verify", help="Check snapshots can be restored")
+    verify.add_argument("--snapshot", default=None)
+    verify.add_argument("--full", action="store_true", help="Decompress and hash every chunk")
+
+    prune = commands.add_parser("prune", help="Delete old snapshots and unused chunks")
+    prune.add_argument("--keep-days", type=int, required=True)
+    prune.add_argument("--keep-last", type=int, default=1)
+
+    contents = commands.add_parser("contents", help="Show indexed snapshot contents")
+    contents.add_argument("snapshot", help="Snapshot id or 'latest'")
+
+    restore = commands.add_parser("restore", help="Restore a snapshot under a target root")
+    restore.add_argument("snapshot", help="Snapshot id or 'latest'")
+    restore.add_argument("target", type=Path)
+    restore.add_argument(
+        "--agent", action="append", default=[], help="Only restore this agent (repeatable)"
+    )
+    restore.add_argument(
+        "--path", action="append", default=[], help="Only restore this absolute path (repeatable)"
+    )
+    restore.add_argument("--agents-dir", default=DEFAULT_AGENTS_DIR)
+
+    args = parser.parse_args(argv)
+    logging.basicConfig(level=logging.INFO if args.verbose else logging.WARNING)
+    engine = BackupEngine(BackupRepository(Path(args.repo)), max_workers=args.workers)
+
+    try:
+        if args.command == "create":
+            print(json.dumps(engine.create(args.paths, label=args.label), indent=2))
+        elif args.command == "list":
+            for snapshot in engine.repository.list_snapshots():
+                stats = snapshot.get("stats", {})
+                print(
+                    f"{snapshot['id']}  {snapshot['created_at']}  "
+                    f"{stats.get('files', 0)} files  {stats.get('total_bytes', 0)} bytes  "
+                    f"+{stats.get('stored_bytes', 0)} stored"
+                )
+        elif args.command == "verify":
+            problems = engine.verify(args.snapshot, full=args.full)
+            for problem in problems:
+                print(problem, file=sys.stderr)
+            print("Backup verification: OK" if not problems else "Backup verification: FAILED")
+            return 1 if problems else 0
+        elif args.command == "prune":
+            print(json.dumps(engine.prune(args.keep_days, args.keep_last)))
+        elif args.command == "contents":
+            snapshot_id = engine.repository.resolve_snapshot(args.snapshot)
+            summary = engine.repository.load_summary(snapshot_id)
+            for path, item in sorted(summary.get("index", {}).items()):
+                print(f"{path}  {item['files']} files  {item['bytes']} bytes")
+        elif args.command == "restore":
+            snapshot_id = engine.repository.resolve_snapshot(args.snapshot)
+            paths = args.path + [f"{args.agents_dir.rstrip('/')}/{a}" for a in args.agent]
+            restored = engine.restore(snapshot_id, args.target, paths or None)
+            print(f"Restored {restored} files from {snapshot_id}")
+    except RepositoryError as e:
+        print(f"ERROR: {e}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,125 @@
+"""
+Content-defined chunking.
+
+Splits a byte stream into variable-size chunks whose boundaries depend on
+the content (FastCDC-style gear hash with normalized chunking), so an edit
+in the middle of a file only changes the chunks around it and everything
+else deduplicates against earlier backups.
+
+The gear hash runs in Python, so it is the slow part of a backup. When a
+changed file was chunked before (typically a database with a few rewritten
+pages), the previous chunk list is used as a hint: wherever a previous chunk
+starts at the current offset and its bytes are unchanged (checked with
+SHA-256, which runs in C), it is emitted without scanning. A cut point only
+depends on the bytes of its own chunk, so the result is identical to chunking
+the whole file and only the changed regions are hashed byte by byte.
+"""
+
+import hashlib
+from typing import BinaryIO, Dict, Iterator, List, Optional, Sequence, Tuple
+
+MIN_CHUNK_SIZE = 16 * 1024
+AVG_CHUNK_SIZE = 64 * 1024
+MAX_CHUNK_SIZE = 256 * 1024
+
+# Bytes read from the source per refill
+READ_SIZE = 1024 * 1024
+
+_MASK_64 = (1 << 64) - 1
+
+
+def _high_bits_mask(bits: int) -> int:
+    # The gear hash shifts left, so its high bits mix the most recent bytes
+    return ((1 << bits) - 1) << (64 - bits)
+
+
+_AVG_BITS = AVG_CHUNK_SIZE.bit_length() - 1
+# Harder to match before the average size, easier after (normalized chunking)
+MASK_SMALL = _high_bits_mask(_AVG_BITS + 2)
+MASK_LARGE = _high_bits_mask(_AVG_BITS - 2)
+
+# Deterministic gear table: boundaries must be identical across runs and hosts
+GEAR: List[int] = [
+    int.from_bytes(hashlib.sha256(bytes([i])).digest()[:8], "big") for i in range(256)
+]
+
+
+def find_cut_point(data: bytearray, length: int) -> int:
+    """
+    Find the end of the first chunk in data[:length].
+
+    Args:
+        data: Buffered bytes
+        length: Number of valid bytes in data
+
+    Returns:
+        Chunk length (MIN_CHUNK_SIZE..MAX_CHUNK_SIZE, or length if shorter)
+    """
+    if length <= MIN_CHUNK_SIZE:
+        return length
+    end = min(length, MAX_CHUNK_SIZE)
+    normal = min(end, AVG_CHUNK_SIZE)
+    gear = GEAR
+    h = 0
+    i = MIN_CHUNK_SIZE
+    while i < normal:
+        h = ((h << 1) + gear[data[i]]) & _MASK_64
+        i += 1
+        if not h & MASK_SMALL:
+            return i
+    while i < end:
+        h = ((h << 1) + gear[data[i]]) & _MASK_64
+        i += 1
+        if not h & MASK_LARGE:
+            return i
+    return end
+
+
+def iter_chunks(
+    stream: BinaryIO, previous: Optional[Sequence[Tuple[str, int]]] = None
+) -> Iterator[bytes]:
+    """
+    Yield content-defined chunks from a binary stream.
+
+    Args:
+        stream: Readable binary stream
+        previous: (SHA-256 hex digest, size) of the chunks this stream had in
+            an earlier backup; unchanged chunks are emitted without scanning
+
+    Yields:
+        Consecutive chunks covering the whole stream
+    """
+    hints: Dict[int, Tuple[str, int]] = {}
+    previous_end = 0
+    for digest, size in previous or ():
+        hints[previous_end] = (digest, size)
+        previous_end += size
+
+    buffer = bytearray()
+    eof = False
+    position = 0
+    while True:
+        while not eof and len(buffer) < MAX_CHUNK_SIZE:
+            block = stream.read(READ_SIZE)
+            if block:
+                buffer += block
+            else:
+                eof = True
+        if not buffer:
+            return
+        cut = 0
+        hint = hints.get(position)
+        if hint and hint[1] <= len(buffer):
+            digest, size = hint
+            # The old last chunk was cut by the end of the file, so it only
+            # carries over if it is still the end of the file
+            tail = position + size == previous_end
+            if (not tail or (eof and size == len(buffer))) and (
+                hashlib.sha256(memoryview(buffer)[:size]).hexdigest() == digest
+            ):
+                cut = size
+        if not cut:
+            cut = find_cut_point(buffer, len(buffer))
+        yield bytes(buffer[:cut])
+        del buffer[:cut]
+        position += cut
@@ -0,0 +1,365 @@
+"""
+Deduplicating backup repository.
+
+Layout under the repository root:
+
+    config.json                 repository format and chunking parameters
+    chunks/ab/ab12...           one compressed chunk per file, named by the
+                                SHA-256 of its uncompressed content
+    snapshots/<id>.json         snapshot summary, statistics and content index
+    snapshots/<id>.files.jsonl  one file entry (path, mode, owner, chunk list)
+                                per line, ordered so every subtree is contiguous
+    tmp/                        staging for atomic writes and SQLite captures
+    lock                        held while a backup or prune runs
+
+The content index maps each backup source and each of its top-level entries
+(one per agent for /opt/ciris/agents) to a byte range of the file list, so a
+single agent's files are read without parsing the rest of the snapshot.
+
+Chunk files start with a one-byte codec tag, so repositories written with
+zstd and with the zlib fallback can be read by either.
+
+Chunks and snapshot files are fsynced before being renamed into place (and
+their directory after), so a crash never leaves a snapshot that references
+chunks which did not reach the disk. Chunks are checked against their digest
+whenever they are read.
+"""
+
+import fcntl
+import json
+import os
+import secrets
+import zlib
+from contextlib import contextmanager
+from hashlib import sha256
+from pathlib import Path
+from typing import Any, Dict, Iterator, List, Optional, Sequence
+
+from ciris_manager.backup.chunking import AVG_CHUNK_SIZE, MAX_CHUNK_SIZE, MIN_CHUNK_SIZE
+
+try:  # zstd is optional (pip install ciris-manager[backup])
+    import zstandard  # type: ignore
+except ImportError:  # pragma: no cover - depends on environment
+    zstandard = None
+
+REPOSITORY_VERSION = 1
+
+CODEC_STORED = b"\x00"
+CODEC_ZSTD = b"\x01"
+CODEC_ZLIB = b"\x02"
+
+ZSTD_LEVEL = 3
+ZLIB_LEVEL = 6
+
+# Errors a damaged chunk file can raise while decompressing
+_DECOMPRESS_ERRORS: tuple = (zlib.error, ValueError)
+if zstandard is not None:
+    _DECOMPRESS_ERRORS += (zstandard.ZstdError,)
+
+
+class RepositoryError(Exception):
+    """Raised when the repository is missing, incompatible or corrupt."""
+
+
+def compress_chunk(data: bytes) -> bytes:
+    """Compress a chunk with the best available codec, storing it raw if that is smaller."""
+    if zstandard is not None:
+        packed = CODEC_ZSTD + zstandard.ZstdCompressor(level=ZSTD_LEVEL).compress(data)
+    else:
+        packed = CODEC_ZLIB + zlib.compress(data, ZLIB_LEVEL)
+    if len(packed) > len(data):
+        return CODEC_STORED + data
+    return packed
+
+
+def decompress_chunk(blob: bytes) -> bytes:
+    """Decompress a chunk file's contents."""
+    codec, payload = blob[:1], blob[1:]
+    if codec == CODEC_STORED:
+        return payload
+    if codec == CODEC_ZLIB:
+        return zlib.decompress(payload)
+    if codec == CODEC_ZSTD:
+        if zstandard is None:
+            raise RepositoryError("Chunk is zstd-compressed but zstandard is not installed")
+        return bytes(zstandard.ZstdDecompressor().decompress(payload))
+    raise RepositoryError(f"Unknown chunk codec {codec!r}")
+
+
+def _fsync_dir(path: Path) -> None:
+    """Persist renames and new entries in a directory."""
+    fd = os.open(path, os.O_RDONLY | os.O_DIRECTORY)
+    try:
+        os.fsync(fd)
+    finally:
+        os.close(fd)
+
+
+def _path_key(path: str) -> List[str]:
+    # Sorting by components keeps "agent/..." contiguous ("agent-2" sorts after it)
+    return path.split("/")
+
+
+def is_under(path: str, prefix: str) -> bool:
+    """Whether path is prefix or lies inside it."""
+    prefix = prefix.rstrip("/") or "/"
+    return path == prefix or path.startswith(prefix if prefix == "/" else prefix + "/")
+
+
+def _index_keys(path: str, sources: Sequence[str]) -> List[str]:
+    """Indexed paths (sources and their top-level entries) that contain path."""
+    keys = []
+    for source in sources:
+        if is_under(path, source):
+            keys.append(source)
+            rest = path[len(source) :].lstrip("/")
+            if rest:
+                keys.append(f"{source.rstrip('/')}/{rest.split('/')[0]}")
+    return keys
+
+
+class BackupRepository:
+    """Content-addressed chunk store and snapshot manifests."""
+
+    def __init__(self, root: Path):
+        """
+        Initialize repository handle.
+
+        Args:
+            root: Repository directory
+        """
+        self.root = root
+        self.chunks_dir = root / "chunks"
+        self.snapshots_dir = root / "snapshots"
+        self.tmp_dir = root / "tmp"
+        self.config_path = root / "config.json"
+
+    def init(self) -> None:
+        """Create the repository if needed and check its format."""
+        for directory in (self.chunks_dir, self.snapshots_dir, self.tmp_dir):
+            directory.mkdir(parents=True, exist_ok=True)
+        chunking = {"min": MIN_CHUNK_SIZE, "avg": AVG_CHUNK_SIZE, "max": MAX_CHUNK_SIZE}
+        if not self.config_path.exists():
+            self._write_json(
+                self.config_path, {"version": REPOSITORY_VERSION, "chunking": chunking}
+            )
+            return
+        config = json.loads(self.config_path.read_text())
+        if config.get("version") != REPOSITORY_VERSION:
+            raise RepositoryError(f"Unsupported repository version {config.get('version')}")
+        if config.get("chunking") != chunking:
+            # Different boundaries would silently defeat deduplication
+            raise RepositoryError("Repository was created with different chunking parameters")
+
+    @contextmanager
+    def lock(self, shared: bool = False) -> Iterator[None]:
+        """
+        Hold the repository lock.
+
+        Args:
+            shared: Take a shared lock, for readers that must not see chunks
+                disappear (restores may run together, but not alongside a
+                backup or prune); otherwise one writer at a time
+        """
+        self.root.mkdir(parents=True, exist_ok=True)
+        mode = fcntl.LOCK_SH if shared else fcntl.LOCK_EX
+        with open(self.root / "lock", "w") as f:
+            try:
+                fcntl.flock(f.fileno(), mode | fcntl.LOCK_NB)
+            except BlockingIOError:
+                raise RepositoryError(f"Repository {self.root} is locked by another process")
+            try:
+                yield
+            finally:
+                fcntl.flock(f.fileno(), fcntl.LOCK_UN)
+
+    def chunk_path(self, digest: str) -> Path:
+        """Path of a chunk file."""
+        return self.chunks_dir / digest[:2] / digest
+
+    def has_chunk(self, digest: str) -> bool:
+        """Whether a chunk is stored."""
+        return self.chunk_path(digest).exists()
+
+    def write_chunk(self, digest: str, data: bytes) -> int:
+        """
+        Compress and store a chunk (atomic; concurrent writers of the same chunk are safe).
+
+        Args:
+            digest: SHA-256 hex digest of data
+            data: Uncompressed chunk
+
+        Returns:
+            Bytes written to disk
+        """
+        path = self.chunk_path(digest)
+        path.parent.mkdir(exist_ok=True)
+        packed = compress_chunk(data)
+        staging = self.tmp_dir / f"{digest}.{secrets.token_hex(4)}"
+        with open(staging, "wb") as f:
+            f.write(packed)
+            f.flush()
+            os.fsync(f.fileno())
+        os.replace(staging, path)
+        _fsync_dir(path.parent)
+        return len(packed)
+
+    def read_chunk(self, digest: str) -> bytes:
+        """
+        Read and decompress a chunk.
+
+        Raises:
+            RepositoryError: If the chunk is missing or does not match its digest
+        """
+        try:
+            data = decompress_chunk(self.chunk_path(digest).read_bytes())
+        except FileNotFoundError:
+            raise RepositoryError(f"Missing chunk {digest}")
+        except _DECOMPRESS_ERRORS as e:
+            raise RepositoryError(f"Corrupt chunk {digest}: {e}")
+        if sha256(data).hexdigest() != digest:
+            raise RepositoryError(f"Corrupt chunk {digest}: content does not match digest")
+        return data
+
+    def iter_chunk_digests(self) -> Iterator[str]:
+        """All stored chunk digests."""
+        if not self.chunks_dir.exists():
+            return
+        for prefix in self.chunks_dir.iterdir():
+            if prefix.is_dir():
+                for chunk in prefix.iterdir():
+                    yield chunk.name
+
+    def save_snapshot(self, manifest: Dict[str, Any]) -> None:
+        """
+        Write a snapshot (atomic: the summary is written last and marks it complete).
+
+        Args:
+            manifest: Snapshot summary plus its "files" entries
+        """
+        snapshot_id = manifest["id"]
+        files = sorted(manifest.get("files", []), key=lambda e: _path_key(e["path"]))
+        sources = manifest.get("sources", [])
+        index: Dict[str, Dict[str, int]] = {}
+        staging = self.tmp_dir / f"{snapshot_id}.files.{secrets.token_hex(4)}"
+        offset = 0
+        with open(staging, "wb") as f:
+            for entry in files:
+                line = json.dumps(entry).encode() + b"\n"
+                f.write(line)
+                for key in _index_keys(entry["path"], sources):
+                    item = index.setdefault(key, {"offset": offset, "files": 0, "bytes": 0})
+                    item["length"] = offset + len(line) - item["offset"]
+                    if entry["type"] == "file":
+                        item["files"] += 1
+                        item["bytes"] += entry.get("size", 0)
+                offset += len(line)
+            f.flush()
+            os.fsync(f.fileno())
+        os.replace(staging, self._files_path(snapshot_id))
+        summary = {k: v for k, v in manifest.items() if k != "files"}
+        summary["index"] = index
+        self._write_json(self.snapshots_dir / f"{snapshot_id}.json", summary)
+
+    def load_snapshot(self, snapshot_id: str) -> Dict[str, Any]:
+        """Load a snapshot summary with all of its file entries."""
+        manifest = self.load_summary(snapshot_id)
+        manifest["files"] = list(self.iter_snapshot_files(snapshot_id))
+        return manifest
+
+    def load_summary(self, snapshot_id: str) -> Dict[str, Any]:
+        """Load a snapshot summary and content index (without file entries)."""
+        path = self.snapshots_dir / f"{snapshot_id}.json"
+        if not path.exists():
+            raise RepositoryError(f"Snapshot {snapshot_id} not found")
+        data: Dict[str, Any] = json.loads(path.read_text())
+        return data
+
+    def iter_snapshot_files(
+        self, snapshot_id: str, paths: Optional[Sequence[str]] = None
+    ) -> Iterator[Dict[str, Any]]:
+        """
+        File entries of a snapshot, parents before their contents.
+
+        Paths inside an indexed entry are read from its byte range only.
+
+        Args:
+            snapshot_id: Snapshot to read
+            paths: Only entries at or below these absolute paths (default: all)
+
+        Yields:
+            File entries
+        """
+        summary = self.load_summary(snapshot_id)
+        files_path = self._files_path(snapshot_id)
+        if "files" in summary or not files_path.exists():
+            # Written before snapshots had a separate file list
+            for entry in sorted(summary.get("files", []), key=lambda e: _path_key(e["path"])):
+                if not paths or any(is_under(entry["path"], p) for p in paths):
+                    yield entry
+            return
+
+        index: Dict[str, Dict[str, int]] = summary.get("index", {})
+        with open(files_path, "rb") as f:
+            if not paths:
+                for line in f:
+                    yield json.loads(line)
+                return
+            seen = set()
+            for prefix in paths:
+                ancestors = [k for k in index if is_under(prefix, k)]
+                if ancestors:
+                    item = index[max(ancestors, key=len)]
+                    f.seek(item["offset"])
+                    lines = f.read(item["length"]).splitlines()
+                else:
+                    f.seek(0)
+                    lines = f.read().splitlines()
+                for line in lines:
+                    entry = json.loads(line)
+                    if is_under(entry["path"], prefix) and entry["path"] not in seen:
+                        seen.add(entry["path"])
+                        yield entry
+
+    def delete_snapshot(self, snapshot_id: str) -> None:
+        """Delete a snapshot (chunks are reclaimed by garbage collection)."""
+        (self.snapshots_dir / f"{snapshot_id}.json").unlink(missing_ok=True)
+        self._files_path(snapshot_id).unlink(missing_ok=True)
+
+    def list_snapshots(self) -> List[Dict[str, Any]]:
+        """Snapshot summaries (without file lists or index), oldest first."""
+        if not self.snapshots_dir.exists():
+            return []
+        summaries = []
+        for path in self.snapshots_dir.glob("*.json"):
+            summary = json.loads(path.read_text())
+            summary.pop("files", None)
+            summary.pop("index", None)
+            summaries.append(summary)
+        return sorted(summaries, key=lambda s: s.get("created_at", ""))
+
+    def latest_snapshot(self) -> Optional[Dict[str, Any]]:
+        """The most recent snapshot manifest, if any."""
+        snapshots = self.list_snapshots()
+        return self.load_snapshot(snapshots[-1]["id"]) if snapshots else None
+
+    def resolve_snapshot(self, snapshot_id: str) -> str:
+        """Resolve "latest" to the newest snapshot id."""
+        if snapshot_id != "latest":
+            return snapshot_id
+        snapshots = self.list_snapshots()
+        if not snapshots:
+            raise RepositoryError("Repository has no snapshots")
+        return str(snapshots[-1]["id"])
+
+    def _files_path(self, snapshot_id: str) -> Path:
+        return self.snapshots_dir / f"{snapshot_id}.files.jsonl"
+
+    def _write_json(self, path: Path, data: Dict[str, Any]) -> None:
+        staging = path.with_suffix(".tmp")
+        with open(staging, "w") as f:
+            json.dump(data, f)
+            f.flush()
+            os.fsync(f.fileno())
+        os.replace(staging, path)
+        _fsync_dir(path.parent)
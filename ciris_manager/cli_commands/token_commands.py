@@ -156,9 +156,9 @@ def handle_token_rotate(args):
             print(f"⚠ Rotated {success_count}/{total_count} agent tokens")
 
             # Show failures
-            for agent_id, result in results.items():
+            for key, result in results.items():
                 if not result.success:
-                    print(f"  ✗ {agent_id}: {result.error_message}")
+                    print(f"  ✗ {key.agent_id} ({key.server_id}): {result.error_message}")
 
             if success_count < total_count:
                 print("\nTo restore from backup:")
@@ -4,14 +4,21 @@ Docker Compose file generator for CIRIS agents.
 Generates individual docker-compose.yml files for each agent.
 """
 
+import hashlib
 import yaml
 import logging
+from dataclasses import dataclass, field
 from datetime import datetime, timezone
 from pathlib import Path
 from typing import Dict, Any, List, Optional, Union
 
 logger = logging.getLogger(__name__)
 
+# Values stamped with the generation time; carried over from the existing file
+# so that regenerating an unchanged agent produces byte-identical output.
+VOLATILE_ENV_KEYS = ("CIRIS_ACCORD_METRICS_CONSENT_TIMESTAMP",)
+VOLATILE_LABELS = ("ai.ciris.agents.created",)
+
 
 def normalize_compose_env(env: Union[Dict[str, Any], List[str], None]) -> Dict[str, str]:
     """Normalize a Docker Compose `environment:` field to a dict.
@@ -40,6 +47,99 @@ def normalize_compose_env(env: Union[Dict[str, Any], List[str], None]) -> Dict[s
     raise TypeError(f"Unsupported environment type: {type(env).__name__}")
 
 
+def carry_over_volatile_fields(new: Dict[str, Any], existing: Optional[Dict[str, Any]]) -> None:
+    """
+    Copy generation timestamps from an existing compose config into a new one.
+
+    Args:
+        new: Freshly generated compose config (modified in place)
+        existing: Compose config currently on disk, if any
+    """
+    if not existing:
+        return
+    old_services = existing.get("services") or {}
+    for name, service in (new.get("services") or {}).items():
+        old_service = old_services.get(name)
+        if not isinstance(old_service, dict):
+            continue
+
+        old_labels = old_service.get("labels")
+        labels = service.get("labels")
+        if isinstance(old_labels, dict) and isinstance(labels, dict):
+            for key in VOLATILE_LABELS:
+                if key in old_labels and key in labels:
+                    labels[key] = old_labels[key]
+
+        env = service.get("environment")
+        if isinstance(env, dict):
+            old_env = normalize_compose_env(old_service.get("environment"))
+            for key in VOLATILE_ENV_KEYS:
+                if key in old_env and key in env:
+                    env[key] = old_env[key]
+
+
+def _content_hash(content: Union[str, bytes]) -> str:
+    if isinstance(content, str):
+        content = content.encode()
+    return hashlib.sha256(content).hexdigest()
+
+
+def _file_hash(path: Path) -> Optional[str]:
+    try:
+        return _content_hash(path.read_bytes())
+    except FileNotFoundError:
+        return None
+
+
+def write_if_changed(path: Path, content: str) -> bool:
+    """
+    Write a file only if its content differs from what is on disk.
+
+    The file is rewritten in place rather than replaced, so ownership set up by
+    the privileged helper is kept.
+
+    Args:
+        path: File to write
+        content: New file content
+
+    Returns:
+        True if the file was written
+    """
+    if _file_hash(path) == _content_hash(content):
+        return False
+
+    path.parent.mkdir(parents=True, exist_ok=True)
+    with open(path, "w") as f:
+        f.write(content)
+    return True
+
+
+@dataclass
+class ComposeRequest:
+    """One agent's input to ComposeGenerator.generate_batch."""
+
+    agent_id: str
+    compose_path: Path
+    params: Dict[str, Any]  # generate_compose keyword arguments, without agent_id
+    env_vars: Optional[Dict[str, str]] = None
+    env_path: Optional[Path] = None
+
+
+@dataclass
+class ComposeChangeSet:
+    """Outcome of a batch compose generation."""
+
+    changed: List[str] = field(default_factory=list)
+    unchanged: List[str] = field(default_factory=list)
+    failed: Dict[str, str] = field(default_factory=dict)
+    configs: Dict[str, Dict[str, Any]] = field(default_factory=dict)
+    hashes: Dict[str, str] = field(default_factory=dict)
+
+    def is_changed(self, agent_id: str) -> bool:
+        """Whether an agent's files changed and its container needs a restart."""
+        return agent_id in self.changed
+
+
 class ComposeGenerator:
     """Generates Docker Compose configurations for agents."""
 
@@ -345,36 +445,114 @@ class ComposeGenerator:
             if effective_base:
                 env["CIRIS_OPENAI_API_BASE_2"] = effective_base
 
-    def write_compose_file(self, compose_config: Dict[str, Any], compose_path: Path) -> None:
+    @staticmethod
+    def render_compose(compose_config: Dict[str, Any]) -> str:
+        """Render a compose configuration as YAML."""
+        return yaml.dump(compose_config, default_flow_style=False, sort_keys=False, width=120)
+
+    @staticmethod
+    def render_env_file(env_vars: Dict[str, str]) -> str:
+        """Render environment variables in .env format."""
+        lines = []
+        for key, value in env_vars.items():
+            # Quote values that contain spaces
+            if " " in value:
+                value = f'"{value}"'
+            lines.append(f"{key}={value}\n")
+        return "".join(lines)
+
+    def write_compose_file(self, compose_config: Dict[str, Any], compose_path: Path) -> bool:
         """
-        Write compose configuration to file.
+        Write compose configuration to file, unless it is already up to date.
 
         Args:
             compose_config: Docker compose configuration
             compose_path: Path to write the file
-        """
-        # Ensure directory exists
-        compose_path.parent.mkdir(parents=True, exist_ok=True)
 
-        # Write with proper formatting
-        with open(compose_path, "w") as f:
-            yaml.dump(compose_config, f, default_flow_style=False, sort_keys=False, width=120)
+        Returns:
+            True if the file was written, False if its content was unchanged
+        """
+        if not write_if_changed(compose_path, self.render_compose(compose_config)):
+            logger.debug(f"docker-compose.yml unchanged at {compose_path}")
+            return False
 
         logger.info(f"Wrote docker-compose.yml to {compose_path}")
+        return True
 
-    def generate_env_file(self, env_vars: Dict[str, str], env_path: Path) -> None:
+    def generate_env_file(self, env_vars: Dict[str, str], env_path: Path) -> bool:
         """
         Generate .env file for sensitive environment variables.
 
         Args:
             env_vars: Environment variables
             env_path: Path to .env file
+
+        Returns:
+            True if the file was written, False if its content was unchanged
         """
-        with open(env_path, "w") as f:
-            for key, value in env_vars.items():
-                # Quote values that contain spaces
-                if " " in value:
-                    value = f'"{value}"'
-                f.write(f"{key}={value}\n")
+        if not write_if_changed(env_path, self.render_env_file(env_vars)):
+            logger.debug(f".env unchanged at {env_path}")
+            return False
 
         logger.info(f"Wrote .env file to {env_path}")
+        return True
+
+    def generate_batch(
+        self, requests: List[ComposeRequest], dry_run: bool = False
+    ) -> ComposeChangeSet:
+        """
+        Generate compose (and optional .env) files for many agents at once.
+
+        Each rendered file is compared with the content on disk, and only files
+        whose content changed are written. Generation timestamps are carried
+        over from the existing compose file so an agent whose configuration did
+        not change is reported as unchanged and needs no restart.
+
+        Args:
+            requests: One request per agent
+            dry_run: Compute the change set without writing anything
+
+        Returns:
+            ComposeChangeSet listing changed, unchanged and failed agents
+        """
+        changes = ComposeChangeSet()
+        for request in requests:
+            agent_id = request.agent_id
+            try:
+                compose_config = self.generate_compose(agent_id=agent_id, **request.params)
+                existing = _read_yaml(request.compose_path)
+                carry_over_volatile_fields(compose_config, existing)
+
+                compose_content = self.render_compose(compose_config)
+                files = [(request.compose_path, compose_content)]
+                if request.env_vars is not None and request.env_path is not None:
+                    files.append((request.env_path, self.render_env_file(request.env_vars)))
+
+                if dry_run:
+                    changed = any(_file_hash(path) != _content_hash(c) for path, c in files)
+                else:
+                    # Evaluate every file; any() would stop at the first write
+                    changed = any([write_if_changed(path, c) for path, c in files])
+            except Exception as e:
+                logger.error(f"Failed to generate compose for {agent_id}: {e}")
+                changes.failed[agent_id] = str(e)
+                continue
+
+            changes.configs[agent_id] = compose_config
+            changes.hashes[agent_id] = _content_hash(compose_content)
+            (changes.changed if changed else changes.unchanged).append(agent_id)
+
+        logger.info(
+            f"Compose batch: {len(changes.changed)} changed, {len(changes.unchanged)} unchanged, "
+            f"{len(changes.failed)} failed{' (dry run)' if dry_run else ''}"
+        )
+        return changes
+
+
+def _read_yaml(path: Path) -> Optional[Dict[str, Any]]:
+    try:
+        with open(path) as f:
+            data = yaml.safe_load(f)
+    except FileNotFoundError:
+        return None
+    return data if isinstance(data, dict) else None
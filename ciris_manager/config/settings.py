@@ -20,6 +20,10 @@ class UpdateConfig(BaseModel):
 
     check_interval: int = Field(default=300, description="Seconds between update checks")
     auto_notify: bool = Field(default=True, description="Automatically notify agents of updates")
+    prestage_containers: bool = Field(
+        default=False,
+        description="Build replacement containers while agents shut down to cut update downtime",
+    )
 
 
 class ContainerConfig(BaseModel):
@@ -71,6 +75,16 @@ class ManagerConfig(BaseModel):
         default="/etc/ciris-manager/pre-approved-templates.json",
         description="Path to pre-approved templates manifest",
     )
+    prewarm_template_checksums: bool = Field(
+        default=True, description="Hash all templates at startup so agent creation skips it"
+    )
+    fast_startup: bool = Field(
+        default=False,
+        description=(
+            "Serve from the startup snapshot right away and reconcile agent directories, "
+            "Docker connections, discovery and nginx in the background"
+        ),
+    )
 
 
 class NginxConfig(BaseModel):
@@ -118,6 +132,13 @@ class ServerConfig(BaseModel):
     tls_key: Optional[str] = Field(
         default=None, description="Path to TLS client key for Docker API"
     )
+    agent_host_port: Optional[int] = Field(
+        default=None,
+        description=(
+            "Port of the agent-host sidecar (ciris-agent-host.service) for file operations, "
+            "authenticated with the Docker API certificates; None uses the Docker API"
+        ),
+    )
 
 
 class CIRISManagerConfig(BaseModel):
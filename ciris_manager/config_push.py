@@ -0,0 +1,156 @@
+"""
+Live configuration push for running agents.
+
+Adapter and LLM settings reach an agent as environment variables in its
+compose file, which normally means recreating the container. Most of those
+changes are a handful of env vars, so instead the manager sends running agents
+a versioned config document over the agent API and waits for it to be
+acknowledged. Any other compose change (image, volumes, labels, healthcheck,
+...) still requires a recreate.
+
+Values pushed live are not part of the container's own configuration, so
+restarting the container would revert them. The manager records the push and
+recreates the agent from its compose file instead of restarting it.
+"""
+
+import logging
+from dataclasses import dataclass, field
+from datetime import datetime, timezone
+from typing import Any, Dict, List, Optional
+
+from ciris_manager.agent_http import get_agent_http_client
+from ciris_manager.compose_generator import normalize_compose_env
+
+logger = logging.getLogger(__name__)
+
+# Agent endpoint that accepts live config documents
+LIVE_CONFIG_ENDPOINT = "/v1/system/config/live"
+
+# Service keys a running agent can apply live; a change to any other key
+# requires recreating the container
+LIVE_KEYS = ("environment",)
+
+
+@dataclass
+class ConfigChange:
+    """Difference between an agent's current and regenerated compose service."""
+
+    env_changes: Dict[str, Optional[str]] = field(default_factory=dict)  # None = removed
+    recreate_fields: List[str] = field(default_factory=list)
+
+    @property
+    def requires_recreate(self) -> bool:
+        """Whether the change cannot be applied to the running container."""
+        return bool(self.recreate_fields)
+
+
+@dataclass
+class ConfigPushResult:
+    """Outcome of pushing a config document to an agent."""
+
+    acknowledged: bool
+    version: int
+    supported: bool = True
+    error: Optional[str] = None
+
+
+def diff_service_config(old: Dict[str, Any], new: Dict[str, Any]) -> ConfigChange:
+    """
+    Compare two compose service definitions.
+
+    Args:
+        old: Service config currently deployed
+        new: Regenerated service config
+
+    Returns:
+        ConfigChange listing env var changes and fields that need a recreate
+    """
+    old_env = normalize_compose_env(old.get("environment"))
+    new_env = normalize_compose_env(new.get("environment"))
+
+    env_changes: Dict[str, Optional[str]] = {
+        key: value for key, value in new_env.items() if old_env.get(key) != value
+    }
+    env_changes.update({key: None for key in old_env if key not in new_env})
+
+    recreate_fields = sorted(
+        key for key in set(old) | set(new) if key not in LIVE_KEYS and old.get(key) != new.get(key)
+    )
+    return ConfigChange(env_changes=env_changes, recreate_fields=recreate_fields)
+
+
+class AgentConfigPusher:
+    """Delivers versioned config documents to running agents."""
+
+    def __init__(self, timeout: float = 10.0):
+        """
+        Initialize config pusher.
+
+        Args:
+            timeout: Seconds to wait for the agent to apply and acknowledge
+        """
+        self.timeout = timeout
+
+    @staticmethod
+    def build_document(version: int, env_changes: Dict[str, Optional[str]]) -> Dict[str, Any]:
+        """Build the config document sent to the agent."""
+        return {
+            "version": version,
+            "issued_at": datetime.now(timezone.utc).isoformat(),
+            "environment": {k: v for k, v in env_changes.items() if v is not None},
+            "removed": sorted(k for k, v in env_changes.items() if v is None),
+        }
+
+    async def push(
+        self,
+        base_url: str,
+        headers: Dict[str, str],
+        version: int,
+        env_changes: Dict[str, Optional[str]],
+    ) -> ConfigPushResult:
+        """
+        Push a config document and wait for the agent's acknowledgment.
+
+        The agent acknowledges by echoing the version it applied. Agents that
+        predate the endpoint answer 404/405 and are reported as unsupported so
+        callers can fall back to a restart.
+
+        Args:
+            base_url: Agent API base URL
+            headers: Agent auth headers
+            version: Config version being delivered
+            env_changes: Environment changes (None values are removals)
+
+        Returns:
+            ConfigPushResult
+        """
+        document = self.build_document(version, env_changes)
+        try:
+            response = await get_agent_http_client().put(
+                f"{base_url}{LIVE_CONFIG_ENDPOINT}",
+                headers=headers,
+                json=document,
+                timeout=self.timeout,
+            )
+        except Exception as e:
+            return ConfigPushResult(False, version, error=f"Config push failed: {e}")
+
+        if response.status_code in (404, 405):
+            return ConfigPushResult(False, version, supported=False, error="Not supported")
+        if response.status_code != 200:
+            return ConfigPushResult(
+                False, version, error=f"Agent returned {response.status_code}: {response.text}"
+            )
+
+        try:
+            body = response.json()
+            data = body.get("data", body)
+            applied = data.get("applied_version")
+        except Exception:
+            applied = None
+
+        if applied != version:
+            return ConfigPushResult(
+                False, version, error=f"Agent acknowledged version {applied}, expected {version}"
+            )
+        return ConfigPushResult(True, version)
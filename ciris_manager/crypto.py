@@ -6,14 +6,84 @@ Provides encryption for sensitive data at rest using Fernet (symmetric encryptio
 
 import os
 import base64
+import hashlib
+import threading
+from collections import OrderedDict
 from cryptography.fernet import Fernet
 from cryptography.hazmat.primitives import hashes
 from cryptography.hazmat.primitives.kdf.pbkdf2 import PBKDF2HMAC
-from typing import Optional
+from typing import Dict, Optional
 import logging
 
 logger = logging.getLogger(__name__)
 
+# Derived ciphers by hash of (secret, salt), so PBKDF2 runs once per process
+_derived_ciphers: Dict[bytes, Fernet] = {}
+_derived_ciphers_lock = threading.Lock()
+
+
+class DecryptedTokenCache:
+    """
+    Bounded LRU cache of decrypted tokens keyed by ciphertext hash.
+
+    The cache's own bytearrays are overwritten when entries are evicted or
+    cleared. This is best-effort only: tokens are passed in and handed out as
+    immutable str objects, so copies stay in process memory until the
+    interpreter reuses it. It bounds how many plaintexts the cache itself
+    holds; it does not keep them out of memory.
+    """
+
+    def __init__(self, max_entries: int = 1024):
+        """
+        Initialize cache.
+
+        Args:
+            max_entries: Maximum number of decrypted tokens to keep
+        """
+        self.max_entries = max_entries
+        self._entries: "OrderedDict[bytes, bytearray]" = OrderedDict()
+        self._lock = threading.Lock()
+
+    @staticmethod
+    def _key(encrypted_token: str) -> bytes:
+        return hashlib.sha256(encrypted_token.encode()).digest()
+
+    @staticmethod
+    def _zeroize(buffer: bytearray) -> None:
+        buffer[:] = bytes(len(buffer))
+
+    def get(self, encrypted_token: str) -> Optional[str]:
+        """Get the plaintext for a ciphertext, or None if not cached."""
+        key = self._key(encrypted_token)
+        with self._lock:
+            buffer = self._entries.get(key)
+            if buffer is None:
+                return None
+            self._entries.move_to_end(key)
+            return buffer.decode()
+
+    def put(self, encrypted_token: str, token: str) -> None:
+        """Cache the plaintext for a ciphertext, evicting the least recently used entry."""
+        key = self._key(encrypted_token)
+        with self._lock:
+            previous = self._entries.pop(key, None)
+            if previous is not None:
+                self._zeroize(previous)
+            self._entries[key] = bytearray(token.encode())
+            while len(self._entries) > self.max_entries:
+                _, evicted = self._entries.popitem(last=False)
+                self._zeroize(evicted)
+
+    def clear(self) -> None:
+        """Drop every cached plaintext, overwriting the cache's buffers."""
+        with self._lock:
+            for buffer in self._entries.values():
+                self._zeroize(buffer)
+            self._entries.clear()
+
+    def __len__(self) -> int:
+        return len(self._entries)
+
 
 class TokenEncryption:
     """Handles encryption/decryption of service tokens."""
@@ -30,6 +100,7 @@ class TokenEncryption:
         else:
             # Derive key from environment secret
             self.cipher = self._get_cipher()
+        self.decrypted_cache = DecryptedTokenCache()
 
     def _get_cipher(self) -> Fernet:
         """Get or create encryption cipher from environment."""
@@ -61,16 +132,23 @@ class TokenEncryption:
             logger.error(error_msg)
             raise ValueError(error_msg)
 
-        kdf = PBKDF2HMAC(
-            algorithm=hashes.SHA256(),
-            length=32,
-            salt=salt.encode(),
-            iterations=100000,
-        )
-        key = base64.urlsafe_b64encode(kdf.derive(password.encode()))
-
-        logger.warning("Using derived encryption key. Set CIRIS_ENCRYPTION_KEY for production.")
-        return Fernet(key)
+        cache_key = hashlib.sha256(f"{len(password)}:{password}{salt}".encode()).digest()
+        with _derived_ciphers_lock:
+            cipher = _derived_ciphers.get(cache_key)
+            if cipher is None:
+                kdf = PBKDF2HMAC(
+                    algorithm=hashes.SHA256(),
+                    length=32,
+                    salt=salt.encode(),
+                    iterations=100000,
+                )
+                key = base64.urlsafe_b64encode(kdf.derive(password.encode()))
+                cipher = Fernet(key)
+                _derived_ciphers[cache_key] = cipher
+                logger.warning(
+                    "Using derived encryption key. Set CIRIS_ENCRYPTION_KEY for production."
+                )
+        return cipher
 
     def encrypt_token(self, token: str) -> str:
         """
@@ -113,13 +191,20 @@ class TokenEncryption:
                 f"got: {encrypted_token[:20]}..."
             )
 
+        cached = self.decrypted_cache.get(encrypted_token)
+        if cached is not None:
+            return cached
+
         try:
             decrypted = self.cipher.decrypt(encrypted_token.encode())
-            return str(decrypted.decode())
+            token = str(decrypted.decode())
         except Exception as e:
             logger.error(f"Token decryption failed: {e}")
             raise
 
+        self.decrypted_cache.put(encrypted_token, token)
+        return token
+
 
 # Global instance
 _token_encryption = None
@@ -21,6 +21,7 @@ Usage:
 from ciris_manager.deployment.orchestrator import (
     DeploymentOrchestrator,
     get_deployment_orchestrator,
+    set_deployment_orchestrator,
 )
 
 # Export sub-module classes
@@ -36,6 +37,7 @@ __all__ = [
     # Main orchestrator
     "DeploymentOrchestrator",
     "get_deployment_orchestrator",
+    "set_deployment_orchestrator",
     # Sub-modules
     "ContainerOperations",
     "DeploymentState",
@@ -0,0 +1,137 @@
+"""
+Adaptive canary scheduling.
+
+Uses time-to-WORK samples from recent deployments to decide how long each
+canary phase may take to reach WORK, how many agents must be stable before a
+phase advances, and how the general population is split into growing waves.
+Without enough history the schedule falls back to the fixed defaults.
+
+A phase ends as soon as its quorum is stable (or it times out), so agents that
+had not reached WORK by then only tell us their time-to-WORK was longer than
+the phase lasted. Those right-censored observations are kept and percentiles
+use the Kaplan-Meier estimate, so fast agents alone cannot shrink the wait.
+"""
+
+import math
+from typing import List, Optional, TypeVar
+
+# Samples needed before history is trusted to shorten waits
+ADAPTIVE_MIN_SAMPLES = 5
+
+# Recent completed deployments whose samples feed the estimate
+RECENT_DEPLOYMENTS = 5
+
+# Headroom over the observed p95 time-to-WORK
+WAIT_MARGIN = 1.5
+MIN_WAIT_FOR_WORK_MINUTES = 3
+
+# Observation window for incidents in later waves once history is trusted
+MIN_STABILITY_MINUTES = 0.5
+
+# A phase advances once this share of its agents (capped) is stable
+QUORUM_FRACTION = 0.1
+MAX_QUORUM = 3
+
+# General population waves: first wave share, growth per wave, minimum size
+FIRST_WAVE_FRACTION = 0.1
+WAVE_GROWTH = 3
+MIN_WAVE_SIZE = 5
+
+T = TypeVar("T")
+
+
+class CanarySchedule:
+    """Phase timing and wave sizing for one canary deployment."""
+
+    def __init__(
+        self,
+        time_to_work_samples: List[float],
+        default_wait_minutes: int,
+        censored_samples: Optional[List[float]] = None,
+    ):
+        """
+        Initialize canary schedule.
+
+        Args:
+            time_to_work_samples: Minutes from update to WORK observed in recent deployments
+            default_wait_minutes: Fixed wait used without enough history (also the ceiling)
+            censored_samples: Minutes agents were watched without reaching WORK
+        """
+        self.samples = sorted(s for s in time_to_work_samples if s >= 0)
+        self.censored = sorted(s for s in censored_samples or [] if s >= 0)
+        self.default_wait_minutes = default_wait_minutes
+
+    @property
+    def confident(self) -> bool:
+        """Whether there is enough history to adapt the schedule."""
+        return len(self.samples) >= ADAPTIVE_MIN_SAMPLES
+
+    def percentile(self, q: float) -> Optional[float]:
+        """
+        Time-to-WORK percentile in minutes (Kaplan-Meier over censored samples).
+
+        Returns None without samples, or when too many agents were censored to
+        know where the percentile lies.
+        """
+        if not self.samples:
+            return None
+        events = [(t, 1) for t in self.samples] + [(t, 0) for t in self.censored]
+        # At equal times, events happen before censoring (censored agents are still at risk)
+        events.sort(key=lambda event: (event[0], -event[1]))
+        at_risk = len(events)
+        survival = 1.0
+        for t, observed in events:
+            if observed:
+                survival *= 1 - 1 / at_risk
+                if 1 - survival >= q - 1e-9:
+                    return t
+            at_risk -= 1
+        return None
+
+    def wait_for_work_minutes(self) -> float:
+        """How long a phase may take to reach WORK before it is declared failed."""
+        p95 = self.percentile(0.95)
+        if not self.confident or p95 is None:
+            return self.default_wait_minutes
+        adaptive = math.ceil(p95 * WAIT_MARGIN)
+        return min(self.default_wait_minutes, max(MIN_WAIT_FOR_WORK_MINUTES, adaptive))
+
+    def required_stable(self, group_size: int) -> int:
+        """Number of agents that must be stable in WORK before the phase advances."""
+        quorum = math.ceil(group_size * QUORUM_FRACTION)
+        return max(1, min(group_size, quorum, MAX_QUORUM))
+
+    def stability_minutes(self, wave_index: int) -> float:
+        """
+        Time an agent must stay in WORK to count as stable.
+
+        This is also the window checked for critical incidents, so it never
+        drops to zero. Later general waves use a shorter window once the
+        release has proven stable in earlier phases and history confirms
+        normal timing.
+        """
+        return MIN_STABILITY_MINUTES if wave_index > 0 and self.confident else 1
+
+    def plan_waves(self, agents: List[T]) -> List[List[T]]:
+        """
+        Split the general population into waves that grow as confidence grows.
+
+        Args:
+            agents: General population agents
+
+        Returns:
+            Waves in rollout order (a single wave for small groups)
+        """
+        fraction = FIRST_WAVE_FRACTION * (2 if self.confident else 1)
+        size = max(MIN_WAVE_SIZE, math.ceil(len(agents) * fraction))
+        waves: List[List[T]] = []
+        start = 0
+        while start < len(agents):
+            # Fold a remainder smaller than this wave into it
+            end = start + size
+            if len(agents) - end < size:
+                end = len(agents)
+            waves.append(agents[start:end])
+            start = end
+            size *= WAVE_GROWTH
+        return waves
@@ -0,0 +1,256 @@
+"""
+Deployment history archive.
+
+Only active and recent deployments stay in the orchestrator's state file.
+Older finished deployments are moved into month partitions under
+<state_dir>/deployment_history:
+
+    2026-10.jsonl         full DeploymentStatus records, one per line
+    2026-10.index.jsonl   one summary per record, used to answer queries
+
+Queries read index files only, newest partition first, and skip partitions
+outside the requested time range, so their cost follows the page asked for
+rather than the total history size.
+"""
+
+import json
+import logging
+from pathlib import Path
+from typing import Any, Dict, Iterable, List, Optional
+
+from ciris_manager.models import DeploymentStatus
+
+logger = logging.getLogger(__name__)
+
+# Finished deployments kept in memory (and in the state file)
+HOT_DEPLOYMENTS = 20
+
+# Deployments that are never archived
+ACTIVE_STATUSES = {"pending", "in_progress", "paused", "rolling_back"}
+
+# Partition for deployments without any timestamp
+UNDATED_PARTITION = "undated"
+
+# Fields returned by history queries
+SUMMARY_FIELDS = (
+    "deployment_id",
+    "started_at",
+    "completed_at",
+    "status",
+    "message",
+    "agents_total",
+    "agents_updated",
+    "agents_failed",
+)
+
+
+def deployment_time(deployment: DeploymentStatus) -> str:
+    """ISO timestamp a deployment is ordered and partitioned by."""
+    return deployment.started_at or deployment.staged_at or deployment.completed_at or ""
+
+
+def deployment_agents(deployment: DeploymentStatus) -> List[str]:
+    """Agents a deployment touched (canary assignments, restarts and events)."""
+    agents = set(deployment.agents_pending_restart) | set(deployment.agents_in_progress)
+    for group in (deployment.canary_assignments or {}).values():
+        agents.update(group)
+    for event in deployment.events:
+        agent_id = (event.get("details") or {}).get("agent_id")
+        if agent_id:
+            agents.add(agent_id)
+    return sorted(agents)
+
+
+def summarize(deployment: DeploymentStatus) -> Dict[str, Any]:
+    """
+    Build the history summary of a deployment.
+
+    Args:
+        deployment: Deployment to summarize
+
+    Returns:
+        Summary fields plus the sort timestamp and touched agents
+    """
+    summary: Dict[str, Any] = {name: getattr(deployment, name) for name in SUMMARY_FIELDS}
+    summary["timestamp"] = deployment_time(deployment)
+    summary["agents"] = deployment_agents(deployment)
+    return summary
+
+
+def matches(
+    summary: Dict[str, Any],
+    status: Optional[str] = None,
+    agent_id: Optional[str] = None,
+    since: Optional[str] = None,
+    until: Optional[str] = None,
+) -> bool:
+    """
+    Check a summary against history filters.
+
+    Args:
+        summary: Summary from summarize()
+        status: Only this deployment status
+        agent_id: Only deployments that touched this agent
+        since: Only deployments at or after this ISO timestamp
+        until: Only deployments before this ISO timestamp
+
+    Returns:
+        True if the summary passes every filter
+    """
+    if status and summary.get("status") != status:
+        return False
+    if agent_id and agent_id not in summary.get("agents", []):
+        return False
+    timestamp = summary.get("timestamp") or ""
+    if since and timestamp < since:
+        return False
+    if until and (not timestamp or timestamp >= until):
+        return False
+    return True
+
+
+def public_summary(summary: Dict[str, Any]) -> Dict[str, Any]:
+    """Summary with only the fields returned by history queries."""
+    return {name: summary.get(name) for name in SUMMARY_FIELDS}
+
+
+class DeploymentHistoryArchive:
+    """Append-only, month-partitioned archive of finished deployments."""
+
+    def __init__(self, archive_dir: Path) -> None:
+        """
+        Initialize deployment history archive.
+
+        Args:
+            archive_dir: Directory holding the partition files
+        """
+        self.archive_dir = archive_dir
+
+    @staticmethod
+    def _partition(timestamp: str) -> str:
+        return timestamp[:7] if len(timestamp) >= 7 else UNDATED_PARTITION
+
+    def _partitions(self) -> List[str]:
+        """Partition keys, newest first (undated last)."""
+        if not self.archive_dir.exists():
+            return []
+        keys = sorted(
+            (p.name[: -len(".index.jsonl")] for p in self.archive_dir.glob("*.index.jsonl")),
+            reverse=True,
+        )
+        return [k for k in keys if k != UNDATED_PARTITION] + [
+            k for k in keys if k == UNDATED_PARTITION
+        ]
+
+    def _read_index(self, partition: str) -> List[Dict[str, Any]]:
+        """Summaries of one partition, newest first (last write wins on duplicates)."""
+        summaries: Dict[str, Dict[str, Any]] = {}
+        index_file = self.archive_dir / f"{partition}.index.jsonl"
+        try:
+            with open(index_file, "r") as f:
+                for line in f:
+                    if line.strip():
+                        summary = json.loads(line)
+                        summaries[summary["deployment_id"]] = summary
+        except (OSError, ValueError) as e:
+            logger.warning(f"Failed to read deployment history index {index_file}: {e}")
+        return sorted(summaries.values(), key=lambda s: s.get("timestamp") or "", reverse=True)
+
+    def archive(self, deployments: Iterable[DeploymentStatus]) -> int:
+        """
+        Append deployments to their month partitions.
+
+        Records are written before their index lines, so a crash never leaves
+        an index entry without a record. A deployment archived twice (crash
+        before the state file was rewritten) is de-duplicated on read.
+
+        Args:
+            deployments: Finished deployments to archive
+
+        Returns:
+            Number of deployments archived
+
+        Raises:
+            OSError: If the archive cannot be written
+        """
+        by_partition: Dict[str, List[DeploymentStatus]] = {}
+        for deployment in deployments:
+            partition = self._partition(deployment_time(deployment))
+            by_partition.setdefault(partition, []).append(deployment)
+        if not by_partition:
+            return 0
+
+        self.archive_dir.mkdir(parents=True, exist_ok=True)
+        count = 0
+        for partition, batch in by_partition.items():
+            with open(self.archive_dir / f"{partition}.jsonl", "a") as f:
+                for deployment in batch:
+                    f.write(json.dumps(deployment.model_dump()) + "\n")
+            with open(self.archive_dir / f"{partition}.index.jsonl", "a") as f:
+                for deployment in batch:
+                    f.write(json.dumps(summarize(deployment)) + "\n")
+            count += len(batch)
+        return count
+
+    def query(
+        self,
+        limit: int = 10,
+        offset: int = 0,
+        status: Optional[str] = None,
+        agent_id: Optional[str] = None,
+        since: Optional[str] = None,
+        until: Optional[str] = None,
+    ) -> List[Dict[str, Any]]:
+        """
+        Page through archived deployment summaries, newest first.
+
+        Args:
+            limit: Maximum summaries to return
+            offset: Matching summaries to skip
+            status: Only this deployment status
+            agent_id: Only deployments that touched this agent
+            since: Only deployments at or after this ISO timestamp
+            until: Only deployments before this ISO timestamp
+
+        Returns:
+            Summaries from summarize(), newest first
+        """
+        wanted = offset + limit
+        found: List[Dict[str, Any]] = []
+        for partition in self._partitions():
+            if partition != UNDATED_PARTITION:
+                if since and partition < since[:7]:
+                    break  # Every remaining partition is older
+                if until and partition > until[:7]:
+                    continue
+            elif since or until:
+                continue
+            found.extend(
+                s for s in self._read_index(partition) if matches(s, status, agent_id, since, until)
+            )
+            if len(found) >= wanted:
+                break
+        return found[offset:wanted]
+
+    def get(self, deployment_id: str) -> Optional[DeploymentStatus]:
+        """
+        Load an archived deployment with its full event timeline.
+
+        Args:
+            deployment_id: Deployment to load
+
+        Returns:
+            Archived deployment or None
+        """
+        for partition in self._partitions():
+            if not any(s["deployment_id"] == deployment_id for s in self._read_index(partition)):
+                continue
+            record = None
+            with open(self.archive_dir / f"{partition}.jsonl", "r") as f:
+                for line in f:
+                    if deployment_id in line:
+                        data = json.loads(line)
+                        if data.get("deployment_id") == deployment_id:
+                            record = data
+            return DeploymentStatus(**record) if record else None
+        return None
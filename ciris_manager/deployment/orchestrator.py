@@ -17,13 +17,17 @@ import asyncio
 import json
 import logging
 import os
+import shutil
 from datetime import datetime, timezone
 from pathlib import Path
-from typing import Dict, List, Optional, Any, cast
+from typing import Dict, List, Optional, Any, Set, cast
 from uuid import uuid4
 import httpx
 import aiofiles  # type: ignore
 
+from ciris_manager.agent_http import AgentHTTPClient, get_agent_http_client
+from ciris_manager.compose_generator import ComposeGenerator, write_if_changed
+from ciris_manager.manifest_cache import get_manifest_cache
 from ciris_manager.agent_auth import get_agent_auth
 from ciris_manager.models import (
     AgentInfo,
@@ -33,7 +37,13 @@ from ciris_manager.models import (
 )
 from ciris_manager.docker_registry import DockerRegistryClient
 from ciris_manager.utils.compose_command import compose_cmd
+from ciris_manager.utils.agent_host import (
+    AgentHostError,
+    AgentHostUnavailableError,
+    get_agent_host,
+)
 from ciris_manager.utils.log_sanitizer import sanitize_agent_id, sanitize_for_log
+from ciris_manager.utils.permission_helper import fix_agent_permissions
 
 # Import from helper modules
 from ciris_manager.deployment.helpers import (
@@ -42,7 +52,31 @@ from ciris_manager.deployment.helpers import (
     get_risk_indicator,
 )
 from ciris_manager.deployment.state import DeploymentState, add_event
+from ciris_manager.deployment.history import (
+    ACTIVE_STATUSES,
+    HOT_DEPLOYMENTS,
+    DeploymentHistoryArchive,
+    deployment_time,
+    matches,
+    public_summary,
+    summarize,
+)
+from ciris_manager.deployment.canary_schedule import RECENT_DEPLOYMENTS, CanarySchedule
+from ciris_manager.deployment.rollback import (
+    ROLLBACK_CONCURRENCY_PER_SERVER,
+    TRACKER_SLOTS,
+    AgentRollback,
+    RollbackPlan,
+    build_rollback_plan,
+)
 from ciris_manager.deployment.containers import ContainerOperations
+from ciris_manager.deployment.preview_cache import (
+    PreviewCache,
+    agent_fingerprint,
+    agent_key,
+    fleet_version,
+)
+from ciris_manager.startup_snapshot import StartupSnapshot
 
 logger = logging.getLogger(__name__)
 
@@ -53,6 +87,36 @@ logger = logging.getLogger(__name__)
 # were still healthily progressing through cognitive bootstrap.
 DEFAULT_WAIT_FOR_WORK_MINUTES = 15
 
+# Canary health polling: seconds between sweeps and agents polled at once
+HEALTH_POLL_INTERVAL_SECONDS = 10
+HEALTH_POLL_CONCURRENCY = 20
+
+# Time-to-WORK samples kept per deployment and used for scheduling
+MAX_TIME_TO_WORK_SAMPLES = 200
+
+# Compose file a local agent's update is staged in until the agent has stopped
+STAGED_COMPOSE_NAME = "docker-compose.next.yml"
+
+# HostConfig settings carried over when a container is recreated through the
+# Docker API, mapped to their docker-py create() argument
+CAPTURED_HOST_OPTIONS = {
+    "Memory": "mem_limit",
+    "MemorySwap": "memswap_limit",
+    "MemoryReservation": "mem_reservation",
+    "NanoCpus": "nano_cpus",
+    "CpuShares": "cpu_shares",
+    "CpuQuota": "cpu_quota",
+    "CpuPeriod": "cpu_period",
+    "PidsLimit": "pids_limit",
+    "ShmSize": "shm_size",
+    "CapAdd": "cap_add",
+    "CapDrop": "cap_drop",
+    "SecurityOpt": "security_opt",
+    "ExtraHosts": "extra_hosts",
+    "LogConfig": "log_config",
+    "Ulimits": "ulimits",
+}
+
 # Global deployment orchestrator instance
 _orchestrator: Optional["DeploymentOrchestrator"] = None
 
@@ -68,6 +132,12 @@ def get_deployment_orchestrator() -> "DeploymentOrchestrator":
     return _orchestrator
 
 
+def set_deployment_orchestrator(orchestrator: "DeploymentOrchestrator") -> None:
+    """Make an orchestrator the global instance (so every API shares its state)."""
+    global _orchestrator
+    _orchestrator = orchestrator
+
+
 class DeploymentOrchestrator:
     """Orchestrates deployments across agent fleet."""
 
@@ -85,6 +155,16 @@ class DeploymentOrchestrator:
         # Track background tasks to prevent garbage collection
         self._background_tasks: set = set()
 
+        # Replacement containers built during agent shutdown: (server_id, agent_id) -> details
+        self._prestaged_containers: Dict[tuple, Dict[str, Any]] = {}
+        # Pre-staging still in progress, with the deployment it belongs to
+        self._prestage_tasks: Dict[tuple, tuple] = {}
+        # Local agents whose compose file was regenerated for their deployment group
+        self._regenerated_composes: Set[str] = set()
+
+        # Deployment previews, reused while the fleet is unchanged
+        self._preview_cache = PreviewCache()
+
         # Deferred recovery - set during __init__, run on first async operation
         # This avoids calling asyncio.create_task() from synchronous __init__
         self._pending_recovery_deployment: Optional[DeploymentStatus] = None
@@ -98,6 +178,9 @@ class DeploymentOrchestrator:
         self.state_dir = self._state_manager.state_dir
         self.deployment_state_file = self._state_manager.deployment_state_file
 
+        # Finished deployments beyond the hot set live in the history archive
+        self._history = DeploymentHistoryArchive(self.state_dir / "deployment_history")
+
         # Initialize container operations
         self._container_ops = ContainerOperations(manager)
 
@@ -113,88 +196,135 @@ class DeploymentOrchestrator:
 
     def _load_state(self) -> None:
         """Load deployment state from persistent storage (sync version for __init__)."""
-        if self.deployment_state_file.exists():
+        # A manager started in fast mode may already hold this state, validated against the file
+        snapshot = getattr(self.manager, "startup_snapshot", None)
+        state = None
+        if isinstance(snapshot, StartupSnapshot):
+            state = snapshot.section("deployments", self.deployment_state_file)
+        if state is not None or self.deployment_state_file.exists():
             try:
-                with open(self.deployment_state_file, "r") as f:
-                    state = json.load(f)
-                    # Restore deployments
-                    for deployment_id, deployment_data in state.get("deployments", {}).items():
-                        self.deployments[deployment_id] = DeploymentStatus(**deployment_data)
-                    # Restore pending deployments
-                    for deployment_id, deployment_data in state.get(
-                        "pending_deployments", {}
-                    ).items():
-                        self.pending_deployments[deployment_id] = DeploymentStatus(
-                            **deployment_data
-                        )
-                    # Restore current deployment
-                    self.current_deployment = state.get("current_deployment")
-                    logger.info(
-                        f"Loaded deployment state with {len(self.deployments)} deployments "
-                        f"and {len(self.pending_deployments)} pending deployments"
-                    )
+                if state is None:
+                    with open(self.deployment_state_file, "r") as f:
+                        state = json.load(f)
+                # Restore deployments
+                for deployment_id, deployment_data in state.get("deployments", {}).items():
+                    self.deployments[deployment_id] = DeploymentStatus(**deployment_data)
+                # Restore pending deployments
+                for deployment_id, deployment_data in state.get("pending_deployments", {}).items():
+                    self.pending_deployments[deployment_id] = DeploymentStatus(**deployment_data)
+                # Restore current deployment
+                self.current_deployment = state.get("current_deployment")
+                logger.info(
+                    f"Loaded deployment state with {len(self.deployments)} deployments "
+                    f"and {len(self.pending_deployments)} pending deployments"
+                )
 
-                    # Check for in-progress deployments that need recovery or marking as failed
-                    # First check the current deployment if set
-                    if self.current_deployment and self.current_deployment in self.deployments:
-                        deployment = self.deployments[self.current_deployment]
-                        if deployment.status == "in_progress":
-                            # Check if we have agents that were in the middle of being restarted
-                            if deployment.agents_pending_restart or deployment.agents_in_progress:
-                                logger.warning(
-                                    f"Found interrupted deployment {self.current_deployment} after restart. "
-                                    f"Agents pending restart: {deployment.agents_pending_restart}, "
-                                    f"Agents in progress: {list(deployment.agents_in_progress.keys())}"
-                                )
-                                # Mark for deferred recovery - don't use asyncio.create_task in __init__!
-                                # The recovery will be triggered on the first async operation.
-                                self._pending_recovery_deployment = deployment
-                                logger.info(
-                                    "Deployment recovery deferred - will run on first async operation"
-                                )
-                            else:
-                                logger.warning(
-                                    f"Found in-progress deployment {self.current_deployment} after restart. "
-                                    "Marking as failed due to manager restart during deployment."
-                                )
-                                deployment.status = "failed"
-                                deployment.completed_at = datetime.now(timezone.utc).isoformat()
-                                deployment.message = "Deployment interrupted by manager restart"
-                                # Clear the current deployment lock to allow new deployments
-                                self.current_deployment = None
-                                self._save_state()
+                # Check for in-progress deployments that need recovery or marking as failed
+                # First check the current deployment if set
+                if self.current_deployment and self.current_deployment in self.deployments:
+                    deployment = self.deployments[self.current_deployment]
+                    if deployment.status == "in_progress":
+                        # Check if we have agents that were in the middle of being restarted
+                        if deployment.agents_pending_restart or deployment.agents_in_progress:
+                            logger.warning(
+                                f"Found interrupted deployment {self.current_deployment} after restart. "
+                                f"Agents pending restart: {deployment.agents_pending_restart}, "
+                                f"Agents in progress: {list(deployment.agents_in_progress.keys())}"
+                            )
+                            # Mark for deferred recovery - don't use asyncio.create_task in __init__!
+                            # The recovery will be triggered on the first async operation.
+                            self._pending_recovery_deployment = deployment
+                            logger.info(
+                                "Deployment recovery deferred - will run on first async operation"
+                            )
+                        else:
+                            logger.warning(
+                                f"Found in-progress deployment {self.current_deployment} after restart. "
+                                "Marking as failed due to manager restart during deployment."
+                            )
+                            deployment.status = "failed"
+                            deployment.completed_at = datetime.now(timezone.utc).isoformat()
+                            deployment.message = "Deployment interrupted by manager restart"
+                            # Clear the current deployment lock to allow new deployments
+                            self.current_deployment = None
+                            self._save_state()
 
-                    # Also scan all deployments for stale in-progress status (where current_deployment was cleared)
-                    stale_threshold = datetime.now(timezone.utc).timestamp() - (
-                        10 * 60
-                    )  # 10 minutes
-                    for deployment_id, deployment in list(self.deployments.items()):
-                        if deployment.status == "in_progress" and deployment.started_at:
-                            started_timestamp = datetime.fromisoformat(
-                                deployment.started_at.replace("Z", "+00:00")
-                            ).timestamp()
-                            if started_timestamp < stale_threshold:
-                                logger.warning(
-                                    f"Found stale in-progress deployment {deployment_id} after restart. "
-                                    f"Started at {deployment.started_at}, marking as failed."
-                                )
-                                deployment.status = "failed"
-                                deployment.completed_at = datetime.now(timezone.utc).isoformat()
-                                deployment.message = (
-                                    "Deployment marked as failed - stale after manager restart"
-                                )
-                                self._save_state()
+                # Also scan all deployments for stale in-progress status (where current_deployment was cleared)
+                stale_threshold = datetime.now(timezone.utc).timestamp() - (
+                    10 * 60
+                )  # 10 minutes
+                for deployment_id, deployment in list(self.deployments.items()):
+                    if deployment.status == "in_progress" and deployment.started_at:
+                        started_timestamp = datetime.fromisoformat(
+                            deployment.started_at.replace("Z", "+00:00")
+                        ).timestamp()
+                        if started_timestamp < stale_threshold:
+                            logger.warning(
+                                f"Found stale in-progress deployment {deployment_id} after restart. "
+                                f"Started at {deployment.started_at}, marking as failed."
+                            )
+                            deployment.status = "failed"
+                            deployment.completed_at = datetime.now(timezone.utc).isoformat()
+                            deployment.message = (
+                                "Deployment marked as failed - stale after manager restart"
+                            )
+                            self._save_state()
+
+                # State files from before the archive may hold months of history
+                if self._archive_history():
+                    self._save_state()
             except Exception as e:
                 logger.warning(f"Failed to load deployment state: {e}")
 
+    def _archive_history(self) -> int:
+        """
+        Move finished deployments beyond the hot set into the history archive.
+
+        Keeps the current deployment, active deployments and the most recent
+        HOT_DEPLOYMENTS finished ones in memory, so state saves stay small.
+
+        Returns:
+            Number of deployments archived
+        """
+        finished = [
+            d
+            for d in self.deployments.values()
+            if d.deployment_id != self.current_deployment and d.status not in ACTIVE_STATUSES
+        ]
+        if len(finished) <= HOT_DEPLOYMENTS:
+            return 0
+
+        finished.sort(key=deployment_time, reverse=True)
+        cold = finished[HOT_DEPLOYMENTS:]
+        try:
+            archived = self._history.archive(cold)
+        except OSError as e:
+            logger.error(f"Failed to archive deployment history: {e}")
+            return 0
+
+        for deployment in cold:
+            self.deployments.pop(deployment.deployment_id, None)
+        logger.info(f"Archived {archived} finished deployments")
+        return archived
+
+    def export_state(self) -> Dict[str, Any]:
+        """Deployment state in the state file's shape, for a startup snapshot."""
+        return {
+            "deployments": {k: d.model_dump() for k, d in self.deployments.items()},
+            "pending_deployments": {k: d.model_dump() for k, d in self.pending_deployments.items()},
+            "current_deployment": self.current_deployment,
+        }
+
     def _save_state(self) -> None:
         """Save deployment state synchronously (for compatibility)."""
+        self._archive_history()
         self._state_manager.save_sync(
             self.deployments, self.pending_deployments, self.current_deployment
         )
 
     async def _save_state_async(self) -> None:
         """Save deployment state to persistent storage (async version)."""
+        self._archive_history()
         await self._state_manager.save_async(
             self.deployments, self.pending_deployments, self.current_deployment
         )
@@ -957,6 +1087,7 @@ class DeploymentOrchestrator:
 
         # Save state
         self._save_state()
+        await self._discard_prestage(deployment_id=deployment_id)
 
         # Audit the cancellation
         from ciris_manager.audit import audit_deployment_action
@@ -1013,6 +1144,7 @@ class DeploymentOrchestrator:
 
         deployment = self.deployments[deployment_id]
         deployment.status = "rolling_back"
+        await self._discard_prestage(deployment_id=deployment_id)
 
         # Store rollback target in deployment metadata
         if deployment.notification:
@@ -1143,25 +1275,38 @@ class DeploymentOrchestrator:
 
         return result
 
-    async def get_deployment_history(self, limit: int = 10) -> List[Dict[str, Any]]:
-        """Get deployment history."""
-        deployments = sorted(
-            self.deployments.values(), key=lambda d: d.started_at or "", reverse=True
-        )[:limit]
-
-        return [
-            {
-                "deployment_id": d.deployment_id,
-                "started_at": d.started_at,
-                "completed_at": d.completed_at,
-                "status": d.status,
-                "message": d.message,
-                "agents_total": d.agents_total,
-                "agents_updated": d.agents_updated,
-                "agents_failed": d.agents_failed,
-            }
-            for d in deployments
-        ]
+    async def get_deployment_history(
+        self,
+        limit: int = 10,
+        offset: int = 0,
+        status: Optional[str] = None,
+        agent_id: Optional[str] = None,
+        since: Optional[str] = None,
+        until: Optional[str] = None,
+    ) -> List[Dict[str, Any]]:
+        """
+        Get deployment history, newest first, across hot and archived deployments.
+
+        Args:
+            limit: Maximum deployments to return
+            offset: Matching deployments to skip (for paging)
+            status: Only this deployment status
+            agent_id: Only deployments that touched this agent
+            since: Only deployments at or after this ISO timestamp
+            until: Only deployments before this ISO timestamp
+
+        Returns:
+            Deployment summaries
+        """
+        hot = [summarize(d) for d in self.deployments.values()]
+        hot = [s for s in hot if matches(s, status, agent_id, since, until)]
+        # Fetching offset + limit from each side keeps paging exact after the merge
+        archived = await asyncio.to_thread(
+            self._history.query, offset + limit, 0, status, agent_id, since, until
+        )
+
+        summaries = sorted(hot + archived, key=lambda s: s["timestamp"], reverse=True)
+        return [public_summary(s) for s in summaries[offset : offset + limit]]
 
     async def evaluate_and_stage(
         self,
@@ -1332,29 +1477,21 @@ class DeploymentOrchestrator:
         """
         Get previous image versions for agents.
 
+        Uses the same single-pass plan as the rollback itself, so the proposal
+        shows exactly the images an approved rollback would run.
+
         Args:
             agents: List of agents
 
         Returns:
-            Dictionary mapping agent_id to previous image version
+            Dictionary mapping agent_id to previous image version ("unknown" if none)
         """
-        previous_versions = {}
-
-        for agent in agents:
-            # Get from agent metadata if available
-            if self.manager and hasattr(self.manager, "agent_registry"):
-                agent_info = self.manager.agent_registry.get_agent(agent.agent_id)
-                if agent_info and hasattr(agent_info, "metadata"):
-                    # Look for n-1 version in metadata
-                    previous_images = agent_info.metadata.get("previous_images", {})
-                    if previous_images:
-                        # Get the most recent previous version
-                        previous_versions[agent.agent_id] = previous_images.get(
-                            "n-1", previous_images.get("agent", "unknown")
-                        )
-                    else:
-                        previous_versions[agent.agent_id] = "unknown"
+        if not (self.manager and hasattr(self.manager, "agent_registry")):
+            return {}
 
+        plan = await self._plan_agent_rollback([a.agent_id for a in agents], "n-1", {})
+        previous_versions = {agent_id: "unknown" for agent_id in plan.skipped}
+        previous_versions.update({a.agent_id: a.image for a in plan.agents})
         return previous_versions
 
     async def _rollback_agents(
@@ -1409,71 +1546,32 @@ class DeploymentOrchestrator:
             # Rollback agents
             if self.manager and hasattr(self.manager, "agent_registry"):
                 agent_list = rollback_targets.get("agent", [])
-                for agent_id in agent_list:
-                    agent_info = self.manager.agent_registry.get_agent(agent_id)
-                    if not agent_info:
-                        continue
-
-                    # Get target version from metadata
-                    if hasattr(agent_info, "metadata"):
-                        previous_images = agent_info.metadata.get("previous_images", {})
-
-                        # Check for agent-specific target version
-                        agent_target = target_version
-                        if target_versions and "agent" in target_versions:
-                            agent_target = target_versions["agent"].get(agent_id, target_version)
-
-                        # Get the appropriate image based on target
-                        if agent_target in ["n-1", "n-2"]:
-                            rollback_image = previous_images.get(agent_target)
-                            if not rollback_image:
-                                logger.warning(
-                                    f"No {agent_target} version available for agent {agent_id}, skipping rollback"
-                                )
-                                continue
-                        else:
-                            # Specific version provided
-                            rollback_image = agent_target
-
-                        if rollback_image and rollback_image != "not available":
-                            logger.info(
-                                f"Rolling back {agent_id} to {rollback_image} (target: {agent_target})"
-                            )
-
-                            # Update the agent's image in docker-compose
-                            # This would involve updating the compose file
-                            # For now, we'll restart with the previous image tag
-                            container_name = agent_info.container_name
-
-                            # Stop container to force re-pull of n-1 image
-                            await asyncio.create_subprocess_exec(
-                                "docker",
-                                "stop",
-                                container_name,
-                                stdout=asyncio.subprocess.PIPE,
-                                stderr=asyncio.subprocess.PIPE,
-                            )
+                agent_targets: Dict[str, str] = {}
+                if target_versions and isinstance(target_versions.get("agent"), dict):
+                    agent_targets = target_versions["agent"]
 
-                            # Update container with n-1 image
-                            await asyncio.create_subprocess_exec(
-                                "docker",
-                                "run",
-                                "-d",
-                                "--name",
-                                container_name,
-                                "--restart",
-                                "unless-stopped",
-                                rollback_image,
-                                stdout=asyncio.subprocess.PIPE,
-                                stderr=asyncio.subprocess.PIPE,
-                            )
+                plan = await self._plan_agent_rollback(
+                    list(agent_list), target_version, agent_targets
+                )
+                failed = await self._execute_agent_rollback(deployment, plan)
 
-                            # Update metadata to reflect rollback
-                            agent_info.metadata["current_images"]["agent"] = rollback_image
-                            self.manager.agent_registry.update_agent(agent_info)
+                if failed or plan.skipped:
+                    deployment.status = "rollback_failed"
+                    deployment.message = (
+                        f"Rolled back {len(plan.agents) - len(failed)} agents; "
+                        f"failed: {len(failed)}, skipped: {len(plan.skipped)}"
+                    )
+                    deployment.completed_at = datetime.now(timezone.utc).isoformat()
+                    self._save_state()
+                    logger.error(
+                        f"Rollback for deployment {deployment.deployment_id} incomplete: "
+                        f"failed={failed}, skipped={plan.skipped}"
+                    )
+                    return
 
             deployment.status = "rolled_back"
             deployment.completed_at = datetime.now(timezone.utc).isoformat()
+            self._save_state()
             logger.info(f"Rollback completed for deployment {deployment.deployment_id}")
 
         except Exception as e:
@@ -1481,6 +1579,165 @@ class DeploymentOrchestrator:
             deployment.status = "rollback_failed"
             deployment.completed_at = datetime.now(timezone.utc).isoformat()
 
+    async def _plan_agent_rollback(
+        self, agent_ids: List[str], target_version: str, agent_targets: Dict[str, str]
+    ) -> RollbackPlan:
+        """
+        Resolve every agent's rollback image in one pass.
+
+        Args:
+            agent_ids: Agents to roll back
+            target_version: Default target ("n-1", "n-2" or an explicit image)
+            agent_targets: Per-agent overrides of the target
+
+        Returns:
+            Rollback plan
+        """
+        tracker_options: Dict[str, Any] = {}
+        if any(agent_targets.get(a, target_version) in TRACKER_SLOTS for a in agent_ids):
+            try:
+                from ciris_manager.version_tracker import get_version_tracker
+
+                tracker_options = await get_version_tracker().get_rollback_options("agent")
+            except Exception as e:
+                logger.warning(f"Version history unavailable for rollback planning: {e}")
+
+        registry = self.manager.agent_registry if self.manager else None
+        entries = [(a, registry.get_agent(a) if registry else None) for a in agent_ids]
+        plan = build_rollback_plan(entries, target_version, agent_targets, tracker_options)
+        for agent_id, reason in plan.skipped.items():
+            logger.warning(f"Skipping rollback of agent {agent_id}: {reason}")
+        return plan
+
+    async def _ensure_rollback_image(self, server_id: str, image: str) -> bool:
+        """
+        Make sure a rollback image is present on a server, pulling it if needed.
+
+        Args:
+            server_id: Server that will run the image
+            image: Image reference
+
+        Returns:
+            True if the image is available on the server
+        """
+        try:
+            if self._is_local_server(server_id):
+                process = await asyncio.create_subprocess_exec(
+                    "docker",
+                    "image",
+                    "inspect",
+                    image,
+                    stdout=asyncio.subprocess.PIPE,
+                    stderr=asyncio.subprocess.PIPE,
+                )
+                await process.communicate()
+                if process.returncode == 0:
+                    return True
+                result = await self._pull_single_image_with_retry(image, "rollback")
+                return bool(result.get("success"))
+
+            if not (self.manager and hasattr(self.manager, "docker_client")):
+                return False
+            client = self.manager.docker_client.get_client(server_id)
+            try:
+                await asyncio.to_thread(client.images.get, image)
+            except Exception:
+                await asyncio.to_thread(client.images.pull, image)
+            return True
+        except Exception as e:
+            logger.error(f"Rollback image {image} unavailable on {server_id}: {e}")
+            return False
+
+    async def _execute_agent_rollback(
+        self, deployment: DeploymentStatus, plan: RollbackPlan
+    ) -> List[str]:
+        """
+        Restart agents on their rollback images.
+
+        Every (server, image) pair is confirmed first, so no agent is stopped
+        for an image its server cannot get. Agents then restart concurrently,
+        limited per server, with progress written to the deployment as each
+        agent finishes.
+
+        Args:
+            deployment: Deployment being rolled back
+            plan: Rollback plan
+
+        Returns:
+            IDs of agents that failed to roll back
+        """
+        if not plan.agents:
+            return []
+
+        pairs = sorted(plan.server_images())
+        available = await asyncio.gather(
+            *(self._ensure_rollback_image(server_id, image) for server_id, image in pairs)
+        )
+        missing = {pair for pair, ok in zip(pairs, available) if not ok}
+
+        total = len(plan.agents)
+        done = 0
+        failed: List[str] = []
+        semaphores: Dict[str, asyncio.Semaphore] = {}
+        registry = self.manager.agent_registry if self.manager else None
+
+        def report(agent: AgentRollback, success: bool) -> None:
+            nonlocal done
+            done += 1
+            if not success:
+                failed.append(agent.agent_id)
+            deployment.agents_in_progress.pop(agent.agent_id, None)
+            deployment.message = f"Rolling back: {done}/{total} agents ({len(failed)} failed)"
+            add_event(
+                deployment,
+                "agent_rolled_back" if success else "agent_rollback_failed",
+                f"{agent.agent_id} {'rolled back' if success else 'failed to roll back'} "
+                f"to {agent.image}",
+                {"agent_id": agent.agent_id, "server_id": agent.server_id, "image": agent.image},
+            )
+            self._save_state()
+
+        async def roll_back(agent: AgentRollback) -> None:
+            if (agent.server_id, agent.image) in missing:
+                report(agent, False)
+                return
+            semaphore = semaphores.setdefault(
+                agent.server_id, asyncio.Semaphore(ROLLBACK_CONCURRENCY_PER_SERVER)
+            )
+            async with semaphore:
+                deployment.agents_in_progress[agent.agent_id] = "rolling_back"
+                logger.info(
+                    f"Rolling back {agent.agent_id} to {agent.image} (target: {agent.target})"
+                )
+                try:
+                    success = await self._recreate_agent_container(
+                        agent.agent_id, agent.server_id, agent.image
+                    )
+                except Exception as e:
+                    logger.error(f"Rollback of {agent.agent_id} failed: {e}")
+                    success = False
+
+            if success and registry:
+                agent_info = registry.get_agent(agent.agent_id)
+                if agent_info is not None and isinstance(agent_info.metadata, dict):
+                    current = agent_info.metadata.setdefault("current_images", {})
+                    current["agent"] = agent.image
+                    current["agent_tag"] = agent.image
+            report(agent, success)
+
+        await asyncio.gather(*(roll_back(agent) for agent in plan.agents))
+
+        # One registry write for the whole rollback
+        if registry and done > len(failed):
+            registry._save_metadata()
+            get_manifest_cache().invalidate()
+
+        logger.info(
+            f"Rollback of deployment {deployment.deployment_id}: "
+            f"{total - len(failed)}/{total} agents restarted"
+        )
+        return failed
+
     async def _pull_images(self, notification: UpdateNotification) -> Dict[str, Any]:
         """
         Pull Docker images specified in the notification with retry logic.
@@ -1752,6 +2009,19 @@ class DeploymentOrchestrator:
         if not notification:
             return {"error": "No notification in deployment"}
 
+        # Early adopters will see explorer results (if explorers exist)
+        has_explorers = has_early_adopters = False
+        if self.manager and hasattr(self.manager, "agent_registry"):
+            groups = self.manager.agent_registry.get_agents_by_canary_group()
+            has_explorers = bool(groups.get("explorer"))
+            has_early_adopters = bool(groups.get("early_adopter"))
+
+        self._preview_cache.retain(self.pending_deployments)
+        cache_key = (has_explorers, has_early_adopters)
+        cached = self._preview_cache.get_shutdown_reasons(deployment_id, cache_key)
+        if cached is not None:
+            return cached
+
         # Build base reason
         if notification.version and not notification.version.startswith(("v", "1", "2", "3")):
             base_reason = f"Runtime: CD update to commit {notification.version[:7]}"
@@ -1766,36 +2036,34 @@ class DeploymentOrchestrator:
             "general": f"{base_reason} (deployment {deployment_id[:8]})",
         }
 
-        # Early adopters will see explorer results (if explorers exist)
-        if self.manager and hasattr(self.manager, "agent_registry"):
-            groups = self.manager.agent_registry.get_agents_by_canary_group()
-
-            if groups.get("explorer"):
-                # Simulate successful explorer
-                reasons["early_adopters"] = (
-                    f"{base_reason} | Prior groups: Explorers: 1/1 succeeded "
-                    f"(avg 2.5min to WORK) (deployment {deployment_id[:8]})"
-                )
+        if has_explorers:
+            # Simulate successful explorer
+            reasons["early_adopters"] = (
+                f"{base_reason} | Prior groups: Explorers: 1/1 succeeded "
+                f"(avg 2.5min to WORK) (deployment {deployment_id[:8]})"
+            )
 
-                # General will see both
-                reasons["general"] = (
-                    f"{base_reason} | Prior groups: Explorers: 1/1 succeeded (avg 2.5min to WORK) | "
-                    f"Early adopters: 1/1 succeeded (avg 2.0min to WORK) (deployment {deployment_id[:8]})"
-                )
-            elif groups.get("early_adopter"):
-                # No explorers, so early adopters get no peer info
-                # General only sees early adopters
-                reasons["general"] = (
-                    f"{base_reason} | Prior groups: Early adopters: 1/1 succeeded "
-                    f"(avg 2.0min to WORK) (deployment {deployment_id[:8]})"
-                )
+            # General will see both
+            reasons["general"] = (
+                f"{base_reason} | Prior groups: Explorers: 1/1 succeeded (avg 2.5min to WORK) | "
+                f"Early adopters: 1/1 succeeded (avg 2.0min to WORK) (deployment {deployment_id[:8]})"
+            )
+        elif has_early_adopters:
+            # No explorers, so early adopters get no peer info
+            # General only sees early adopters
+            reasons["general"] = (
+                f"{base_reason} | Prior groups: Early adopters: 1/1 succeeded "
+                f"(avg 2.0min to WORK) (deployment {deployment_id[:8]})"
+            )
 
-        return {
+        result = {
             "deployment_id": deployment_id,
             "version": notification.version,
             "shutdown_reasons": reasons,
             "note": "These are example reasons. Actual times and success counts will vary based on deployment results.",
         }
+        self._preview_cache.store_shutdown_reasons(deployment_id, cache_key, result)
+        return result
 
     async def get_deployment_preview(self, deployment_id: str) -> Dict[str, Any]:
         """
@@ -1807,142 +2075,271 @@ class DeploymentOrchestrator:
         Returns:
             Preview data with per-agent update status
         """
+        preview, serialized = await self._build_deployment_preview(deployment_id)
+        return json.loads(serialized) if serialized is not None else preview
+
+    async def get_deployment_preview_json(self, deployment_id: str) -> bytes:
+        """
+        Get the deployment preview already serialized as JSON.
+
+        Repeat calls against an unchanged fleet are served from the preview
+        cache without re-encoding.
+
+        Args:
+            deployment_id: ID of the pending deployment
+        Returns:
+            JSON-encoded preview (or error)
+        """
+        preview, serialized = await self._build_deployment_preview(deployment_id)
+        return serialized if serialized is not None else json.dumps(preview).encode()
+
+    async def _build_deployment_preview(
+        self, deployment_id: str
+    ) -> tuple[Dict[str, Any], Optional[bytes]]:
+        """
+        Build (or fetch from cache) the preview for a pending deployment.
+
+        Only agents whose discovered state changed since the last preview are
+        re-checked; everything else comes from the preview cache.
+
+        Args:
+            deployment_id: ID of the pending deployment
+        Returns:
+            Tuple of (preview, serialized preview); serialized is None for errors
+        """
         if deployment_id not in self.pending_deployments:
-            return {"error": "Deployment not found"}
+            return {"error": "Deployment not found"}, None
 
         deployment = self.pending_deployments[deployment_id]
-        if not deployment.notification:
-            return {"error": "No update notification for deployment"}
-
-        # Get all agents
-        from ciris_manager.docker_discovery import DockerAgentDiscovery
+        notification = deployment.notification
+        if not notification:
+            return {"error": "No update notification for deployment"}, None
 
         if not self.manager or not self.manager.agent_registry:
-            return {"error": "Manager not available"}
-
-        discovery = DockerAgentDiscovery(self.manager.agent_registry)
-        all_agents = discovery.discover_agents()
+            return {"error": "Manager not available"}, None
 
-        # Check which agents need updates
-        agents_needing_update, nginx_needs_update = await self._check_agents_need_update(
-            deployment.notification, all_agents
-        )
+        all_agents = await self._discover_preview_agents()
 
-        # Build preview data
-        preview: Dict[str, Any] = {
-            "deployment_id": deployment_id,
-            "version": deployment.notification.version or "unknown",
-            "total_agents": len(all_agents),
-            "agents_to_update": len(agents_needing_update),
-            "nginx_needs_update": nginx_needs_update,
-            "agent_details": [],
+        self._preview_cache.retain(self.pending_deployments)
+        groups = {a.agent_id: self._get_agent_canary_group(a.agent_id) for a in all_agents}
+        # Occurrences of one agent_id are separate containers, each with its own row
+        fingerprints = {
+            agent_key(agent): agent_fingerprint(agent, groups[agent.agent_id])
+            for agent in all_agents
         }
+        version = fleet_version(fingerprints.values())
+        serialized = self._preview_cache.get_preview(deployment_id, version)
+        if serialized is not None:
+            return {}, serialized
 
-        # Get current and target digests for each agent
+        # GUI/nginx and target digests are a handful of local inspects
+        nginx_needs_update = await self._check_gui_needs_update(notification)
         target_agent_digest = None
-        if deployment.notification.agent_image:
-            target_agent_digest = await self._get_local_image_digest(
-                deployment.notification.agent_image
-            )
+        if notification.agent_image:
+            target_agent_digest = await self._get_local_image_digest(notification.agent_image)
 
-        # Add details for each agent
+        details: Dict[Any, Dict[str, Any]] = {}
+        stale: List[AgentInfo] = []
         for agent in all_agents:
-            current_digest = await self._get_container_image_digest(f"ciris-{agent.agent_id}")
-
-            needs_update = agent in agents_needing_update
-            agent_detail = {
-                "agent_id": agent.agent_id,
-                "agent_name": agent.agent_name,
-                "needs_update": needs_update,
-                "current_digest": current_digest[:12] if current_digest else "unknown",
-                "target_digest": target_agent_digest[:12]
-                if target_agent_digest and needs_update
-                else None,
-                "status": "Up to date" if not needs_update else "Needs update",
-                "canary_group": self._get_agent_canary_group(agent.agent_id),
-            }
+            cached_row = self._preview_cache.get_row(deployment_id, fingerprints[agent_key(agent)])
+            if cached_row is not None:
+                details[agent_key(agent)] = cached_row
+            else:
+                stale.append(agent)
 
-            # Try to get current version from agent
-            try:
-                async with httpx.AsyncClient(timeout=2.0) as client:
-                    from ciris_manager.agent_auth import get_agent_auth
+        if stale:
+            logger.info(
+                f"Preview {deployment_id[:8]}: checking {len(stale)} of {len(all_agents)} agents"
+            )
+            semaphore = asyncio.Semaphore(HEALTH_POLL_CONCURRENCY)
 
-                    auth = get_agent_auth()
-                    headers = auth.get_auth_headers(
-                        agent.agent_id,
-                        occurrence_id=agent.occurrence_id,
-                        server_id=agent.server_id,
-                    )
+            async with get_agent_http_client() as client:
 
-                    agent_url = self._get_agent_url(agent)
-                    health_url = f"{agent_url}/v1/system/health"
-                    response = await client.get(health_url, headers=headers)
+                async def check(agent: AgentInfo) -> None:
+                    async with semaphore:
+                        detail = await self._preview_agent_detail(
+                            client, agent, notification, target_agent_digest
+                        )
+                    detail["canary_group"] = groups[agent.agent_id]
+                    fingerprint = fingerprints[agent_key(agent)]
+                    self._preview_cache.store_row(deployment_id, fingerprint, detail)
+                    details[agent_key(agent)] = detail
 
-                    if response.status_code == 200:
-                        health_data = response.json()
-                        if isinstance(health_data, dict) and health_data.get("data"):
-                            health_data = health_data["data"]
-                        agent_detail["current_version"] = health_data.get("version", "unknown")
-            except Exception:
-                agent_detail["current_version"] = "unknown"
+                await asyncio.gather(*(check(agent) for agent in stale))
 
-            preview["agent_details"].append(agent_detail)
+        agent_details = [details[agent_key(agent)] for agent in all_agents]
 
         # Sort agents by update status and canary group (in deployment order)
         canary_order = {"explorer": 0, "early_adopter": 1, "general": 2}
-        preview["agent_details"].sort(
+        agent_details.sort(
             key=lambda x: (
                 not x["needs_update"],
                 canary_order.get(x.get("canary_group", "general"), 2),
                 x["agent_id"],
+                x.get("server_id") or "main",
+                x.get("occurrence_id") or "",
             )
         )
 
-        return preview
+        preview: Dict[str, Any] = {
+            "deployment_id": deployment_id,
+            "version": notification.version or "unknown",
+            "total_agents": len(all_agents),
+            "agents_to_update": sum(1 for d in agent_details if d["needs_update"]),
+            "nginx_needs_update": nginx_needs_update,
+            "agent_details": agent_details,
+        }
+        serialized = self._preview_cache.store_preview(
+            deployment_id, version, fingerprints.keys(), preview
+        )
+        return preview, serialized
+
+    async def _discover_preview_agents(self) -> List[AgentInfo]:
+        """
+        Discover agents for a preview without blocking the event loop.
 
-    async def _check_agents_need_update(
+        A discovery result younger than the discovery cache TTL is used as is;
+        otherwise discovery, which connects to Docker, runs in a worker thread.
+
+        Returns:
+            Discovered agents
+        """
+        from ciris_manager.docker_discovery import (
+            CACHE_TTL_SECONDS,
+            DockerAgentDiscovery,
+            get_cached_discovery,
+        )
+
+        cached = get_cached_discovery("local", max_age=CACHE_TTL_SECONDS)
+        if cached is not None:
+            return cached
+        registry = self.manager.agent_registry
+        return await asyncio.to_thread(lambda: DockerAgentDiscovery(registry).discover_agents())
+
+    async def _preview_agent_detail(
         self,
+        client: AgentHTTPClient,
+        agent: AgentInfo,
         notification: UpdateNotification,
-        agents: List[AgentInfo],
-    ) -> tuple[List[AgentInfo], bool]:
+        target_agent_digest: Optional[str],
+    ) -> Dict[str, Any]:
         """
-        Check which agents actually need updating based on versions.
+        Compute one agent's preview row with a single health request.
 
-        Args:
-            notification: Update notification with new images
-            agents: List of all agents
+        Uses the same rules as _check_agents_need_update: version comparison
+        when the notification has a version (unreachable agents need an
+        update), digest comparison otherwise.
 
+        Args:
+            client: Shared agent HTTP client
+            agent: Agent to check
+            notification: Update notification of the deployment
+            target_agent_digest: Digest of the target agent image, if known
         Returns:
-            Tuple of (List of agents that need updating, bool for nginx needs update)
+            Preview row (without canary group)
         """
-        # For GUI/nginx, still use digests since they don't have versions
-        new_gui_digest = None
-        nginx_needs_update = False
-
-        if notification.gui_image:
-            # Normalize image name to lowercase for Docker compatibility
-            gui_image = notification.gui_image.lower()
-            new_gui_digest = await self._get_local_image_digest(gui_image)
-            logger.info(f"New GUI image digest: {new_gui_digest}")
-
-            # Check if GUI container needs updating by comparing digests
-            # Try to get current GUI container digest
-            current_gui_digest = await self._get_container_image_digest("ciris-gui")
-            if new_gui_digest and new_gui_digest != current_gui_digest:
-                nginx_needs_update = True
-                logger.info(f"GUI/nginx needs update: {current_gui_digest} -> {new_gui_digest}")
-            else:
-                logger.info("GUI/nginx image unchanged")
+        from ciris_manager.agent_auth import get_agent_auth
 
-        # Check each agent to see if it needs updating based on version
-        agents_needing_update: List[AgentInfo] = []
+        current_digest = await self._get_container_image_digest(
+            agent.container_name or f"ciris-{agent.agent_id}"
+        )
 
-        # Only check agents if an agent_image was provided
-        if not notification.agent_image:
-            logger.info("No agent_image in notification, skipping agent checks")
-            return agents_needing_update, nginx_needs_update
+        current_version: Optional[str] = None
+        try:
+            try:
+                headers = get_agent_auth().get_auth_headers(
+                    agent.agent_id,
+                    occurrence_id=agent.occurrence_id,
+                    server_id=agent.server_id,
+                )
+            except Exception:
+                headers = {}
+            response = await client.get(
+                f"{self._get_agent_url(agent)}/v1/system/health", headers=headers, timeout=5.0
+            )
+            if response.status_code == 200:
+                health_data = response.json()
+                if isinstance(health_data, dict) and health_data.get("data"):
+                    health_data = health_data["data"]
+                current_version = health_data.get("version", "unknown")
+        except Exception as e:
+            logger.debug(f"Preview health check failed for {agent.agent_id}: {e}")
 
-        target_version = notification.version
+        if not notification.agent_image:
+            needs_update = False
+        elif notification.version:
+            needs_update = current_version != notification.version
+        else:
+            needs_update = bool(target_agent_digest and target_agent_digest != current_digest)
+
+        return {
+            "agent_id": agent.agent_id,
+            "agent_name": agent.agent_name,
+            "occurrence_id": agent.occurrence_id,
+            "server_id": agent.server_id or "main",
+            "needs_update": needs_update,
+            "current_digest": current_digest[:12] if current_digest else "unknown",
+            "target_digest": target_agent_digest[:12]
+            if target_agent_digest and needs_update
+            else None,
+            "status": "Up to date" if not needs_update else "Needs update",
+            "current_version": current_version or "unknown",
+        }
+
+    async def _check_gui_needs_update(self, notification: UpdateNotification) -> bool:
+        """
+        Check whether the GUI/nginx container runs a different image than notified.
+
+        GUI/nginx have no versions, so this compares image digests.
+
+        Args:
+            notification: Update notification with new images
+
+        Returns:
+            True if the GUI/nginx container needs updating
+        """
+        if not notification.gui_image:
+            return False
+
+        # Normalize image name to lowercase for Docker compatibility
+        gui_image = notification.gui_image.lower()
+        new_gui_digest = await self._get_local_image_digest(gui_image)
+        logger.info(f"New GUI image digest: {new_gui_digest}")
+
+        # Check if GUI container needs updating by comparing digests
+        current_gui_digest = await self._get_container_image_digest("ciris-gui")
+        if new_gui_digest and new_gui_digest != current_gui_digest:
+            logger.info(f"GUI/nginx needs update: {current_gui_digest} -> {new_gui_digest}")
+            return True
+        logger.info("GUI/nginx image unchanged")
+        return False
+
+    async def _check_agents_need_update(
+        self,
+        notification: UpdateNotification,
+        agents: List[AgentInfo],
+    ) -> tuple[List[AgentInfo], bool]:
+        """
+        Check which agents actually need updating based on versions.
+
+        Args:
+            notification: Update notification with new images
+            agents: List of all agents
+
+        Returns:
+            Tuple of (List of agents that need updating, bool for nginx needs update)
+        """
+        nginx_needs_update = await self._check_gui_needs_update(notification)
+
+        # Check each agent to see if it needs updating based on version
+        agents_needing_update: List[AgentInfo] = []
+
+        # Only check agents if an agent_image was provided
+        if not notification.agent_image:
+            logger.info("No agent_image in notification, skipping agent checks")
+            return agents_needing_update, nginx_needs_update
+
+        target_version = notification.version
 
         if not target_version:
             logger.warning(
@@ -2030,8 +2427,11 @@ class DeploymentOrchestrator:
         return agents_needing_update, nginx_needs_update
 
     async def get_deployment_status(self, deployment_id: str) -> Optional[DeploymentStatus]:
-        """Get status of a deployment."""
-        return self.deployments.get(deployment_id)
+        """Get status of a deployment (archived deployments are loaded from history)."""
+        deployment = self.deployments.get(deployment_id)
+        if deployment is None:
+            deployment = await asyncio.to_thread(self._history.get, deployment_id)
+        return deployment
 
     async def get_current_deployment(self) -> Optional[DeploymentStatus]:
         """Get current active deployment."""
@@ -2158,17 +2558,129 @@ class DeploymentOrchestrator:
                     },
                 )
 
+    async def _poll_canary_agent(
+        self, client: AgentHTTPClient, agent: AgentInfo, headers: Dict[str, str]
+    ) -> Optional[Dict[str, str]]:
+        """
+        Read one agent's cognitive state.
+
+        Args:
+            client: Shared agent HTTP client
+            agent: Agent to poll
+            headers: Auth headers for the agent
+
+        Returns:
+            Dict with cognitive_state and version, or None if the agent was unreachable
+        """
+        try:
+            # Check health endpoint (using system/health which is the correct endpoint)
+            health_url = f"{self._get_agent_url(agent)}/v1/system/health"
+            response = await client.get(health_url, headers=headers, timeout=5.0)
+            if response.status_code != 200:
+                return None
+
+            health_data = response.json()
+            if isinstance(health_data, dict) and health_data.get("data"):
+                health_data = health_data["data"]
+
+            return {
+                "cognitive_state": (health_data.get("cognitive_state") or "").lower(),
+                "version": health_data.get("version") or "unknown",
+            }
+        except httpx.ConnectError as e:
+            # Connection errors are expected when container is starting
+            logger.debug(f"Agent {agent.agent_id} not ready yet: {e}")
+        except Exception as e:
+            # Log other errors but don't fail the deployment
+            logger.warning(f"Error checking agent {sanitize_agent_id(agent.agent_id)} health: {e}")
+        return None
+
+    async def _check_recent_incidents(
+        self,
+        client: AgentHTTPClient,
+        agent: AgentInfo,
+        headers: Dict[str, str],
+        stability_minutes: float,
+    ) -> tuple[bool, bool]:
+        """
+        Check an agent's telemetry for critical incidents within the stability period.
+
+        Telemetry failures never block: the agent is then judged on WORK state alone.
+
+        Args:
+            client: Shared agent HTTP client
+            agent: Agent to check
+            headers: Auth headers for the agent
+            stability_minutes: Look-back window for incidents
+
+        Returns:
+            Tuple of (recent_critical, telemetry_checked)
+        """
+        try:
+            telemetry_url = f"{self._get_agent_url(agent)}/v1/telemetry/overview"
+            telemetry_response = await client.get(telemetry_url, headers=headers, timeout=5.0)
+
+            if telemetry_response.status_code != 200:
+                logger.warning(
+                    f"Telemetry endpoint returned {telemetry_response.status_code} "
+                    f"for agent {agent.agent_id}, proceeding without incident check"
+                )
+                return False, False
+
+            telemetry_data = telemetry_response.json()
+            if isinstance(telemetry_data, dict) and telemetry_data.get("data"):
+                telemetry_data = telemetry_data["data"]
+
+            incidents = telemetry_data.get("recent_incidents", [])
+
+            # Handle case where incidents might be an int (count) instead of list
+            if isinstance(incidents, int):
+                incidents = []  # No incidents if it's just a count
+            elif not isinstance(incidents, list):
+                logger.warning(
+                    f"Unexpected incidents type for {agent.agent_id}: {type(incidents)}"
+                )
+                incidents = []
+
+            # Check for critical incidents in the last stability_minutes
+            cutoff_time = datetime.now(timezone.utc).timestamp() - (stability_minutes * 60)
+
+            for incident in incidents:
+                if incident.get("severity") in ["critical", "high"]:
+                    incident_time = incident.get("timestamp", 0)
+                    if isinstance(incident_time, str):
+                        # Parse ISO timestamp
+                        from dateutil import parser
+
+                        incident_time = parser.parse(incident_time).timestamp()
+                    if incident_time > cutoff_time:
+                        return True, True
+
+            return False, True
+        except Exception as e:
+            # Telemetry check failed, but agent is in WORK state
+            logger.warning(
+                f"Could not check telemetry for agent {agent.agent_id}: {e}. "
+                f"Proceeding based on WORK state alone."
+            )
+            return False, False
+
     async def _check_canary_group_health(
         self,
         deployment_id: str,
         agents: List[AgentInfo],
         phase_name: str,
-        wait_for_work_minutes: int = 5,
-        stability_minutes: int = 1,
+        wait_for_work_minutes: float = 5,
+        stability_minutes: float = 1,
+        required_stable: int = 1,
     ) -> tuple[bool, Dict[str, Any]]:
         """
-        Check if at least one agent in the canary group has reached WORK state
-        and has no incidents for the stability period.
+        Check if enough agents in the canary group have reached WORK state
+        and have no incidents for the stability period.
+
+        Agents are polled concurrently each sweep, and the phase completes as
+        soon as required_stable agents are stable rather than waiting on the
+        slowest agent.
 
         Args:
             deployment_id: Deployment identifier
@@ -2176,202 +2688,164 @@ class DeploymentOrchestrator:
             phase_name: Name of the current phase (for logging)
             wait_for_work_minutes: Max time to wait for WORK state
             stability_minutes: Time agent must be stable in WORK state
+            required_stable: Stable agents needed to pass (capped at the running agents)
 
         Returns:
             Tuple of (success, results_dict) where results_dict contains timing info
         """
+        from ciris_manager.agent_auth import get_agent_auth
+
         logger.info(
             f"Deployment {deployment_id}: Waiting for {phase_name} agents to reach WORK state"
         )
 
         start_time = datetime.now(timezone.utc)
         wait_until = start_time.timestamp() + (wait_for_work_minutes * 60)
+        auth = get_agent_auth()
+        semaphore = asyncio.Semaphore(HEALTH_POLL_CONCURRENCY)
 
         # Track which agents have reached WORK and when
         agents_in_work: Dict[str, datetime] = {}
+        # First time each agent reached WORK, in minutes since the phase started
+        time_to_work: Dict[str, float] = {}
+        stable: Dict[str, Dict[str, Any]] = {}
 
         while datetime.now(timezone.utc).timestamp() < wait_until:
-            # Check each agent's state
-            for agent in agents:
-                if not agent.is_running:
+            running = [agent for agent in agents if agent.is_running]
+            needed = max(1, min(required_stable, len(running)))
+            headers: Dict[str, Dict[str, str]] = {}
+            for agent in running:
+                if agent.agent_id in stable:
                     continue
-
                 try:
-                    # Get agent health status
-                    async with httpx.AsyncClient(timeout=5.0) as client:
-                        # Get auth headers for this agent
-                        from ciris_manager.agent_auth import get_agent_auth
+                    headers[agent.agent_id] = auth.get_auth_headers(
+                        agent.agent_id,
+                        occurrence_id=agent.occurrence_id,
+                        server_id=agent.server_id,
+                    )
+                except Exception as e:
+                    logger.warning(
+                        f"Error checking agent {sanitize_agent_id(agent.agent_id)} health: {e}"
+                    )
+            pending = [agent for agent in running if agent.agent_id in headers]
 
-                        auth = get_agent_auth()
-                        headers = auth.get_auth_headers(
-                            agent.agent_id,
-                            occurrence_id=agent.occurrence_id,
-                            server_id=agent.server_id,
+            async with get_agent_http_client() as client:
+
+                async def poll(agent: AgentInfo) -> Optional[Dict[str, str]]:
+                    async with semaphore:
+                        return await self._poll_canary_agent(
+                            client, agent, headers[agent.agent_id]
                         )
 
-                        # Check health endpoint (using system/health which is the correct endpoint)
-                        agent_url = self._get_agent_url(agent)
-                        health_url = f"{agent_url}/v1/system/health"
-                        response = await client.get(health_url, headers=headers)
+                polls = await asyncio.gather(*(poll(agent) for agent in pending))
 
-                        if response.status_code == 200:
-                            health_data = response.json()
-                            if isinstance(health_data, dict) and health_data.get("data"):
-                                health_data = health_data["data"]
-
-                            cognitive_state = (health_data.get("cognitive_state") or "").lower()
-                            version = health_data.get("version") or "unknown"
-
-                            # Check if agent is in WORK state
-                            if cognitive_state == "work":
-                                if agent.agent_id not in agents_in_work:
-                                    agents_in_work[agent.agent_id] = datetime.now(timezone.utc)
-                                    logger.info(
-                                        f"Agent {agent.agent_id} reached WORK state with version {version}"
-                                    )
-
-                                # Check if agent has been stable for required period
-                                work_duration = (
-                                    datetime.now(timezone.utc) - agents_in_work[agent.agent_id]
-                                ).total_seconds() / 60
-
-                                if work_duration >= stability_minutes:
-                                    # Agent has been in WORK state for required duration
-                                    # Try to check telemetry for incidents, but don't block on it
-                                    recent_critical = False
-                                    telemetry_checked = False
-
-                                    try:
-                                        agent_url = self._get_agent_url(agent)
-                                        telemetry_url = f"{agent_url}/v1/telemetry/overview"
-                                        telemetry_response = await client.get(
-                                            telemetry_url, headers=headers, timeout=5.0
-                                        )
-
-                                        if telemetry_response.status_code == 200:
-                                            telemetry_data = telemetry_response.json()
-                                            if isinstance(
-                                                telemetry_data, dict
-                                            ) and telemetry_data.get("data"):
-                                                telemetry_data = telemetry_data["data"]
-
-                                            incidents = telemetry_data.get("recent_incidents", [])
-
-                                            # Handle case where incidents might be an int (count) instead of list
-                                            if isinstance(incidents, int):
-                                                incidents = []  # No incidents if it's just a count
-                                            elif not isinstance(incidents, list):
-                                                logger.warning(
-                                                    f"Unexpected incidents type for {agent.agent_id}: {type(incidents)}"
-                                                )
-                                                incidents = []
-
-                                            # Check for critical incidents in the last stability_minutes
-                                            cutoff_time = datetime.now(timezone.utc).timestamp() - (
-                                                stability_minutes * 60
-                                            )
-
-                                            for incident in incidents:
-                                                if incident.get("severity") in ["critical", "high"]:
-                                                    incident_time = incident.get("timestamp", 0)
-                                                    if isinstance(incident_time, str):
-                                                        # Parse ISO timestamp
-                                                        from dateutil import parser
-
-                                                        incident_time = parser.parse(
-                                                            incident_time
-                                                        ).timestamp()
-                                                    if incident_time > cutoff_time:
-                                                        recent_critical = True
-                                                        break
-
-                                            telemetry_checked = True
-                                        else:
-                                            logger.warning(
-                                                f"Telemetry endpoint returned {telemetry_response.status_code} "
-                                                f"for agent {agent.agent_id}, proceeding without incident check"
-                                            )
-                                    except Exception as e:
-                                        # Telemetry check failed, but agent is in WORK state
-                                        logger.warning(
-                                            f"Could not check telemetry for agent {agent.agent_id}: {e}. "
-                                            f"Proceeding based on WORK state alone."
-                                        )
-
-                                    # If there were critical incidents, skip this agent
-                                    if recent_critical:
-                                        logger.warning(
-                                            f"Agent {agent.agent_id} has recent critical incidents, "
-                                            f"continuing to monitor"
-                                        )
-                                        continue
-
-                                    # Agent is stable in WORK state (with or without telemetry confirmation)
-                                    if telemetry_checked:
-                                        logger.info(
-                                            f"Agent {agent.agent_id} is stable in WORK state "
-                                            f"for {work_duration:.1f} minutes with no critical incidents"
-                                        )
-                                    else:
-                                        logger.info(
-                                            f"Agent {agent.agent_id} is stable in WORK state "
-                                            f"for {work_duration:.1f} minutes (telemetry unavailable)"
-                                        )
-
-                                    # Add event for agent reaching stable WORK
-                                    self._add_event(
-                                        deployment_id,
-                                        "agent_stable",
-                                        f"{agent.agent_name} reached stable WORK state",
-                                        {
-                                            "agent_id": agent.agent_id,
-                                            "phase": phase_name,
-                                            "time_to_work": round(work_duration, 1),
-                                            "version": version,
-                                            "telemetry_checked": telemetry_checked,
-                                        },
-                                    )
-
-                                    # Calculate time to reach WORK
-                                    time_to_work = (
-                                        agents_in_work[agent.agent_id] - start_time
-                                    ).total_seconds() / 60
-
-                                    results = {
-                                        "successful_agent": agent.agent_id,
-                                        "time_to_work_minutes": round(time_to_work, 1),
-                                        "stability_duration_minutes": round(work_duration, 1),
-                                        "version": version,
-                                        "telemetry_available": telemetry_checked,
-                                    }
-                                    return True, results
-                            else:
-                                # Agent not in WORK state, remove from tracking
-                                if agent.agent_id in agents_in_work:
-                                    del agents_in_work[agent.agent_id]
-                                    logger.warning(
-                                        f"Agent {agent.agent_id} left WORK state, now in {cognitive_state}"
-                                    )
-
-                except httpx.ConnectError as e:
-                    # Connection errors are expected when container is starting
-                    logger.debug(f"Agent {agent.agent_id} not ready yet: {e}")
-                except Exception as e:
-                    # Log other errors but don't fail the deployment
+                now = datetime.now(timezone.utc)
+                candidates = []
+                for agent, health in zip(pending, polls):
+                    if health is None:
+                        continue
+                    if health["cognitive_state"] == "work":
+                        if agent.agent_id not in agents_in_work:
+                            agents_in_work[agent.agent_id] = now
+                            time_to_work.setdefault(
+                                agent.agent_id, (now - start_time).total_seconds() / 60
+                            )
+                            logger.info(
+                                f"Agent {agent.agent_id} reached WORK state with version "
+                                f"{health['version']}"
+                            )
+                        work_duration = (now - agents_in_work[agent.agent_id]).total_seconds() / 60
+                        if work_duration >= stability_minutes:
+                            candidates.append((agent, health["version"], work_duration))
+                    elif agent.agent_id in agents_in_work:
+                        # Agent not in WORK state, remove from tracking
+                        del agents_in_work[agent.agent_id]
+                        logger.warning(
+                            f"Agent {agent.agent_id} left WORK state, "
+                            f"now in {health['cognitive_state']}"
+                        )
+
+                # Only confirm as many agents as the quorum still needs, longest in WORK first
+                candidates.sort(key=lambda candidate: candidate[2], reverse=True)
+                candidates = candidates[: needed - len(stable)]
+
+                async def incidents(agent: AgentInfo) -> tuple[bool, bool]:
+                    async with semaphore:
+                        return await self._check_recent_incidents(
+                            client, agent, headers[agent.agent_id], stability_minutes
+                        )
+
+                checks = await asyncio.gather(*(incidents(agent) for agent, _, _ in candidates))
+
+            for (agent, version, work_duration), (recent_critical, telemetry_checked) in zip(
+                candidates, checks
+            ):
+                # If there were critical incidents, skip this agent
+                if recent_critical:
                     logger.warning(
-                        f"Error checking agent {sanitize_agent_id(agent.agent_id)} health: {e}"
+                        f"Agent {agent.agent_id} has recent critical incidents, "
+                        f"continuing to monitor"
                     )
+                    continue
+
+                # Agent is stable in WORK state (with or without telemetry confirmation)
+                detail = (
+                    "with no critical incidents" if telemetry_checked else "(telemetry unavailable)"
+                )
+                logger.info(
+                    f"Agent {agent.agent_id} is stable in WORK state "
+                    f"for {work_duration:.1f} minutes {detail}"
+                )
+
+                # Add event for agent reaching stable WORK
+                self._add_event(
+                    deployment_id,
+                    "agent_stable",
+                    f"{agent.agent_name} reached stable WORK state",
+                    {
+                        "agent_id": agent.agent_id,
+                        "phase": phase_name,
+                        "time_to_work": round(time_to_work[agent.agent_id], 1),
+                        "version": version,
+                        "telemetry_checked": telemetry_checked,
+                    },
+                )
+                stable[agent.agent_id] = {
+                    "time_to_work_minutes": round(time_to_work[agent.agent_id], 1),
+                    "stability_duration_minutes": round(work_duration, 1),
+                    "version": version,
+                    "telemetry_available": telemetry_checked,
+                }
+
+            if len(stable) >= needed:
+                first_id = next(iter(stable))
+                # Agents still starting only tell us they need longer than this phase ran
+                elapsed = (datetime.now(timezone.utc) - start_time).total_seconds() / 60
+                results = {
+                    "successful_agent": first_id,
+                    **stable[first_id],
+                    "stable_agents": list(stable),
+                    "time_to_work_samples": [round(t, 2) for t in time_to_work.values()],
+                    "censored_time_to_work": [
+                        round(elapsed, 2)
+                        for agent in running
+                        if agent.agent_id not in time_to_work
+                    ],
+                }
+                return True, results
 
             # Check for agents that timed out during shutdown
             await self.check_timed_out_shutdowns()
 
             # Wait before next check
-            await asyncio.sleep(10)
+            remaining = wait_until - datetime.now(timezone.utc).timestamp()
+            await asyncio.sleep(max(0, min(HEALTH_POLL_INTERVAL_SECONDS, remaining)))
 
         # Timeout reached - propose rollback to operator
         logger.warning(
-            f"Deployment {sanitize_for_log(deployment_id)}: No {sanitize_for_log(phase_name)} agents reached stable WORK state "
-            f"within {wait_for_work_minutes} minutes"
+            f"Deployment {sanitize_for_log(deployment_id)}: Only {len(stable)} of "
+            f"{required_stable} required {sanitize_for_log(phase_name)} agents reached stable "
+            f"WORK state within {wait_for_work_minutes} minutes"
         )
 
         # Stage a rollback proposal for human review
@@ -2381,7 +2855,52 @@ class DeploymentOrchestrator:
             affected_agents=agents,
         )
 
-        return False, {"failed": True, "reason": "timeout"}
+        return False, {
+            "failed": True,
+            "reason": "timeout",
+            "stable_agents": list(stable),
+            "time_to_work_samples": [round(t, 2) for t in time_to_work.values()],
+            # Agents that never reached WORK took at least the full wait
+            "censored_time_to_work": [
+                float(wait_for_work_minutes)
+                for agent in agents
+                if agent.is_running and agent.agent_id not in time_to_work
+            ],
+        }
+
+    def _recent_time_to_work_samples(self) -> tuple[List[float], List[float]]:
+        """
+        Time-to-WORK samples from the most recent completed deployments.
+
+        Returns:
+            Tuple of (minutes from update to WORK, minutes agents were watched
+            without reaching WORK), newest deployments first
+        """
+        completed = [
+            d
+            for d in self.deployments.values()
+            if d.status == "completed" and (d.time_to_work_samples or d.censored_time_to_work)
+        ]
+        completed.sort(key=lambda d: d.completed_at or "", reverse=True)
+        samples: List[float] = []
+        censored: List[float] = []
+        for deployment in completed[:RECENT_DEPLOYMENTS]:
+            samples.extend(deployment.time_to_work_samples)
+            censored.extend(deployment.censored_time_to_work)
+        return samples[:MAX_TIME_TO_WORK_SAMPLES], censored[:MAX_TIME_TO_WORK_SAMPLES]
+
+    def _record_time_to_work(self, status: DeploymentStatus, results: Dict[str, Any]) -> None:
+        """Keep a phase's time-to-WORK samples for scheduling future deployments."""
+        if not isinstance(results, dict):
+            return
+        for key, recorded in (
+            ("time_to_work_samples", status.time_to_work_samples),
+            ("censored_time_to_work", status.censored_time_to_work),
+        ):
+            samples = results.get(key)
+            if samples:
+                room = MAX_TIME_TO_WORK_SAMPLES - len(recorded)
+                recorded.extend(samples[: max(0, room)])
 
     async def _run_canary_deployment(
         self,
@@ -2466,6 +2985,15 @@ class DeploymentOrchestrator:
             f"{len(explorers)} explorers, {len(early_adopters)} early adopters, {len(general)} general"
         )
 
+        # Size phase timeouts from how long agents took to reach WORK recently
+        history, censored_history = self._recent_time_to_work_samples()
+        schedule = CanarySchedule(history, DEFAULT_WAIT_FOR_WORK_MINUTES, censored_history)
+        logger.info(
+            f"Deployment {deployment_id}: Canary wait for WORK "
+            f"{schedule.wait_for_work_minutes()} minutes "
+            f"({len(history)} samples from recent deployments)"
+        )
+
         # Phase 1: Explorers (if any)
         from ciris_manager.audit import audit_deployment_action
 
@@ -2484,19 +3012,21 @@ class DeploymentOrchestrator:
             # First group - no peer results to share
             await self._update_agent_group(deployment_id, notification, explorers, None)
 
-            # Wait for at least one explorer to reach WORK state and be stable
+            # Wait for a quorum of explorers to reach WORK state and be stable
             success, results = await self._check_canary_group_health(
                 deployment_id,
                 explorers,
                 "explorer",
-                wait_for_work_minutes=DEFAULT_WAIT_FOR_WORK_MINUTES,
-                stability_minutes=1,
+                wait_for_work_minutes=schedule.wait_for_work_minutes(),
+                stability_minutes=schedule.stability_minutes(0),
+                required_stable=schedule.required_stable(len(explorers)),
             )
+            self._record_time_to_work(status, results)
 
             if success:
                 # Update peer results
                 peer_results["explorers"]["total"] = len(explorers)
-                peer_results["explorers"]["successful"] = 1
+                peer_results["explorers"]["successful"] = len(results.get("stable_agents") or [1])
                 peer_results["explorers"]["time_to_work"].append(
                     results.get("time_to_work_minutes", 0)
                 )
@@ -2548,19 +3078,23 @@ class DeploymentOrchestrator:
                 deployment_id, notification, early_adopters, peer_results_to_pass
             )
 
-            # Wait for at least one early adopter to reach WORK state and be stable
+            # Wait for a quorum of early adopters to reach WORK state and be stable
             success, results = await self._check_canary_group_health(
                 deployment_id,
                 early_adopters,
                 "early adopter",
-                wait_for_work_minutes=DEFAULT_WAIT_FOR_WORK_MINUTES,
-                stability_minutes=1,
+                wait_for_work_minutes=schedule.wait_for_work_minutes(),
+                stability_minutes=schedule.stability_minutes(0),
+                required_stable=schedule.required_stable(len(early_adopters)),
             )
+            self._record_time_to_work(status, results)
 
             if success:
                 # Update peer results
                 peer_results["early_adopters"]["total"] = len(early_adopters)
-                peer_results["early_adopters"]["successful"] = 1
+                peer_results["early_adopters"]["successful"] = len(
+                    results.get("stable_agents") or [1]
+                )
                 peer_results["early_adopters"]["time_to_work"].append(
                     results.get("time_to_work_minutes", 0)
                 )
@@ -2598,10 +3132,9 @@ class DeploymentOrchestrator:
                 f"Deployment {deployment_id}: No early adopter agents assigned, skipping phase"
             )
 
-        # Phase 3: General Population (if any)
+        # Phase 3: General Population (if any), in waves that grow as the release proves out
         if general:
             status.canary_phase = "general"
-            status.message = f"Notifying {len(general)} general agents"
             self._save_state()
             logger.info(
                 f"Deployment {deployment_id}: Starting general phase with {len(general)} pre-assigned agents"
@@ -2611,24 +3144,63 @@ class DeploymentOrchestrator:
                 action="canary_phase_started",
                 details={"phase": "general", "agent_count": len(general)},
             )
-            await self._update_agent_group(deployment_id, notification, general, peer_results)
 
-            # For general population, just log if they don't reach WORK state (don't fail deployment)
-            success, results = await self._check_canary_group_health(
-                deployment_id,
-                general,
-                "general",
-                wait_for_work_minutes=DEFAULT_WAIT_FOR_WORK_MINUTES,
-                stability_minutes=1,
+            # Samples from this deployment's canaries count towards confidence
+            schedule = CanarySchedule(
+                history + status.time_to_work_samples,
+                DEFAULT_WAIT_FOR_WORK_MINUTES,
+                censored_history + status.censored_time_to_work,
             )
-            if success:
-                logger.info(
-                    f"Deployment {deployment_id}: General phase agents reached stable WORK state"
-                )
-            else:
-                logger.warning(
-                    f"Deployment {sanitize_for_log(deployment_id)}: Some general phase agents did not reach stable WORK state"
+            waves = schedule.plan_waves(general)
+            for wave_index, wave in enumerate(waves):
+                wave_label = f" (wave {wave_index + 1}/{len(waves)})" if len(waves) > 1 else ""
+                status.message = f"Notifying {len(wave)} general agents{wave_label}"
+                self._save_state()
+                await self._update_agent_group(deployment_id, notification, wave, peer_results)
+
+                success, results = await self._check_canary_group_health(
+                    deployment_id,
+                    wave,
+                    "general",
+                    wait_for_work_minutes=schedule.wait_for_work_minutes(),
+                    stability_minutes=schedule.stability_minutes(wave_index),
+                    required_stable=schedule.required_stable(len(wave)),
                 )
+                self._record_time_to_work(status, results)
+
+                if success:
+                    logger.info(
+                        f"Deployment {deployment_id}: General phase agents{wave_label} "
+                        f"reached stable WORK state"
+                    )
+                elif wave_index == len(waves) - 1:
+                    # Final wave: just log if they don't reach WORK state (don't fail deployment)
+                    logger.warning(
+                        f"Deployment {sanitize_for_log(deployment_id)}: Some general phase agents did not reach stable WORK state"
+                    )
+                else:
+                    # Later waves have not been touched yet - stop before widening the blast radius
+                    status.message = (
+                        f"General phase wave {wave_index + 1} failed - "
+                        f"{sum(len(w) for w in waves[wave_index + 1:])} agents not updated"
+                    )
+                    status.status = "failed"
+                    self.current_deployment = None
+                    self._save_state()
+                    logger.error(
+                        f"Deployment {deployment_id}: General wave {wave_index + 1} failed, "
+                        f"halting remaining waves"
+                    )
+                    audit_deployment_action(
+                        deployment_id=deployment_id,
+                        action="canary_phase_failed",
+                        details={
+                            "phase": "general",
+                            "wave": wave_index + 1,
+                            "reason": "no_stable_work_state",
+                        },
+                    )
+                    return
         else:
             logger.info(f"Deployment {deployment_id}: No general agents assigned, skipping phase")
 
@@ -2692,6 +3264,7 @@ class DeploymentOrchestrator:
         """
         status = self.deployments[deployment_id]
         tasks = []
+        regenerated = await self._regenerate_group_composes(agents)
 
         for agent in agents:
             task = asyncio.create_task(
@@ -2702,7 +3275,10 @@ class DeploymentOrchestrator:
             task.add_done_callback(self._background_tasks.discard)
 
         # Run updates in parallel
-        results = await asyncio.gather(*tasks, return_exceptions=True)
+        try:
+            results = await asyncio.gather(*tasks, return_exceptions=True)
+        finally:
+            self._regenerated_composes.difference_update(regenerated)
 
         # Count results
         for result in results:
@@ -2724,6 +3300,37 @@ class DeploymentOrchestrator:
         # Save state after updating counts
         self._save_state()
 
+    async def _regenerate_group_composes(self, agents: List[AgentInfo]) -> Set[str]:
+        """
+        Regenerate the compose files of a group's local agents in one batch.
+
+        Agents covered here skip per-agent regeneration in _prepare_local_compose.
+
+        Args:
+            agents: Agents in the deployment group
+
+        Returns:
+            IDs of the agents whose compose file is now up to date
+        """
+        if not (self.manager and hasattr(self.manager, "regenerate_local_composes")):
+            return set()
+        local_ids = [a.agent_id for a in agents if self._is_local_server(a.server_id)]
+        if not local_ids:
+            return set()
+        try:
+            changes = await self.manager.regenerate_local_composes(local_ids)
+            regenerated = set(changes.changed) | set(changes.unchanged)
+        except Exception as e:
+            logger.warning(f"Batch compose regeneration failed, regenerating per agent: {e}")
+            return set()
+
+        self._regenerated_composes.update(regenerated)
+        logger.info(
+            f"Regenerated compose files for {len(local_ids)} local agent(s): "
+            f"{len(changes.changed)} changed, {len(changes.unchanged)} unchanged"
+        )
+        return regenerated
+
     async def _update_single_agent(
         self,
         deployment_id: str,
@@ -2944,11 +3551,19 @@ class DeploymentOrchestrator:
                     deployment.agents_in_progress[agent.agent_id] = "waiting_for_shutdown"
                     self._save_state()
 
+                    # Build the replacement container while the agent shuts down
+                    prestage_task = self._start_container_prestage(
+                        agent.agent_id, agent.server_id, notification.agent_image, deployment_id
+                    )
+
                     # Wait for container to stop and recreate it with new image
                     logger.info(f"Waiting for container {agent.container_name} to stop...")
                     stopped = await self._wait_for_container_stop(agent.container_name, timeout=60)
 
                     if stopped:
+                        if prestage_task:
+                            await asyncio.shield(prestage_task)
+
                         # Update state to show we're restarting
                         deployment.agents_in_progress[agent.agent_id] = "restarting"
                         self._save_state()
@@ -3280,6 +3895,9 @@ class DeploymentOrchestrator:
 
                 except docker.errors.NotFound:
                     logger.warning(f"Container {container_name} not found, may have been removed")
+                    await self._discard_prestage(
+                        agent_id, agent_info.server_id if agent_info else "main"
+                    )
                     return
                 except Exception as e:
                     logger.error(f"Error checking container status: {e}")
@@ -3292,6 +3910,7 @@ class DeploymentOrchestrator:
             logger.error(
                 f"Agent {agent_id} never stopped after {max_wait} seconds, giving up on update"
             )
+            await self._discard_prestage(agent_id, agent_info.server_id if agent_info else "main")
 
             # Mark as failed in deployment
             if deployment_id in self.deployments:
@@ -3354,12 +3973,468 @@ class DeploymentOrchestrator:
         logger.warning(f"Timeout waiting for container {container_name} to stop")
         return False
 
+    def _is_local_server(self, server_id: Optional[str]) -> bool:
+        """Whether the manager runs on the same host as the server (compose vs Docker API)."""
+        if self.manager and hasattr(self.manager, "docker_client") and self.manager.docker_client:
+            try:
+                return bool(self.manager.docker_client.get_server_config(server_id).is_local)
+            except Exception:
+                # If we can't get config, assume not local for safety
+                return False
+        return False
+
+    def _find_agent_container_name(self, agent_id: str, server_id: Optional[str]) -> str:
+        """
+        Find the actual container name for an agent on its server.
+
+        Multi-occurrence agents have suffixes like -002, so the name is looked up
+        from container environments rather than derived from the agent ID.
+
+        Args:
+            agent_id: Agent identifier
+            server_id: Server where the agent is hosted
+
+        Returns:
+            Container name (ciris-{agent_id} if no container was found)
+        """
+        container_name = f"ciris-{agent_id}"  # Default fallback
+
+        try:
+            # Get Docker client for the server
+            if server_id == "main":
+                import docker as docker_lib
+
+                docker_client_for_search = docker_lib.from_env()
+            else:
+                if self.manager and hasattr(self.manager, "docker_client"):
+                    docker_client_for_search = self.manager.docker_client.get_client(server_id)
+                else:
+                    raise RuntimeError(f"Cannot get Docker client for server {server_id}")
+
+            # List containers that match the agent_id pattern
+            # Use all=True to include stopped/exited containers (important for recreation)
+            containers = docker_client_for_search.containers.list(all=True)
+            for container in containers:
+                # Check if this container belongs to our agent
+                env_vars = container.attrs.get("Config", {}).get("Env", [])
+                for env in env_vars:
+                    if env.startswith(f"CIRIS_AGENT_ID={agent_id}"):
+                        # Found it! Use the actual container name
+                        if container.name:
+                            container_name = container.name
+                        logger.info(
+                            f"Found actual container name for {agent_id} on {server_id}: {container_name}"
+                        )
+                        break
+                if container_name != f"ciris-{agent_id}":
+                    break  # Found it, stop searching
+
+        except Exception as e:
+            logger.warning(
+                f"Could not find container for {agent_id} on {server_id}, using default name: {e}"
+            )
+
+        return container_name
+
+    @staticmethod
+    def _capture_container_config(container: Any) -> Dict[str, Any]:
+        """Capture the configuration needed to recreate a container."""
+        config = container.attrs.get("Config", {})
+        host_config = container.attrs.get("HostConfig", {})
+        return {
+            "image": container.image.tags[0] if container.image.tags else container.image.id,
+            "environment": config.get("Env", []),
+            "volumes": host_config.get("Binds", []),
+            "ports": host_config.get("PortBindings", {}),
+            "networks": list(container.attrs.get("NetworkSettings", {}).get("Networks", {}).keys()),
+            "restart_policy": host_config.get("RestartPolicy", {}),
+            "labels": config.get("Labels", {}),
+            "command": config.get("Cmd"),
+            "entrypoint": config.get("Entrypoint"),
+            "user": config.get("User") or None,
+            "healthcheck": config.get("Healthcheck"),
+            # Resource limits and other host settings that are set (zero means unset)
+            "host_options": {
+                option: host_config[key]
+                for key, option in CAPTURED_HOST_OPTIONS.items()
+                if host_config.get(key)
+            },
+        }
+
+    @staticmethod
+    def _create_container_from_config(
+        docker_client: Any,
+        config: Dict[str, Any],
+        name: str,
+        image: str,
+        environment: Any,
+    ) -> Any:
+        """
+        Create (without starting) a container from a captured configuration.
+
+        Args:
+            docker_client: Docker client of the container's server
+            config: Configuration from _capture_container_config
+            name: Container name
+            image: Image to run
+            environment: Environment for the new container
+
+        Returns:
+            The created container
+        """
+        networks = config.get("networks") or []
+        container = docker_client.containers.create(
+            image=image,
+            name=name,
+            environment=environment,
+            volumes=config["volumes"],
+            ports=config["ports"],
+            network=networks[0] if networks else None,
+            restart_policy=config["restart_policy"],
+            labels=config["labels"],
+            command=config.get("command"),
+            entrypoint=config.get("entrypoint"),
+            user=config.get("user"),
+            healthcheck=config.get("healthcheck"),
+            detach=True,
+            **config.get("host_options", {}),
+        )
+        # create() attaches only one network
+        for network in networks[1:]:
+            docker_client.networks.get(network).connect(container)
+        return container
+
+    async def _prepare_local_compose(
+        self,
+        agent_id: str,
+        compose_file: Path,
+        new_image: Optional[str],
+        output: Optional[Path] = None,
+    ) -> bool:
+        """
+        Regenerate an agent's compose file and point it at the new image.
+
+        Args:
+            agent_id: Agent identifier
+            compose_file: Agent's docker-compose.yml
+            new_image: New Docker image to use (if None, keeps the current image)
+            output: Write the result here instead of back to compose_file
+
+        Returns:
+            True if the compose file is ready, False if the image could not be set
+        """
+        # Regenerate compose file to pick up latest configs (LLM, OAuth, adapters, etc.)
+        # This ensures all registry-stored configurations are applied during deployment
+        if agent_id in self._regenerated_composes:
+            # Already regenerated with the rest of its deployment group
+            self._regenerated_composes.discard(agent_id)
+        elif self.manager and hasattr(self.manager, "regenerate_agent_compose"):
+            try:
+                logger.info(f"Regenerating compose file for agent {agent_id}...")
+                await self.manager.regenerate_agent_compose(agent_id)
+                logger.info(f"Compose file regenerated with latest configs for {agent_id}")
+            except Exception as e:
+                logger.warning(f"Failed to regenerate compose for {agent_id}: {e}")
+                # Continue with existing compose file if regeneration fails
+
+        # If new_image is provided, update the docker-compose.yml with the new image tag
+        if new_image:
+            try:
+                import yaml
+
+                with open(compose_file, "r") as f:
+                    compose_config = yaml.safe_load(f)
+
+                # Update the image for the agent service
+                if "services" in compose_config:
+                    for service_name, service_config in compose_config["services"].items():
+                        if "image" in service_config:
+                            old_image = service_config["image"]
+                            service_config["image"] = new_image
+                            logger.info(
+                                f"Updated docker-compose.yml image: {old_image} -> {new_image}"
+                            )
+
+                # Write the updated compose file (skipped if the image was already set)
+                target = output or compose_file
+                if write_if_changed(target, ComposeGenerator.render_compose(compose_config)):
+                    logger.info(f"Saved updated {target.name} for agent {agent_id}")
+            except Exception as e:
+                logger.error(f"Failed to update docker-compose.yml with new image: {e}")
+                return False
+        elif output:
+            shutil.copyfile(compose_file, output)
+
+        return True
+
+    async def _regenerated_environment(
+        self, agent_id: str, default: Any, server_id: Optional[str] = None
+    ) -> Any:
+        """
+        Regenerate an agent's compose file and return its environment.
+
+        Args:
+            agent_id: Agent identifier
+            default: Environment to use if regeneration fails
+            server_id: Server where the agent is hosted
+
+        Returns:
+            Environment from the regenerated compose file, or the default
+        """
+        if not (self.manager and hasattr(self.manager, "regenerate_agent_compose")):
+            return default
+        try:
+            logger.info(f"Regenerating compose for remote agent {agent_id}...")
+            result = await self.manager.regenerate_agent_compose(agent_id, server_id=server_id)
+            if isinstance(result, dict) and result.get("environment"):
+                # Includes values pushed live, which the old container lacks
+                return result["environment"]
+            # Read the updated environment from the regenerated compose
+            compose_file = Path("/opt/ciris/agents") / agent_id / "docker-compose.yml"
+            if compose_file.exists():
+                import yaml
+
+                with open(compose_file, "r") as f:
+                    compose_config = yaml.safe_load(f)
+                if "services" in compose_config:
+                    for service_config in compose_config["services"].values():
+                        if "environment" in service_config:
+                            logger.info(
+                                f"Using updated environment from regenerated compose for {agent_id}"
+                            )
+                            return service_config["environment"]
+        except Exception as e:
+            logger.warning(
+                f"Failed to regenerate compose for remote {agent_id}: {e}, using old env"
+            )
+        return default
+
+    def _start_container_prestage(
+        self,
+        agent_id: str,
+        server_id: Optional[str],
+        new_image: Optional[str],
+        deployment_id: Optional[str] = None,
+    ) -> Optional["asyncio.Task[None]"]:
+        """
+        Prepare an agent's replacement container in the background.
+
+        Called once the agent has been asked to shut down, so image pull, compose
+        rendering, container creation and permission fixes overlap its graceful
+        shutdown instead of extending its downtime. _recreate_agent_container
+        picks up the result; _discard_prestage throws it away if the update
+        does not go ahead.
+
+        Args:
+            agent_id: Agent being updated
+            server_id: Server where the agent is hosted
+            new_image: Image the replacement container should run
+            deployment_id: Deployment the update belongs to
+
+        Returns:
+            The background task, or None if pre-staging is disabled
+        """
+        config = getattr(self.manager, "config", None)
+        if getattr(getattr(config, "updates", None), "prestage_containers", False) is not True:
+            return None
+
+        key = (server_id or "main", agent_id)
+        previous = self._prestaged_containers.pop(key, None)
+        if previous:
+            self._discard_prestaged_container(server_id, previous)
+
+        async def prestage() -> None:
+            try:
+                prestaged = await self._prestage_agent_container(agent_id, server_id, new_image)
+            except Exception as e:
+                logger.warning(f"Pre-staging container for {agent_id} failed: {e}")
+                return
+            finally:
+                current = self._prestage_tasks.get(key)
+                if current and current[0] is task:
+                    del self._prestage_tasks[key]
+                    dropped = False
+                else:
+                    dropped = True
+            if not prestaged:
+                return
+            if dropped:
+                # Discarded while it was still being built
+                await asyncio.to_thread(self._discard_prestaged_container, server_id, prestaged)
+                return
+            prestaged["deployment_id"] = deployment_id
+            self._prestaged_containers[key] = prestaged
+
+        task = asyncio.create_task(prestage())
+        self._prestage_tasks[key] = (task, deployment_id)
+        self._background_tasks.add(task)
+        task.add_done_callback(self._background_tasks.discard)
+        return task
+
+    async def _discard_prestage(
+        self,
+        agent_id: Optional[str] = None,
+        server_id: Optional[str] = None,
+        deployment_id: Optional[str] = None,
+    ) -> None:
+        """
+        Throw away pre-staged replacements that will not be used.
+
+        Matches one agent (agent_id and server_id) or everything staged for a
+        deployment. Staging still in progress discards its own result when it
+        finishes.
+        """
+
+        def matches(key: tuple, owner: Optional[str]) -> bool:
+            if deployment_id is not None:
+                return owner == deployment_id
+            return key == (server_id or "main", agent_id)
+
+        for key, (_, owner) in list(self._prestage_tasks.items()):
+            if matches(key, owner):
+                del self._prestage_tasks[key]
+        for key, prestaged in list(self._prestaged_containers.items()):
+            if matches(key, prestaged.get("deployment_id")):
+                del self._prestaged_containers[key]
+                await asyncio.to_thread(self._discard_prestaged_container, key[0], prestaged)
+
+    async def _prestage_agent_container(
+        self, agent_id: str, server_id: Optional[str], new_image: Optional[str]
+    ) -> Optional[Dict[str, Any]]:
+        """
+        Build everything a replacement container needs while the old one still runs.
+
+        Local agents get a regenerated compose file pointed at the new image
+        written beside the live one (STAGED_COMPOSE_NAME), its image pulled and
+        permissions fixed; the live compose file is left as it was until the
+        agent has stopped. Remote agents get the image pulled and the new
+        container created under a staging name.
+
+        Args:
+            agent_id: Agent being updated
+            server_id: Server where the agent is hosted
+            new_image: Image the replacement container should run
+
+        Returns:
+            Pre-staged container description, or None if nothing was staged
+        """
+        if self._is_local_server(server_id):
+            agent_dir = self.agent_dir / agent_id
+            compose_file = agent_dir / "docker-compose.yml"
+            if not compose_file.exists():
+                return None
+            staged_compose = agent_dir / STAGED_COMPOSE_NAME
+            original = compose_file.read_text()
+            try:
+                prepared = await self._prepare_local_compose(
+                    agent_id, compose_file, new_image, output=staged_compose
+                )
+            finally:
+                # Regeneration rewrites the live file; the running agent keeps its
+                # compose until it has stopped and the staged one is swapped in
+                write_if_changed(compose_file, original)
+            if not prepared:
+                staged_compose.unlink(missing_ok=True)
+                return None
+
+            process = await asyncio.create_subprocess_exec(
+                *compose_cmd("-f", str(staged_compose), "pull"),
+                stdout=asyncio.subprocess.PIPE,
+                stderr=asyncio.subprocess.PIPE,
+                cwd=str(agent_dir),
+            )
+            _, stderr = await process.communicate()
+            if process.returncode != 0:
+                logger.warning(f"Pre-staged pull failed for {agent_id}: {stderr.decode()}")
+                staged_compose.unlink(missing_ok=True)
+                return None
+
+            await fix_agent_permissions(agent_dir)
+            logger.info(f"Pre-staged compose and image for agent {agent_id}")
+            return {"local": True, "image": new_image, "staged_compose": str(staged_compose)}
+
+        if not (self.manager and hasattr(self.manager, "docker_client")):
+            return None
+
+        # docker-py blocks, so every call runs in a worker thread to keep the
+        # event loop (health polls, other agents' shutdowns) moving during the pull
+        docker_client = self.manager.docker_client.get_client(server_id)
+        container_name = await asyncio.to_thread(
+            self._find_agent_container_name, agent_id, server_id
+        )
+        staged_name = f"{container_name}-next"
+
+        old_container = await asyncio.to_thread(docker_client.containers.get, container_name)
+        old_config = self._capture_container_config(old_container)
+        target_image = new_image if new_image else old_config["image"]
+        environment = await self._regenerated_environment(
+            agent_id, old_config["environment"], server_id
+        )
+
+        await asyncio.to_thread(docker_client.images.pull, target_image)
+
+        def create_staged() -> None:
+            # Clear out a staging container left by an earlier attempt
+            try:
+                docker_client.containers.get(staged_name).remove(force=True)
+            except Exception:
+                pass
+
+            # Ports are only bound on start, so this can coexist with the old container
+            self._create_container_from_config(
+                docker_client, old_config, staged_name, target_image, environment
+            )
+
+        try:
+            await asyncio.to_thread(create_staged)
+        except BaseException:
+            # Never leave a half-made staging container behind
+            await asyncio.to_thread(self._remove_staged_container, docker_client, staged_name)
+            raise
+        logger.info(f"Pre-staged container {staged_name} on server {server_id}")
+        return {
+            "local": False,
+            "image": new_image,
+            "container_name": container_name,
+            "staged_name": staged_name,
+            "target_image": target_image,
+            "environment": environment,
+        }
+
+    def _discard_prestaged_container(
+        self, server_id: Optional[str], prestaged: Dict[str, Any]
+    ) -> None:
+        """Remove a pre-staged compose file or remote container that will not be used."""
+        if prestaged.get("local"):
+            if prestaged.get("staged_compose"):
+                Path(prestaged["staged_compose"]).unlink(missing_ok=True)
+            return
+        if not self.manager:
+            return
+        try:
+            docker_client = self.manager.docker_client.get_client(server_id)
+        except Exception as e:
+            logger.debug(f"Could not remove pre-staged container: {e}")
+            return
+        self._remove_staged_container(docker_client, prestaged["staged_name"])
+
+    @staticmethod
+    def _remove_staged_container(docker_client: Any, staged_name: str) -> None:
+        """Force-remove a "-next" staging container if it exists."""
+        try:
+            docker_client.containers.get(staged_name).remove(force=True)
+        except Exception as e:
+            logger.debug(f"Could not remove pre-staged container {staged_name}: {e}")
+
     async def _recreate_agent_container(
         self, agent_id: str, server_id: Optional[str] = "main", new_image: Optional[str] = None
     ) -> bool:
         """
         Recreate an agent container using Docker API.
 
+        If the replacement was pre-staged during the agent's shutdown, only the
+        switch to the new container remains.
+
         Args:
             agent_id: ID of the agent to recreate
             server_id: Server where the agent is hosted (default: "main")
@@ -3381,63 +4456,27 @@ class DeploymentOrchestrator:
                     return True  # Return True to avoid deployment failure, but skip the operation
 
             logger.info(f"Recreating container for agent {agent_id} on server {server_id}...")
+            self._preview_cache.invalidate_agent(agent_id)
 
-            # Find the actual container name by listing containers on the target server
-            # (important for multi-occurrence agents which have suffixes like -002)
-            container_name = f"ciris-{agent_id}"  # Default fallback
+            prestaged = self._prestaged_containers.pop((server_id or "main", agent_id), None)
+            if prestaged and prestaged.get("image") != new_image:
+                # Staged for a different image (e.g. a newer deployment superseded it)
+                self._discard_prestaged_container(server_id, prestaged)
+                prestaged = None
 
-            try:
-                # Get Docker client for the server
-                if server_id == "main":
-                    import docker as docker_lib
-
-                    docker_client_for_search = docker_lib.from_env()
-                else:
-                    if self.manager and hasattr(self.manager, "docker_client"):
-                        docker_client_for_search = self.manager.docker_client.get_client(server_id)
-                    else:
-                        raise RuntimeError(f"Cannot get Docker client for server {server_id}")
-
-                # List containers that match the agent_id pattern
-                # Use all=True to include stopped/exited containers (important for recreation)
-                containers = docker_client_for_search.containers.list(all=True)
-                for container in containers:
-                    # Check if this container belongs to our agent
-                    env_vars = container.attrs.get("Config", {}).get("Env", [])
-                    for env in env_vars:
-                        if env.startswith(f"CIRIS_AGENT_ID={agent_id}"):
-                            # Found it! Use the actual container name
-                            if container.name:
-                                container_name = container.name
-                            logger.info(
-                                f"Found actual container name for {agent_id} on {server_id}: {container_name}"
-                            )
-                            break
-                    if container_name != f"ciris-{agent_id}":
-                        break  # Found it, stop searching
+            # Check if this is truly a local server (manager running on same host)
+            is_local_server = self._is_local_server(server_id)
 
-            except Exception as e:
-                logger.warning(
-                    f"Could not find container for {agent_id} on {server_id}, using default name: {e}"
-                )
+            # Find the actual container name on the target server
+            # (important for multi-occurrence agents which have suffixes like -002)
+            if prestaged and not is_local_server:
+                container_name = prestaged["container_name"]
+            else:
+                container_name = self._find_agent_container_name(agent_id, server_id)
 
             old_config = None
             docker_client = None
 
-            # Check if this is truly a local server (manager running on same host)
-            is_local_server = False
-            if (
-                self.manager
-                and hasattr(self.manager, "docker_client")
-                and self.manager.docker_client
-            ):
-                try:
-                    server_config = self.manager.docker_client.get_server_config(server_id)
-                    is_local_server = server_config.is_local
-                except Exception:
-                    # If we can't get config, assume not local for safety
-                    is_local_server = False
-
             # For remote servers (including "main" when manager is on separate host), use Docker API
             if not is_local_server:
                 # Get Docker client for remote server via manager
@@ -3458,23 +4497,7 @@ class DeploymentOrchestrator:
                 try:
                     old_container = docker_client.containers.get(container_name)
                     # Store the configuration we need to recreate the container
-                    old_config = {
-                        "image": old_container.image.tags[0]
-                        if old_container.image.tags
-                        else old_container.image.id,
-                        "environment": old_container.attrs.get("Config", {}).get("Env", []),
-                        "volumes": old_container.attrs.get("HostConfig", {}).get("Binds", []),
-                        "ports": old_container.attrs.get("HostConfig", {}).get("PortBindings", {}),
-                        "networks": list(
-                            old_container.attrs.get("NetworkSettings", {})
-                            .get("Networks", {})
-                            .keys()
-                        ),
-                        "restart_policy": old_container.attrs.get("HostConfig", {}).get(
-                            "RestartPolicy", {}
-                        ),
-                        "labels": old_container.attrs.get("Config", {}).get("Labels", {}),
-                    }
+                    old_config = self._capture_container_config(old_container)
                     logger.info(f"Captured configuration from container {container_name}")
 
                     # Stop and remove the old container
@@ -3484,9 +4507,13 @@ class DeploymentOrchestrator:
                     logger.info(f"Removed container {container_name}")
                 except docker.errors.NotFound:
                     logger.warning(f"Container {container_name} not found, cannot capture config")
+                    if prestaged:
+                        self._discard_prestaged_container(server_id, prestaged)
                     return False
                 except Exception as e:
                     logger.error(f"Error getting/removing old container: {e}")
+                    if prestaged:
+                        self._discard_prestaged_container(server_id, prestaged)
                     return False
 
             # For local server, use docker-compose as before
@@ -3499,53 +4526,23 @@ class DeploymentOrchestrator:
                     logger.error(f"Docker compose file not found: {compose_file}")
                     return False
 
-                # Regenerate compose file to pick up latest configs (LLM, OAuth, adapters, etc.)
-                # This ensures all registry-stored configurations are applied during deployment
-                if self.manager and hasattr(self.manager, "regenerate_agent_compose"):
-                    try:
-                        logger.info(f"Regenerating compose file for agent {agent_id}...")
-                        await self.manager.regenerate_agent_compose(agent_id)
-                        logger.info(f"Compose file regenerated with latest configs for {agent_id}")
-                    except Exception as e:
-                        logger.warning(f"Failed to regenerate compose for {agent_id}: {e}")
-                        # Continue with existing compose file if regeneration fails
-
-                # If new_image is provided, update the docker-compose.yml with the new image tag
-                if new_image:
+                # The agent has stopped: swap in the pre-staged compose file
+                if prestaged:
                     try:
-                        import yaml
-
-                        with open(compose_file, "r") as f:
-                            compose_config = yaml.safe_load(f)
-
-                        # Update the image for the agent service
-                        if "services" in compose_config:
-                            for service_name, service_config in compose_config["services"].items():
-                                if "image" in service_config:
-                                    old_image = service_config["image"]
-                                    service_config["image"] = new_image
-                                    logger.info(
-                                        f"Updated docker-compose.yml image: {old_image} -> {new_image}"
-                                    )
-
-                        # Write the updated compose file
-                        with open(compose_file, "w") as f:
-                            yaml.dump(
-                                compose_config,
-                                f,
-                                default_flow_style=False,
-                                sort_keys=False,
-                                width=120,
-                            )
-                        logger.info(f"Saved updated docker-compose.yml for agent {agent_id}")
-                    except Exception as e:
-                        logger.error(f"Failed to update docker-compose.yml with new image: {e}")
-                        return False
+                        os.replace(prestaged["staged_compose"], compose_file)
+                    except (KeyError, OSError) as e:
+                        logger.warning(f"Pre-staged compose for {agent_id} unusable: {e}")
+                        prestaged = None
+                if not prestaged and not await self._prepare_local_compose(
+                    agent_id, compose_file, new_image
+                ):
+                    return False
 
                 # Run docker-compose up -d with --pull always to use the newly pulled image
+                pull_policy = "missing" if prestaged else "always"
                 logger.info(f"Starting new container for agent {agent_id}...")
                 result = await asyncio.create_subprocess_exec(
-                    *compose_cmd("-f", str(compose_file), "up", "-d", "--pull", "always"),
+                    *compose_cmd("-f", str(compose_file), "up", "-d", "--pull", pull_policy),
                     stdout=asyncio.subprocess.PIPE,
                     stderr=asyncio.subprocess.PIPE,
                     cwd=str(agent_dir),
@@ -3557,6 +4554,29 @@ class DeploymentOrchestrator:
                     return False
 
                 logger.info(f"Successfully ran docker-compose up for agent {agent_id}")
+            elif prestaged:
+                # Old container is gone - promote the pre-staged one into its place
+                assert docker_client is not None, "docker_client should be set for remote servers"
+                try:
+                    new_container = docker_client.containers.get(prestaged["staged_name"])
+                    new_container.rename(container_name)
+                    new_container.start()
+                    logger.info(
+                        f"Started pre-staged container {container_name} on server {server_id}"
+                    )
+
+                    # Sync compose file to remote server so manual restarts use correct image
+                    if server_id is not None:
+                        await self._sync_compose_to_remote_server(
+                            agent_id=agent_id,
+                            server_id=server_id,
+                            docker_client=docker_client,
+                            target_image=prestaged["target_image"],
+                            updated_environment=prestaged["environment"],
+                        )
+                except Exception as e:
+                    logger.error(f"Failed to start pre-staged container: {e}")
+                    return False
             else:
                 # For remote servers, use Docker API to recreate container
                 logger.info(
@@ -3574,31 +4594,9 @@ class DeploymentOrchestrator:
                 assert docker_client is not None, "docker_client should be set for remote servers"
 
                 # Regenerate compose to get latest environment (LLM, OAuth, adapters, etc.)
-                updated_environment = old_config["environment"]
-                if self.manager and hasattr(self.manager, "regenerate_agent_compose"):
-                    try:
-                        logger.info(f"Regenerating compose for remote agent {agent_id}...")
-                        await self.manager.regenerate_agent_compose(agent_id)
-                        # Read the updated environment from the regenerated compose
-                        agent_dir = Path("/opt/ciris/agents") / agent_id
-                        compose_file = agent_dir / "docker-compose.yml"
-                        if compose_file.exists():
-                            import yaml
-
-                            with open(compose_file, "r") as f:
-                                compose_config = yaml.safe_load(f)
-                            if "services" in compose_config:
-                                for service_config in compose_config["services"].values():
-                                    if "environment" in service_config:
-                                        updated_environment = service_config["environment"]
-                                        logger.info(
-                                            f"Using updated environment from regenerated compose for {agent_id}"
-                                        )
-                                        break
-                    except Exception as e:
-                        logger.warning(
-                            f"Failed to regenerate compose for remote {agent_id}: {e}, using old env"
-                        )
+                updated_environment = await self._regenerated_environment(
+                    agent_id, old_config["environment"], server_id
+                )
 
                 # Pull the new image first
                 logger.info(f"Pulling image {target_image} on remote server {server_id}...")
@@ -3612,16 +4610,12 @@ class DeploymentOrchestrator:
                 # Create new container with updated image and environment
                 logger.info(f"Creating new container {container_name} on server {server_id}...")
                 try:
-                    new_container = docker_client.containers.create(
-                        image=target_image,
-                        name=container_name,
-                        environment=updated_environment,
-                        volumes=old_config["volumes"],
-                        ports=old_config["ports"],
-                        network=old_config["networks"][0] if old_config["networks"] else None,
-                        restart_policy=old_config["restart_policy"],
-                        labels=old_config["labels"],
-                        detach=True,
+                    new_container = self._create_container_from_config(
+                        docker_client,
+                        old_config,
+                        container_name,
+                        target_image,
+                        updated_environment,
                     )
                     new_container.start()
                     logger.info(
@@ -3641,30 +4635,20 @@ class DeploymentOrchestrator:
                     logger.error(f"Failed to create container via Docker API: {e}")
                     return False
 
-            # Fix permissions on agent directories (local server only)
-            if is_local_server:
+            # Fix permissions on agent directories (done if pre-staged)
+            if is_local_server and not prestaged:
                 agent_dir = Path("/opt/ciris/agents") / agent_id
                 logger.info(f"Fixing permissions for agent {agent_id} directories...")
-                helper_script = Path("/usr/local/bin/ciris-fix-permissions")
-                if helper_script.exists():
-                    perm_result = await asyncio.create_subprocess_exec(
-                        str(helper_script),
-                        str(agent_dir),
-                        stdout=asyncio.subprocess.PIPE,
-                        stderr=asyncio.subprocess.PIPE,
-                    )
-                    perm_stdout, perm_stderr = await perm_result.communicate()
-
-                    if perm_result.returncode == 0:
-                        logger.info(f"Successfully fixed permissions for agent {agent_id}")
-                    else:
-                        logger.warning(
-                            f"Permission fix failed for agent {agent_id}: {perm_stderr.decode()}"
-                        )
-                else:
-                    logger.warning(
-                        f"Permission helper not found at {helper_script}, skipping permission fix"
-                    )
+                if await fix_agent_permissions(agent_dir):
+                    logger.info(f"Successfully fixed permissions for agent {agent_id}")
+            elif not prestaged and server_id is not None:
+                host = get_agent_host(server_id)
+                if host:
+                    try:
+                        await host.fix_permissions(Path("/opt/ciris/agents") / agent_id)
+                        logger.info(f"Fixed permissions for agent {agent_id} on {server_id}")
+                    except AgentHostError as e:
+                        logger.warning(f"Permission fix for {agent_id} on {server_id} failed: {e}")
 
             # Wait a moment for container to start
             await asyncio.sleep(5)
@@ -3811,6 +4795,22 @@ class DeploymentOrchestrator:
             # Remote path for compose file
             remote_compose_path = f"/opt/ciris/agents/{agent_id}/docker-compose.yml"
 
+            # Write through the agent-host sidecar when the server has one
+            host = get_agent_host(server_id)
+            if host:
+                try:
+                    await host.write_file(Path(remote_compose_path), compose_content.encode())
+                    logger.info(
+                        f"✅ Synced compose file to remote server {server_id}: {remote_compose_path}"
+                    )
+                    self._save_local_compose(agent_dir, compose_file, compose_content)
+                    return True
+                except AgentHostUnavailableError as e:
+                    logger.warning(f"{e}, falling back to Docker exec")
+                except AgentHostError as e:
+                    logger.error(f"Failed to write compose file to remote: {e}")
+                    return False
+
             # Get nginx container to exec into (has /opt/ciris mounted)
             try:
                 nginx_container = docker_client.containers.get("ciris-nginx")
@@ -3831,13 +4831,7 @@ class DeploymentOrchestrator:
                 )
 
                 # Also save the updated compose file locally for consistency
-                try:
-                    agent_dir.mkdir(parents=True, exist_ok=True)
-                    with open(compose_file, "w") as f:
-                        f.write(compose_content)
-                    logger.info(f"Updated local compose file: {compose_file}")
-                except Exception as e:
-                    logger.warning(f"Could not update local compose file: {e}")
+                self._save_local_compose(agent_dir, compose_file, compose_content)
                 return True
 
             except Exception as e:
@@ -3863,6 +4857,18 @@ class DeploymentOrchestrator:
             logger.error(f"Error syncing compose file to remote server {server_id}: {e}")
             return False
 
+    def _save_local_compose(
+        self, agent_dir: Path, compose_file: Path, compose_content: str
+    ) -> None:
+        """Keep the manager's copy of a remotely synced compose file up to date."""
+        try:
+            agent_dir.mkdir(parents=True, exist_ok=True)
+            with open(compose_file, "w") as f:
+                f.write(compose_content)
+            logger.info(f"Updated local compose file: {compose_file}")
+        except Exception as e:
+            logger.warning(f"Could not update local compose file: {e}")
+
     async def _recover_interrupted_deployment(self, deployment: DeploymentStatus) -> None:
         """
         Recover an interrupted deployment after manager restart.
@@ -4243,6 +5249,9 @@ class DeploymentOrchestrator:
                 f"current={notification.agent_image}, n-1={current_agent}, n-2={n1_agent}"
             )
 
+            # The agent runs a new image now; drop adapter manifests of images in use before
+            get_manifest_cache().invalidate()
+
             # Schedule image cleanup to remove versions older than n-2
             task = asyncio.create_task(self._trigger_image_cleanup())
             self._background_tasks.add(task)
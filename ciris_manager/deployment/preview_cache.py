@@ -0,0 +1,200 @@
+"""
+Deployment preview cache.
+
+The admin UI asks for the same deployment preview repeatedly while an
+operator decides whether to launch. Each agent's preview row is cached
+against a fingerprint of its discovered state, and the assembled preview is
+kept serialized per (deployment, fleet snapshot version). A repeat call with
+an unchanged fleet is served from memory; when agents change, only their
+rows are recomputed.
+
+Rows are keyed by (agent_id, occurrence_id, server_id): occurrences of one
+agent on different servers are separate containers with their own state.
+"""
+
+import hashlib
+import json
+import time
+from dataclasses import dataclass, field
+from typing import Any, Callable, Dict, Iterable, Optional, Tuple
+
+from ciris_manager.models import AgentInfo
+
+# Seconds a cached agent row is trusted without its discovered state changing
+PREVIEW_AGENT_TTL_SECONDS = 300
+
+Fingerprint = Tuple[Any, ...]
+AgentKey = Tuple[str, Optional[str], str]
+
+
+def agent_key(agent: AgentInfo) -> AgentKey:
+    """Identify one agent instance (an occurrence on a server)."""
+    return (agent.agent_id, agent.occurrence_id, agent.server_id or "main")
+
+
+def agent_fingerprint(agent: AgentInfo, canary_group: str) -> Fingerprint:
+    """
+    Fingerprint the discovered state that a preview row depends on.
+
+    Args:
+        agent: Discovered agent
+        canary_group: Agent's canary group
+
+    Returns:
+        Hashable fingerprint starting with the agent's key; changes whenever the
+        agent's row must be recomputed
+    """
+    return (
+        agent_key(agent),
+        agent.agent_name,
+        agent.container_name,
+        agent.api_port,
+        agent.status,
+        agent.image,
+        agent.version,
+        agent.code_hash,
+        canary_group,
+    )
+
+
+def fleet_version(fingerprints: Iterable[Fingerprint]) -> str:
+    """
+    Compute a version for a fleet snapshot.
+
+    Args:
+        fingerprints: Fingerprints of every discovered agent
+
+    Returns:
+        Digest that changes whenever any agent is added, removed or changed
+    """
+    digest = hashlib.sha256()
+    for fingerprint in sorted(fingerprints, key=repr):
+        digest.update(repr(fingerprint).encode())
+    return digest.hexdigest()[:16]
+
+
+@dataclass
+class _AgentRow:
+    fingerprint: Fingerprint
+    detail: Dict[str, Any]
+    computed_at: float
+
+
+@dataclass
+class _DeploymentPreviews:
+    rows: Dict[AgentKey, _AgentRow] = field(default_factory=dict)
+    fleet_version: Optional[str] = None
+    serialized: Optional[bytes] = None
+    expires_at: float = 0.0
+    shutdown_reasons: Dict[Tuple[bool, bool], Dict[str, Any]] = field(default_factory=dict)
+
+
+class PreviewCache:
+    """Per-deployment preview rows and serialized previews."""
+
+    def __init__(
+        self,
+        ttl_seconds: float = PREVIEW_AGENT_TTL_SECONDS,
+        clock: Callable[[], float] = time.monotonic,
+    ):
+        """
+        Initialize preview cache.
+
+        Args:
+            ttl_seconds: How long an agent row is trusted without a state change
+            clock: Monotonic time source (injectable for tests)
+        """
+        self.ttl_seconds = ttl_seconds
+        self._clock = clock
+        self._deployments: Dict[str, _DeploymentPreviews] = {}
+
+    def get_preview(self, deployment_id: str, version: str) -> Optional[bytes]:
+        """Serialized preview for this fleet version, if still fresh."""
+        entry = self._deployments.get(deployment_id)
+        if (
+            entry is None
+            or entry.serialized is None
+            or entry.fleet_version != version
+            or self._clock() >= entry.expires_at
+        ):
+            return None
+        return entry.serialized
+
+    def get_row(self, deployment_id: str, fingerprint: Fingerprint) -> Optional[Dict[str, Any]]:
+        """Cached preview row for an agent, if its state has not changed."""
+        entry = self._deployments.get(deployment_id)
+        row = entry.rows.get(fingerprint[0]) if entry else None
+        if (
+            row is None
+            or row.fingerprint != fingerprint
+            or self._clock() - row.computed_at >= self.ttl_seconds
+        ):
+            return None
+        return row.detail
+
+    def store_row(
+        self, deployment_id: str, fingerprint: Fingerprint, detail: Dict[str, Any]
+    ) -> None:
+        """Cache a freshly computed preview row."""
+        entry = self._deployments.setdefault(deployment_id, _DeploymentPreviews())
+        entry.rows[fingerprint[0]] = _AgentRow(fingerprint, detail, self._clock())
+
+    def store_preview(
+        self,
+        deployment_id: str,
+        version: str,
+        agent_keys: Iterable[AgentKey],
+        preview: Dict[str, Any],
+    ) -> bytes:
+        """
+        Serialize and cache an assembled preview.
+
+        Rows for agents no longer in the fleet are dropped, and the preview
+        expires together with the oldest row it was built from.
+
+        Args:
+            deployment_id: Deployment the preview belongs to
+            version: Fleet snapshot version the preview was built from
+            agent_keys: Agents in the snapshot
+            preview: Assembled preview
+
+        Returns:
+            Serialized preview
+        """
+        entry = self._deployments.setdefault(deployment_id, _DeploymentPreviews())
+        current = set(agent_keys)
+        entry.rows = {key: row for key, row in entry.rows.items() if key in current}
+        oldest = min((row.computed_at for row in entry.rows.values()), default=self._clock())
+        entry.fleet_version = version
+        entry.serialized = json.dumps(preview).encode()
+        entry.expires_at = oldest + self.ttl_seconds
+        return entry.serialized
+
+    def get_shutdown_reasons(
+        self, deployment_id: str, groups: Tuple[bool, bool]
+    ) -> Optional[Dict[str, Any]]:
+        """Cached shutdown reasons for the given (explorers, early adopters) presence."""
+        entry = self._deployments.get(deployment_id)
+        return entry.shutdown_reasons.get(groups) if entry else None
+
+    def store_shutdown_reasons(
+        self, deployment_id: str, groups: Tuple[bool, bool], reasons: Dict[str, Any]
+    ) -> None:
+        """Cache shutdown reasons for the given (explorers, early adopters) presence."""
+        entry = self._deployments.setdefault(deployment_id, _DeploymentPreviews())
+        entry.shutdown_reasons[groups] = reasons
+
+    def invalidate_agent(self, agent_id: str) -> None:
+        """Forget every occurrence's rows (and previews containing them) in every deployment."""
+        for entry in self._deployments.values():
+            keys = [key for key in entry.rows if key[0] == agent_id]
+            for key in keys:
+                del entry.rows[key]
+            if keys:
+                entry.serialized = None
+
+    def retain(self, deployment_ids: Iterable[str]) -> None:
+        """Drop cached previews for deployments that are no longer pending."""
+        keep = set(deployment_ids)
+        for deployment_id in [d for d in self._deployments if d not in keep]:
+            del self._deployments[deployment_id]
@@ -0,0 +1,134 @@
+"""
+Agent rollback planning.
+
+Resolves the image every agent should roll back to in a single pass, before
+any container is touched, so the executor only has to verify images and
+restart agents. Per-agent history in registry metadata wins; the fleet-wide
+VersionTracker history fills the gaps.
+"""
+
+from dataclasses import dataclass, field
+from typing import Any, Dict, Iterable, List, Optional, Set, Tuple
+
+# Agents restarted at once on each server during a rollback
+ROLLBACK_CONCURRENCY_PER_SERVER = 4
+
+# Relative rollback targets and their VersionTracker slots
+TRACKER_SLOTS = {"n-1": "n_minus_1", "n-2": "n_minus_2"}
+
+
+@dataclass
+class AgentRollback:
+    """One agent's rollback target."""
+
+    agent_id: str
+    server_id: str
+    image: str
+    target: str
+
+
+@dataclass
+class RollbackPlan:
+    """Rollback targets for a set of agents, plus agents that cannot be rolled back."""
+
+    agents: List[AgentRollback] = field(default_factory=list)
+    skipped: Dict[str, str] = field(default_factory=dict)
+
+    def server_images(self) -> Set[Tuple[str, str]]:
+        """Distinct (server_id, image) pairs that must be present before restarting."""
+        return {(a.server_id, a.image) for a in self.agents}
+
+
+def pin_image(reference: str, tag: Optional[str]) -> str:
+    """
+    Turn a bare digest into a pullable reference.
+
+    Registry metadata stores previous agent images as digests; docker needs the
+    repository as well (repo@sha256:...).
+
+    Args:
+        reference: Image tag, repo@digest or bare sha256 digest
+        tag: Known image tag for the agent, used to find the repository
+
+    Returns:
+        Image reference docker can pull and run
+    """
+    if not reference.startswith("sha256:") or not tag:
+        return reference
+    repository = tag.split("@", 1)[0]
+    # Strip a tag, but not a registry port (host:5000/repo)
+    if ":" in repository.rsplit("/", 1)[-1]:
+        repository = repository.rsplit(":", 1)[0]
+    return f"{repository}@{reference}"
+
+
+def resolve_rollback_image(
+    metadata: Dict[str, Any], target: str, tracker_options: Dict[str, Any]
+) -> Optional[str]:
+    """
+    Resolve the image one agent should roll back to.
+
+    Args:
+        metadata: Agent registry metadata (previous_images, current_images)
+        target: "n-1", "n-2" or an explicit image
+        tracker_options: VersionTracker.get_rollback_options("agent") result
+
+    Returns:
+        Image reference, or None if no such version is known
+    """
+    if target not in TRACKER_SLOTS:
+        return target
+
+    previous = (metadata.get("previous_images") or {}).get(target)
+    if isinstance(previous, str) and previous and previous != "not available":
+        tag = (metadata.get("current_images") or {}).get("agent_tag")
+        return pin_image(previous, tag)
+
+    version = tracker_options.get(TRACKER_SLOTS[target])
+    if isinstance(version, dict) and version.get("image"):
+        return str(version["image"])
+    return None
+
+
+def build_rollback_plan(
+    agents: Iterable[Tuple[str, Optional[Any]]],
+    target_version: str,
+    agent_targets: Dict[str, str],
+    tracker_options: Dict[str, Any],
+) -> RollbackPlan:
+    """
+    Build the rollback plan for a set of agents.
+
+    Args:
+        agents: (agent_id, registry entry or None) pairs
+        target_version: Default target ("n-1", "n-2" or an explicit image)
+        agent_targets: Per-agent overrides of the target
+        tracker_options: VersionTracker.get_rollback_options("agent") result
+
+    Returns:
+        Rollback plan
+    """
+    plan = RollbackPlan()
+    for agent_id, agent_info in agents:
+        if agent_info is None:
+            plan.skipped[agent_id] = "not registered"
+            continue
+
+        target = agent_targets.get(agent_id, target_version)
+        metadata = getattr(agent_info, "metadata", None)
+        image = resolve_rollback_image(
+            metadata if isinstance(metadata, dict) else {}, target, tracker_options
+        )
+        if not image:
+            plan.skipped[agent_id] = f"no {target} version available"
+            continue
+
+        plan.agents.append(
+            AgentRollback(
+                agent_id=agent_id,
+                server_id=getattr(agent_info, "server_id", None) or "main",
+                image=image,
+                target=target,
+            )
+        )
+    return plan
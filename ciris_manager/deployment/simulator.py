@@ -0,0 +1,738 @@
+"""
+Deployment simulator for load-testing the orchestrator.
+
+Drives the real DeploymentOrchestrator (start_deployment, canary phases,
+_update_agent_group, _update_single_agent and _check_canary_group_health)
+against a simulated fleet:
+
+- a fake Docker backend (containers, events, image pulls, stop/recreate) with
+  configurable latency and failure rates, standing in for the orchestrator's
+  Docker-facing methods
+- fake agent HTTP endpoints that accept or reject shutdowns and move through
+  WAKEUP -> WORK after restart, standing in for httpx
+
+Time is simulated: all orchestrator sleeps and timestamps run on a virtual
+clock that advances `time_scale` times faster than the wall clock, so a
+15-minute canary phase completes in seconds. CPU work (state saves, loops
+over the fleet) is not scaled: it shows up as event-loop lag and, multiplied
+by the scale, as simulated time. If lag is high, lower --time-scale before
+reading per-stage latencies or timeouts.
+
+Usage:
+    python -m ciris_manager.deployment.simulator --agents 500 --time-scale 120
+"""
+
+import argparse
+import asyncio
+import hashlib
+import json
+import logging
+import random
+import statistics
+import tempfile
+import time
+from collections import Counter
+from contextlib import ExitStack
+from dataclasses import asdict, dataclass, field
+from datetime import datetime, timedelta, timezone
+from pathlib import Path
+from types import SimpleNamespace
+from typing import Any, Dict, List, Optional, Tuple
+from unittest.mock import patch
+from urllib.parse import urlsplit
+
+import httpx
+
+from ciris_manager.models import AgentInfo, UpdateNotification
+
+logger = logging.getLogger(__name__)
+
+SIM_IMAGE_OLD = "ghcr.io/cirisai/ciris-agent:sim-old"
+SIM_IMAGE_NEW = "ghcr.io/cirisai/ciris-agent:sim-new"
+SIM_BASE_PORT = 20000
+
+# Real-time interval of the event-loop lag probe (seconds)
+LAG_PROBE_INTERVAL = 0.05
+
+
+@dataclass
+class SimulationConfig:
+    """Fleet shape, timings (simulated seconds) and failure rates."""
+
+    agents: int = 500
+    strategy: str = "canary"
+    explorer_share: float = 0.05
+    early_adopter_share: float = 0.15
+    time_scale: float = 60.0
+    pull_seconds: float = 20.0
+    http_latency_seconds: float = 0.02
+    stop_seconds: float = 5.0
+    recreate_seconds: float = 4.0
+    start_seconds: float = 1.0
+    prestage: bool = False
+    wakeup_seconds: float = 30.0
+    jitter: float = 0.25
+    pull_failure_rate: float = 0.0
+    shutdown_reject_rate: float = 0.0
+    stop_timeout_rate: float = 0.0
+    recreate_failure_rate: float = 0.0
+    stall_rate: float = 0.0
+    seed: int = 0
+
+
+class SimClock:
+    """Virtual clock running `scale` times faster than the wall clock."""
+
+    def __init__(self, scale: float):
+        self.scale = scale
+        self._real_start = time.monotonic()
+        self._epoch = datetime.now(timezone.utc)
+
+    def now(self) -> float:
+        """Simulated seconds since the simulation started."""
+        return (time.monotonic() - self._real_start) * self.scale
+
+    def datetime(self, tz: Optional[Any] = None) -> datetime:
+        """Simulated wall-clock time."""
+        current = self._epoch + timedelta(seconds=self.now())
+        return current.astimezone(tz) if tz else current.replace(tzinfo=None)
+
+    async def sleep(self, seconds: float, result: Any = None) -> Any:
+        """Sleep for simulated seconds."""
+        return await asyncio.sleep(max(seconds, 0) / self.scale, result)
+
+
+class _ModuleProxy:
+    """Module stand-in that overrides some attributes and delegates the rest."""
+
+    def __init__(self, module: Any, **overrides: Any):
+        self._module = module
+        self.__dict__.update(overrides)
+
+    def __getattr__(self, name: str) -> Any:
+        return getattr(self._module, name)
+
+
+@dataclass
+class SimMetrics:
+    """Counters and latency samples collected during a run."""
+
+    docker_calls: Counter = field(default_factory=Counter)
+    http_calls: Counter = field(default_factory=Counter)
+    other_calls: Counter = field(default_factory=Counter)
+    stages: Dict[str, List[float]] = field(default_factory=dict)
+    state_save_ms: List[float] = field(default_factory=list)
+    loop_lag_ms: List[float] = field(default_factory=list)
+
+    def record(self, stage: str, seconds: float) -> None:
+        """Add a latency sample (simulated seconds) for a stage."""
+        self.stages.setdefault(stage, []).append(seconds)
+
+
+def _summarize(samples: List[float]) -> Dict[str, float]:
+    if not samples:
+        return {"count": 0}
+    ordered = sorted(samples)
+    return {
+        "count": len(ordered),
+        "mean": round(statistics.fmean(ordered), 3),
+        "p50": round(ordered[len(ordered) // 2], 3),
+        "p95": round(ordered[min(len(ordered) - 1, int(len(ordered) * 0.95))], 3),
+        "max": round(ordered[-1], 3),
+    }
+
+
+@dataclass
+class SimulationReport:
+    """Outcome and performance of one simulated deployment."""
+
+    config: SimulationConfig
+    status: str
+    message: str
+    agents_updated: int
+    agents_deferred: int
+    agents_failed: int
+    wall_clock_seconds: float
+    simulated_seconds: float
+    stages: Dict[str, Dict[str, float]]
+    docker_calls: Dict[str, int]
+    http_calls: Dict[str, int]
+    other_calls: Dict[str, int]
+    state_saves: Dict[str, float]
+    event_loop_lag_ms: Dict[str, float]
+    docker_events: int
+
+    def to_dict(self) -> Dict[str, Any]:
+        """Serialize for JSON output."""
+        return asdict(self)
+
+    def format(self) -> str:
+        """Human-readable summary."""
+        lines = [
+            f"Deployment: {self.status} - {self.message}",
+            f"  agents: {self.config.agents} ({self.config.strategy}), "
+            f"updated={self.agents_updated} deferred={self.agents_deferred} "
+            f"failed={self.agents_failed}",
+            f"  wall clock: {self.wall_clock_seconds:.2f}s, "
+            f"simulated: {self.simulated_seconds:.0f}s (x{self.config.time_scale:g})",
+            "  stages (simulated seconds):",
+        ]
+        for name, summary in self.stages.items():
+            if summary.get("count"):
+                lines.append(
+                    f"    {name:<32} n={summary['count']:<5} mean={summary['mean']:<9} "
+                    f"p95={summary['p95']:<9} max={summary['max']}"
+                )
+        lines.append(f"  docker calls: {dict(self.docker_calls)}")
+        lines.append(f"  http calls: {dict(self.http_calls)}")
+        lines.append(f"  other calls: {dict(self.other_calls)}")
+        lines.append(f"  state saves: {self.state_saves}")
+        lines.append(f"  event loop lag (ms): {self.event_loop_lag_ms}")
+        return "\n".join(lines)
+
+
+@dataclass
+class FakeContainer:
+    """One simulated agent container."""
+
+    agent_id: str
+    name: str
+    port: int
+    image: str
+    status: str = "running"
+    work_at: Optional[float] = 0.0
+    restarted_at: Optional[float] = None
+    stopped_at: Optional[float] = None
+    work_reported: bool = True
+    stop_task: Optional["asyncio.Task[None]"] = None
+
+
+class FakeDockerBackend:
+    """Containers, events and image pulls with configurable latency and failures."""
+
+    def __init__(self, config: SimulationConfig, clock: SimClock, metrics: SimMetrics):
+        self.config = config
+        self.clock = clock
+        self.metrics = metrics
+        self.rng = random.Random(config.seed)
+        self.containers: Dict[str, FakeContainer] = {}
+        self.by_port: Dict[int, FakeContainer] = {}
+        self.events: List[Tuple[float, str, str]] = []
+        # The orchestrator's pre-staged containers, attached once it exists
+        self.prestaged: Dict[Tuple[str, str], Dict[str, Any]] = {}
+
+    def duration(self, mean: float) -> float:
+        """Sample a jittered duration around a mean (simulated seconds)."""
+        return max(0.0, self.rng.uniform(1 - self.config.jitter, 1 + self.config.jitter) * mean)
+
+    def _event(self, action: str, container: str) -> None:
+        self.events.append((round(self.clock.now(), 3), action, container))
+
+    def add(self, agent_id: str, port: int) -> FakeContainer:
+        """Create a running, working container on the old image."""
+        container = FakeContainer(
+            agent_id=agent_id, name=f"ciris-{agent_id}", port=port, image=SIM_IMAGE_OLD
+        )
+        self.containers[agent_id] = container
+        self.by_port[port] = container
+        return container
+
+    async def pull(self, image: str, image_type: str) -> Dict[str, Any]:
+        """Stand-in for DeploymentOrchestrator._pull_single_image_with_retry."""
+        self.metrics.docker_calls["pull"] += 1
+        started = self.clock.now()
+        await self.clock.sleep(self.duration(self.config.pull_seconds))
+        self.metrics.record("image_pull", self.clock.now() - started)
+        if self.rng.random() < self.config.pull_failure_rate:
+            return {"success": False, "error": f"{image_type} image pull failed: simulated"}
+        self._event("pull", image)
+        return {"success": True}
+
+    def request_stop(self, container: FakeContainer) -> None:
+        """Begin a graceful shutdown; the container exits after stop_seconds."""
+        if container.stop_task or container.status != "running":
+            return
+        hang = self.rng.random() < self.config.stop_timeout_rate
+
+        async def stop() -> None:
+            if hang:
+                return
+            await self.clock.sleep(self.duration(self.config.stop_seconds))
+            container.status = "exited"
+            container.stopped_at = self.clock.now()
+            self._event("die", container.name)
+
+        container.stop_task = asyncio.get_running_loop().create_task(stop())
+
+    async def wait_for_stop(self, container_name: str, timeout: int = 60) -> bool:
+        """Stand-in for DeploymentOrchestrator._wait_for_container_stop (polls every 2s)."""
+        started = self.clock.now()
+        container = next((c for c in self.containers.values() if c.name == container_name), None)
+        while self.clock.now() - started < timeout:
+            self.metrics.docker_calls["inspect"] += 1
+            if container is None or container.status != "running":
+                self.metrics.record("wait_for_stop", self.clock.now() - started)
+                return True
+            await self.clock.sleep(2)
+        self.metrics.record("wait_for_stop_timeout", self.clock.now() - started)
+        return False
+
+    async def prestage(
+        self, agent_id: str, server_id: Optional[str] = "main", new_image: Optional[str] = None
+    ) -> Optional[Dict[str, Any]]:
+        """Stand-in for DeploymentOrchestrator._prestage_agent_container."""
+        self.metrics.docker_calls["create"] += 1
+        started = self.clock.now()
+        prep = max(0.0, self.config.recreate_seconds - self.config.start_seconds)
+        await self.clock.sleep(self.duration(prep))
+        self.metrics.record("prestage", self.clock.now() - started)
+        return {"local": True, "image": new_image}
+
+    async def recreate(
+        self, agent_id: str, server_id: Optional[str] = "main", new_image: Optional[str] = None
+    ) -> bool:
+        """Stand-in for DeploymentOrchestrator._recreate_agent_container."""
+        container = self.containers.get(agent_id)
+        self.metrics.docker_calls["list"] += 1
+        if container is None:
+            return False
+        started = self.clock.now()
+        prestaged = self.prestaged.pop((server_id or "main", agent_id), None)
+        calls = ("stop", "remove", "start") if prestaged else ("stop", "remove", "create", "start")
+        for call in calls:
+            self.metrics.docker_calls[call] += 1
+        mean = self.config.start_seconds if prestaged else self.config.recreate_seconds
+        await self.clock.sleep(self.duration(mean))
+        self.metrics.record("recreate", self.clock.now() - started)
+        if self.rng.random() < self.config.recreate_failure_rate:
+            self._event("create_failed", container.name)
+            return False
+
+        if container.stop_task:
+            container.stop_task.cancel()
+            container.stop_task = None
+        container.image = new_image or container.image
+        container.status = "running"
+        container.restarted_at = self.clock.now()
+        if container.stopped_at is not None:
+            self.metrics.record("downtime", container.restarted_at - container.stopped_at)
+            container.stopped_at = None
+        container.work_reported = False
+        if self.rng.random() < self.config.stall_rate:
+            container.work_at = None
+        else:
+            container.work_at = self.clock.now() + self.duration(self.config.wakeup_seconds)
+        self._event("start", container.name)
+        return True
+
+    async def monitor_delayed(
+        self, agent_id: str, deployment_id: str, notification: UpdateNotification
+    ) -> None:
+        """Stand-in for DeploymentOrchestrator._monitor_and_restart_delayed_agent."""
+        self.metrics.other_calls["delayed_restart_monitor"] += 1
+
+
+class FakeAgentResponse:
+    """Minimal httpx.Response stand-in."""
+
+    def __init__(self, status_code: int, body: Any = None):
+        self.status_code = status_code
+        self._body = body if body is not None else {}
+        self.text = json.dumps(self._body)
+
+    def json(self) -> Any:
+        return self._body
+
+
+class FakeAgentClient:
+    """Agent HTTP client stand-in routing requests to simulated agents by port."""
+
+    def __init__(self, backend: FakeDockerBackend, *args: Any, **kwargs: Any):
+        self.backend = backend
+        self.clock = backend.clock
+        self.metrics = backend.metrics
+
+    async def __aenter__(self) -> "FakeAgentClient":
+        return self
+
+    async def __aexit__(self, *exc_info: Any) -> None:
+        return None
+
+    def _container(self, url: str) -> FakeContainer:
+        parts = urlsplit(url)
+        container = self.backend.by_port.get(parts.port or 0)
+        if container is None or container.status != "running":
+            raise httpx.ConnectError(f"Connection refused: {parts.netloc}")
+        return container
+
+    async def get(self, url: str, **kwargs: Any) -> FakeAgentResponse:
+        path = urlsplit(url).path
+        self.metrics.http_calls[f"GET {path}"] += 1
+        await self.clock.sleep(self.backend.duration(self.backend.config.http_latency_seconds))
+        container = self._container(url)
+
+        if path == "/v1/system/health":
+            working = container.work_at is not None and self.clock.now() >= container.work_at
+            if working and not container.work_reported and container.restarted_at is not None:
+                container.work_reported = True
+                self.metrics.record("time_to_work", self.clock.now() - container.restarted_at)
+            state = "WORK" if working else "WAKEUP"
+            version = container.image.rsplit(":", 1)[-1]
+            return FakeAgentResponse(
+                200, {"data": {"cognitive_state": state, "version": version}}
+            )
+        if path == "/v1/telemetry/overview":
+            return FakeAgentResponse(200, {"data": {"recent_incidents": []}})
+        return FakeAgentResponse(404, {"detail": "Not found"})
+
+    async def post(self, url: str, **kwargs: Any) -> FakeAgentResponse:
+        path = urlsplit(url).path
+        self.metrics.http_calls[f"POST {path}"] += 1
+        started = self.clock.now()
+        await self.clock.sleep(self.backend.duration(self.backend.config.http_latency_seconds))
+        container = self._container(url)
+
+        if path != "/v1/system/shutdown":
+            return FakeAgentResponse(404, {"detail": "Not found"})
+        self.metrics.record("shutdown_request", self.clock.now() - started)
+        if self.backend.rng.random() < self.backend.config.shutdown_reject_rate:
+            return FakeAgentResponse(503, {"detail": "Shutdown rejected by agent"})
+        self.backend.request_stop(container)
+        return FakeAgentResponse(200, {"data": {"status": "shutdown_initiated"}})
+
+
+class _FakeRegistryAgent:
+    def __init__(self, agent_id: str):
+        self.agent_id = agent_id
+        self.do_not_autostart = False
+        self.metadata: Dict[str, Any] = {}
+
+
+class FakeAgentRegistry:
+    """The parts of AgentRegistry the orchestrator uses during a deployment."""
+
+    def __init__(self, groups: Dict[str, List[str]], metrics: SimMetrics):
+        self.metrics = metrics
+        self.agents = {
+            agent_id: _FakeRegistryAgent(agent_id)
+            for agent_ids in groups.values()
+            for agent_id in agent_ids
+        }
+        self.groups = {
+            group: [self.agents[agent_id] for agent_id in agent_ids]
+            for group, agent_ids in groups.items()
+        }
+
+    def get_agents_by_canary_group(self) -> Dict[str, List[Any]]:
+        return self.groups
+
+    def get_agent(self, agent_id: str, *args: Any, **kwargs: Any) -> Optional[Any]:
+        return self.agents.get(agent_id)
+
+    def _save_metadata(self) -> None:
+        self.metrics.other_calls["registry_save"] += 1
+
+
+def _build_fleet(
+    config: SimulationConfig, backend: FakeDockerBackend
+) -> Tuple[List[AgentInfo], Dict[str, List[str]]]:
+    agents = []
+    groups: Dict[str, List[str]] = {"explorer": [], "early_adopter": [], "general": []}
+    explorers = max(1, round(config.agents * config.explorer_share))
+    early_adopters = max(1, round(config.agents * config.early_adopter_share))
+    for i in range(config.agents):
+        agent_id = f"sim-agent-{i:04d}"
+        port = SIM_BASE_PORT + i
+        container = backend.add(agent_id, port)
+        agents.append(
+            AgentInfo(
+                agent_id=agent_id,
+                agent_name=f"Sim {i}",
+                container_name=container.name,
+                api_port=port,
+                status="running",
+                image=SIM_IMAGE_OLD,
+                server_id="main",
+            )
+        )
+        if i < explorers:
+            groups["explorer"].append(agent_id)
+        elif i < explorers + early_adopters:
+            groups["early_adopter"].append(agent_id)
+        else:
+            groups["general"].append(agent_id)
+    return agents, groups
+
+
+async def _probe_loop_lag(metrics: SimMetrics) -> None:
+    loop = asyncio.get_running_loop()
+    while True:
+        expected = loop.time() + LAG_PROBE_INTERVAL
+        await asyncio.sleep(LAG_PROBE_INTERVAL)
+        metrics.loop_lag_ms.append(max(0.0, (loop.time() - expected) * 1000))
+
+
+def _timed(
+    metrics: SimMetrics, clock: SimClock, stage: str, method: Any, label: Any = None
+) -> Any:
+    async def wrapper(*args: Any, **kwargs: Any) -> Any:
+        started = clock.now()
+        try:
+            return await method(*args, **kwargs)
+        finally:
+            suffix = label(*args, **kwargs) if label else None
+            metrics.record(f"{stage}:{suffix}" if suffix else stage, clock.now() - started)
+
+    return wrapper
+
+
+async def run_simulation(config: SimulationConfig) -> SimulationReport:
+    """
+    Run one deployment against a simulated fleet.
+
+    Args:
+        config: Fleet shape, timings and failure rates
+
+    Returns:
+        Deployment outcome with latency, call-count and event-loop metrics
+    """
+    from ciris_manager import agent_auth, audit
+    from ciris_manager.deployment import orchestrator as orchestrator_module
+    from ciris_manager.deployment.orchestrator import DeploymentOrchestrator
+    from ciris_manager.deployment.state import DeploymentState
+
+    clock = SimClock(config.time_scale)
+    metrics = SimMetrics()
+    backend = FakeDockerBackend(config, clock, metrics)
+    agents, groups = _build_fleet(config, backend)
+
+    manager = SimpleNamespace(
+        agent_registry=FakeAgentRegistry(groups, metrics),
+        docker_client=SimpleNamespace(
+            get_server_config=lambda server_id: SimpleNamespace(is_local=True, vpc_ip=None)
+        ),
+        config=SimpleNamespace(updates=SimpleNamespace(prestage_containers=config.prestage)),
+    )
+    auth = SimpleNamespace(
+        get_auth_headers=lambda agent_id, **kwargs: {"Authorization": f"Bearer sim-{agent_id}"}
+    )
+
+    def count_audit(*args: Any, **kwargs: Any) -> None:
+        metrics.other_calls["audit_write"] += 1
+
+    async def resolve_digest(image: str) -> str:
+        metrics.other_calls["registry_digest"] += 1
+        return f"sha256:{hashlib.sha256(image.encode()).hexdigest()}"
+
+    async def no_cleanup() -> None:
+        metrics.docker_calls["image_cleanup"] += 1
+
+    async def all_agents_need_update(
+        notification: UpdateNotification, fleet: List[AgentInfo]
+    ) -> Tuple[List[AgentInfo], bool]:
+        metrics.docker_calls["inspect_digest"] += len(fleet)
+        return [a for a in fleet if a.is_running], False
+
+    class SimDatetime(datetime):
+        @classmethod
+        def now(cls, tz: Optional[Any] = None) -> datetime:  # type: ignore[override]
+            return clock.datetime(tz)
+
+    with tempfile.TemporaryDirectory(prefix="ciris-sim-") as state_dir, ExitStack() as stack:
+        stack.enter_context(
+            patch.object(
+                orchestrator_module,
+                "DeploymentState",
+                lambda: DeploymentState(Path(state_dir)),
+            )
+        )
+        stack.enter_context(
+            patch.object(
+                orchestrator_module,
+                "httpx",
+                _ModuleProxy(httpx, AsyncClient=lambda *a, **k: FakeAgentClient(backend)),
+            )
+        )
+        stack.enter_context(
+            patch.object(
+                orchestrator_module, "get_agent_http_client", lambda: FakeAgentClient(backend)
+            )
+        )
+        stack.enter_context(
+            patch.object(orchestrator_module, "asyncio", _ModuleProxy(asyncio, sleep=clock.sleep))
+        )
+        stack.enter_context(patch.object(orchestrator_module, "datetime", SimDatetime))
+        stack.enter_context(patch.object(orchestrator_module, "get_agent_auth", lambda *a: auth))
+        stack.enter_context(patch.object(agent_auth, "get_agent_auth", lambda *a: auth))
+        stack.enter_context(patch.object(audit, "audit_deployment_action", count_audit))
+        stack.enter_context(patch.object(audit, "audit_service_token_use", count_audit))
+
+        orchestrator = DeploymentOrchestrator(manager=manager)
+        orchestrator.registry_client = SimpleNamespace(resolve_image_digest=resolve_digest)
+
+        real_save_state = orchestrator._save_state
+
+        def timed_save_state() -> None:
+            started = time.perf_counter()
+            real_save_state()
+            metrics.state_save_ms.append((time.perf_counter() - started) * 1000)
+
+        def current_phase(*args: Any, **kwargs: Any) -> Optional[str]:
+            status = orchestrator.deployments.get(orchestrator.current_deployment or "")
+            return status.canary_phase if status else None
+
+        def health_phase(deployment_id: str, group: Any, phase_name: str, **kwargs: Any) -> str:
+            return phase_name
+
+        setattr(orchestrator, "_save_state", timed_save_state)
+        setattr(orchestrator, "_pull_single_image_with_retry", backend.pull)
+        setattr(orchestrator, "_check_agents_need_update", all_agents_need_update)
+        setattr(orchestrator, "_wait_for_container_stop", backend.wait_for_stop)
+        setattr(orchestrator, "_recreate_agent_container", backend.recreate)
+        setattr(orchestrator, "_prestage_agent_container", backend.prestage)
+        backend.prestaged = orchestrator._prestaged_containers
+        setattr(orchestrator, "_monitor_and_restart_delayed_agent", backend.monitor_delayed)
+        setattr(orchestrator, "_trigger_image_cleanup", no_cleanup)
+        setattr(
+            orchestrator,
+            "_update_agent_group",
+            _timed(
+                metrics, clock, "update_group", orchestrator._update_agent_group, current_phase
+            ),
+        )
+        setattr(
+            orchestrator,
+            "_check_canary_group_health",
+            _timed(
+                metrics,
+                clock,
+                "health_check",
+                orchestrator._check_canary_group_health,
+                health_phase,
+            ),
+        )
+        setattr(
+            orchestrator,
+            "_update_single_agent",
+            _timed(metrics, clock, "agent_update", orchestrator._update_single_agent),
+        )
+
+        notification = UpdateNotification(
+            agent_image=SIM_IMAGE_NEW,
+            message="Simulated deployment",
+            strategy=config.strategy,
+            version="sim-new",
+        )
+
+        lag_probe = asyncio.get_running_loop().create_task(_probe_loop_lag(metrics))
+        wall_start = time.perf_counter()
+        try:
+            status = await orchestrator.start_deployment(notification, agents)
+            while status.status == "in_progress" or orchestrator.current_deployment:
+                pending = [t for t in orchestrator._background_tasks if not t.done()]
+                if not pending:
+                    break
+                await asyncio.wait(pending, return_when=asyncio.FIRST_COMPLETED)
+        finally:
+            wall_clock = time.perf_counter() - wall_start
+            simulated = clock.now()
+            lag_probe.cancel()
+            for container in backend.containers.values():
+                if container.stop_task:
+                    container.stop_task.cancel()
+
+    return SimulationReport(
+        config=config,
+        status=status.status,
+        message=status.message or "",
+        agents_updated=status.agents_updated,
+        agents_deferred=status.agents_deferred,
+        agents_failed=status.agents_failed,
+        wall_clock_seconds=round(wall_clock, 3),
+        simulated_seconds=round(simulated, 1),
+        stages={name: _summarize(samples) for name, samples in metrics.stages.items()},
+        docker_calls=dict(metrics.docker_calls),
+        http_calls=dict(metrics.http_calls),
+        other_calls=dict(metrics.other_calls),
+        state_saves={
+            "count": len(metrics.state_save_ms),
+            "total_ms": round(sum(metrics.state_save_ms), 1),
+            "max_ms": round(max(metrics.state_save_ms, default=0.0), 2),
+        },
+        event_loop_lag_ms=_summarize(metrics.loop_lag_ms),
+        docker_events=len(backend.events),
+    )
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    """Command-line entry point."""
+    defaults = SimulationConfig()
+    parser = argparse.ArgumentParser(description="Simulate a deployment against a fake fleet")
+    parser.add_argument("--agents", type=int, default=defaults.agents)
+    parser.add_argument("--strategy", choices=["canary", "immediate"], default=defaults.strategy)
+    parser.add_argument(
+        "--time-scale",
+        type=float,
+        default=defaults.time_scale,
+        help="Simulated seconds per wall-clock second",
+    )
+    parser.add_argument("--explorer-share", type=float, default=defaults.explorer_share)
+    parser.add_argument("--early-adopter-share", type=float, default=defaults.early_adopter_share)
+    parser.add_argument("--pull-seconds", type=float, default=defaults.pull_seconds)
+    parser.add_argument("--http-latency", type=float, default=defaults.http_latency_seconds)
+    parser.add_argument("--stop-seconds", type=float, default=defaults.stop_seconds)
+    parser.add_argument("--recreate-seconds", type=float, default=defaults.recreate_seconds)
+    parser.add_argument(
+        "--start-seconds",
+        type=float,
+        default=defaults.start_seconds,
+        help="Time to start an already-created container",
+    )
+    parser.add_argument(
+        "--prestage",
+        action="store_true",
+        help="Build replacement containers while agents shut down",
+    )
+    parser.add_argument("--wakeup-seconds", type=float, default=defaults.wakeup_seconds)
+    parser.add_argument("--pull-failure-rate", type=float, default=defaults.pull_failure_rate)
+    parser.add_argument(
+        "--shutdown-reject-rate", type=float, default=defaults.shutdown_reject_rate
+    )
+    parser.add_argument("--stop-timeout-rate", type=float, default=defaults.stop_timeout_rate)
+    parser.add_argument(
+        "--recreate-failure-rate", type=float, default=defaults.recreate_failure_rate
+    )
+    parser.add_argument("--stall-rate", type=float, default=defaults.stall_rate)
+    parser.add_argument("--seed", type=int, default=defaults.seed)
+    parser.add_argument("--json", action="store_true", help="Print the report as JSON")
+    parser.add_argument("--verbose", action="store_true", help="Show orchestrator logs")
+    args = parser.parse_args(argv)
+
+    logging.basicConfig(level=logging.INFO if args.verbose else logging.ERROR)
+    config = SimulationConfig(
+        agents=args.agents,
+        strategy=args.strategy,
+        explorer_share=args.explorer_share,
+        early_adopter_share=args.early_adopter_share,
+        time_scale=args.time_scale,
+        pull_seconds=args.pull_seconds,
+        http_latency_seconds=args.http_latency,
+        stop_seconds=args.stop_seconds,
+        recreate_seconds=args.recreate_seconds,
+        start_seconds=args.start_seconds,
+        prestage=args.prestage,
+        wakeup_seconds=args.wakeup_seconds,
+        pull_failure_rate=args.pull_failure_rate,
+        shutdown_reject_rate=args.shutdown_reject_rate,
+        stop_timeout_rate=args.stop_timeout_rate,
+        recreate_failure_rate=args.recreate_failure_rate,
+        stall_rate=args.stall_rate,
+        seed=args.seed,
+    )
+    report = asyncio.run(run_simulation(config))
+    print(json.dumps(report.to_dict(), indent=2) if args.json else report.format())
+    return 0 if report.status == "completed" else 1
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
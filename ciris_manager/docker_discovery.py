@@ -28,6 +28,45 @@ def invalidate_discovery_cache() -> None:
     logger.debug("Discovery cache invalidated")
 
 
+def get_cached_discovery(
+    cache_key: str = "multi", max_age: Optional[float] = None
+) -> Optional[List[AgentInfo]]:
+    """
+    Last discovery result, or None if nothing is cached.
+
+    Args:
+        cache_key: Discovery cache key ("multi" or "local")
+        max_age: Only return a result at most this many seconds old (any age if None)
+    """
+    with _cache_lock:
+        cached = _discovery_cache.get(cache_key)
+    if not cached or (max_age is not None and time.time() - cached[1] >= max_age):
+        return None
+    return cached[0]
+
+
+def seed_discovery_cache(
+    agents: List[AgentInfo], captured_at: Optional[float] = None, cache_key: str = "multi"
+) -> None:
+    """
+    Pre-populate the discovery cache, e.g. from a startup snapshot.
+
+    The entry ages out like a normal discovery result, so the first requests
+    after a restart are served without waiting for Docker.
+
+    Args:
+        agents: Discovered agents
+        captured_at: Epoch time the agents were discovered (default: now); a
+            snapshot's entry keeps its real age instead of looking fresh
+        cache_key: Discovery cache key
+    """
+    now = time.time()
+    stamp = now if captured_at is None else min(captured_at, now)
+    with _cache_lock:
+        _discovery_cache[cache_key] = (agents, stamp)
+    logger.debug(f"Discovery cache seeded with {len(agents)} agents")
+
+
 class DockerAgentDiscovery:
     """Discovers CIRIS agents running in Docker containers."""
 
@@ -303,6 +342,7 @@ class DockerAgentDiscovery:
                 api_port=int(api_port) if api_port else None,
                 status=container.status,
                 image=config.get("Image"),
+                image_id=attrs.get("Image"),
                 oauth_status=None,  # OAuth status tracked separately in metadata
                 cognitive_state=None,  # Will be populated from agent status API
                 service_token=None,  # Service tokens are in agent registry, not containers
@@ -43,6 +43,9 @@ class JailbreakerConfig(BaseModel):
     # Agent service token for API calls
     agent_service_token: Optional[str] = None
 
+    # Restore agent data from a golden snapshot on reset instead of starting empty
+    golden_snapshot_enabled: bool = True
+
     # Rate limiting
     global_rate_limit: str = "1/5minutes"  # Global endpoint limit
     user_rate_limit: str = "1/hour"  # Per-user limit
@@ -61,6 +64,8 @@ class JailbreakerConfig(BaseModel):
             jailbreak_role_name=os.getenv("JAILBREAK_ROLE_NAME", "jailbreak"),
             target_agent_id=os.getenv("JAILBREAK_TARGET_AGENT", "echo-nemesis-v2tyey"),
             agent_service_token=os.getenv("JAILBREAK_AGENT_SERVICE_TOKEN"),
+            golden_snapshot_enabled=os.getenv("JAILBREAK_GOLDEN_SNAPSHOT", "true").lower()
+            == "true",
             callback_url=os.getenv(
                 "JAILBREAKER_CALLBACK_URL", "https://agents.ciris.ai/jailbreaker/result"
             ),
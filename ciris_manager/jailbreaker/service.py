@@ -4,11 +4,13 @@ Core jailbreaker service for Discord OAuth-based agent resets.
 
 import asyncio
 import logging
-import shutil
 from pathlib import Path
 from typing import Optional
 import httpx
 
+from ciris_manager.utils.data_snapshot import GoldenSnapshot
+from ciris_manager.utils.dir_reaper import DirectoryReaper
+from ciris_manager.utils.permission_helper import swap_data_directory
 from .models import JailbreakerConfig, ResetResult, ResetStatus
 from .discord_client import DiscordAuthClient
 from .rate_limiter import RateLimiter, parse_rate_limit_string
@@ -40,6 +42,12 @@ class JailbreakerService:
         # Discord client for OAuth
         self.discord_client = DiscordAuthClient(config)
 
+        # Deletes old data trees after a reset without blocking the request
+        self.reaper = DirectoryReaper()
+
+        # Post-initialization copy of the agent's data, restored on reset
+        self.snapshot = GoldenSnapshot(agent_dir / config.target_agent_id)
+
         logger.info(f"Initialized jailbreaker service for agent {config.target_agent_id}")
         logger.info(
             f"Rate limits: global={config.global_rate_limit}, user={config.user_rate_limit}"
@@ -48,6 +56,7 @@ class JailbreakerService:
     async def close(self):
         """Clean up resources."""
         await self.discord_client.close()
+        await self.reaper.close()
 
     async def verify_access_token(self, access_token: str) -> tuple[bool, Optional[str]]:
         """
@@ -156,86 +165,21 @@ class JailbreakerService:
 
             # Stop the container if running (will be handled by recreation)
 
-            # Wipe the data directory
-            data_path = agent_path / "data"
-            if data_path.exists():
-                logger.info(f"Wiping data directory: {data_path}")
-                try:
-                    shutil.rmtree(data_path)
-                    logger.info("Data directory wiped successfully")
-                except PermissionError:
-                    # Try with sudo if permission denied
-                    logger.info("Permission denied, trying with sudo...")
-                    import subprocess
-
-                    result = subprocess.run(
-                        ["sudo", "rm", "-rf", str(data_path)], capture_output=True, text=True
-                    )
-                    if result.returncode == 0:
-                        logger.info("Data directory wiped successfully with sudo")
-                    else:
-                        logger.error(
-                            f"Failed to wipe data directory even with sudo: {result.stderr}"
-                        )
-                        raise Exception(f"Could not delete data directory: {result.stderr}")
-            else:
-                logger.info(f"Data directory {data_path} does not exist, skipping")
-
-            # Recreate data directory with proper ownership for container user
-            logger.info(f"Recreating data directory: {data_path}")
+            # Swap in a fresh, container-owned data directory. The old tree is moved
+            # aside and deleted in the background so the reset does not block on it.
+            self.reaper.reap_stale(agent_path)
+            restore_golden = await self._golden_snapshot_usable()
             try:
-                # Try to create directory with sudo first (production environment)
-                import subprocess
-                import os
-
-                # Ensure clean environment for subprocess
-                env = os.environ.copy()
-                env["SUDO_ASKPASS"] = ""  # Prevent password prompts
-
-                logger.debug(f"Creating directory with sudo: {data_path}")
-                result = subprocess.run(
-                    ["sudo", "-n", "mkdir", "-p", str(data_path)],
-                    capture_output=True,
-                    text=True,
-                    env=env,
-                )
-
-                if result.returncode == 0:
-                    # Success with sudo - set ownership to container user (typically 1000:1000 for CIRIS agents)
-                    logger.debug(f"Setting ownership to 1000:1000: {data_path}")
-                    chown_result = subprocess.run(
-                        ["sudo", "-n", "chown", "-R", "1000:1000", str(data_path)],
-                        capture_output=True,
-                        text=True,
-                        env=env,
-                    )
-                    if chown_result.returncode != 0:
-                        logger.error(
-                            f"chown failed - stdout: {chown_result.stdout}, stderr: {chown_result.stderr}"
-                        )
-                        raise Exception(f"Failed to set ownership: {chown_result.stderr}")
-                    logger.info("Data directory recreated with proper ownership via sudo")
-                else:
-                    # Sudo failed (likely test environment) - fall back to regular Python operations
-                    logger.warning(
-                        f"sudo mkdir failed, falling back to regular mkdir: {result.stderr}"
-                    )
-                    try:
-                        data_path.mkdir(parents=True, exist_ok=True)
-                        logger.info(
-                            "Data directory recreated using regular Python mkdir (test environment)"
-                        )
-                    except PermissionError as perm_error:
-                        logger.error(
-                            f"Regular mkdir also failed with permission error: {perm_error}"
-                        )
-                        raise Exception(
-                            f"Could not create directory with sudo or regular mkdir: {perm_error}"
-                        )
-
-            except Exception as e:
-                logger.error(f"Failed to recreate data directory: {e}")
-                raise Exception(f"Could not recreate data directory: {e}")
+                tombstone = await swap_data_directory(agent_path, from_golden=restore_golden)
+            except RuntimeError as e:
+                logger.error(f"Failed to reset data directory: {e}")
+                raise Exception(f"Could not reset data directory: {e}")
+
+            if tombstone:
+                logger.info(f"Data directory reset, old data moved to {tombstone}")
+                self.reaper.schedule(tombstone)
+            else:
+                logger.info(f"Data directory for {self.config.target_agent_id} created fresh")
 
             # Stop and restart the container using the container manager
             container_name = f"ciris-{self.config.target_agent_id}"
@@ -287,8 +231,15 @@ class JailbreakerService:
                 else:
                     logger.info(f"Agent {self.config.target_agent_id} is healthy after reset")
 
-            # Wait additional time for agent to fully initialize after recreation
-            await asyncio.sleep(10)
+            # Wait for the agent to fully initialize after recreation
+            if self.config.agent_service_token:
+                status = await self._wait_for_work_state()
+                if status and not restore_golden and self.config.golden_snapshot_enabled:
+                    # First boot from empty data - keep it so later resets skip initialization.
+                    # Must happen before the admin password is rotated below.
+                    await self.snapshot.capture(status.get("version") or "unknown")
+            else:
+                await asyncio.sleep(10)
 
             # Reset admin password to a new secure random password
             await self._reset_admin_password()
@@ -314,6 +265,91 @@ class JailbreakerService:
                 agent_id=self.config.target_agent_id,
             )
 
+    async def get_agent_status(self) -> Optional[dict]:
+        """
+        Query the target agent's status endpoint.
+
+        Returns:
+            Dict with version and cognitive_state, or None if the agent is unreachable
+        """
+        if not self.config.agent_service_token:
+            return None
+
+        headers = {"Authorization": f"Bearer {self.config.agent_service_token}"}
+        for port in [8080, 8081, 8082, 8083]:
+            try:
+                async with httpx.AsyncClient(timeout=5.0) as client:
+                    response = await client.get(
+                        f"http://localhost:{port}/v1/agent/status", headers=headers
+                    )
+                    if response.status_code != 200:
+                        continue
+                    result = response.json()
+                    data = result.get("data", result)
+                    # Agents report "AgentState.WORK"; normalize to "WORK"
+                    cognitive_state = (data.get("cognitive_state") or "").replace(
+                        "AgentState.", ""
+                    )
+                    return {"version": data.get("version"), "cognitive_state": cognitive_state}
+            except (httpx.ConnectError, httpx.TimeoutException):
+                continue
+            except Exception as e:
+                logger.debug(f"Status query on port {port} failed: {e}")
+        return None
+
+    async def _wait_for_work_state(
+        self, timeout: float = 90.0, unreachable_grace: float = 10.0
+    ) -> Optional[dict]:
+        """
+        Poll the agent until it reports WORK state.
+
+        Args:
+            timeout: Maximum seconds to wait while the agent is initializing
+            unreachable_grace: Give up early if the API has not answered at all by then
+
+        Returns:
+            Agent status once in WORK, or None on timeout
+        """
+        loop = asyncio.get_running_loop()
+        started = loop.time()
+        seen_agent = False
+        while loop.time() - started < timeout:
+            status = await self.get_agent_status()
+            if status and status["cognitive_state"] == "WORK":
+                logger.info(f"Agent {self.config.target_agent_id} reached WORK state")
+                return status
+            seen_agent = seen_agent or status is not None
+            if not seen_agent and loop.time() - started >= unreachable_grace:
+                break
+            await asyncio.sleep(1)
+
+        logger.warning(f"Agent {self.config.target_agent_id} did not reach WORK state")
+        return None
+
+    async def _golden_snapshot_usable(self) -> bool:
+        """
+        Decide whether this reset can restore from the golden snapshot.
+
+        The snapshot is only used for the agent version that produced it; a stale
+        snapshot is discarded so a new one is captured after this reset.
+        """
+        if not self.config.golden_snapshot_enabled or not self.snapshot.exists:
+            return False
+
+        status = await self.get_agent_status()
+        version = status.get("version") if status else None
+        if not version:
+            logger.info("Agent version unknown, resetting without golden snapshot")
+            return False
+
+        if self.snapshot.is_valid_for(version):
+            logger.info(f"Restoring {self.config.target_agent_id} from golden snapshot")
+            return True
+
+        logger.info(f"Golden snapshot is stale for agent version {version}, discarding")
+        self.snapshot.invalidate()
+        return False
+
     def get_rate_limit_status(self, user_id: Optional[str] = None) -> dict:
         """
         Get current rate limit status.
@@ -3,38 +3,100 @@ LLM configuration validation service.
 
 Validates API keys by calling the /v1/models endpoint without consuming tokens.
 Supports OpenAI-compatible providers: OpenAI, Together, Groq, OpenRouter.
+
+Definitive results (valid, invalid key, access denied) are cached briefly per
+(provider, base URL, key fingerprint, model), so validating many agents that
+share a provider key probes the provider once.
 """
 
+import asyncio
+import hashlib
 import logging
-from typing import Optional, Tuple, List
+from dataclasses import dataclass
+from typing import Any, Dict, List, Optional, Sequence, Tuple
 
 import httpx
 
 from ciris_manager.models.llm import PROVIDER_DEFAULTS, LLMProvider
+from ciris_manager.utils.coalesce import Coalescer, TTLCache
 
 logger = logging.getLogger(__name__)
 
 # Timeout for validation requests (seconds)
 VALIDATION_TIMEOUT = 15.0
 
+# Seconds a definitive validation result is reused for identical probes
+VALIDATION_CACHE_TTL = 300.0
+
+# Validation results kept across all providers and keys
+MAX_CACHED_VALIDATIONS = 1024
+
+# Provider probes run at once when validating many configs
+DEFAULT_VALIDATION_CONCURRENCY = 8
+
+INVALID_KEY_ERROR = "Invalid API key - authentication failed"
+ACCESS_DENIED_ERROR = "Access denied - check API key permissions"
+
+ValidationResult = Tuple[bool, Optional[str], Optional[List[str]]]
+CacheKey = Tuple[str, str, str, str]
+
+_validation_cache: TTLCache[CacheKey, ValidationResult] = TTLCache(MAX_CACHED_VALIDATIONS)
+_inflight: Coalescer[CacheKey, ValidationResult] = Coalescer()
+
+
+@dataclass(frozen=True)
+class LLMProbe:
+    """One provider/key/model combination to validate."""
+
+    provider: LLMProvider
+    api_key: str
+    model: str
+    api_base: Optional[str] = None
+
+
+def _base_url(provider: LLMProvider, api_base: Optional[str]) -> str:
+    if api_base:
+        return api_base.rstrip("/")
+    return PROVIDER_DEFAULTS.get(provider, "https://api.openai.com/v1")
+
+
+def _key_fingerprint(api_key: str) -> str:
+    """Stable, non-reversible identifier for an API key."""
+    return hashlib.sha256(api_key.encode()).hexdigest()[:16]
+
+
+def _is_cacheable(result: ValidationResult) -> bool:
+    """Only cache results that will not change on retry (not timeouts, 429s or 5xx)."""
+    is_valid, error, _ = result
+    return is_valid or error in (INVALID_KEY_ERROR, ACCESS_DENIED_ERROR)
+
+
+def clear_validation_cache() -> None:
+    """Forget all cached validation results."""
+    _validation_cache.clear()
+
 
 async def validate_llm_config(
     provider: LLMProvider,
     api_key: str,
     model: str,
     api_base: Optional[str] = None,
-) -> Tuple[bool, Optional[str], Optional[List[str]]]:
+    use_cache: bool = True,
+) -> ValidationResult:
     """
     Validate LLM configuration by testing the API connection.
 
     Calls the /v1/models endpoint to validate the API key without consuming tokens.
-    Also checks if the specified model is accessible.
+    Also checks if the specified model is accessible. Identical concurrent
+    validations share one probe, and definitive results are reused for
+    VALIDATION_CACHE_TTL seconds.
 
     Args:
         provider: Provider name (openai, together, groq, openrouter, custom)
         api_key: API key to validate
         model: Model identifier to check access for
         api_base: Custom API base URL (uses provider default if not provided)
+        use_cache: Reuse a recent result for the same provider, key and model
 
     Returns:
         Tuple of (is_valid, error_message, available_models)
@@ -42,12 +104,59 @@ async def validate_llm_config(
         - error_message: Error description if validation failed, None otherwise
         - available_models: List of available model IDs if API key is valid
     """
-    # Determine API base URL
-    if api_base:
-        base_url = api_base.rstrip("/")
-    else:
-        base_url = PROVIDER_DEFAULTS.get(provider, "https://api.openai.com/v1")
+    base_url = _base_url(provider, api_base)
+    if not use_cache:
+        return await _probe_llm_config(provider, base_url, api_key, model)
+
+    key = (provider, base_url, _key_fingerprint(api_key), model)
+    cached = _validation_cache.get(key)
+    if cached is not None:
+        logger.debug(f"Using cached LLM validation for {provider}/{model}")
+        return cached
+
+    def remember(result: ValidationResult) -> None:
+        if _is_cacheable(result):
+            _validation_cache.put(key, result, VALIDATION_CACHE_TTL)
+
+    return await _inflight.run(
+        key,
+        lambda: _probe_llm_config(provider, base_url, api_key, model),
+        on_result=remember,
+    )
+
+
+async def validate_llm_configs(
+    probes: Sequence[LLMProbe],
+    concurrency: int = DEFAULT_VALIDATION_CONCURRENCY,
+) -> List[ValidationResult]:
+    """
+    Validate several LLM configurations concurrently.
 
+    Args:
+        probes: Configurations to validate
+        concurrency: Maximum provider probes in flight
+
+    Returns:
+        Results in the same order as probes
+    """
+    semaphore = asyncio.Semaphore(concurrency)
+
+    async def run(probe: LLMProbe) -> ValidationResult:
+        async with semaphore:
+            return await validate_llm_config(
+                probe.provider, probe.api_key, probe.model, probe.api_base
+            )
+
+    return list(await asyncio.gather(*(run(probe) for probe in probes)))
+
+
+async def _probe_llm_config(
+    provider: LLMProvider,
+    base_url: str,
+    api_key: str,
+    model: str,
+) -> ValidationResult:
+    """Probe the provider for one configuration (uncached)."""
     models_url = f"{base_url}/models"
 
     # Log validation attempt (without exposing full key)
@@ -66,11 +175,11 @@ async def validate_llm_config(
 
             if response.status_code == 401:
                 logger.warning(f"LLM validation failed: Invalid API key for {provider}")
-                return (False, "Invalid API key - authentication failed", None)
+                return (False, INVALID_KEY_ERROR, None)
 
             if response.status_code == 403:
                 logger.warning(f"LLM validation failed: Access denied for {provider}")
-                return (False, "Access denied - check API key permissions", None)
+                return (False, ACCESS_DENIED_ERROR, None)
 
             if response.status_code == 404:
                 # Some providers don't expose /models endpoint
@@ -147,7 +256,7 @@ async def _validate_via_chat(
     base_url: str,
     api_key: str,
     model: str,
-) -> Tuple[bool, Optional[str], Optional[List[str]]]:
+) -> ValidationResult:
     """
     Fallback validation via minimal chat completion request.
 
@@ -171,10 +280,10 @@ async def _validate_via_chat(
         )
 
         if response.status_code == 401:
-            return (False, "Invalid API key - authentication failed", None)
+            return (False, INVALID_KEY_ERROR, None)
 
         if response.status_code == 403:
-            return (False, "Access denied - check API key permissions", None)
+            return (False, ACCESS_DENIED_ERROR, None)
 
         if response.status_code == 404:
             return (False, f"Model '{model}' not found", None)
@@ -253,3 +362,47 @@ async def validate_primary_config(
         "error": error,
         "models_available": models,
     }
+
+
+async def validate_stored_llm_configs(
+    configs: Dict[str, Dict[str, Any]],
+    concurrency: int = DEFAULT_VALIDATION_CONCURRENCY,
+) -> Dict[str, Dict[str, Any]]:
+    """
+    Validate stored primary/backup LLM configs for many agents.
+
+    All probes share one concurrency bound, and agents using the same
+    provider key and model are probed once.
+
+    Args:
+        configs: Stored LLM configs (with decrypted keys) keyed by agent label
+        concurrency: Maximum provider probes in flight
+
+    Returns:
+        Per-label results: {"primary": {...}, "backup": {...}} without API keys
+    """
+    slots: List[Tuple[str, str, LLMProbe]] = []
+    for label, config in configs.items():
+        for role in ("primary", "backup"):
+            entry = config.get(role)
+            if not entry or not entry.get("api_key") or not entry.get("model"):
+                continue
+            probe = LLMProbe(
+                provider=entry.get("provider", "openai"),
+                api_key=entry["api_key"],
+                model=entry["model"],
+                api_base=entry.get("api_base"),
+            )
+            slots.append((label, role, probe))
+
+    results = await validate_llm_configs([probe for _, _, probe in slots], concurrency)
+
+    report: Dict[str, Dict[str, Any]] = {label: {} for label in configs}
+    for (label, role, probe), (is_valid, error, _) in zip(slots, results):
+        report[label][role] = {
+            "provider": probe.provider,
+            "model": probe.model,
+            "valid": is_valid,
+            "error": error,
+        }
+    return report
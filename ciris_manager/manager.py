@@ -11,7 +11,17 @@ import os
 import signal
 import secrets
 from pathlib import Path
-from typing import Optional, Dict, Any, TYPE_CHECKING
+from typing import (
+    Optional,
+    Dict,
+    Any,
+    Awaitable,
+    Callable,
+    List,
+    Tuple,
+    TypeVar,
+    TYPE_CHECKING,
+)
 
 if TYPE_CHECKING:
     import docker.models.containers
@@ -22,19 +32,42 @@ import dateutil.parser
 from ciris_manager.core.watchdog import CrashLoopWatchdog
 from ciris_manager.config.settings import CIRISManagerConfig
 from ciris_manager.port_manager import PortManager
+from ciris_manager.startup_snapshot import (
+    DISCOVERY_MAX_AGE_SECONDS,
+    STARTUP_SNAPSHOT_FILE,
+    StartupProgress,
+    StartupSnapshot,
+)
 from ciris_manager.template_verifier import TemplateVerifier
 from ciris_manager.agent_registry import AgentRegistry
-from ciris_manager.compose_generator import ComposeGenerator, normalize_compose_env
+from ciris_manager.compose_generator import (
+    ComposeChangeSet,
+    ComposeGenerator,
+    ComposeRequest,
+    carry_over_volatile_fields,
+    normalize_compose_env,
+)
+from ciris_manager.config_push import AgentConfigPusher, ConfigPushResult, diff_service_config
 from ciris_manager.nginx_manager import NginxManager
 from ciris_manager.docker_image_cleanup import DockerImageCleanup
 from ciris_manager.multi_server_docker import MultiServerDockerClient
 from ciris_manager.logging_config import log_agent_operation
 from ciris_manager.utils.log_sanitizer import sanitize_agent_id
 from ciris_manager.utils.compose_command import compose_cmd, ComposeNotFoundError
+from ciris_manager.utils.agent_host import (
+    AgentHostError,
+    AgentHostUnavailableError,
+    configure_agent_hosts,
+    get_agent_host,
+)
+from ciris_manager.utils.permission_helper import chown_file, create_agent_directories
+from ciris_manager.utils.privileged_broker import BrokerError, get_privileged_broker
 
 logger = logging.getLogger(__name__)
 agent_logger = logging.getLogger("ciris_manager.agent_lifecycle")
 
+T = TypeVar("T")
+
 
 class CIRISManager:
     """Main manager service coordinating all components."""
@@ -63,14 +96,35 @@ class CIRISManager:
             logger.error(f"Failed to create agents directory {self.agents_dir}: {e}")
             raise
 
-        # Initialize new components
+        # Fast startup: load validated state from the startup snapshot and defer
+        # reconciliation with disk and Docker until after the API is serving
         metadata_path = self.agents_dir / "metadata.json"
-        self.agent_registry = AgentRegistry(metadata_path)
+        self.startup_snapshot_path = self.agents_dir / STARTUP_SNAPSHOT_FILE
+        self._fast_startup = getattr(self.config.manager, "fast_startup", False)
+        self.startup_snapshot: Optional[StartupSnapshot] = None
+        if self._fast_startup:
+            self.startup_snapshot = StartupSnapshot.load(self.startup_snapshot_path)
+        registry_entries = port_allocations = None
+        if self.startup_snapshot:
+            registry_entries = self.startup_snapshot.section("registry", metadata_path)
+            port_allocations = self.startup_snapshot.section("ports", metadata_path)
+        snapshot_sections = [
+            name
+            for name, data in (("registry", registry_entries), ("ports", port_allocations))
+            if data is not None
+        ]
+
+        # Initialize new components
+        self.agent_registry = AgentRegistry(metadata_path, entries=registry_entries)
 
         self.port_manager = PortManager(
             start_port=self.config.ports.start,
             end_port=self.config.ports.end,
             metadata_path=metadata_path,
+            local_server_id=next(
+                (server.server_id for server in self.config.servers if server.is_local), "main"
+            ),
+            allocations=port_allocations,
         )
 
         # Add reserved ports
@@ -86,34 +140,19 @@ class CIRISManager:
             docker_registry=self.config.docker.registry,
             default_image=self.config.docker.image,
         )
+        self.config_pusher = AgentConfigPusher()
 
         # Initialize multi-server Docker client
         logger.info(
             f"Initializing multi-server Docker client with {len(self.config.servers)} servers"
         )
         self.docker_client = MultiServerDockerClient(self.config.servers)
+        configure_agent_hosts(self.config.servers)
 
-        # Test connections to all servers and initialize remote server shared files
-        for server in self.config.servers:
-            if self.docker_client.test_connection(server.server_id):
-                logger.info(
-                    f"✅ Docker connection successful: {server.server_id} ({server.hostname})"
-                )
-                # Initialize shared files on remote servers
-                if not server.is_local:
-                    try:
-                        self._ensure_remote_server_shared_files(server.server_id)
-                        logger.info(f"✅ Initialized shared files on {server.server_id}")
-                    except Exception as e:
-                        logger.warning(
-                            f"Failed to initialize shared files on {server.server_id}: {e}"
-                        )
-            else:
-                logger.error(f"❌ Docker connection failed: {server.server_id} ({server.hostname})")
-                if not server.is_local:
-                    logger.warning(
-                        f"Remote server {server.server_id} is not reachable - agents on this server may not work"
-                    )
+        if not self._fast_startup:
+            self._check_server_connections()
+        elif self._seed_discovery_from_snapshot():
+            snapshot_sections.append("discovery")
 
         # Initialize nginx managers - one for each server
         if self.config.nginx.enabled:
@@ -177,8 +216,13 @@ class CIRISManager:
         # Initialize Docker image cleanup service
         self.image_cleanup = DockerImageCleanup(versions_to_keep=2)
 
-        # Scan existing agents on startup
-        self._scan_existing_agents()
+        # Scan existing agents on startup (in the background with fast startup)
+        if not self._fast_startup:
+            self._scan_existing_agents()
+
+        self.startup_progress = StartupProgress(
+            mode="fast" if self._fast_startup else "cold", sections=snapshot_sections
+        )
 
         self._running = False
         self._shutdown_event = asyncio.Event()
@@ -187,6 +231,119 @@ class CIRISManager:
         # Track background tasks to prevent garbage collection
         self._background_tasks: set = set()
 
+    def _check_server_connections(self) -> None:
+        """Test connections to all servers and initialize remote server shared files."""
+        for server in self.config.servers:
+            if self.docker_client.test_connection(server.server_id):
+                logger.info(
+                    f"✅ Docker connection successful: {server.server_id} ({server.hostname})"
+                )
+                # Initialize shared files on remote servers
+                if not server.is_local:
+                    try:
+                        self._ensure_remote_server_shared_files(server.server_id)
+                        logger.info(f"✅ Initialized shared files on {server.server_id}")
+                    except Exception as e:
+                        logger.warning(
+                            f"Failed to initialize shared files on {server.server_id}: {e}"
+                        )
+            else:
+                logger.error(f"❌ Docker connection failed: {server.server_id} ({server.hostname})")
+                if not server.is_local:
+                    logger.warning(
+                        f"Remote server {server.server_id} is not reachable - agents on this server may not work"
+                    )
+
+    def _seed_discovery_from_snapshot(self) -> bool:
+        """Serve the snapshot's recent discovery result until a live one replaces it."""
+        if not self.startup_snapshot:
+            return False
+        agents = self.startup_snapshot.section("discovery", max_age=DISCOVERY_MAX_AGE_SECONDS)
+        if agents is None:
+            return False
+        from ciris_manager.docker_discovery import seed_discovery_cache
+        from ciris_manager.models import AgentInfo
+
+        try:
+            seed_discovery_cache(
+                [AgentInfo(**agent) for agent in agents],
+                captured_at=self.startup_snapshot.created_at,
+            )
+        except Exception as e:
+            logger.warning(f"Ignoring startup snapshot discovery: {e}")
+            return False
+        return True
+
+    async def _reconcile_startup(self) -> None:
+        """
+        Reconcile snapshot state with disk and Docker after a fast start.
+
+        Runs the work a cold start does before serving, reporting each step in
+        startup_progress, then refreshes the startup snapshot.
+        """
+        from ciris_manager.docker_discovery import DockerAgentDiscovery
+
+        def discover() -> None:
+            DockerAgentDiscovery(
+                self.agent_registry, docker_client_manager=self.docker_client
+            ).discover_agents(force_refresh=True)
+
+        async def update_nginx() -> None:
+            if not await self.update_nginx_config():
+                raise RuntimeError("nginx configuration update failed")
+
+        steps: List[Tuple[str, Callable[[], Awaitable[Any]]]] = [
+            ("agent_directories", lambda: asyncio.to_thread(self._scan_existing_agents)),
+            ("docker_connections", lambda: asyncio.to_thread(self._check_server_connections)),
+            ("discovery", lambda: asyncio.to_thread(discover)),
+            ("nginx", update_nginx),
+        ]
+        progress = self.startup_progress
+        progress.begin([name for name, _ in steps])
+        for name, step in steps:
+            progress.start_step(name)
+            try:
+                await step()
+            except Exception as e:
+                logger.error(f"Startup reconciliation step {name} failed: {e}")
+                progress.finish_step(name, error=str(e))
+            else:
+                progress.finish_step(name)
+        progress.finish()
+        logger.info(f"Startup reconciliation {progress.state}")
+        # Live state has replaced the snapshot's; write a fresh one for the next start
+        self.startup_snapshot = None
+        self.save_startup_snapshot()
+
+    def save_startup_snapshot(self) -> bool:
+        """
+        Write the startup snapshot used by fast startup.
+
+        Returns:
+            True if the snapshot was written
+        """
+        from ciris_manager.docker_discovery import get_cached_discovery
+
+        snapshot = StartupSnapshot()
+        metadata_path = self.agent_registry.metadata_path
+        snapshot.capture("registry", metadata_path, self.agent_registry.export_entries)
+        snapshot.capture("ports", metadata_path, self.port_manager.export_allocations)
+        orchestrator = getattr(self, "deployment_orchestrator", None)
+        if orchestrator is not None:
+            snapshot.capture(
+                "deployments", orchestrator.deployment_state_file, orchestrator.export_state
+            )
+        discovered = get_cached_discovery()
+        if discovered:
+            snapshot.add("discovery", [agent.model_dump() for agent in discovered])
+        try:
+            snapshot.save(self.startup_snapshot_path)
+        except (OSError, ValueError) as e:
+            logger.warning(f"Failed to write startup snapshot: {e}")
+            return False
+        logger.info(f"Startup snapshot written ({', '.join(snapshot.sections)})")
+        return True
+
     def _scan_existing_agents(self) -> None:
         """Scan agent directories to rebuild registry on startup."""
         if not self.agents_dir.exists():
@@ -207,7 +364,7 @@ class CIRISManager:
                 agent_info = self.agent_registry.get_agent(agent_id)
                 if agent_info:
                     # Ensure port manager knows about this allocation
-                    self.port_manager.allocate_port(agent_id)
+                    self.port_manager.allocate_port(agent_id, agent_info.server_id)
                     logger.info(
                         f"Found existing agent: {sanitize_agent_id(agent_id)} on port {agent_info.port}"
                     )
@@ -288,17 +445,6 @@ class CIRISManager:
         if not template_path.exists():
             raise ValueError(f"Template not found: {template}")
 
-        # Check if template is pre-approved
-        is_pre_approved = await self.template_verifier.is_pre_approved(template, template_path)
-
-        if not is_pre_approved and not wa_signature:
-            raise PermissionError(
-                f"Template '{template}' is not pre-approved. WA signature required."
-            )
-
-        if wa_signature and not is_pre_approved:
-            logger.info(f"Verifying WA signature for custom template: {template}")
-
         # Generate agent ID based on whether occurrence_id is provided
         base_id = name.lower().replace(" ", "-")
 
@@ -358,73 +504,55 @@ class CIRISManager:
                     f"(existing instances: {len(existing_agents)})"
                 )
 
-        # Allocate port
-        allocated_port = self.port_manager.allocate_port(agent_id)
-
-        # Generate service token for secure manager-to-agent communication
-        service_token = self._generate_service_token()
-        logger.info(f"Generated service token for agent {sanitize_agent_id(agent_id)}")
+        # Template verification, port allocation, credential generation and the image
+        # presence check do not depend on each other, so run them concurrently
+        step_timings: Dict[str, int] = {}
+
+        async def allocate_port() -> int:
+            return self.port_manager.allocate_port(agent_id, target_server_id)
+
+        results = await asyncio.gather(
+            self._timed_step(
+                step_timings,
+                "template_verification",
+                self.template_verifier.is_pre_approved(template, template_path),
+            ),
+            self._timed_step(step_timings, "port_allocation", allocate_port()),
+            self._timed_step(
+                step_timings,
+                "credential_generation",
+                asyncio.to_thread(self._generate_agent_credentials, agent_id),
+            ),
+            self._timed_step(
+                step_timings, "image_check", self._check_agent_image(target_server_id)
+            ),
+            return_exceptions=True,
+        )
+        is_pre_approved, allocated_port, credentials, _ = results
 
-        # Generate random admin password to replace default
-        admin_password = self._generate_admin_password()
-        logger.info(f"Generated secure admin password for agent {sanitize_agent_id(agent_id)}")
+        failure = next((r for r in results if isinstance(r, BaseException)), None)
+        if failure is None and not is_pre_approved and not wa_signature:
+            failure = PermissionError(
+                f"Template '{template}' is not pre-approved. WA signature required."
+            )
+        if failure is not None:
+            if not isinstance(allocated_port, BaseException):
+                self.port_manager.release_port(agent_id, target_server_id)
+            raise failure
 
-        # Encrypt both token and password for storage
-        from ciris_manager.crypto import get_token_encryption
+        if wa_signature and not is_pre_approved:
+            logger.info(f"Verifying WA signature for custom template: {template}")
 
-        encryption = get_token_encryption()
-        encrypted_token = encryption.encrypt_token(service_token)
-        encrypted_password = encryption.encrypt_token(admin_password)
+        # Type assertions for mypy - failures were raised above
+        assert not isinstance(allocated_port, BaseException)
+        assert not isinstance(credentials, BaseException)
+        service_token, admin_password, encrypted_token, encrypted_password = credentials
 
         # Create agent directory using agent_id (no spaces!)
         agent_dir = self.agents_dir / agent_id
-        agent_dir.mkdir(parents=True, exist_ok=True)
-
-        # Create subdirectories with proper permissions matching CIRIS agent expectations
-        # Based on CIRIS File Permission System requirements
-        directories = {
-            "data": 0o755,  # Database files - readable by all
-            "data_archive": 0o755,  # Archived thoughts/tasks - audit trail accessible
-            "logs": 0o755,  # Log files - must be inspectable
-            "config": 0o755,  # Configuration files - config is public
-            "audit_keys": 0o700,  # Audit signing keys - prevent key compromise
-            ".secrets": 0o700,  # Secrets storage - protect sensitive data
-        }
-
-        for dir_name, permissions in directories.items():
-            dir_path = agent_dir / dir_name
-            dir_path.mkdir(parents=True, exist_ok=True)
-            dir_path.chmod(permissions)
-            logger.info(f"Created directory {dir_path} with permissions {oct(permissions)}")
-
-        # NOTE: We defer ownership changes until AFTER all files are written
-        # This ensures the manager can write docker-compose.yml and init scripts
-        import os
-        import subprocess
-        import shutil
-
-        # Ownership change deferred to after all files are written (see below)
-
-        # Copy init script to agent directory
-        init_script_src = Path(__file__).parent / "templates" / "init_permissions.sh"
-        init_script_dst = agent_dir / "init_permissions.sh"
-        if init_script_src.exists():
-            try:
-                # Try regular copy first
-                shutil.copy2(init_script_src, init_script_dst)
-                # Try to set permissions
-                try:
-                    init_script_dst.chmod(0o755)
-                except PermissionError:
-                    logger.warning(f"Could not set execute permission on {init_script_dst}")
-                logger.info(f"Copied init script to {init_script_dst}")
-            except PermissionError as e:
-                logger.warning(f"Could not copy init script due to permissions: {e}")
-                logger.warning(
-                    f"Manual fix: sudo cp {init_script_src} {init_script_dst} && sudo chmod 755 {init_script_dst}"
-                )
-        else:
-            logger.warning(f"Init script not found at {init_script_src}")
+        await self._timed_step(
+            step_timings, "directory_provisioning", self._provision_agent_directory(agent_dir)
+        )
 
         # Add service token and admin password to environment for agent
         if environment is None:
@@ -440,6 +568,7 @@ class CIRISManager:
         # Default to billing disabled if not specified
         actual_billing_enabled = billing_enabled if billing_enabled is not None else False
 
+        compose_start = time.perf_counter()
         compose_config = self.compose_generator.generate_compose(
             agent_id=agent_id,
             agent_name=name,
@@ -478,63 +607,12 @@ class CIRISManager:
             logger.debug("Set compose file ownership to ciris-manager:ciris-manager")
         except Exception as e:
             logger.warning(f"Could not set compose file ownership: {e}")
-            # Try sudo approach as fallback
-            try:
-                result = subprocess.run(
-                    ["sudo", "chown", "ciris-manager:ciris-manager", str(compose_path)],
-                    capture_output=True,
-                    text=True,
-                )
-                if result.returncode == 0:
-                    subprocess.run(
-                        ["sudo", "chmod", "664", str(compose_path)], capture_output=True, text=True
-                    )
-                    logger.debug("Set compose file ownership using sudo")
-                else:
-                    logger.warning(
-                        f"Could not set compose file ownership via sudo: {result.stderr}"
-                    )
-            except Exception as sudo_error:
-                logger.warning(f"Sudo fallback failed: {sudo_error}")
-
-        # NOW change ownership of data directories to container user (uid 1000)
-        # This happens AFTER all files are written so the manager can create them
-        # The compose file stays owned by ciris-manager so it can be updated later
-        logger.debug("Changing ownership of data directories to container user (1000:1000)")
-        try:
-            # Only change ownership of the data directories, NOT the compose file
-            dirs_to_chown = [
-                agent_dir / "data",
-                agent_dir / "data_archive",
-                agent_dir / "logs",
-                agent_dir / "config",
-                agent_dir / "audit_keys",
-                agent_dir / ".secrets",
-            ]
-
-            # Also include init_permissions.sh if it exists
-            if (agent_dir / "init_permissions.sh").exists():
-                dirs_to_chown.append(agent_dir / "init_permissions.sh")
-
-            # Change ownership of all data directories
-            result = subprocess.run(
-                ["sudo", "chown", "-R", "1000:1000"] + [str(d) for d in dirs_to_chown],
-                capture_output=True,
-                text=True,
-            )
-
-            if result.returncode == 0:
-                logger.info("Successfully set ownership of data directories to uid:gid 1000:1000")
+            # Try the privileged broker first, then sudo as fallback
+            if await chown_file(compose_path, "manager"):
+                logger.debug("Set compose file ownership via privileged broker")
             else:
-                logger.warning(f"Failed to set data directory ownership: {result.stderr}")
-                logger.warning(
-                    f"Agent may have permission issues. Manual fix: sudo chown -R 1000:1000 {agent_dir}/data {agent_dir}/logs {agent_dir}/config"
-                )
-        except Exception as e:
-            logger.warning(f"Could not change data directory ownership: {e}")
-            logger.warning(
-                f"Agent may have permission issues. Manual fix: sudo chown -R 1000:1000 {agent_dir}/data {agent_dir}/logs {agent_dir}/config"
-            )
+                self._chown_compose_file_with_sudo(compose_path)
+        step_timings["compose_generation"] = int((time.perf_counter() - compose_start) * 1000)
 
         # Register agent
         self.agent_registry.register_agent(
@@ -555,7 +633,11 @@ class CIRISManager:
             f"Starting container for agent {sanitize_agent_id(agent_id)} on server {target_server_id}"
         )
         try:
-            await self._start_agent(agent_id, compose_path, target_server_id)
+            await self._timed_step(
+                step_timings,
+                "container_start",
+                self._start_agent(agent_id, compose_path, target_server_id),
+            )
             agent_logger.info(
                 f"✅ Container started for agent {sanitize_agent_id(agent_id)} on {target_server_id}"
             )
@@ -565,7 +647,7 @@ class CIRISManager:
             )
             # Clean up on failure
             self.agent_registry.unregister_agent(agent_id)
-            self.port_manager.release_port(agent_id)
+            self.port_manager.release_port(agent_id, target_server_id)
             raise RuntimeError(f"Failed to start agent container: {e}")
 
         # Wait a moment for container to be fully up
@@ -604,6 +686,7 @@ class CIRISManager:
         agent_logger.info(
             f"✅ Agent {sanitize_agent_id(agent_id)} created successfully in {duration_ms}ms"
         )
+        agent_logger.debug(f"Agent creation step timings (ms): {step_timings}")
 
         log_agent_operation(
             operation="create_complete",
@@ -613,6 +696,7 @@ class CIRISManager:
                 "template": template,
                 "port": allocated_port,
                 "duration_ms": duration_ms,
+                "step_timings_ms": step_timings,
             },
         )
 
@@ -625,11 +709,103 @@ class CIRISManager:
             "status": "starting",
         }
 
+    def _compose_params(
+        self, agent: Any, server_config: Any, current_env: Dict[str, str]
+    ) -> Dict[str, Any]:
+        """
+        Build generate_compose arguments (without agent_id) for an existing agent.
+
+        Registry-stored configuration (adapters, LLM, OAuth domains) is combined
+        with the environment of the agent's current compose file.
+
+        Args:
+            agent: Registered agent
+            server_config: Config of the agent's server
+            current_env: Environment from the agent's current compose file
+
+        Returns:
+            Keyword arguments for ComposeGenerator.generate_compose
+        """
+        # Get LLM config from registry (decrypted)
+        llm_config = self.agent_registry.get_llm_config(
+            agent.agent_id,
+            occurrence_id=agent.occurrence_id,
+            server_id=agent.server_id,
+        )
+
+        # Check if discord was originally enabled (before adapter_configs)
+        enable_discord = "discord" in current_env.get("CIRIS_ADAPTER", "").split(",")
+
+        return {
+            "agent_name": agent.name,
+            "port": agent.port,
+            "template": agent.template,
+            "agent_dir": Path(agent.compose_file).parent,
+            "environment": current_env,
+            "use_mock_llm": current_env.get("CIRIS_MOCK_LLM") == "true",
+            "enable_discord": enable_discord,
+            "billing_enabled": current_env.get("CIRIS_BILLING_ENABLED") == "true",
+            "billing_api_key": current_env.get("CIRIS_BILLING_API_KEY"),
+            "database_url": current_env.get("CIRIS_DB_URL"),
+            "database_ssl_cert_path": current_env.get("PGSSLROOTCERT"),
+            "agent_occurrence_id": current_env.get("AGENT_OCCURRENCE_ID"),
+            "oauth_callback_hostname": server_config.hostname,
+            # Use agent's oauth_allowed_domains or fall back to server hostname
+            "oauth_allowed_domains": agent.oauth_allowed_domains or [server_config.hostname],
+            "adapter_configs": agent.adapter_configs or {},
+            "llm_config": llm_config,
+        }
+
+    async def regenerate_local_composes(self, agent_ids: List[str]) -> ComposeChangeSet:
+        """
+        Regenerate the compose files of several local agents in one batch.
+
+        Only files whose content changed are rewritten, so agents whose
+        configuration is unchanged are reported as unchanged and untouched.
+        Agents that are not registered, not on a local server or have no
+        compose file are reported as failed.
+
+        Args:
+            agent_ids: Agents to regenerate
+
+        Returns:
+            ComposeChangeSet with changed, unchanged and failed agents
+        """
+        import yaml
+
+        requests: List[ComposeRequest] = []
+        skipped: Dict[str, str] = {}
+        for agent_id in agent_ids:
+            agent = self.agent_registry.get_agent(agent_id, server_id="main")
+            if not agent:
+                skipped[agent_id] = "agent not found"
+                continue
+            server_config = self.docker_client.get_server_config(agent.server_id or "main")
+            compose_path = Path(agent.compose_file)
+            if not server_config.is_local:
+                skipped[agent_id] = "not on a local server"
+                continue
+            try:
+                with open(compose_path) as f:
+                    current_compose = yaml.safe_load(f) or {}
+                service_config = current_compose.get("services", {}).get(agent_id, {})
+                current_env = normalize_compose_env(service_config.get("environment"))
+                params = self._compose_params(agent, server_config, current_env)
+            except Exception as e:
+                skipped[agent_id] = str(e)
+                continue
+            requests.append(ComposeRequest(agent_id, compose_path, params))
+
+        changes = await asyncio.to_thread(self.compose_generator.generate_batch, requests)
+        changes.failed.update(skipped)
+        return changes
+
     async def regenerate_agent_compose(
         self,
         agent_id: str,
         occurrence_id: Optional[str] = None,
         server_id: Optional[str] = None,
+        apply_live: bool = False,
     ) -> Dict[str, Any]:
         """
         Regenerate docker-compose.yml for an existing agent.
@@ -641,13 +817,19 @@ class CIRISManager:
         - Local: reads/writes compose file directly from filesystem
         - Remote: fetches/syncs compose file via Docker exec on nginx container
 
+        When apply_live is set and only environment variables changed, the new
+        values are also pushed to the running agent as a versioned config
+        document, so no restart is needed once the agent acknowledges it.
+
         Args:
             agent_id: Agent identifier
             occurrence_id: Occurrence ID for multi-instance agents
             server_id: Server ID
+            apply_live: Push env-only changes to the running agent
 
         Returns:
-            Dict with regeneration status
+            Dict with regeneration status, including whether a recreate is required
+            and whether the change was applied live
 
         Raises:
             ValueError: If agent not found
@@ -688,74 +870,222 @@ class CIRISManager:
         # the orchestrator silently falls back to stale env from the old container.
         current_env = normalize_compose_env(service_config.get("environment"))
 
-        # Get adapter configs from registry
-        adapter_configs = agent.adapter_configs or {}
-
-        # Get LLM config from registry (decrypted)
-        llm_config = self.agent_registry.get_llm_config(
-            agent.agent_id,
-            occurrence_id=agent.occurrence_id,
-            server_id=agent.server_id,
-        )
-
-        # Check if discord was originally enabled (before adapter_configs)
-        enable_discord = "discord" in current_env.get("CIRIS_ADAPTER", "").split(",")
-
         # Regenerate compose with adapter_configs and llm_config
-        agent_dir = compose_path.parent
-        # Use agent's oauth_allowed_domains or fall back to server hostname
-        oauth_allowed_domains = agent.oauth_allowed_domains or [server_config.hostname]
+        adapter_configs = agent.adapter_configs or {}
         new_compose = self.compose_generator.generate_compose(
-            agent_id=agent_id,
-            agent_name=agent.name,
-            port=agent.port,
-            template=agent.template,
-            agent_dir=agent_dir,
-            environment=current_env,
-            use_mock_llm=current_env.get("CIRIS_MOCK_LLM") == "true",
-            enable_discord=enable_discord,
-            billing_enabled=current_env.get("CIRIS_BILLING_ENABLED") == "true",
-            billing_api_key=current_env.get("CIRIS_BILLING_API_KEY"),
-            database_url=current_env.get("CIRIS_DB_URL"),
-            database_ssl_cert_path=current_env.get("PGSSLROOTCERT"),
-            agent_occurrence_id=current_env.get("AGENT_OCCURRENCE_ID"),
-            oauth_callback_hostname=server_config.hostname,
-            oauth_allowed_domains=oauth_allowed_domains,
-            adapter_configs=adapter_configs,
-            llm_config=llm_config,
+            agent_id=agent_id, **self._compose_params(agent, server_config, current_env)
         )
 
-        # Write updated compose file
+        # Keep generation timestamps so an unchanged config renders identically
+        carry_over_volatile_fields(new_compose, current_compose)
+
+        # Write updated compose file, skipping the write when nothing changed
         if server_config.is_local:
             # Local server: write directly
-            self.compose_generator.write_compose_file(new_compose, compose_path)
+            compose_changed = self.compose_generator.write_compose_file(new_compose, compose_path)
         else:
             # Remote server: sync via Docker exec
-            success = await self._sync_compose_to_remote_server(
-                target_server_id, str(compose_path), new_compose
-            )
-            if not success:
-                raise ValueError(f"Failed to sync compose file to remote server: {compose_path}")
+            render = self.compose_generator.render_compose
+            compose_changed = render(new_compose) != render(current_compose)
+            if compose_changed:
+                success = await self._sync_compose_to_remote_server(
+                    target_server_id, str(compose_path), new_compose
+                )
+                if not success:
+                    raise ValueError(
+                        f"Failed to sync compose file to remote server: {compose_path}"
+                    )
 
         logger.info(
             f"Regenerated compose file for agent {agent_id} with "
             f"{len(adapter_configs)} adapter config(s) (server: {target_server_id})"
         )
 
-        return {
+        change = diff_service_config(service_config, new_compose["services"].get(agent_id, {}))
+        new_service = new_compose["services"].get(agent_id, {})
+        result: Dict[str, Any] = {
             "agent_id": agent_id,
             "compose_file": str(compose_path),
+            "environment": new_service.get("environment", {}),
             "adapter_configs_applied": list(adapter_configs.keys()),
+            "changed_env": sorted(change.env_changes),
+            "requires_recreate": change.requires_recreate,
+            "recreate_fields": change.recreate_fields,
+            "compose_changed": compose_changed,
+            "live_applied": False,
             "message": "Compose file regenerated. Restart agent to apply changes.",
         }
+        if not compose_changed:
+            result["message"] = "Compose file already up to date."
+
+        if apply_live and change.env_changes and not change.requires_recreate:
+            push = await self._push_live_config(agent, server_config, change.env_changes)
+            if push is not None:
+                result["config_version"] = push.version
+                result["live_applied"] = push.acknowledged
+                if push.acknowledged:
+                    result["message"] = (
+                        f"Compose file regenerated and config version {push.version} "
+                        "applied live."
+                    )
+                else:
+                    result["live_error"] = push.error
+
+        return result
+
+    async def apply_config_live(
+        self,
+        agent: Any,
+        env_changes: Dict[str, Optional[str]],
+        compose_config: Dict[str, Any],
+    ) -> Optional[ConfigPushResult]:
+        """
+        Push environment changes that were already written to the local compose file.
+
+        For remote agents the compose file on the agent's server is synced first,
+        so a later restart or recreate keeps the values applied live. Nothing is
+        pushed if the compose file cannot be persisted.
+
+        Args:
+            agent: Registered agent
+            env_changes: Environment changes (None values are removals)
+            compose_config: Updated compose configuration
+
+        Returns:
+            ConfigPushResult, or None if the push could not be attempted
+        """
+        server_id = agent.server_id or "main"
+        server_config = self.docker_client.get_server_config(server_id)
+        if not server_config.is_local and not await self._sync_compose_to_remote_server(
+            server_id, str(agent.compose_file), compose_config
+        ):
+            logger.warning(f"Not applying config live to {agent.agent_id}: compose sync failed")
+            return None
+        return await self._push_live_config(agent, server_config, env_changes)
+
+    async def _push_live_config(
+        self, agent: Any, server_config: Any, env_changes: Dict[str, Optional[str]]
+    ) -> Optional[ConfigPushResult]:
+        """
+        Push environment changes to a running agent and wait for acknowledgment.
+
+        Args:
+            agent: Registered agent
+            server_config: Server the agent runs on
+            env_changes: Environment changes (None values are removals)
+
+        Returns:
+            ConfigPushResult, or None if the push could not be attempted
+        """
+        from ciris_manager.agent_auth import get_agent_auth
+
+        version = self.agent_registry.next_config_version(
+            agent.agent_id, occurrence_id=agent.occurrence_id, server_id=agent.server_id
+        )
+        if version is None:
+            return None
+
+        try:
+            headers = get_agent_auth().get_auth_headers(
+                agent.agent_id, occurrence_id=agent.occurrence_id, server_id=agent.server_id
+            )
+        except ValueError as e:
+            logger.warning(f"Cannot push live config to {agent.agent_id}: {e}")
+            return None
+
+        host = "localhost" if server_config.is_local else server_config.vpc_ip
+        push = await self.config_pusher.push(
+            f"http://{host}:{agent.port}", headers, version, env_changes
+        )
+        if push.acknowledged:
+            logger.info(f"Agent {agent.agent_id} applied live config version {version}")
+            # The container's own environment still has the old values
+            self.agent_registry.mark_live_config_applied(
+                agent.agent_id, occurrence_id=agent.occurrence_id, server_id=agent.server_id
+            )
+        else:
+            logger.info(
+                f"Live config version {version} not applied by {agent.agent_id}: {push.error}"
+            )
+        return push
+
+    def needs_recreate_for_live_config(self, agent: Any, container: Any) -> bool:
+        """
+        Whether a container predates a live config push to its agent.
+
+        Config pushed live is not in the container's Config.Env, so restarting
+        such a container would revert it; it has to be recreated instead.
+
+        Args:
+            agent: Registered agent
+            container: The agent's Docker container
+
+        Returns:
+            True if the container must be recreated rather than restarted
+        """
+        applied_at = (getattr(agent, "metadata", None) or {}).get("live_config_applied_at")
+        if not applied_at:
+            return False
+        created = container.attrs.get("Created")
+        try:
+            return not created or dateutil.parser.parse(created) < dateutil.parser.parse(
+                applied_at
+            )
+        except (ValueError, OverflowError):
+            return True
+
+    async def recreate_agent_container(self, agent: Any) -> bool:
+        """
+        Recreate an agent's container from its compose file.
+
+        Used instead of a restart for containers that predate a live config
+        push, so the pushed values survive.
+
+        Args:
+            agent: Registered agent
+
+        Returns:
+            True if the container was recreated
+        """
+        server_id = agent.server_id or "main"
+        if self.docker_client.get_server_config(server_id).is_local:
+            compose_path = Path(agent.compose_file)
+            try:
+                process = await asyncio.create_subprocess_exec(
+                    *compose_cmd("-f", str(compose_path), "up", "-d", "--force-recreate"),
+                    stdout=asyncio.subprocess.PIPE,
+                    stderr=asyncio.subprocess.PIPE,
+                    cwd=str(compose_path.parent),
+                )
+            except ComposeNotFoundError as e:
+                logger.error(f"Cannot recreate agent {agent.agent_id}: {e}")
+                return False
+            _, stderr = await process.communicate()
+            if process.returncode != 0:
+                logger.error(f"Failed to recreate {agent.agent_id}: {stderr.decode()}")
+                return False
+        else:
+            from ciris_manager.deployment import get_deployment_orchestrator
+
+            if not await get_deployment_orchestrator()._recreate_agent_container(
+                agent.agent_id, server_id=server_id, new_image=None
+            ):
+                return False
+
+        logger.info(f"Recreated container for {agent.agent_id} to keep its live config")
+        self.agent_registry.clear_live_config_applied(
+            agent.agent_id, occurrence_id=agent.occurrence_id, server_id=agent.server_id
+        )
+        return True
 
     async def _fetch_remote_compose(
         self, server_id: str, compose_path: str
     ) -> Optional[Dict[str, Any]]:
         """
-        Fetch compose file content from a remote server via Docker exec.
+        Fetch compose file content from a remote server.
 
-        Uses the nginx container which has /opt/ciris mounted.
+        Uses the server's agent-host sidecar when configured, otherwise Docker
+        exec in the nginx container which has /opt/ciris mounted.
 
         Args:
             server_id: Remote server ID
@@ -766,6 +1096,18 @@ class CIRISManager:
         """
         import yaml
 
+        host = get_agent_host(server_id)
+        if host:
+            try:
+                content = await host.read_file(Path(compose_path))
+                parsed: Dict[str, Any] = yaml.safe_load(content)
+                return parsed
+            except AgentHostUnavailableError as e:
+                logger.warning(f"{e}, falling back to Docker exec")
+            except AgentHostError as e:
+                logger.error(f"Failed to read compose file from {server_id}: {e}")
+                return None
+
         try:
             docker_client = self.docker_client.get_client(server_id)
             if not docker_client:
@@ -805,9 +1147,10 @@ class CIRISManager:
         self, server_id: str, compose_path: str, compose_config: Dict[str, Any]
     ) -> bool:
         """
-        Sync compose file content to a remote server via Docker exec.
+        Sync compose file content to a remote server.
 
-        Uses the nginx container which has /opt/ciris mounted.
+        Uses the server's agent-host sidecar when configured, otherwise Docker
+        exec in the nginx container which has /opt/ciris mounted.
 
         Args:
             server_id: Remote server ID
@@ -820,6 +1163,26 @@ class CIRISManager:
         import base64
         import yaml
 
+        # Convert compose dict to YAML string
+        compose_content = yaml.dump(
+            compose_config,
+            default_flow_style=False,
+            sort_keys=False,
+            width=120,
+        )
+
+        host = get_agent_host(server_id)
+        if host:
+            try:
+                await host.write_file(Path(compose_path), compose_content.encode())
+                logger.info(f"✅ Synced compose file to remote server {server_id}: {compose_path}")
+                return True
+            except AgentHostUnavailableError as e:
+                logger.warning(f"{e}, falling back to Docker exec")
+            except AgentHostError as e:
+                logger.error(f"Failed to write compose file to {server_id}: {e}")
+                return False
+
         try:
             docker_client = self.docker_client.get_client(server_id)
             if not docker_client:
@@ -828,14 +1191,6 @@ class CIRISManager:
 
             nginx_container = docker_client.containers.get("ciris-nginx")
 
-            # Convert compose dict to YAML string
-            compose_content = yaml.dump(
-                compose_config,
-                default_flow_style=False,
-                sort_keys=False,
-                width=120,
-            )
-
             # Ensure directory exists and write compose file via base64
             compose_dir = str(Path(compose_path).parent)
             encoded_content = base64.b64encode(compose_content.encode()).decode()
@@ -967,6 +1322,22 @@ class CIRISManager:
         """
         logger.info(f"Ensuring shared files exist on remote server {server_id}")
 
+        script_src = Path(__file__).parent / "templates" / "fix_agent_permissions.sh"
+        host = get_agent_host(server_id)
+        if host and script_src.exists():
+            # The sidecar creates /home/ciris/shared along with the file
+            try:
+                host.request_sync(
+                    "write-file",
+                    Path("/home/ciris/shared/fix_agent_permissions.sh"),
+                    "755",
+                    script_src.read_bytes(),
+                )
+                logger.info(f"✅ Copied fix_agent_permissions.sh to {server_id}:/home/ciris/shared/")
+                return
+            except AgentHostError as e:
+                logger.warning(f"Agent host could not write shared files on {server_id}: {e}")
+
         docker_client = self.docker_client.get_client(server_id)
 
         # Create /home/ciris/shared directory if it doesn't exist
@@ -989,7 +1360,6 @@ class CIRISManager:
             )
 
         # Copy fix_agent_permissions.sh script
-        script_src = Path(__file__).parent / "templates" / "fix_agent_permissions.sh"
         if script_src.exists():
             with open(script_src, "r") as f:
                 script_content = f.read()
@@ -1033,12 +1403,24 @@ class CIRISManager:
         """
         logger.info(f"Creating agent directories for {agent_id} on remote server {server_id}")
 
-        # Get Docker client for remote server
-        docker_client = self.docker_client.get_client(server_id)
-
         # Base path for agent directories on remote server
         base_path = f"/opt/ciris/agents/{agent_id}"
 
+        host = get_agent_host(server_id)
+        if host:
+            try:
+                await host.provision_agent(Path(base_path))
+                logger.info(f"✅ Created agent directories on {server_id} at {base_path}")
+                return
+            except AgentHostUnavailableError as e:
+                logger.warning(f"{e}, falling back to Docker exec")
+            except AgentHostError as e:
+                logger.error(f"Failed to create agent directories on {server_id}: {e}")
+                raise RuntimeError(f"Failed to create agent directories on {server_id}: {e}")
+
+        # Get Docker client for remote server
+        docker_client = self.docker_client.get_client(server_id)
+
         # Subdirectories to create with their permissions
         directories = {
             "data": "755",
@@ -1049,56 +1431,37 @@ class CIRISManager:
             ".secrets": "700",
         }
 
+        # Build the whole skeleton in one shell invocation so provisioning costs
+        # a single remote round trip instead of one per directory
+        commands = [f"mkdir -p {base_path}", f"chown 1000:1000 {base_path}"]
+        for dir_name, perms in directories.items():
+            dir_path = f"{base_path}/{dir_name}"
+            commands.append(
+                f"mkdir -p {dir_path} && chmod {perms} {dir_path} && chown 1000:1000 {dir_path}"
+            )
+        create_cmd = " && ".join(commands)
+
         try:
-            # First, create the base agent directory
-            base_dir_cmd = f"mkdir -p {base_path} && chown 1000:1000 {base_path}"
             try:
                 nginx_container = docker_client.containers.get("ciris-nginx")
-                exec_result = nginx_container.exec_run(f"sh -c '{base_dir_cmd}'", user="root")
+                exec_result = await asyncio.to_thread(
+                    nginx_container.exec_run, f"sh -c '{create_cmd}'", user="root"
+                )
                 if exec_result.exit_code != 0:
                     output = exec_result.output
                     error_msg = output.decode() if isinstance(output, bytes) else str(output)
-                    raise RuntimeError(f"Failed to create base directory: {error_msg}")
+                    raise RuntimeError(f"Failed to create directories: {error_msg}")
             except Exception as e:
-                logger.warning(f"Could not use nginx container for base directory: {e}")
-                docker_client.containers.run(
+                logger.warning(f"Could not use nginx container for agent directories: {e}")
+                await asyncio.to_thread(
+                    docker_client.containers.run,
                     "alpine:latest",
-                    command=f"sh -c '{base_dir_cmd}'",
+                    command=f"sh -c '{create_cmd}'",
                     volumes={"/opt/ciris": {"bind": "/opt/ciris", "mode": "rw"}},
                     remove=True,
                     detach=False,
                 )
-            logger.info(f"Created base directory: {base_path}")
-
-            # Create subdirectories
-            for dir_name, perms in directories.items():
-                dir_path = f"{base_path}/{dir_name}"
-                create_cmd = (
-                    f"mkdir -p {dir_path} && chmod {perms} {dir_path} && chown 1000:1000 {dir_path}"
-                )
 
-                try:
-                    nginx_container = docker_client.containers.get("ciris-nginx")
-                    exec_result = nginx_container.exec_run(f"sh -c '{create_cmd}'", user="root")
-                    if exec_result.exit_code != 0:
-                        output = exec_result.output
-                        error_msg = output.decode() if isinstance(output, bytes) else str(output)
-                        raise RuntimeError(f"Failed to create directory: {error_msg}")
-                except Exception as e:
-                    logger.warning(f"Could not use nginx container for {dir_name}: {e}")
-                    docker_client.containers.run(
-                        "alpine:latest",
-                        command=f"sh -c '{create_cmd}'",
-                        volumes={"/opt/ciris": {"bind": "/opt/ciris", "mode": "rw"}},
-                        remove=True,
-                        detach=False,
-                    )
-
-                logger.debug(f"Created directory {dir_path} with permissions {perms}")
-
-            # Permissions are already set correctly by the alpine/nginx containers above
-            # The fix_agent_permissions.sh script is only needed for local servers
-            # For remote servers, we've already set ownership to 1000:1000 in each directory creation
             logger.info(
                 f"✅ Created agent directories on {server_id} at {base_path} with correct permissions"
             )
@@ -1367,6 +1730,9 @@ class CIRISManager:
                                 logger.error(
                                     f"Compose file not found for {agent_id}: {compose_path}"
                                 )
+                        elif self.needs_recreate_for_live_config(agent_info, container):
+                            # Starting it again would revert config pushed live
+                            await self.recreate_agent_container(agent_info)
                         else:
                             # Remote server: use Docker API to restart container directly
                             await self._restart_remote_container(agent_id, container, server_id)
@@ -1540,11 +1906,17 @@ class CIRISManager:
         self._running = True
         self._start_time = datetime.now(timezone.utc)
 
-        # Generate initial nginx config
-        logger.info("Updating nginx configuration on startup...")
-        success = await self.update_nginx_config()
-        if not success:
-            logger.error("Failed to update nginx configuration on startup")
+        if self._fast_startup:
+            # Serve from snapshot state; the cold-start work runs in the background
+            task = asyncio.create_task(self._reconcile_startup())
+            self._background_tasks.add(task)
+            task.add_done_callback(self._background_tasks.discard)
+        else:
+            # Generate initial nginx config
+            logger.info("Updating nginx configuration on startup...")
+            success = await self.update_nginx_config()
+            if not success:
+                logger.error("Failed to update nginx configuration on startup")
 
         # Start the new container management loop
         task = asyncio.create_task(self.container_management_loop())
@@ -1570,6 +1942,13 @@ class CIRISManager:
         self._background_tasks.add(task)
         task.add_done_callback(self._background_tasks.discard)
 
+        # Hash templates ahead of time so create_agent finds their checksums cached
+        if getattr(self.config.manager, "prewarm_template_checksums", False):
+            templates_dir = Path(self.config.manager.templates_directory).resolve()
+            task = asyncio.create_task(self.template_verifier.prewarm(templates_dir))
+            self._background_tasks.add(task)
+            task.add_done_callback(self._background_tasks.discard)
+
         logger.info("CIRISManager started successfully")
 
     async def _start_api_server(self) -> None:
@@ -1623,10 +2002,16 @@ class CIRISManager:
             app.state.manager = self
 
             # Create deployment orchestrator and token manager for modular routes
-            from ciris_manager.deployment import DeploymentOrchestrator
+            from ciris_manager.deployment import (
+                DeploymentOrchestrator,
+                set_deployment_orchestrator,
+            )
             from ciris_manager.deployment_tokens import DeploymentTokenManager
 
-            app.state.deployment_orchestrator = DeploymentOrchestrator(self)
+            # One orchestrator for every API version, so deployment state is loaded once
+            self.deployment_orchestrator = DeploymentOrchestrator(self)
+            set_deployment_orchestrator(self.deployment_orchestrator)
+            app.state.deployment_orchestrator = self.deployment_orchestrator
             app.state.token_manager = DeploymentTokenManager()
             logger.info(f"[{time.time() - start_time:.2f}s] App state initialized")
 
@@ -1665,7 +2050,7 @@ class CIRISManager:
 
             # Create routes with manager instance
             logger.info(f"[{time.time() - start_time:.2f}s] About to call create_routes...")
-            router = create_routes(self)
+            router = create_routes(self, self.deployment_orchestrator)
             logger.info(f"[{time.time() - start_time:.2f}s] create_routes returned successfully")
             app.include_router(router, prefix="/manager/v1")
             logger.info(f"[{time.time() - start_time:.2f}s] v1 routes included at /manager/v1")
@@ -1866,7 +2251,7 @@ class CIRISManager:
 
             # Free the port
             if agent_info.port:
-                self.port_manager.release_port(agent_id)
+                self.port_manager.release_port(agent_id, getattr(agent_info, "server_id", None))
 
             # Remove from registry - use composite key for multi-instance support
             self.agent_registry.unregister_agent(
@@ -1907,9 +2292,19 @@ class CIRISManager:
         if hasattr(self, "deployment_orchestrator") and self.deployment_orchestrator:
             await self.deployment_orchestrator.stop()
 
+        if self._fast_startup:
+            self.save_startup_snapshot()
+
         # Stop watchdog
         await self.watchdog.stop()
 
+        # Close pooled agent and agent-host connections
+        from ciris_manager.agent_http import close_agent_http_client
+        from ciris_manager.utils.agent_host import close_agent_hosts
+
+        await close_agent_http_client()
+        await close_agent_hosts()
+
         self._shutdown_event.set()
 
         logger.info("CIRISManager stopped")
@@ -2007,11 +2402,200 @@ class CIRISManager:
         next_occurrence = max_occurrence + 1
         return f"{next_occurrence:03d}"
 
+    @staticmethod
+    async def _timed_step(timings: Dict[str, int], step: str, awaitable: Awaitable[T]) -> T:
+        """Await one agent creation step, recording its duration in milliseconds."""
+        step_start = time.perf_counter()
+        try:
+            return await awaitable
+        finally:
+            timings[step] = int((time.perf_counter() - step_start) * 1000)
+
+    def _generate_agent_credentials(self, agent_id: str) -> Tuple[str, str, str, str]:
+        """
+        Generate and encrypt the service token and admin password for a new agent.
+
+        Runs in a worker thread since key derivation and encryption are CPU bound.
+
+        Returns:
+            (service_token, admin_password, encrypted_token, encrypted_password)
+        """
+        from ciris_manager.crypto import get_token_encryption
+
+        # Service token for secure manager-to-agent communication
+        service_token = self._generate_service_token()
+        logger.info(f"Generated service token for agent {sanitize_agent_id(agent_id)}")
+
+        # Random admin password to replace default
+        admin_password = self._generate_admin_password()
+        logger.info(f"Generated secure admin password for agent {sanitize_agent_id(agent_id)}")
+
+        encryption = get_token_encryption()
+        return (
+            service_token,
+            admin_password,
+            encryption.encrypt_token(service_token),
+            encryption.encrypt_token(admin_password),
+        )
+
+    async def _check_agent_image(self, server_id: str) -> Optional[bool]:
+        """
+        Check whether the default agent image is already present on a server.
+
+        Purely informational: a missing image is pulled by compose/run at start,
+        which is the slowest part of creation and worth knowing about up front.
+
+        Returns:
+            True/False for present/missing, None if the server could not be queried
+        """
+        image = f"{self.compose_generator.docker_registry}/{self.compose_generator.default_image}"
+        try:
+            import docker
+
+            client = self.docker_client.get_client(server_id)
+            await asyncio.to_thread(client.images.get, image)
+            return True
+        except docker.errors.ImageNotFound:
+            logger.info(f"Image {image} not present on {server_id}, it will be pulled at start")
+            return False
+        except Exception as e:
+            logger.debug(f"Could not check for image {image} on {server_id}: {e}")
+            return None
+
+    async def _provision_agent_directory(self, agent_dir: Path) -> None:
+        """
+        Build an agent's directory skeleton with container ownership.
+
+        The agent directory itself stays owned by the manager so it can write the
+        compose file; the data subdirectories are created and handed to the
+        container user (1000:1000) in a single privileged broker call. Without a
+        broker they are created here and chowned via sudo.
+
+        Args:
+            agent_dir: Agent directory (e.g. /opt/ciris/agents/agent-id)
+        """
+        import shutil
+
+        agent_dir.mkdir(parents=True, exist_ok=True)
+
+        # Copy init script first so the privileged pass can hand it over too
+        init_script_src = Path(__file__).parent / "templates" / "init_permissions.sh"
+        init_script_dst = agent_dir / "init_permissions.sh"
+        if init_script_src.exists():
+            try:
+                # Try regular copy first
+                shutil.copy2(init_script_src, init_script_dst)
+                # Try to set permissions
+                try:
+                    init_script_dst.chmod(0o755)
+                except PermissionError:
+                    logger.warning(f"Could not set execute permission on {init_script_dst}")
+                logger.info(f"Copied init script to {init_script_dst}")
+            except PermissionError as e:
+                logger.warning(f"Could not copy init script due to permissions: {e}")
+                logger.warning(
+                    f"Manual fix: sudo cp {init_script_src} {init_script_dst} && sudo chmod 755 {init_script_dst}"
+                )
+        else:
+            logger.warning(f"Init script not found at {init_script_src}")
+
+        if await create_agent_directories(agent_dir):
+            logger.info(f"Provisioned agent directories for {agent_dir} via privileged broker")
+            return
+
+        # Create subdirectories with proper permissions matching CIRIS agent expectations
+        # Based on CIRIS File Permission System requirements
+        directories = {
+            "data": 0o755,  # Database files - readable by all
+            "data_archive": 0o755,  # Archived thoughts/tasks - audit trail accessible
+            "logs": 0o755,  # Log files - must be inspectable
+            "config": 0o755,  # Configuration files - config is public
+            "audit_keys": 0o700,  # Audit signing keys - prevent key compromise
+            ".secrets": 0o700,  # Secrets storage - protect sensitive data
+        }
+
+        for dir_name, permissions in directories.items():
+            dir_path = agent_dir / dir_name
+            dir_path.mkdir(parents=True, exist_ok=True)
+            dir_path.chmod(permissions)
+            logger.info(f"Created directory {dir_path} with permissions {oct(permissions)}")
+
+        logger.debug("Changing ownership of data directories to container user (1000:1000)")
+        self._chown_agent_directories_with_sudo(agent_dir)
+
+    def _chown_compose_file_with_sudo(self, compose_path: Path) -> None:
+        """Hand the compose file back to ciris-manager via sudo (no broker installed)."""
+        import subprocess
+
+        try:
+            result = subprocess.run(
+                ["sudo", "chown", "ciris-manager:ciris-manager", str(compose_path)],
+                capture_output=True,
+                text=True,
+            )
+            if result.returncode == 0:
+                subprocess.run(
+                    ["sudo", "chmod", "664", str(compose_path)], capture_output=True, text=True
+                )
+                logger.debug("Set compose file ownership using sudo")
+            else:
+                logger.warning(f"Could not set compose file ownership via sudo: {result.stderr}")
+        except Exception as sudo_error:
+            logger.warning(f"Sudo fallback failed: {sudo_error}")
+
+    def _chown_agent_directories_with_sudo(self, agent_dir: Path) -> None:
+        """Give the agent's data directories to the container user via sudo (no broker)."""
+        import subprocess
+
+        manual_fix = (
+            f"Agent may have permission issues. Manual fix: sudo chown -R 1000:1000 "
+            f"{agent_dir}/data {agent_dir}/logs {agent_dir}/config"
+        )
+        try:
+            # Only change ownership of the data directories, NOT the compose file
+            dirs_to_chown = [
+                agent_dir / "data",
+                agent_dir / "data_archive",
+                agent_dir / "logs",
+                agent_dir / "config",
+                agent_dir / "audit_keys",
+                agent_dir / ".secrets",
+            ]
+
+            # Also include init_permissions.sh if it exists
+            if (agent_dir / "init_permissions.sh").exists():
+                dirs_to_chown.append(agent_dir / "init_permissions.sh")
+
+            # Change ownership of all data directories
+            result = subprocess.run(
+                ["sudo", "chown", "-R", "1000:1000"] + [str(d) for d in dirs_to_chown],
+                capture_output=True,
+                text=True,
+            )
+
+            if result.returncode == 0:
+                logger.info("Successfully set ownership of data directories to uid:gid 1000:1000")
+            else:
+                logger.warning(f"Failed to set data directory ownership: {result.stderr}")
+                logger.warning(manual_fix)
+        except Exception as e:
+            logger.warning(f"Could not change data directory ownership: {e}")
+            logger.warning(manual_fix)
+
     def _run_emergency_permission_fix(self, agent_dir: Path, agent_id: str) -> None:
         """Emergency permission fixing using a temporary script."""
         import tempfile
         import subprocess
 
+        broker = get_privileged_broker()
+        if broker:
+            try:
+                broker.request_sync("fix-perms", agent_dir)
+                logger.info(f"Emergency permission fix for {agent_id} done via privileged broker")
+                return
+            except BrokerError as e:
+                logger.warning(f"Privileged broker permission fix failed, using sudo: {e}")
+
         script_content = f"""#!/bin/bash
 set -e
 echo "Emergency permission fix for agent {agent_id}..."
@@ -2094,7 +2678,7 @@ echo "✓ Emergency permission fix completed"
             new_password: New password to set
             server_id: Server ID where agent is running
         """
-        import httpx
+        from ciris_manager.agent_http import get_agent_http_client
 
         # Determine the base URL based on server
         if server_id == "main":
@@ -2107,9 +2691,9 @@ echo "✓ Emergency permission fix completed"
         login_url = f"http://{base_url}:{port}/v1/auth/login"
         login_data = {"username": "admin", "password": "ciris_admin_password"}
 
-        async with httpx.AsyncClient(timeout=10.0) as client:
+        async with get_agent_http_client() as client:
             logger.info(f"Logging into agent {sanitize_agent_id(agent_id)} to set password")
-            login_response = await client.post(login_url, json=login_data)
+            login_response = await client.post(login_url, json=login_data, timeout=10.0)
 
             if login_response.status_code != 200:
                 raise RuntimeError(
@@ -2135,7 +2719,9 @@ echo "✓ Emergency permission fix completed"
                 "Content-Type": "application/json",
             }
 
-            password_response = await client.put(password_url, headers=headers, json=password_data)
+            password_response = await client.put(
+                password_url, headers=headers, json=password_data, timeout=10.0
+            )
 
             if password_response.status_code != 200:
                 raise RuntimeError(
@@ -2224,6 +2810,7 @@ echo "✓ Emergency permission fix completed"
                 "nginx": "enabled" if self.config.nginx.enabled else "disabled",
             },
             "system_metrics": system_metrics,
+            "startup": self.startup_progress.to_dict(),
         }
 
 
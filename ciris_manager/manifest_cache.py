@@ -0,0 +1,125 @@
+"""
+Adapter manifest cache shared by all agents running the same image.
+
+Adapter type lists and manifests come from the agent image, so every agent
+running a given image returns the same documents. Entries are keyed by
+(image ID, key), filled lazily on first request, and dropped when a
+deployment changes which images are running.
+"""
+
+import logging
+from collections import OrderedDict
+from typing import Any, Awaitable, Callable, Dict, Optional, Tuple
+
+from ciris_manager.utils.coalesce import Coalescer
+
+logger = logging.getLogger(__name__)
+
+# Images kept in the cache; older images are evicted first
+MAX_CACHED_IMAGES = 8
+
+CacheKey = Tuple[str, str]
+
+
+class AdapterManifestCache:
+    """Per-image cache of agent adapter metadata."""
+
+    def __init__(self, max_images: int = MAX_CACHED_IMAGES):
+        """
+        Initialize manifest cache.
+
+        Args:
+            max_images: Number of distinct images to keep entries for
+        """
+        self.max_images = max_images
+        self._images: "OrderedDict[str, Dict[str, Any]]" = OrderedDict()
+        self._inflight: Coalescer[CacheKey, Optional[Any]] = Coalescer()
+        self.hits = 0
+        self.misses = 0
+
+    def get(self, image_id: str, key: str) -> Optional[Any]:
+        """Get a cached document, or None."""
+        entries = self._images.get(image_id)
+        if entries is None or key not in entries:
+            return None
+        self._images.move_to_end(image_id)
+        return entries[key]
+
+    def put(self, image_id: str, key: str, value: Any) -> None:
+        """Store a document for an image."""
+        self._images.setdefault(image_id, {})[key] = value
+        self._images.move_to_end(image_id)
+        while len(self._images) > self.max_images:
+            evicted, _ = self._images.popitem(last=False)
+            logger.debug(f"Evicted adapter manifests for image {evicted[:19]}")
+
+    async def get_or_fetch(
+        self,
+        image_id: Optional[str],
+        key: str,
+        fetch: Callable[[], Awaitable[Optional[Any]]],
+    ) -> Optional[Any]:
+        """
+        Get a document, fetching it from one agent if no agent on the image has yet.
+
+        Concurrent misses for the same (image, key) share a single fetch.
+        None results are returned but not cached.
+
+        Args:
+            image_id: Image the agent runs; without one the cache is bypassed
+            key: Document key (e.g. "types" or "manifest:discord")
+            fetch: Coroutine factory that retrieves the document from the agent
+
+        Returns:
+            The document
+        """
+        if not image_id:
+            return await fetch()
+
+        cached = self.get(image_id, key)
+        if cached is not None:
+            self.hits += 1
+            return cached
+
+        async def fetch_miss() -> Optional[Any]:
+            self.misses += 1
+            return await fetch()
+
+        def remember(value: Optional[Any]) -> None:
+            if value is not None:
+                self.put(image_id, key, value)
+
+        return await self._inflight.run((image_id, key), fetch_miss, on_result=remember)
+
+    def invalidate(self, image_id: Optional[str] = None) -> None:
+        """
+        Drop cached documents.
+
+        Args:
+            image_id: Only drop this image's documents (everything if None)
+        """
+        if image_id is None:
+            self._images.clear()
+        else:
+            self._images.pop(image_id, None)
+        logger.debug(f"Adapter manifest cache invalidated ({image_id or 'all images'})")
+
+    def stats(self) -> Dict[str, int]:
+        """Cache statistics."""
+        return {
+            "images": len(self._images),
+            "entries": sum(len(entries) for entries in self._images.values()),
+            "hits": self.hits,
+            "misses": self.misses,
+        }
+
+
+_manifest_cache: Optional[AdapterManifestCache] = None
+
+
+def get_manifest_cache() -> AdapterManifestCache:
+    """Get the shared adapter manifest cache."""
+    global _manifest_cache
+    if _manifest_cache is None:
+        _manifest_cache = AdapterManifestCache()
+    return _manifest_cache
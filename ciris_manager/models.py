@@ -221,6 +221,14 @@ class DeploymentStatus(BaseModel):
         default=None,
         description="Canary group assignments for this deployment: explorers, early_adopters, general",
     )
+    time_to_work_samples: List[float] = Field(
+        default_factory=list,
+        description="Minutes each canary agent took to reach WORK (feeds adaptive phase timing)",
+    )
+    censored_time_to_work: List[float] = Field(
+        default_factory=list,
+        description="Minutes canary agents were watched without reaching WORK (right-censored)",
+    )
 
 
 class AgentUpdateResponse(BaseModel):
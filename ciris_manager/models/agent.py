@@ -226,6 +226,9 @@ class AgentInfo(BaseModel):
 
     # Docker info
     image: Optional[str] = Field(None, description="Docker image")
+    image_id: Optional[str] = Field(
+        None, description="ID (sha256 digest) of the image the container runs"
+    )
 
     # Authentication
     oauth_status: Optional[str] = Field(
@@ -2,6 +2,12 @@
 Port management for CIRIS agents.
 
 Handles dynamic port allocation and tracking for agent containers.
+
+Each server has its own port space: a bitmap of used ports plus forward
+(agent -> port) and reverse (port -> agent) indexes, so allocation, release and
+availability checks never scan the allocation table. Ports already bound on
+the local host are found with a single /proc/net/tcp{,6} snapshot per
+allocation rather than a bind probe per candidate port.
 """
 
 import json
@@ -9,16 +15,126 @@ import logging
 import socket
 import threading
 from pathlib import Path
-from typing import Dict, Set, Optional
+from typing import Dict, Iterable, Set, Optional
 
 logger = logging.getLogger(__name__)
 
+PROC_NET_TCP_FILES = (Path("/proc/net/tcp"), Path("/proc/net/tcp6"))
+TCP_LISTEN_STATE = "0A"
+
+
+def listening_ports(paths: Iterable[Path] = PROC_NET_TCP_FILES) -> Optional[Set[int]]:
+    """
+    Snapshot the TCP ports in LISTEN state on this host.
+
+    Args:
+        paths: /proc/net tables to read
+
+    Returns:
+        Set of listening ports, or None if no table could be read (non-Linux)
+    """
+    ports: Set[int] = set()
+    readable = False
+    for path in paths:
+        try:
+            lines = path.read_text().splitlines()[1:]
+        except OSError:
+            continue
+        readable = True
+        for line in lines:
+            # sl local_address rem_address st ...; local_address is HEXIP:HEXPORT
+            fields = line.split()
+            if len(fields) > 3 and fields[3] == TCP_LISTEN_STATE:
+                ports.add(int(fields[1].rsplit(":", 1)[1], 16))
+    return ports if readable else None
+
+
+class PortSpace:
+    """Port allocation state for a single server."""
+
+    def __init__(self, start_port: int, end_port: int, reserved: Iterable[int] = ()):
+        """
+        Initialize port space.
+
+        Args:
+            start_port: First port in allocation range
+            end_port: Last port in allocation range
+            reserved: Ports that must never be allocated
+        """
+        self.start_port = start_port
+        self.end_port = end_port
+        self.agent_ports: Dict[str, int] = {}  # agent_id -> port
+        self.port_owners: Dict[int, str] = {}  # port -> agent_id
+        self.reserved: Set[int] = set()
+        # One byte per port in range: 0 = free, 1 = allocated or reserved
+        self._used = bytearray(max(end_port - start_port + 1, 0))
+        for port in reserved:
+            self.reserve(port)
+
+    def _mark(self, port: int, used: bool) -> None:
+        if self.start_port <= port <= self.end_port:
+            self._used[port - self.start_port] = 1 if used else 0
+
+    def reserve(self, port: int) -> None:
+        """Exclude a port from allocation."""
+        self.reserved.add(port)
+        self._mark(port, True)
+
+    def assign(self, agent_id: str, port: int) -> None:
+        """Record that an agent owns a port."""
+        previous = self.agent_ports.get(agent_id)
+        if previous is not None and previous != port:
+            self.release(agent_id)
+        self.agent_ports[agent_id] = port
+        self.port_owners[port] = agent_id
+        self._mark(port, True)
+
+    def release(self, agent_id: str) -> Optional[int]:
+        """Drop an agent's port, returning it if one was allocated."""
+        port = self.agent_ports.pop(agent_id, None)
+        if port is None:
+            return None
+        if self.port_owners.get(port) == agent_id:
+            del self.port_owners[port]
+            if port not in self.reserved:
+                self._mark(port, False)
+        return port
+
+    def is_free(self, port: int) -> bool:
+        """Whether a port is in range and neither allocated nor reserved."""
+        if port < self.start_port or port > self.end_port:
+            return False
+        return self._used[port - self.start_port] == 0
+
+    def find_free(self, exclude: Optional[Set[int]] = None) -> Optional[int]:
+        """
+        Find the lowest free port.
+
+        Args:
+            exclude: Additional ports to skip (e.g. bound by other processes)
+
+        Returns:
+            Free port, or None if the space is exhausted
+        """
+        index = self._used.find(0)
+        while index != -1:
+            port = self.start_port + index
+            if not exclude or port not in exclude:
+                return port
+            index = self._used.find(0, index + 1)
+        return None
+
 
 class PortManager:
     """Manages dynamic port allocation for agents."""
 
     def __init__(
-        self, start_port: int = 8080, end_port: int = 8200, metadata_path: Optional[Path] = None
+        self,
+        start_port: int = 8080,
+        end_port: int = 8200,
+        metadata_path: Optional[Path] = None,
+        local_server_id: str = "main",
+        allocations: Optional[Dict[str, Dict[str, int]]] = None,
     ):
         """
         Initialize port manager.
@@ -27,20 +143,31 @@ class PortManager:
             start_port: First port in allocation range
             end_port: Last port in allocation range
             metadata_path: Path to metadata.json for persistence
+            local_server_id: Server whose ports are also checked against this host's sockets
+            allocations: Ports by server and agent from export_allocations() of a
+                validated startup snapshot; skips reading metadata.json
         """
         self.start_port = start_port
         self.end_port = end_port
         self.metadata_path = metadata_path
+        self.local_server_id = local_server_id
 
         # Thread safety
         self._lock = threading.Lock()
 
         # Port tracking
-        self.allocated_ports: Dict[str, int] = {}  # agent_id -> port
         self.reserved_ports: Set[int] = {8888, 3000, 80, 443}  # Never allocate these
-
+        self._spaces: Dict[str, PortSpace] = {}
+        # agent_id -> port for the local server
+        self.allocated_ports: Dict[str, int] = self._space(local_server_id).agent_ports
+
+        if allocations is not None:
+            for server_id, ports in allocations.items():
+                space = self._space(server_id)
+                for agent_id, port in ports.items():
+                    space.assign(agent_id, port)
         # Load existing allocations if metadata exists
-        if self.metadata_path and self.metadata_path.exists():
+        elif self.metadata_path and self.metadata_path.exists():
             self._load_metadata()
 
     def _load_metadata(self) -> None:
@@ -66,8 +193,12 @@ class PortManager:
                         # Simple agent_id (not composite key), use key as-is
                         agent_id = key
 
-                    self.allocated_ports[agent_id] = agent_data["port"]
-                    logger.info(f"Loaded port allocation: {agent_id} -> {agent_data['port']}")
+                    server_id = agent_data.get("server_id") or self.local_server_id
+                    self._space(server_id).assign(agent_id, agent_data["port"])
+                    logger.info(
+                        f"Loaded port allocation: {agent_id} -> {agent_data['port']} "
+                        f"on {server_id}"
+                    )
         except Exception as e:
             logger.error(f"Failed to load metadata: {e}")
 
@@ -105,12 +236,22 @@ class PortManager:
             # Single part - should not happen but return as-is
             return composite_key
 
-    def allocate_port(self, agent_id: str) -> int:
+    def _space(self, server_id: Optional[str]) -> PortSpace:
+        """Get (creating on first use) the port space for a server."""
+        server_id = server_id or self.local_server_id
+        space = self._spaces.get(server_id)
+        if space is None:
+            space = PortSpace(self.start_port, self.end_port, self.reserved_ports)
+            self._spaces[server_id] = space
+        return space
+
+    def allocate_port(self, agent_id: str, server_id: Optional[str] = None) -> int:
         """
         Allocate a port for an agent.
 
         Args:
             agent_id: Unique agent identifier
+            server_id: Server the agent runs on (defaults to the local server)
 
         Returns:
             Allocated port number
@@ -118,58 +259,69 @@ class PortManager:
         Raises:
             ValueError: If no ports available in range
         """
+        server_id = server_id or self.local_server_id
         with self._lock:
-            # Check if already allocated
-            if agent_id in self.allocated_ports:
-                return self.allocated_ports[agent_id]
-
-            # Find next available port
-            used_ports = set(self.allocated_ports.values()) | self.reserved_ports
+            space = self._space(server_id)
 
-            for port in range(self.start_port, self.end_port + 1):
-                if port not in used_ports:
-                    # Check if port is actually available on the system
-                    if self._is_port_in_use(port):
-                        logger.warning(
-                            f"Port {port} is marked as available but is in use on system, skipping"
-                        )
-                        continue
-
-                    self.allocated_ports[agent_id] = port
-                    logger.info(f"Allocated port {port} to agent {agent_id}")
-                    return port
+            # Check if already allocated
+            if agent_id in space.agent_ports:
+                return space.agent_ports[agent_id]
+
+            # Other processes can only be seen on this host
+            system_ports: Optional[Set[int]] = None
+            if server_id == self.local_server_id:
+                system_ports = listening_ports()
+
+            skip: Set[int] = set()
+            while (port := space.find_free(skip)) is not None:
+                if system_ports is not None:
+                    in_use = port in system_ports
+                else:
+                    # No /proc/net; probe this candidate directly
+                    in_use = server_id == self.local_server_id and self._is_port_in_use(port)
+                if in_use:
+                    logger.warning(
+                        f"Port {port} is marked as available but is in use on system, skipping"
+                    )
+                    skip.add(port)
+                    continue
+
+                space.assign(agent_id, port)
+                logger.info(f"Allocated port {port} to agent {agent_id} on {server_id}")
+                return port
 
-            raise ValueError(f"No available ports in range {self.start_port}-{self.end_port}")
+            raise ValueError(
+                f"No available ports in range {self.start_port}-{self.end_port} on {server_id}"
+            )
 
-    def release_port(self, agent_id: str) -> Optional[int]:
+    def release_port(self, agent_id: str, server_id: Optional[str] = None) -> Optional[int]:
         """
         Release a port allocation.
 
         Args:
             agent_id: Agent identifier
+            server_id: Server the agent runs on (defaults to the local server)
 
         Returns:
             Released port number, or None if not allocated
         """
         with self._lock:
-            if agent_id in self.allocated_ports:
-                port = self.allocated_ports[agent_id]
-                del self.allocated_ports[agent_id]
+            port = self._space(server_id).release(agent_id)
+            if port is not None:
                 logger.info(f"Released port {port} from agent {agent_id}")
-                return port
-            return None
+            return port
 
-    def get_port(self, agent_id: str) -> Optional[int]:
+    def get_port(self, agent_id: str, server_id: Optional[str] = None) -> Optional[int]:
         """Get allocated port for an agent."""
-        return self.allocated_ports.get(agent_id)
+        return self._space(server_id).agent_ports.get(agent_id)
 
-    def is_port_available(self, port: int) -> bool:
+    def get_port_owner(self, port: int, server_id: Optional[str] = None) -> Optional[str]:
+        """Get the agent a port is allocated to."""
+        return self._space(server_id).port_owners.get(port)
+
+    def is_port_available(self, port: int, server_id: Optional[str] = None) -> bool:
         """Check if a port is available for allocation."""
-        if port in self.reserved_ports:
-            return False
-        if port < self.start_port or port > self.end_port:
-            return False
-        return port not in self.allocated_ports.values()
+        return self._space(server_id).is_free(port)
 
     def _is_port_in_use(self, port: int, host: str = "0.0.0.0") -> bool:
         """
@@ -190,11 +342,21 @@ class PortManager:
             except OSError:
                 return True  # Port is in use
 
-    def get_allocated_ports(self) -> Dict[str, int]:
-        """Get all current port allocations."""
-        return self.allocated_ports.copy()
+    def get_allocated_ports(self, server_id: Optional[str] = None) -> Dict[str, int]:
+        """Get all current port allocations for a server."""
+        return self._space(server_id).agent_ports.copy()
+
+    def export_allocations(self) -> Dict[str, Dict[str, int]]:
+        """Port allocations by server and agent, for a startup snapshot."""
+        with self._lock:
+            return {
+                server_id: dict(space.agent_ports) for server_id, space in self._spaces.items()
+            }
 
     def add_reserved_port(self, port: int) -> None:
         """Add a port to the reserved list."""
-        self.reserved_ports.add(port)
+        with self._lock:
+            self.reserved_ports.add(port)
+            for space in self._spaces.values():
+                space.reserve(port)
         logger.info(f"Added port {port} to reserved list")
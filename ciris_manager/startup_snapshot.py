@@ -0,0 +1,254 @@
+"""
+Startup snapshot for fast manager restarts.
+
+A cold start parses metadata.json and the deployment state, scans every
+agent directory, tests every server's Docker connection and regenerates
+nginx config before the API answers, and the first agent listing waits for
+a full discovery. With manager.fast_startup the manager loads this snapshot
+instead, starts serving, and reconciles with disk and Docker in the
+background (see StartupProgress).
+
+The file is a fixed header (magic, format version, marshal and Python
+versions, payload length, SHA-256 of the payload) followed by a
+zlib-compressed marshal payload. Each section records the size and mtime of
+the file it was derived from and is only used while that file is
+unchanged, so a snapshot never brings back state older than disk; any
+mismatch falls back to the cold path for that section.
+"""
+
+import logging
+import marshal
+import os
+import struct
+import sys
+import time
+import zlib
+from datetime import datetime, timezone
+from hashlib import sha256
+from pathlib import Path
+from typing import Any, Callable, Dict, List, Optional
+
+logger = logging.getLogger(__name__)
+
+STARTUP_SNAPSHOT_FILE = ".startup-snapshot"
+
+SNAPSHOT_MAGIC = b"CIRISSNP"
+SNAPSHOT_FORMAT_VERSION = 1
+
+# Cached discovery older than this is not served after a restart
+DISCOVERY_MAX_AGE_SECONDS = 600
+
+# magic, format version, marshal version, Python major*100+minor, payload length, digest
+_HEADER = struct.Struct(">8sHHHQ32s")
+_PYTHON_VERSION = sys.version_info[0] * 100 + sys.version_info[1]
+
+
+def file_fingerprint(path: Path) -> Optional[List[Any]]:
+    """Path, size and mtime of a file, or None if it does not exist."""
+    try:
+        st = path.stat()
+    except FileNotFoundError:
+        return None
+    return [str(path), st.st_size, st.st_mtime_ns]
+
+
+class StartupSnapshot:
+    """Named sections of manager state, each validated against its source file."""
+
+    def __init__(
+        self,
+        sections: Optional[Dict[str, Dict[str, Any]]] = None,
+        created_at: Optional[float] = None,
+    ):
+        """
+        Initialize startup snapshot.
+
+        Args:
+            sections: Section name -> {"source": fingerprint or None, "data": ...}
+            created_at: Epoch time the snapshot was taken (default: now)
+        """
+        self.sections: Dict[str, Dict[str, Any]] = sections or {}
+        self.created_at = time.time() if created_at is None else created_at
+
+    def add(self, name: str, data: Any) -> None:
+        """Add a section that is not derived from a file (valid until it ages out)."""
+        self.sections[name] = {"source": None, "data": data}
+
+    def capture(self, name: str, source: Path, produce: Callable[[], Any]) -> bool:
+        """
+        Add a section derived from a file.
+
+        Args:
+            name: Section name
+            source: File the in-memory state is persisted to
+            produce: Returns the section data (marshal-serializable)
+
+        Returns:
+            False if the file changed while the data was captured (section skipped)
+        """
+        before = file_fingerprint(source)
+        data = produce()
+        if before is None or file_fingerprint(source) != before:
+            logger.debug(f"Startup snapshot section {name} skipped: {source} changed")
+            return False
+        self.sections[name] = {"source": before, "data": data}
+        return True
+
+    def section(
+        self, name: str, source: Optional[Path] = None, max_age: Optional[float] = None
+    ) -> Any:
+        """
+        Get a section's data if it is still valid.
+
+        Args:
+            name: Section name
+            source: File the section must still match
+            max_age: Maximum snapshot age in seconds
+
+        Returns:
+            Section data, or None if missing or stale
+        """
+        item = self.sections.get(name)
+        if item is None:
+            return None
+        if source is not None and item.get("source") != file_fingerprint(source):
+            logger.info(f"Startup snapshot section {name} is stale ({source} changed)")
+            return None
+        if max_age is not None and time.time() - self.created_at > max_age:
+            return None
+        return item["data"]
+
+    def save(self, path: Path) -> None:
+        """
+        Write the snapshot atomically.
+
+        Raises:
+            OSError: If the file cannot be written
+        """
+        body = {"created_at": self.created_at, "sections": self.sections}
+        payload = zlib.compress(marshal.dumps(body), 1)
+        header = _HEADER.pack(
+            SNAPSHOT_MAGIC,
+            SNAPSHOT_FORMAT_VERSION,
+            marshal.version,
+            _PYTHON_VERSION,
+            len(payload),
+            sha256(payload).digest(),
+        )
+        staging = path.with_name(f"{path.name}.tmp")
+        fd = os.open(staging, os.O_WRONLY | os.O_CREAT | os.O_TRUNC, 0o600)
+        with os.fdopen(fd, "wb") as f:
+            f.write(header + payload)
+        os.replace(staging, path)
+
+    @classmethod
+    def load(cls, path: Path) -> Optional["StartupSnapshot"]:
+        """
+        Read and validate a snapshot.
+
+        Args:
+            path: Snapshot file
+
+        Returns:
+            Snapshot, or None if it is missing, corrupt or from another format/Python
+        """
+        try:
+            blob = path.read_bytes()
+        except FileNotFoundError:
+            logger.info(f"No startup snapshot at {path}, starting cold")
+            return None
+        except OSError as e:
+            logger.warning(f"Failed to read startup snapshot {path}: {e}")
+            return None
+
+        if len(blob) < _HEADER.size:
+            logger.warning(f"Startup snapshot {path} is truncated, ignoring it")
+            return None
+        magic, version, marshal_version, python_version, length, digest = _HEADER.unpack_from(
+            blob
+        )
+        payload = blob[_HEADER.size :]
+        if (magic, version, marshal_version, python_version) != (
+            SNAPSHOT_MAGIC,
+            SNAPSHOT_FORMAT_VERSION,
+            marshal.version,
+            _PYTHON_VERSION,
+        ):
+            logger.info(f"Startup snapshot {path} is from another format or Python, ignoring it")
+            return None
+        if len(payload) != length or sha256(payload).digest() != digest:
+            logger.warning(f"Startup snapshot {path} failed its checksum, ignoring it")
+            return None
+        try:
+            body = marshal.loads(zlib.decompress(payload))
+            return cls(sections=dict(body["sections"]), created_at=float(body["created_at"]))
+        except (ValueError, EOFError, TypeError, KeyError, zlib.error) as e:
+            logger.warning(f"Startup snapshot {path} could not be decoded: {e}")
+            return None
+
+
+class StartupProgress:
+    """Progress of startup reconciliation, reported through the status API."""
+
+    def __init__(self, mode: str = "cold", sections: Optional[List[str]] = None):
+        """
+        Initialize startup progress.
+
+        Args:
+            mode: "fast" (reconciliation runs in the background) or "cold"
+            sections: Startup snapshot sections that were used
+        """
+        self.mode = mode
+        self.sections = sections or []
+        self.state = "complete" if mode == "cold" else "pending"
+        self.steps: List[Dict[str, Any]] = []
+        self.started_at: Optional[str] = None
+        self.finished_at: Optional[str] = None
+        self._step_started = 0.0
+
+    def begin(self, steps: List[str]) -> None:
+        """Start reconciliation with the given steps."""
+        self.state = "running"
+        self.started_at = datetime.now(timezone.utc).isoformat()
+        self.steps = [{"name": name, "status": "pending"} for name in steps]
+
+    def start_step(self, name: str) -> None:
+        """Mark a step as running."""
+        self._step(name)["status"] = "running"
+        self._step_started = time.monotonic()
+
+    def finish_step(self, name: str, error: Optional[str] = None) -> None:
+        """Mark a step as done (or failed with an error)."""
+        step = self._step(name)
+        step["status"] = "failed" if error else "done"
+        step["seconds"] = round(time.monotonic() - self._step_started, 3)
+        if error:
+            step["error"] = error
+
+    def finish(self) -> None:
+        """Mark reconciliation as finished."""
+        failed = any(step["status"] == "failed" for step in self.steps)
+        self.state = "failed" if failed else "complete"
+        self.finished_at = datetime.now(timezone.utc).isoformat()
+
+    def to_dict(self) -> Dict[str, Any]:
+        """Progress for the status API."""
+        done = sum(1 for step in self.steps if step["status"] in ("done", "failed"))
+        return {
+            "mode": self.mode,
+            "snapshot_sections": self.sections,
+            "reconciliation": self.state,
+            "steps_done": done,
+            "steps_total": len(self.steps),
+            "steps": [dict(step) for step in self.steps],
+            "started_at": self.started_at,
+            "finished_at": self.finished_at,
+        }
+
+    def _step(self, name: str) -> Dict[str, Any]:
+        for step in self.steps:
+            if step["name"] == name:
+                return step
+        step = {"name": name, "status": "pending"}
+        self.steps.append(step)
+        return step
@@ -5,22 +5,53 @@ Verifies templates against the root-signed manifest to determine
 if they require WA approval for creation.
 """
 
+import asyncio
 import json
 import hashlib
 import logging
+import mmap
+import os
 from pathlib import Path
-from typing import Optional, Dict, Any
+from typing import Optional, Dict, Any, Tuple
 import base64
-import aiofiles  # type: ignore
 from nacl.signing import VerifyKey
 from nacl.exceptions import BadSignatureError
 
 logger = logging.getLogger(__name__)
 
+# Read size for files too small to be worth mapping
+HASH_BLOCK_SIZE = 1024 * 1024
+
+# (st_dev, st_ino, st_size, st_mtime_ns, st_ctime_ns) - changes whenever the file is
+# replaced or edited. The mtime can be set back with touch -d after a same-size edit,
+# but userspace cannot set the ctime, so an edit always produces a new key.
+FileKey = Tuple[int, int, int, int, int]
+
+
+def _file_key(st: os.stat_result) -> FileKey:
+    return (st.st_dev, st.st_ino, st.st_size, st.st_mtime_ns, st.st_ctime_ns)
+
+
+def _sha256_file(path: Path) -> Tuple[FileKey, str]:
+    """Hash a file and return it with the stat key it was hashed under."""
+    sha256_hash = hashlib.sha256()
+    with open(path, "rb") as f:
+        st = os.fstat(f.fileno())
+        if st.st_size >= HASH_BLOCK_SIZE:
+            with mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as mapped:
+                sha256_hash.update(mapped)
+        else:
+            while byte_block := f.read(HASH_BLOCK_SIZE):
+                sha256_hash.update(byte_block)
+    return _file_key(st), sha256_hash.hexdigest()
+
 
 class TemplateVerifier:
     """Verifies templates against pre-approved manifest."""
 
+    # Checksums by resolved path, shared by all verifiers (API routes create their own)
+    _checksum_cache: Dict[str, Tuple[FileKey, str]] = {}
+
     def __init__(self, manifest_path: Path):
         """
         Initialize template verifier.
@@ -100,15 +131,44 @@ class TemplateVerifier:
             return False
 
     async def calculate_template_checksum(self, template_path: Path) -> str:
-        """Calculate SHA-256 checksum of a template file."""
-        sha256_hash = hashlib.sha256()
-        async with aiofiles.open(template_path, "rb") as f:
-            while True:
-                byte_block = await f.read(4096)
-                if not byte_block:
-                    break
-                sha256_hash.update(byte_block)
-        return sha256_hash.hexdigest()
+        """
+        Calculate SHA-256 checksum of a template file.
+
+        Checksums are cached by (dev, inode, size, mtime_ns, ctime_ns), so an
+        unchanged template costs one stat() instead of a full read.
+        """
+        cache_key = str(template_path)
+        cached = self._checksum_cache.get(cache_key)
+        if cached is not None:
+            if cached[0] == _file_key(os.stat(template_path)):
+                return cached[1]
+
+        file_key, checksum = await asyncio.to_thread(_sha256_file, template_path)
+        self._checksum_cache[cache_key] = (file_key, checksum)
+        return checksum
+
+    async def prewarm(self, templates_dir: Path) -> int:
+        """
+        Hash every template in a directory so agent creation hits the cache.
+
+        Args:
+            templates_dir: Directory containing *.yaml templates
+
+        Returns:
+            Number of templates hashed
+        """
+        paths = sorted(templates_dir.glob("*.yaml")) if templates_dir.is_dir() else []
+        results = await asyncio.gather(
+            *(self.calculate_template_checksum(path) for path in paths),
+            return_exceptions=True,
+        )
+        for path, result in zip(paths, results):
+            if isinstance(result, Exception):
+                logger.warning(f"Could not prewarm checksum for {path}: {result}")
+
+        warmed = sum(1 for result in results if not isinstance(result, Exception))
+        logger.info(f"Prewarmed template checksums for {warmed} template(s) in {templates_dir}")
+        return warmed
 
     async def is_pre_approved(self, template_name: str, template_path: Path) -> bool:
         """
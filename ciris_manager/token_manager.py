@@ -13,14 +13,14 @@ import shutil
 from datetime import datetime, timezone
 from enum import Enum
 from pathlib import Path
-from typing import Any, Dict, List, Optional, Tuple
+from typing import Any, Dict, List, NamedTuple, Optional, Tuple
 from dataclasses import dataclass
 
 import httpx
-from httpx import AsyncClient
 
+from ciris_manager.agent_http import get_agent_http_client
 from ciris_manager.agent_registry import AgentRegistry, RegisteredAgent
-from ciris_manager.crypto import TokenEncryption
+from ciris_manager.crypto import get_token_encryption
 from ciris_manager.agent_auth import get_agent_auth
 from ciris_manager.utils.compose_command import compose_cmd
 
@@ -63,9 +63,31 @@ class TokenRotationResult:
     error_message: Optional[str] = None
 
 
+class AgentKey(NamedTuple):
+    """One agent instance; an agent_id can run as several occurrences and servers."""
+
+    agent_id: str
+    occurrence_id: Optional[str]
+    server_id: str
+
+    @classmethod
+    def of(cls, agent: RegisteredAgent) -> "AgentKey":
+        """Key of a registered agent."""
+        return cls(agent.agent_id, agent.occurrence_id, agent.server_id or "main")
+
+
 class TokenManager:
     """Manages service tokens for CIRIS agents."""
 
+    # Concurrent authentication checks during bulk validation
+    VERIFY_CONCURRENCY = 20
+    # Concurrent container restarts per server during fleet-wide rotation
+    ROTATION_CONCURRENCY = 2
+    # Seconds to let a canary wave settle before verifying it
+    WAVE_SETTLE_SECONDS = 30
+    # Checkpoints older than this are from an abandoned rotation and are not resumed
+    CHECKPOINT_MAX_AGE_SECONDS = 6 * 3600
+
     def __init__(
         self,
         registry: AgentRegistry,
@@ -81,7 +103,7 @@ class TokenManager:
             docker_client_manager: Optional multi-server Docker client manager
         """
         self.registry = registry
-        self.encryption = TokenEncryption()
+        self.encryption = get_token_encryption()
         self.agents_dir = agents_dir or Path("/opt/ciris/agents")
         self.backup_dir = self.agents_dir / "token_backups"
         self.backup_dir.mkdir(exist_ok=True)
@@ -95,16 +117,18 @@ class TokenManager:
             List of TokenHealth objects for all agents
         """
         agents = self.registry.list_agents()
-        token_health = []
-
-        for agent in agents:
-            health = await self._check_token_health(agent)
-            token_health.append(health)
-
-        return token_health
+        return await self._check_token_health_bulk(agents)
 
     async def _check_token_health(self, agent: RegisteredAgent) -> TokenHealth:
         """Check health of a single agent's token."""
+        return self._token_health(agent)
+
+    async def _check_token_health_bulk(self, agents: List[RegisteredAgent]) -> List[TokenHealth]:
+        """Check token health for many agents in one worker-thread pass, off the event loop."""
+        return await asyncio.to_thread(lambda: [self._token_health(agent) for agent in agents])
+
+    def _token_health(self, agent: RegisteredAgent) -> TokenHealth:
+        """Check health of a single agent's token (blocking, decrypts)."""
         health = TokenHealth(agent_id=agent.agent_id, status=TokenStatus.MISSING)
 
         # Check if token exists
@@ -134,23 +158,29 @@ class TokenManager:
 
         return health
 
-    async def verify_token(self, agent_id: str) -> Tuple[bool, str]:
+    async def verify_token(
+        self, agent_id: str, server_id: Optional[str] = None, occurrence_id: Optional[str] = None
+    ) -> Tuple[bool, str]:
         """
         Verify that an agent's token is working.
 
         Args:
             agent_id: ID of the agent to verify
+            server_id: Server the agent runs on (optional, for agents on several servers)
+            occurrence_id: Occurrence ID (optional, for multi-instance agents)
 
         Returns:
             Tuple of (success, message)
         """
-        agent = self.registry.get_agent(agent_id)
+        agent = self.registry.get_agent(agent_id, occurrence_id=occurrence_id, server_id=server_id)
         if not agent:
             return False, f"Agent {agent_id} not found"
 
         # Get auth headers using the token
         auth = get_agent_auth()
-        headers = auth.get_auth_headers(agent_id)
+        headers = auth.get_auth_headers(
+            agent_id, occurrence_id=agent.occurrence_id, server_id=agent.server_id
+        )
 
         if not headers:
             return False, "Failed to get authentication headers"
@@ -171,15 +201,14 @@ class TokenManager:
             else:
                 url = f"http://localhost:{agent.port}/v1/system/health"
 
-            async with AsyncClient(timeout=10.0) as client:
-                response = await client.get(url, headers=headers)
+            response = await get_agent_http_client().get(url, headers=headers, timeout=10.0)
 
-                if response.status_code == 200:
-                    return True, "Token authentication successful"
-                elif response.status_code == 401:
-                    return False, "Token authentication failed (401 Unauthorized)"
-                else:
-                    return False, f"Unexpected response: {response.status_code}"
+            if response.status_code == 200:
+                return True, "Token authentication successful"
+            elif response.status_code == 401:
+                return False, "Token authentication failed (401 Unauthorized)"
+            else:
+                return False, f"Unexpected response: {response.status_code}"
 
         except httpx.ConnectError:
             return False, f"Failed to connect to agent on port {agent.port}"
@@ -187,7 +216,11 @@ class TokenManager:
             return False, f"Error testing token: {str(e)}"
 
     async def regenerate_token(
-        self, agent_id: str, restart_container: bool = True
+        self,
+        agent_id: str,
+        restart_container: bool = True,
+        server_id: Optional[str] = None,
+        occurrence_id: Optional[str] = None,
     ) -> TokenRotationResult:
         """
         Regenerate token for a specific agent.
@@ -195,6 +228,8 @@ class TokenManager:
         Args:
             agent_id: ID of the agent
             restart_container: Whether to restart the container with new token
+            server_id: Server the agent runs on (optional, for agents on several servers)
+            occurrence_id: Occurrence ID (optional, for multi-instance agents)
 
         Returns:
             TokenRotationResult with operation details
@@ -209,10 +244,12 @@ class TokenManager:
         )
 
         # Get agent info
-        agent = self.registry.get_agent(agent_id)
+        agent = self.registry.get_agent(agent_id, occurrence_id=occurrence_id, server_id=server_id)
         if not agent:
             result.error_message = f"Agent {agent_id} not found"
             return result
+        server_id = agent.server_id
+        occurrence_id = agent.occurrence_id
 
         # Backup existing token
         if agent.service_token:
@@ -241,12 +278,16 @@ class TokenManager:
         result.new_token_generated = True
 
         # Update registry
-        self.registry.update_agent_token(agent_id, encrypted_token)
+        self.registry.update_agent_token(
+            agent_id, encrypted_token, agent.occurrence_id, server_id
+        )
         logger.info(f"Generated new token for {agent_id}")
 
         # Restart container if requested
         if restart_container:
-            success = await self._restart_agent_with_token(agent_id, new_token)
+            success = await self._restart_agent_with_token(
+                agent_id, new_token, server_id, occurrence_id
+            )
             result.container_restarted = success
 
             if success:
@@ -254,7 +295,7 @@ class TokenManager:
                 await asyncio.sleep(5)
 
                 # Verify new token works
-                verified, message = await self.verify_token(agent_id)
+                verified, message = await self.verify_token(agent_id, server_id, occurrence_id)
                 result.auth_verified = verified
                 if not verified:
                     result.error_message = f"Token verification failed: {message}"
@@ -266,10 +307,28 @@ class TokenManager:
         )
         return result
 
-    async def _restart_agent_with_token(self, agent_id: str, token: str) -> bool:
-        """Restart an agent container with a new token."""
-        agent = self.registry.get_agent(agent_id)
-        if not agent or not agent.compose_file:
+    async def _restart_agent_with_token(
+        self,
+        agent_id: str,
+        token: str,
+        server_id: Optional[str] = None,
+        occurrence_id: Optional[str] = None,
+    ) -> bool:
+        """Restart an agent container with a new token on the server it runs on."""
+        agent = self.registry.get_agent(agent_id, occurrence_id=occurrence_id, server_id=server_id)
+        if not agent:
+            return False
+
+        if self.docker_client_manager and agent.server_id:
+            try:
+                server_config = self.docker_client_manager.get_server_config(agent.server_id)
+            except Exception as e:
+                logger.error(f"Unknown server {agent.server_id} for agent {agent_id}: {e}")
+                return False
+            if not server_config.is_local:
+                return await self._recreate_remote_with_token(agent, token)
+
+        if not agent.compose_file:
             return False
 
         compose_path = Path(agent.compose_file)
@@ -315,6 +374,52 @@ class TokenManager:
             logger.error(f"Error restarting agent {agent_id}: {e}")
             return False
 
+    async def _recreate_remote_with_token(self, agent: RegisteredAgent, token: str) -> bool:
+        """Recreate a remote agent's container through its server's Docker API with a new token."""
+        from ciris_manager.deployment.orchestrator import DeploymentOrchestrator
+
+        wanted = {f"CIRIS_AGENT_ID={agent.agent_id}"}
+        if agent.occurrence_id:
+            wanted.add(f"AGENT_OCCURRENCE_ID={agent.occurrence_id}")
+
+        def recreate() -> None:
+            client = self.docker_client_manager.get_client(agent.server_id)
+            # Multi-occurrence containers have suffixed names, so match on environment
+            old = next(
+                (
+                    c
+                    for c in client.containers.list(all=True)
+                    if wanted <= set(c.attrs.get("Config", {}).get("Env") or [])
+                ),
+                None,
+            ) or client.containers.get(f"ciris-{agent.agent_id}")
+            # Same capture and create as deployments, so the command, healthcheck,
+            # resource limits and every network survive the recreate
+            config = DeploymentOrchestrator._capture_container_config(old)
+            environment = [
+                entry
+                for entry in config["environment"] or []
+                if not entry.startswith("CIRIS_SERVICE_TOKEN=")
+            ]
+            environment.append(f"CIRIS_SERVICE_TOKEN={token}")
+            image = old.attrs.get("Config", {}).get("Image") or config["image"]
+            name = old.name
+
+            old.stop(timeout=10)
+            old.remove()
+            DeploymentOrchestrator._create_container_from_config(
+                client, config, name, image, environment
+            ).start()
+
+        try:
+            await asyncio.to_thread(recreate)
+        except Exception as e:
+            logger.error(f"Error restarting agent {agent.agent_id} on {agent.server_id}: {e}")
+            return False
+
+        logger.info(f"Successfully restarted {agent.agent_id} on {agent.server_id} with new token")
+        return True
+
     async def recover_tokens_from_containers(self) -> Dict[str, bool]:
         """
         Recover tokens from running containers and update metadata.
@@ -322,55 +427,57 @@ class TokenManager:
         Returns:
             Dictionary mapping agent_id to recovery success
         """
-        results = {}
         agents = self.registry.list_agents()
+        semaphore = asyncio.Semaphore(self.VERIFY_CONCURRENCY)
 
-        for agent in agents:
-            agent_id = agent.agent_id
-            container_name = f"ciris-{agent_id}"
+        async def recover(agent: RegisteredAgent) -> bool:
+            async with semaphore:
+                return await self._recover_token_from_container(agent.agent_id)
 
-            try:
-                # Get token from container environment
-                proc = await asyncio.create_subprocess_exec(
-                    "docker",
-                    "exec",
-                    container_name,
-                    "printenv",
-                    "CIRIS_SERVICE_TOKEN",
-                    stdout=asyncio.subprocess.PIPE,
-                    stderr=asyncio.subprocess.PIPE,
-                )
+        recovered = await asyncio.gather(*(recover(agent) for agent in agents))
+        return {agent.agent_id: ok for agent, ok in zip(agents, recovered)}
 
-                try:
-                    stdout, stderr = await asyncio.wait_for(proc.communicate(), timeout=5)
-                except asyncio.TimeoutError:
-                    proc.kill()
-                    await proc.wait()
-                    raise
-
-                if proc.returncode == 0:
-                    token = stdout.decode().strip()
-                    if token:
-                        # Encrypt and update
-                        encrypted = self.encryption.encrypt_token(token)
-                        self.registry.update_agent_token(agent_id, encrypted)
-                        results[agent_id] = True
-                        logger.info(f"Recovered token for {agent_id}")
-                    else:
-                        results[agent_id] = False
-                        logger.warning(f"Empty token for {agent_id}")
-                else:
-                    results[agent_id] = False
-                    logger.warning(f"Could not get token from {container_name}")
+    async def _recover_token_from_container(self, agent_id: str) -> bool:
+        """Read one agent's token from its container environment and store it encrypted."""
+        container_name = f"ciris-{agent_id}"
 
+        try:
+            # Get token from container environment
+            proc = await asyncio.create_subprocess_exec(
+                "docker",
+                "exec",
+                container_name,
+                "printenv",
+                "CIRIS_SERVICE_TOKEN",
+                stdout=asyncio.subprocess.PIPE,
+                stderr=asyncio.subprocess.PIPE,
+            )
+
+            try:
+                stdout, stderr = await asyncio.wait_for(proc.communicate(), timeout=5)
             except asyncio.TimeoutError:
-                results[agent_id] = False
-                logger.error(f"Timeout getting token from {container_name}")
-            except Exception as e:
-                results[agent_id] = False
-                logger.error(f"Error recovering token for {agent_id}: {e}")
+                proc.kill()
+                await proc.wait()
+                raise
+
+            if proc.returncode == 0:
+                token = stdout.decode().strip()
+                if token:
+                    # Encrypt and update
+                    encrypted = self.encryption.encrypt_token(token)
+                    self.registry.update_agent_token(agent_id, encrypted)
+                    logger.info(f"Recovered token for {agent_id}")
+                    return True
+                logger.warning(f"Empty token for {agent_id}")
+            else:
+                logger.warning(f"Could not get token from {container_name}")
 
-        return results
+        except asyncio.TimeoutError:
+            logger.error(f"Timeout getting token from {container_name}")
+        except Exception as e:
+            logger.error(f"Error recovering token for {agent_id}: {e}")
+
+        return False
 
     async def validate_all_tokens(self) -> Dict[str, TokenHealth]:
         """
@@ -380,84 +487,201 @@ class TokenManager:
             Dictionary mapping agent_id to TokenHealth
         """
         agents = self.registry.list_agents()
-        results = {}
-
-        for agent in agents:
-            health = await self._check_token_health(agent)
-
-            # Also test authentication if token seems valid
-            if health.status == TokenStatus.VALID:
-                verified, message = await self.verify_token(agent.agent_id)
-                health.auth_tested = True
-                health.auth_successful = verified
-                if not verified:
-                    health.error_message = message
-
-            results[agent.agent_id] = health
+        healths = await self._check_token_health_bulk(agents)
+        semaphore = asyncio.Semaphore(self.VERIFY_CONCURRENCY)
+
+        async def test_auth(health: TokenHealth) -> None:
+            async with semaphore:
+                verified, message = await self.verify_token(health.agent_id)
+            health.auth_tested = True
+            health.auth_successful = verified
+            if not verified:
+                health.error_message = message
+
+        # Also test authentication for tokens that seem valid
+        await asyncio.gather(
+            *(test_auth(health) for health in healths if health.status == TokenStatus.VALID)
+        )
 
-        return results
+        return {health.agent_id: health for health in healths}
 
     async def rotate_all_tokens(
-        self, strategy: str = "immediate", canary_percentage: int = 10
+        self,
+        strategy: str = "immediate",
+        canary_percentage: int = 10,
+        per_server_concurrency: Optional[int] = None,
+        resume: bool = False,
     ) -> Dict[str, TokenRotationResult]:
         """
         Rotate tokens for all agents.
 
+        Agents are rotated in waves. With the canary strategy the waves follow the
+        deployment canary groups (explorer, early_adopter, then everyone else), or
+        the first canary_percentage of agents when no groups are assigned; each
+        wave must rotate and re-authenticate cleanly before the next one starts.
+        Within a wave, up to per_server_concurrency agents restart at once on
+        each server.
+
+        Successful rotations are checkpointed. Re-running with resume=True after an
+        interruption or failed wave skips agents that were already rotated, as long
+        as the checkpoint was written by the same strategy within
+        CHECKPOINT_MAX_AGE_SECONDS; anything else starts a full rotation.
+
         Args:
             strategy: Rotation strategy ('immediate', 'canary')
             canary_percentage: Percentage of agents for canary deployment
+            per_server_concurrency: Concurrent restarts per server (default ROTATION_CONCURRENCY)
+            resume: Skip agents recorded in a recent checkpoint of the same strategy
 
         Returns:
-            Dictionary mapping agent_id to rotation results
+            Dictionary mapping each agent instance (AgentKey) to its rotation result
         """
         agents = self.registry.list_agents()
-        results = {}
+        results: Dict[AgentKey, TokenRotationResult] = {}
+
+        checkpoint = self._load_rotation_checkpoint(strategy) if resume else None
+        completed: List[AgentKey] = (
+            [
+                AgentKey(*entry)
+                for entry in checkpoint["completed"]
+                if isinstance(entry, list) and len(entry) == 3
+            ]
+            if checkpoint
+            else []
+        )
+        if completed:
+            logger.info(f"Resuming token rotation, skipping {len(completed)} rotated agents")
+        pending = [agent for agent in agents if AgentKey.of(agent) not in completed]
 
         if strategy == "canary":
-            # Start with a subset of agents
-            canary_count = max(1, len(agents) * canary_percentage // 100)
-            canary_agents = agents[:canary_count]
-
-            logger.info(f"Starting canary token rotation for {len(canary_agents)} agents")
-
-            # Rotate canary agents
-            for agent in canary_agents:
-                result = await self.regenerate_token(agent.agent_id)
-                results[agent.agent_id] = result
+            waves = self._canary_waves(pending, canary_percentage)
+        else:
+            waves = [pending] if pending else []
+
+        concurrency = per_server_concurrency or self.ROTATION_CONCURRENCY
+        semaphores: Dict[str, asyncio.Semaphore] = {}
+        checkpoint_lock = asyncio.Lock()
+
+        async def rotate(agent: RegisteredAgent) -> None:
+            key = AgentKey.of(agent)
+            semaphore = semaphores.setdefault(key.server_id, asyncio.Semaphore(concurrency))
+            async with semaphore:
+                result = await self.regenerate_token(
+                    agent.agent_id, server_id=agent.server_id, occurrence_id=agent.occurrence_id
+                )
+            results[key] = result
+            if result.success:
+                async with checkpoint_lock:
+                    completed.append(key)
+                    self._save_rotation_checkpoint(strategy, completed)
+
+        for index, wave in enumerate(waves):
+            is_last_wave = index == len(waves) - 1
+            logger.info(f"Rotating tokens for wave {index + 1}/{len(waves)} ({len(wave)} agents)")
+            await asyncio.gather(*(rotate(agent) for agent in wave))
+
+            failed = [a.agent_id for a in wave if not results[AgentKey.of(a)].success]
+            if failed:
+                logger.error(f"Token rotation failed for {failed}, stopping after this wave")
+                return results
 
-                if not result.success:
-                    logger.error(f"Canary rotation failed for {agent.agent_id}, aborting")
+            if strategy == "canary" and not is_last_wave:
+                if not await self._wave_healthy(wave):
+                    logger.error("Canary wave failed verification, aborting full rotation")
                     return results
+                logger.info("Canary wave healthy, proceeding with next wave")
 
-            # Wait and verify canary agents
-            logger.info("Waiting 30 seconds to verify canary agents...")
-            await asyncio.sleep(30)
-
-            canary_healthy = True
-            for agent in canary_agents:
-                verified, _ = await self.verify_token(agent.agent_id)
-                if not verified:
-                    canary_healthy = False
-                    logger.error(f"Canary agent {agent.agent_id} failed verification")
-                    break
-
-            if not canary_healthy:
-                logger.error("Canary deployment failed, aborting full rotation")
-                return results
+        self._clear_rotation_checkpoint()
+        return results
 
-            logger.info("Canary successful, proceeding with remaining agents")
-            remaining_agents = agents[canary_count:]
+    def _canary_waves(
+        self, agents: List[RegisteredAgent], canary_percentage: int
+    ) -> List[List[RegisteredAgent]]:
+        """Split agents into rotation waves using the deployment canary groups."""
+        groups: Dict[str, List[RegisteredAgent]] = {"explorer": [], "early_adopter": []}
+        general: List[RegisteredAgent] = []
+        for agent in agents:
+            group = (agent.metadata or {}).get("canary_group")
+            if group in groups:
+                groups[group].append(agent)
+            else:
+                general.append(agent)
 
+        if groups["explorer"] or groups["early_adopter"]:
+            waves = [groups["explorer"], groups["early_adopter"], general]
         else:
-            remaining_agents = agents
-
-        # Rotate remaining agents
-        for agent in remaining_agents:
-            if agent.agent_id not in results:
-                result = await self.regenerate_token(agent.agent_id)
-                results[agent.agent_id] = result
+            # No groups assigned - fall back to a percentage-based canary
+            canary_count = max(1, len(agents) * canary_percentage // 100)
+            waves = [agents[:canary_count], agents[canary_count:]]
+        return [wave for wave in waves if wave]
+
+    async def _wave_healthy(self, wave: List[RegisteredAgent]) -> bool:
+        """Wait for a rotated wave to settle, then confirm every agent authenticates."""
+        logger.info(f"Waiting {self.WAVE_SETTLE_SECONDS} seconds to verify canary agents...")
+        await asyncio.sleep(self.WAVE_SETTLE_SECONDS)
+
+        verifications = await asyncio.gather(
+            *(
+                self.verify_token(agent.agent_id, agent.server_id, agent.occurrence_id)
+                for agent in wave
+            )
+        )
+        healthy = True
+        for agent, (verified, _) in zip(wave, verifications):
+            if not verified:
+                healthy = False
+                logger.error(f"Canary agent {agent.agent_id} failed verification")
+        return healthy
+
+    @property
+    def rotation_checkpoint_path(self) -> Path:
+        """File recording agents rotated by an unfinished rotation."""
+        return self.backup_dir / "rotation_checkpoint.json"
+
+    def _load_rotation_checkpoint(self, strategy: str) -> Optional[Dict[str, Any]]:
+        """Load the checkpoint of a recent interrupted rotation with the same strategy."""
+        try:
+            with open(self.rotation_checkpoint_path) as f:
+                data: Dict[str, Any] = json.load(f)
+            updated_at = datetime.fromisoformat(data["updated_at"])
+        except FileNotFoundError:
+            return None
+        except Exception as e:
+            logger.warning(f"Ignoring unreadable rotation checkpoint: {e}")
+            return None
+
+        age = (datetime.now(timezone.utc) - updated_at).total_seconds()
+        if data.get("strategy") != strategy:
+            logger.warning(
+                f"Ignoring rotation checkpoint from {data.get('strategy')} strategy, "
+                f"rotating all agents with {strategy}"
+            )
+            return None
+        if age > self.CHECKPOINT_MAX_AGE_SECONDS:
+            logger.warning(
+                f"Ignoring rotation checkpoint from {int(age // 60)} minutes ago, "
+                "rotating all agents"
+            )
+            return None
+        return data
+
+    def _save_rotation_checkpoint(self, strategy: str, completed: List[AgentKey]) -> None:
+        """Atomically record the agents rotated so far."""
+        tmp_path = self.rotation_checkpoint_path.with_suffix(".tmp")
+        with open(tmp_path, "w") as f:
+            json.dump(
+                {
+                    "strategy": strategy,
+                    "completed": completed,
+                    "updated_at": datetime.now(timezone.utc).isoformat(),
+                },
+                f,
+            )
+        tmp_path.replace(self.rotation_checkpoint_path)
 
-        return results
+    def _clear_rotation_checkpoint(self) -> None:
+        """Remove the checkpoint once a rotation has finished."""
+        self.rotation_checkpoint_path.unlink(missing_ok=True)
 
     def backup_metadata(self) -> Path:
         """
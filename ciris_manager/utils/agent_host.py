@@ -0,0 +1,345 @@
+"""
+Client for the agent-host sidecar on remote servers.
+
+The sidecar is ciris-fix-permissions built with -DCIRIS_AGENT_HOST into a
+separate, non-setuid ciris-agent-host binary and run with --serve-remote
+(deployment/ciris-agent-host.service). It writes files,
+provisions agent directories, fixes permissions and tails logs on the remote
+host, so these operations no longer start a container or exec session
+through the Docker API. Connections use mutual TLS with the same CA and
+client certificate as the server's Docker API.
+
+Each request is a frame "<id> <op> <path> <arg|-> <length>\\n" followed by
+<length> body bytes, answered with "<id> OK|ERR <length>\\n" plus payload.
+The sidecar runs requests concurrently, so one connection carries many
+in-flight requests and responses arrive in completion order.
+"""
+
+import asyncio
+import itertools
+import logging
+import socket
+import ssl
+from pathlib import Path
+from typing import Any, Dict, Iterable, Optional, Tuple
+from urllib.parse import urlparse
+
+logger = logging.getLogger(__name__)
+
+# Operations understood by the sidecar
+OPERATIONS = {
+    "ping",
+    "write-file",
+    "read-file",
+    "provision-agent",
+    "fix-perms",
+    "tail-log",
+}
+
+# Largest request or response body the sidecar accepts
+MAX_BODY = 8 * 1024 * 1024
+
+# Most lines tail-log returns
+MAX_TAIL_LINES = 10000
+
+# Requests the sidecar runs at once per connection (it answers "busy" beyond this)
+MAX_IN_FLIGHT = 16
+
+
+class AgentHostError(RuntimeError):
+    """Raised when the sidecar rejects or fails a request."""
+
+
+class AgentHostUnavailableError(AgentHostError):
+    """Raised when the sidecar cannot be reached."""
+
+
+class AgentHostClient:
+    """Persistent, multiplexed connection to one server's agent-host sidecar."""
+
+    def __init__(
+        self,
+        host: str,
+        port: int,
+        ssl_context: Optional[ssl.SSLContext],
+        server_id: str = "",
+        timeout: float = 30.0,
+    ):
+        """
+        Initialize agent-host client.
+
+        Args:
+            host: Sidecar address (the server's VPC IP)
+            port: Sidecar port
+            ssl_context: Client TLS context (None only in tests)
+            server_id: Server ID, for log messages
+            timeout: Seconds to wait for a response
+        """
+        self.host = host
+        self.port = port
+        self.ssl_context = ssl_context
+        self.server_id = server_id or host
+        self.timeout = timeout
+        self._reader: Optional[asyncio.StreamReader] = None
+        self._writer: Optional[asyncio.StreamWriter] = None
+        self._reader_task: Optional[asyncio.Task] = None
+        self._pending: Dict[int, asyncio.Future] = {}
+        self._ids = itertools.count(1)
+        self._connect_lock = asyncio.Lock()
+        self._write_lock = asyncio.Lock()
+        self._slots = asyncio.Semaphore(MAX_IN_FLIGHT)
+
+    @classmethod
+    def from_server_config(cls, server: Any) -> Optional["AgentHostClient"]:
+        """
+        Build a client for a server, or None if it has no sidecar configured.
+
+        Args:
+            server: ServerConfig of a remote server
+        """
+        port = getattr(server, "agent_host_port", None)
+        if server.is_local or not port:
+            return None
+        if not all([server.tls_ca, server.tls_cert, server.tls_key]):
+            logger.warning(
+                f"Agent host on {server.server_id} needs tls_ca, tls_cert and tls_key, "
+                "using the Docker API instead"
+            )
+            return None
+
+        host = server.vpc_ip or urlparse(server.docker_host or "").hostname or server.hostname
+        context = ssl.create_default_context(cafile=server.tls_ca)
+        context.load_cert_chain(server.tls_cert, server.tls_key)
+        return cls(host, port, context, server_id=server.server_id)
+
+    @staticmethod
+    def _build_request(
+        request_id: int, op: str, path: Path, arg: Optional[str], body: bytes
+    ) -> bytes:
+        if op not in OPERATIONS:
+            raise ValueError(f"Unknown agent host operation: {op}")
+        parts = [str(path), arg or "-"]
+        if any(not p or any(c.isspace() for c in p) for p in parts):
+            raise ValueError(f"Invalid agent host request arguments: {parts}")
+        if len(body) > MAX_BODY:
+            raise ValueError(f"Agent host request body too large: {len(body)} bytes")
+        return f"{request_id} {op} {parts[0]} {parts[1]} {len(body)}\n".encode() + body
+
+    @staticmethod
+    def _parse_header(line: bytes) -> Tuple[int, bool, int]:
+        request_id, status, length = line.decode().split()
+        if status not in ("OK", "ERR"):
+            raise ValueError(f"Bad response status {status}")
+        return int(request_id), status == "OK", int(length)
+
+    @property
+    def connected(self) -> bool:
+        """Whether the connection is open."""
+        return self._writer is not None and not self._writer.is_closing()
+
+    async def _connect(self) -> None:
+        async with self._connect_lock:
+            if self.connected:
+                return
+            try:
+                self._reader, self._writer = await asyncio.wait_for(
+                    asyncio.open_connection(self.host, self.port, ssl=self.ssl_context),
+                    self.timeout,
+                )
+            except (OSError, asyncio.TimeoutError) as e:
+                raise AgentHostUnavailableError(
+                    f"Agent host on {self.server_id} unavailable: {e}"
+                )
+            self._reader_task = asyncio.create_task(self._read_responses(self._reader))
+            logger.debug(f"Connected to agent host on {self.server_id}")
+
+    async def _read_responses(self, reader: asyncio.StreamReader) -> None:
+        """Route responses to their requests until the connection closes."""
+        error = "connection closed"
+        try:
+            while True:
+                line = await reader.readline()
+                if not line:
+                    break
+                request_id, ok, length = self._parse_header(line)
+                payload = await reader.readexactly(length)
+                future = self._pending.pop(request_id, None)
+                if future is None or future.done():
+                    continue
+                if ok:
+                    future.set_result(payload)
+                else:
+                    future.set_exception(AgentHostError(payload.decode(errors="replace")))
+        except (OSError, ValueError, asyncio.IncompleteReadError) as e:
+            error = str(e) or type(e).__name__
+        finally:
+            # A replaced connection must not tear down its successor
+            if self._reader is reader:
+                await self._drop_connection(
+                    AgentHostUnavailableError(f"Agent host on {self.server_id} lost: {error}")
+                )
+
+    async def _drop_connection(self, error: Exception) -> None:
+        pending, self._pending = self._pending, {}
+        for future in pending.values():
+            if not future.done():
+                future.set_exception(error)
+        writer, self._writer, self._reader = self._writer, None, None
+        if writer:
+            writer.close()
+            try:
+                await writer.wait_closed()
+            except Exception:
+                pass
+
+    async def close(self) -> None:
+        """Close the connection and fail any in-flight requests."""
+        task, self._reader_task = self._reader_task, None
+        if task and task is not asyncio.current_task():
+            task.cancel()
+        await self._drop_connection(
+            AgentHostUnavailableError(f"Agent host connection to {self.server_id} closed")
+        )
+
+    async def request(
+        self, op: str, path: Path, arg: Optional[str] = None, body: bytes = b""
+    ) -> bytes:
+        """
+        Send one request and wait for its response.
+
+        Other requests may be in flight on the same connection concurrently.
+
+        Args:
+            op: Operation name (see OPERATIONS)
+            path: Target path on the remote server
+            arg: Optional extra argument (file mode, line count)
+            body: Request body (file contents for write-file)
+
+        Returns:
+            Response payload
+
+        Raises:
+            AgentHostUnavailableError: If the sidecar cannot be reached
+            AgentHostError: If the operation failed
+        """
+        request_id = next(self._ids)
+        frame = self._build_request(request_id, op, path, arg, body)
+        async with self._slots:
+            return await self._send(request_id, op, path, frame)
+
+    async def _send(self, request_id: int, op: str, path: Path, frame: bytes) -> bytes:
+        # Retry once on a fresh connection in case the sidecar restarted
+        for attempt in range(2):
+            if not self.connected:
+                await self._connect()
+            future: asyncio.Future = asyncio.get_running_loop().create_future()
+            self._pending[request_id] = future
+            try:
+                async with self._write_lock:
+                    assert self._writer is not None
+                    self._writer.write(frame)
+                    await self._writer.drain()
+            except (OSError, AssertionError) as e:
+                self._pending.pop(request_id, None)
+                await self.close()
+                if attempt == 1:
+                    raise AgentHostUnavailableError(
+                        f"Agent host on {self.server_id} unavailable: {e}"
+                    )
+                continue
+
+            try:
+                return await asyncio.wait_for(future, self.timeout)
+            except asyncio.TimeoutError:
+                self._pending.pop(request_id, None)
+                raise AgentHostUnavailableError(
+                    f"Agent host on {self.server_id} did not answer {op} {path}"
+                )
+        raise AgentHostUnavailableError(f"Agent host on {self.server_id} unavailable")
+
+    def request_sync(
+        self, op: str, path: Path, arg: Optional[str] = None, body: bytes = b""
+    ) -> bytes:
+        """
+        Blocking variant of request for synchronous call sites.
+
+        Uses a short-lived connection rather than the shared async one.
+        """
+        frame = self._build_request(0, op, path, arg, body)
+        try:
+            with socket.create_connection((self.host, self.port), self.timeout) as raw:
+                sock = (
+                    self.ssl_context.wrap_socket(raw, server_hostname=self.host)
+                    if self.ssl_context
+                    else raw
+                )
+                with sock:
+                    sock.sendall(frame)
+                    with sock.makefile("rb") as stream:
+                        _, ok, length = self._parse_header(stream.readline())
+                        payload = stream.read(length)
+        except (OSError, ValueError) as e:
+            raise AgentHostUnavailableError(f"Agent host on {self.server_id} unavailable: {e}")
+        if not ok:
+            raise AgentHostError(payload.decode(errors="replace"))
+        return payload
+
+    async def ping(self) -> str:
+        """Return the sidecar's protocol version."""
+        return (await self.request("ping", Path("-"))).decode()
+
+    async def write_file(self, path: Path, content: bytes, mode: int = 0o644) -> None:
+        """Atomically replace a file (owned by the container user), creating parents."""
+        await self.request("write-file", path, format(mode, "o"), content)
+
+    async def read_file(self, path: Path) -> bytes:
+        """Read a file under the agents or shared directory."""
+        return await self.request("read-file", path)
+
+    async def provision_agent(self, agent_dir: Path) -> None:
+        """Create an agent directory and its standard subdirectories."""
+        await self.request("provision-agent", agent_dir)
+
+    async def fix_permissions(self, agent_dir: Path) -> None:
+        """Fix ownership and permissions of an agent's standard directories."""
+        await self.request("fix-perms", agent_dir)
+
+    async def tail_log(self, path: Path, lines: int = 100) -> str:
+        """Return the last lines of a file in an agent's logs directory."""
+        lines = max(1, min(lines, MAX_TAIL_LINES))
+        return (await self.request("tail-log", path, str(lines))).decode(errors="replace")
+
+
+_hosts: Dict[str, AgentHostClient] = {}
+
+
+def configure_agent_hosts(servers: Iterable[Any]) -> None:
+    """
+    Create sidecar clients for every remote server that has one configured.
+
+    Args:
+        servers: ServerConfig entries from the manager configuration
+    """
+    _hosts.clear()
+    for server in servers:
+        try:
+            client = AgentHostClient.from_server_config(server)
+        except (OSError, ssl.SSLError) as e:
+            logger.warning(f"Cannot set up agent host client for {server.server_id}: {e}")
+            continue
+        if client:
+            _hosts[server.server_id] = client
+            logger.info(f"Using agent host sidecar on {server.server_id} ({client.host})")
+
+
+def get_agent_host(server_id: str) -> Optional[AgentHostClient]:
+    """
+    Get the sidecar client for a server, or None if it has none.
+    """
+    return _hosts.get(server_id)
+
+
+async def close_agent_hosts() -> None:
+    """Close all sidecar connections."""
+    for client in _hosts.values():
+        await client.close()
@@ -0,0 +1,134 @@
+"""
+Request coalescing and short-lived result caching.
+
+Shared by the agent HTTP client, the adapter manifest cache and the LLM
+validator: identical concurrent lookups run once (the first caller fetches,
+the rest wait for its result), and results may be kept for a bounded time
+in a cache that cannot grow without limit.
+"""
+
+import asyncio
+import time
+from collections import OrderedDict
+from typing import Awaitable, Callable, Dict, Generic, Hashable, Optional, Tuple, TypeVar
+
+K = TypeVar("K", bound=Hashable)
+V = TypeVar("V")
+
+
+class _LeaderCancelled(Exception):
+    """Set on a shared fetch whose caller was cancelled, so waiters fetch again."""
+
+
+class Coalescer(Generic[K, V]):
+    """Runs at most one fetch per key at a time and shares its outcome."""
+
+    def __init__(self) -> None:
+        self._inflight: Dict[K, "asyncio.Future[V]"] = {}
+
+    def __len__(self) -> int:
+        return len(self._inflight)
+
+    def __contains__(self, key: object) -> bool:
+        return key in self._inflight
+
+    async def run(
+        self,
+        key: K,
+        fetch: Callable[[], Awaitable[V]],
+        on_result: Optional[Callable[[V], None]] = None,
+    ) -> V:
+        """
+        Fetch a value, or wait for an identical fetch that is already running.
+
+        Errors from the fetch are raised in every caller. If the caller doing the
+        fetch is cancelled, its waiters are not: one of them fetches again.
+
+        Args:
+            key: Identity of the fetch
+            fetch: Coroutine factory producing the value
+            on_result: Called with the value before waiters are woken (e.g. to cache it)
+
+        Returns:
+            The fetched value
+        """
+        while True:
+            inflight = self._inflight.get(key)
+            if inflight is None:
+                break
+            try:
+                return await asyncio.shield(inflight)
+            except _LeaderCancelled:
+                continue
+
+        future: "asyncio.Future[V]" = asyncio.get_running_loop().create_future()
+        self._inflight[key] = future
+        try:
+            value = await fetch()
+        except asyncio.CancelledError:
+            self._settle(future, _LeaderCancelled())
+            raise
+        except Exception as e:
+            self._settle(future, e)
+            raise
+        finally:
+            if self._inflight.get(key) is future:
+                del self._inflight[key]
+
+        if on_result is not None:
+            on_result(value)
+        future.set_result(value)
+        return value
+
+    @staticmethod
+    def _settle(future: "asyncio.Future[V]", error: Exception) -> None:
+        future.set_exception(error)
+        # Retrieve it so a future nobody waited on does not log a warning
+        future.exception()
+
+
+class TTLCache(Generic[K, V]):
+    """Time-limited cache holding at most max_entries values."""
+
+    def __init__(self, max_entries: int):
+        """
+        Initialize cache.
+
+        Args:
+            max_entries: Entries kept; expired entries, then the oldest, are dropped beyond this
+        """
+        self.max_entries = max_entries
+        self._entries: "OrderedDict[K, Tuple[float, V]]" = OrderedDict()
+
+    def __len__(self) -> int:
+        return len(self._entries)
+
+    def get(self, key: K) -> Optional[V]:
+        """Get an unexpired value, or None."""
+        entry = self._entries.get(key)
+        if entry is None:
+            return None
+        if entry[0] <= time.monotonic():
+            del self._entries[key]
+            return None
+        return entry[1]
+
+    def put(self, key: K, value: V, ttl: float) -> None:
+        """Store a value for ttl seconds."""
+        self._entries[key] = (time.monotonic() + ttl, value)
+        self._entries.move_to_end(key)
+        if len(self._entries) > self.max_entries:
+            now = time.monotonic()
+            for expired in [k for k, (expires, _) in self._entries.items() if expires <= now]:
+                del self._entries[expired]
+            while len(self._entries) > self.max_entries:
+                self._entries.popitem(last=False)
+
+    def discard(self, predicate: Callable[[K], bool]) -> None:
+        """Drop every entry whose key matches predicate."""
+        for key in [k for k in self._entries if predicate(k)]:
+            del self._entries[key]
+
+    def clear(self) -> None:
+        """Drop all entries."""
+        self._entries.clear()
@@ -0,0 +1,202 @@
+"""
+Golden snapshots of agent data directories.
+
+A golden snapshot is a copy of an agent's data directory taken once the agent
+has finished first-boot initialization (reached WORK). Restoring it on reset
+skips database initialization, so the agent is ready again in seconds.
+
+Files are copied with reflinks (FICLONE) where the filesystem supports them and
+with a parallel byte copy elsewhere. SQLite databases are captured through the
+online backup API so a snapshot of a running agent is consistent.
+"""
+
+import asyncio
+import fcntl
+import json
+import logging
+import os
+import shutil
+import sqlite3
+from concurrent.futures import ThreadPoolExecutor
+from datetime import datetime, timezone
+from pathlib import Path
+from typing import Any, Dict, Optional
+
+logger = logging.getLogger(__name__)
+
+GOLDEN_DIR_NAME = ".data.golden"
+GOLDEN_META_NAME = ".data.golden.json"
+
+# From linux/fs.h: _IOW(0x94, 9, int)
+FICLONE = 0x40049409
+
+SQLITE_HEADER = b"SQLite format 3\x00"
+SQLITE_SIDECAR_SUFFIXES = ("-wal", "-shm", "-journal")
+
+
+def clone_file(src: Path, dst: Path) -> bool:
+    """
+    Copy a file, sharing extents with the source when the filesystem allows it.
+
+    Returns:
+        True if a reflink was used, False if the data was copied
+    """
+    with open(src, "rb") as fsrc, open(dst, "wb") as fdst:
+        try:
+            fcntl.ioctl(fdst.fileno(), FICLONE, fsrc.fileno())
+            reflinked = True
+        except OSError:
+            shutil.copyfileobj(fsrc, fdst, 1024 * 1024)
+            reflinked = False
+    shutil.copymode(src, dst)
+    return reflinked
+
+
+def is_sqlite_database(path: Path) -> bool:
+    """Check the file header for the SQLite magic string."""
+    try:
+        with open(path, "rb") as f:
+            return f.read(len(SQLITE_HEADER)) == SQLITE_HEADER
+    except OSError:
+        return False
+
+
+def backup_sqlite_database(src: Path, dst: Path) -> None:
+    """Take a transactionally consistent copy of a live SQLite database."""
+    source = sqlite3.connect(f"file:{src}?mode=ro", uri=True)
+    try:
+        target = sqlite3.connect(dst)
+        try:
+            source.backup(target)
+        finally:
+            target.close()
+    finally:
+        source.close()
+    shutil.copymode(src, dst)
+
+
+def copy_tree(src: Path, dst: Path, max_workers: int = 8, consistent_sqlite: bool = False) -> int:
+    """
+    Copy a directory tree, cloning files in parallel.
+
+    Args:
+        src: Source directory
+        dst: Destination directory (created if missing)
+        max_workers: Number of files copied concurrently
+        consistent_sqlite: Copy SQLite databases via the backup API and skip
+            their -wal/-shm/-journal side files
+
+    Returns:
+        Number of files copied
+    """
+    dst.mkdir(parents=True, exist_ok=True)
+    jobs = []
+    for root, dirs, files in os.walk(src):
+        rel = Path(root).relative_to(src)
+        for d in dirs:
+            (dst / rel / d).mkdir(exist_ok=True)
+        for name in files:
+            source = Path(root) / name
+            if source.is_symlink():
+                continue
+            if consistent_sqlite and name.endswith(SQLITE_SIDECAR_SUFFIXES):
+                continue
+            jobs.append((source, dst / rel / name))
+
+    def _copy(job: tuple) -> None:
+        source, target = job
+        if consistent_sqlite and is_sqlite_database(source):
+            backup_sqlite_database(source, target)
+        else:
+            clone_file(source, target)
+
+    with ThreadPoolExecutor(max_workers=max_workers, thread_name_prefix="snapshot") as pool:
+        # list() re-raises the first copy failure
+        list(pool.map(_copy, jobs))
+    return len(jobs)
+
+
+class GoldenSnapshot:
+    """Golden data snapshot for a single agent."""
+
+    def __init__(self, agent_path: Path):
+        """
+        Initialize snapshot handle.
+
+        Args:
+            agent_path: Agent directory (e.g. /opt/ciris/agents/agent-id)
+        """
+        self.agent_path = agent_path
+        self.snapshot_path = agent_path / GOLDEN_DIR_NAME
+        self.metadata_path = agent_path / GOLDEN_META_NAME
+
+    @property
+    def exists(self) -> bool:
+        """Whether a completed snapshot is present."""
+        return self.snapshot_path.is_dir() and self.metadata_path.exists()
+
+    @property
+    def metadata(self) -> Optional[Dict[str, Any]]:
+        """Snapshot metadata, or None if there is no snapshot."""
+        if not self.metadata_path.exists():
+            return None
+        try:
+            with open(self.metadata_path, "r") as f:
+                data: Dict[str, Any] = json.load(f)
+            return data
+        except (OSError, json.JSONDecodeError) as e:
+            logger.warning(f"Unreadable golden snapshot metadata {self.metadata_path}: {e}")
+            return None
+
+    def is_valid_for(self, version: Optional[str]) -> bool:
+        """
+        Check whether the snapshot can be restored for an agent running version.
+
+        Snapshots are only reused for the exact agent version that produced them,
+        since database schemas may change between releases.
+        """
+        metadata = self.metadata
+        if not self.exists or not metadata or not version:
+            return False
+        return bool(metadata.get("version") == version)
+
+    async def capture(self, version: str) -> bool:
+        """
+        Capture the agent's current data directory as the golden snapshot.
+
+        Args:
+            version: Agent version the data was produced by
+
+        Returns:
+            True if the snapshot was written
+        """
+        data_path = self.agent_path / "data"
+        staging = self.agent_path / f"{GOLDEN_DIR_NAME}.tmp"
+        try:
+            if staging.exists():
+                await asyncio.to_thread(shutil.rmtree, staging)
+            count = await asyncio.to_thread(copy_tree, data_path, staging, 8, True)
+
+            self.invalidate()
+            os.rename(staging, self.snapshot_path)
+            with open(self.metadata_path, "w") as f:
+                json.dump(
+                    {
+                        "version": version,
+                        "files": count,
+                        "created_at": datetime.now(timezone.utc).isoformat(),
+                    },
+                    f,
+                )
+            logger.info(f"Captured golden snapshot of {data_path} ({count} files, v{version})")
+            return True
+        except Exception as e:
+            logger.error(f"Failed to capture golden snapshot of {data_path}: {e}")
+            shutil.rmtree(staging, ignore_errors=True)
+            return False
+
+    def invalidate(self) -> None:
+        """Remove the snapshot and its metadata."""
+        self.metadata_path.unlink(missing_ok=True)
+        if self.snapshot_path.exists():
+            shutil.rmtree(self.snapshot_path, ignore_errors=True)
@@ -0,0 +1,129 @@
+"""
+Background deletion of directory trees that have been moved out of the way.
+
+Resetting an agent swaps its data directory for a fresh one and hands the old
+tree to a DirectoryReaper. Deletion then happens off the request path, on a
+small thread pool so a huge tree cannot saturate the disk or the event loop.
+"""
+
+import asyncio
+import logging
+import shutil
+from concurrent.futures import ThreadPoolExecutor
+from pathlib import Path
+from typing import Optional
+
+from ciris_manager.utils.permission_helper import REAP_PREFIX, remove_tree
+
+logger = logging.getLogger(__name__)
+
+
+def _remove_entry(entry: Path) -> None:
+    """Remove a single file or directory tree (runs in a worker thread)."""
+    if entry.is_dir() and not entry.is_symlink():
+        shutil.rmtree(entry)
+    else:
+        entry.unlink()
+
+
+class DirectoryReaper:
+    """Deletes queued directory trees in the background with bounded parallelism."""
+
+    def __init__(self, max_workers: int = 4):
+        """
+        Initialize the reaper.
+
+        Args:
+            max_workers: Maximum number of threads deleting entries concurrently
+        """
+        self.max_workers = max_workers
+        self._executor = ThreadPoolExecutor(
+            max_workers=max_workers, thread_name_prefix="dir-reaper"
+        )
+        self._queue: asyncio.Queue[Path] = asyncio.Queue()
+        self._worker: Optional[asyncio.Task] = None
+        self.reaped = 0
+        self.failed = 0
+
+    def schedule(self, path: Path) -> None:
+        """
+        Queue a directory tree for deletion.
+
+        Must be called from within the running event loop.
+
+        Args:
+            path: Directory to delete
+        """
+        self._queue.put_nowait(path)
+        if self._worker is None or self._worker.done():
+            self._worker = asyncio.create_task(self._run())
+        logger.debug(f"Scheduled {path} for background deletion")
+
+    def reap_stale(self, agent_path: Path) -> int:
+        """
+        Queue tombstones left behind by an earlier process (e.g. after a crash).
+
+        Args:
+            agent_path: Agent directory to scan
+
+        Returns:
+            Number of tombstones scheduled
+        """
+        if not agent_path.exists():
+            return 0
+        stale = [p for p in agent_path.iterdir() if p.name.startswith(REAP_PREFIX)]
+        for path in stale:
+            self.schedule(path)
+        return len(stale)
+
+    async def drain(self) -> None:
+        """Wait until every queued tree has been processed."""
+        await self._queue.join()
+
+    async def close(self) -> None:
+        """Stop the worker. Unfinished tombstones are picked up by reap_stale later."""
+        if self._worker and not self._worker.done():
+            self._worker.cancel()
+            try:
+                await self._worker
+            except asyncio.CancelledError:
+                pass
+        self._executor.shutdown(wait=False, cancel_futures=True)
+
+    async def _run(self) -> None:
+        """Process queued trees one at a time."""
+        while True:
+            path = await self._queue.get()
+            try:
+                await self._reap(path)
+            finally:
+                self._queue.task_done()
+
+    async def _reap(self, path: Path) -> None:
+        """Delete one tree, spreading its top-level entries over the thread pool."""
+        loop = asyncio.get_running_loop()
+        try:
+            entries = await loop.run_in_executor(self._executor, lambda: list(path.iterdir()))
+            results = await asyncio.gather(
+                *(loop.run_in_executor(self._executor, _remove_entry, e) for e in entries),
+                return_exceptions=True,
+            )
+            errors = [r for r in results if isinstance(r, BaseException)]
+            if errors:
+                raise errors[0]
+            await loop.run_in_executor(self._executor, path.rmdir)
+            self.reaped += 1
+            logger.info(f"Reaped {path}")
+        except FileNotFoundError:
+            self.reaped += 1
+        except PermissionError:
+            # Tree contains container-owned files; hand it to the setuid helper
+            if await remove_tree(path):
+                self.reaped += 1
+                logger.info(f"Reaped {path} via permission helper")
+            else:
+                self.failed += 1
+                logger.error(f"Could not reap {path}: permission denied")
+        except Exception as e:
+            self.failed += 1
+            logger.error(f"Could not reap {path}: {e}")
@@ -0,0 +1,233 @@
+"""
+Async wrappers around the ciris-fix-permissions privileged helper.
+
+The helper (scripts/ciris-fix-permissions.c) is the only component allowed to
+touch root/container-owned agent files. Each operation is sent to the
+persistent privileged broker when it is running, falls back to executing the
+setuid binary, and finally to plain filesystem operations when neither is
+installed (development and test environments).
+"""
+
+import asyncio
+import logging
+import os
+import shutil
+import time
+from pathlib import Path
+from typing import Optional, Tuple
+
+from ciris_manager.utils.data_snapshot import GOLDEN_DIR_NAME, copy_tree
+from ciris_manager.utils.privileged_broker import (
+    BrokerError,
+    BrokerUnavailableError,
+    get_privileged_broker,
+)
+
+logger = logging.getLogger(__name__)
+
+PERMISSION_HELPER_PATH = Path("/usr/local/bin/ciris-fix-permissions")
+
+# Prefix of the directory the old data tree is moved to by swap_data_directory
+REAP_PREFIX = ".data.reap-"
+
+# User and group the agent container runs as
+CONTAINER_UID = 1000
+CONTAINER_GID = 1000
+
+
+async def _run_helper(*args: str) -> Tuple[int, str, str]:
+    """Run the permission helper and return (returncode, stdout, stderr)."""
+    process = await asyncio.create_subprocess_exec(
+        str(PERMISSION_HELPER_PATH),
+        *args,
+        stdout=asyncio.subprocess.PIPE,
+        stderr=asyncio.subprocess.PIPE,
+    )
+    stdout, stderr = await process.communicate()
+    return process.returncode or 0, stdout.decode().strip(), stderr.decode().strip()
+
+
+def helper_available() -> bool:
+    """Check whether the setuid permission helper is installed."""
+    return PERMISSION_HELPER_PATH.exists()
+
+
+async def _privileged(
+    op: str, path: Path, helper_args: Optional[Tuple[str, ...]], arg: Optional[str] = None
+) -> Optional[Tuple[bool, str]]:
+    """
+    Run a privileged operation via the broker, or the setuid helper as fallback.
+
+    Args:
+        op: Broker operation name
+        path: Target path
+        helper_args: Equivalent setuid helper arguments, or None if it has no equivalent
+        arg: Optional extra broker argument
+
+    Returns:
+        (succeeded, payload-or-error), or None if no privileged path is installed
+    """
+    broker = get_privileged_broker()
+    if broker:
+        try:
+            return True, await broker.request(op, path, arg)
+        except BrokerUnavailableError as e:
+            logger.warning(f"{e}, falling back to setuid helper")
+        except BrokerError as e:
+            # Includes requests the broker received but did not answer: running
+            # them again through the helper could repeat a swap or delete
+            return False, str(e)
+
+    if helper_args is not None and helper_available():
+        returncode, stdout, stderr = await _run_helper(*helper_args)
+        return returncode == 0, stdout if returncode == 0 else stderr
+
+    return None
+
+
+async def swap_data_directory(agent_path: Path, from_golden: bool = False) -> Optional[Path]:
+    """
+    Replace an agent's data directory with a fresh, container-owned one.
+
+    The old directory is renamed aside rather than deleted, so this returns in
+    milliseconds regardless of how much data the agent has accumulated.
+
+    Args:
+        agent_path: Agent directory (e.g. /opt/ciris/agents/agent-id)
+        from_golden: Populate the fresh directory from the agent's golden snapshot
+
+    Returns:
+        Path of the tombstone holding the old data, or None if there was no data dir
+
+    Raises:
+        RuntimeError: If the privileged swap failed or went unanswered, the local
+            swap could not be performed, or the fresh directory could not be
+            handed to the container user (the old data is put back)
+    """
+    op, flag = ("restore-dir", "--restore-data") if from_golden else ("swap-dir", "--swap-data")
+    result = await _privileged(op, agent_path, (flag, str(agent_path)))
+    if result is not None:
+        ok, output = result
+        if not ok:
+            # The broker or helper may have started (or still be running) the swap,
+            # so repeating it locally could swap twice or race it
+            raise RuntimeError(f"Privileged swap failed for {agent_path}: {output}")
+        logger.debug(f"Swapped data directory via privileged helper for {agent_path}")
+        return Path(output) if output else None
+
+    data_path = agent_path / "data"
+    tombstone: Optional[Path] = None
+    try:
+        if data_path.exists():
+            tombstone = agent_path / f"{REAP_PREFIX}{time.time_ns()}"
+            os.rename(data_path, tombstone)
+        data_path.mkdir(mode=0o755)
+    except OSError as e:
+        if tombstone is not None and tombstone.exists() and not data_path.exists():
+            os.rename(tombstone, data_path)
+        raise RuntimeError(f"Could not swap data directory {data_path}: {e}")
+
+    try:
+        if from_golden:
+            await asyncio.to_thread(copy_tree, agent_path / GOLDEN_DIR_NAME, data_path)
+        # The container must own the fresh tree, or the agent cannot write after restart
+        await asyncio.to_thread(_chown_to_container, data_path)
+    except OSError as e:
+        await asyncio.to_thread(shutil.rmtree, data_path, True)
+        if tombstone is not None:
+            os.rename(tombstone, data_path)
+        raise RuntimeError(f"Could not prepare fresh data directory {data_path}: {e}")
+
+    logger.debug(f"Swapped data directory locally for {agent_path}")
+    return tombstone
+
+
+def _chown_to_container(path: Path) -> None:
+    """Hand a directory tree to the container user (no-op when already running as it)."""
+    if os.geteuid() == CONTAINER_UID:
+        return
+    os.chown(path, CONTAINER_UID, CONTAINER_GID)
+    for root, dirs, files in os.walk(path):
+        for name in dirs + files:
+            os.chown(os.path.join(root, name), CONTAINER_UID, CONTAINER_GID, follow_symlinks=False)
+
+
+async def remove_tree(path: Path) -> bool:
+    """
+    Remove a data tombstone that the current user cannot delete itself.
+
+    Args:
+        path: Tombstone path produced by swap_data_directory
+
+    Returns:
+        True if the tree was removed
+    """
+    result = await _privileged("remove-tree", path, ("--remove-tree", str(path)))
+    if result is None:
+        return False
+
+    ok, output = result
+    if not ok:
+        logger.warning(f"Privileged helper could not remove {path}: {output}")
+    return ok
+
+
+async def fix_agent_permissions(agent_dir: Path) -> bool:
+    """
+    Fix ownership and permissions of an agent's standard directories.
+
+    Args:
+        agent_dir: Agent directory (e.g. /opt/ciris/agents/agent-id)
+
+    Returns:
+        True if permissions were fixed
+    """
+    result = await _privileged("fix-perms", agent_dir, (str(agent_dir),))
+    if result is None:
+        logger.warning(f"No privileged helper installed, skipping permission fix for {agent_dir}")
+        return False
+
+    ok, output = result
+    if not ok:
+        logger.warning(f"Permission fix failed for {agent_dir}: {output}")
+    return ok
+
+
+async def create_agent_directories(agent_dir: Path) -> bool:
+    """
+    Create an agent's standard directories owned by the container user, in one privileged call.
+
+    Only available through the broker; callers fall back to their own chown otherwise.
+
+    Returns:
+        True if the broker created the directories
+    """
+    result = await _privileged("create-agent-dirs", agent_dir, None)
+    if result is None:
+        return False
+
+    ok, output = result
+    if not ok:
+        logger.warning(f"Privileged directory creation failed for {agent_dir}: {output}")
+    return ok
+
+
+async def chown_file(path: Path, owner: str) -> bool:
+    """
+    Hand a file inside an agent directory to the container user or back to the manager.
+
+    Args:
+        path: File to change
+        owner: "container" (1000:1000, 0644) or "manager" (this process's user, 0664)
+
+    Returns:
+        True if the broker changed ownership
+    """
+    result = await _privileged("chown-file", path, None, owner)
+    if result is None:
+        return False
+
+    ok, output = result
+    if not ok:
+        logger.warning(f"Privileged chown of {path} failed: {output}")
+    return ok
@@ -0,0 +1,219 @@
+"""
+Client for the persistent privileged broker.
+
+The broker is ciris-fix-permissions running with --serve as a root systemd
+service (deployment/ciris-privileged-broker.service). It accepts one-line
+requests over a unix socket, so a privileged operation costs one IPC round
+trip instead of fork/exec of sudo or a setuid binary.
+"""
+
+import asyncio
+import logging
+import os
+import socket
+from pathlib import Path
+from typing import List, Optional, Tuple
+
+logger = logging.getLogger(__name__)
+
+BROKER_SOCKET_PATH = Path(
+    os.environ.get("CIRIS_PRIVILEGED_BROKER_SOCKET", "/run/ciris/privileged.sock")
+)
+
+# Operations understood by the broker
+OPERATIONS = {
+    "fix-perms",
+    "create-agent-dirs",
+    "swap-dir",
+    "restore-dir",
+    "remove-tree",
+    "chown-file",
+}
+
+# Longest request line the broker accepts, newline included
+MAX_REQUEST = 1024
+
+# Idle connections kept for reuse; concurrent requests beyond this open their own
+MAX_IDLE_CONNECTIONS = 4
+
+Connection = Tuple[asyncio.StreamReader, asyncio.StreamWriter]
+
+# Operations that walk or copy a whole data tree get longer to answer
+OPERATION_TIMEOUTS = {
+    "remove-tree": 3600.0,
+    "restore-dir": 1800.0,
+}
+
+
+class BrokerError(RuntimeError):
+    """Raised when the broker rejects or fails a request."""
+
+
+class BrokerUnavailableError(BrokerError):
+    """Raised when the broker cannot be reached (the request was not delivered)."""
+
+
+class BrokerNoResponseError(BrokerError):
+    """Raised when a delivered request got no answer; it may still have run."""
+
+
+class PrivilegedBrokerClient:
+    """Pooled connections to the privileged broker."""
+
+    def __init__(self, socket_path: Path = BROKER_SOCKET_PATH, timeout: float = 30.0):
+        """
+        Initialize broker client.
+
+        Args:
+            socket_path: Unix socket the broker listens on
+            timeout: Seconds to wait for a response (see OPERATION_TIMEOUTS)
+        """
+        self.socket_path = socket_path
+        self.timeout = timeout
+        # Idle connections; each in-flight request holds its own, so a long
+        # remove-tree never queues a fix-perms behind it
+        self._idle: List[Connection] = []
+
+    @property
+    def available(self) -> bool:
+        """Whether the broker socket exists."""
+        return self.socket_path.exists()
+
+    @staticmethod
+    def _build_request(op: str, path: Path, arg: Optional[str]) -> bytes:
+        if op not in OPERATIONS:
+            raise ValueError(f"Unknown broker operation: {op}")
+        parts = [op, str(path)] + ([arg] if arg else [])
+        if any(not p or any(c.isspace() for c in p) for p in parts):
+            raise ValueError(f"Invalid broker request arguments: {parts}")
+        request = (" ".join(parts) + "\n").encode()
+        if len(request) >= MAX_REQUEST:
+            raise ValueError(f"Broker request too long: {len(request)} bytes")
+        return request
+
+    def _timeout_for(self, op: str) -> float:
+        return max(self.timeout, OPERATION_TIMEOUTS.get(op, 0.0))
+
+    @staticmethod
+    def _parse_response(op: str, line: bytes) -> str:
+        text = line.decode().rstrip("\n")
+        if text.startswith("OK"):
+            return text[3:]
+        if not text:
+            raise BrokerNoResponseError(f"Broker closed connection during {op}")
+        raise BrokerError(text[4:] if text.startswith("ERR ") else text)
+
+    async def _acquire(self) -> Connection:
+        """Take an idle connection that is still open, or open a new one."""
+        while self._idle:
+            reader, writer = self._idle.pop()
+            if not writer.is_closing() and not reader.at_eof():
+                return reader, writer
+            await self._discard(writer)
+        return await asyncio.open_unix_connection(str(self.socket_path))
+
+    def _release(self, connection: Connection) -> None:
+        """Return a connection whose request was answered to the idle pool."""
+        if len(self._idle) < MAX_IDLE_CONNECTIONS:
+            self._idle.append(connection)
+        else:
+            connection[1].close()
+
+    @staticmethod
+    async def _discard(writer: asyncio.StreamWriter) -> None:
+        writer.close()
+        try:
+            await writer.wait_closed()
+        except Exception:
+            pass
+
+    async def close(self) -> None:
+        """Close the idle connections (in-flight requests close theirs when done)."""
+        idle, self._idle = self._idle, []
+        for _, writer in idle:
+            await self._discard(writer)
+
+    async def request(self, op: str, path: Path, arg: Optional[str] = None) -> str:
+        """
+        Send one request to the broker.
+
+        Args:
+            op: Operation name (see OPERATIONS)
+            path: Target path
+            arg: Optional extra argument (e.g. owner for chown-file)
+
+        Returns:
+            Response payload (e.g. tombstone path for swap-dir)
+
+        Raises:
+            BrokerUnavailableError: If the broker cannot be reached
+            BrokerNoResponseError: If the request was sent but not answered in time
+            BrokerError: If the operation failed
+        """
+        payload = self._build_request(op, path, arg)
+        # Reconnect only while nothing has been sent: a request that reached the
+        # broker is never repeated, since swap-dir or remove-tree must not run twice
+        try:
+            reader, writer = await self._acquire()
+        except (ConnectionError, FileNotFoundError) as e:
+            raise BrokerUnavailableError(f"Privileged broker unavailable: {e}")
+        try:
+            writer.write(payload)
+            await writer.drain()
+        except ConnectionError as e:
+            await self._discard(writer)
+            raise BrokerUnavailableError(f"Privileged broker unavailable: {e}")
+
+        try:
+            line = await asyncio.wait_for(reader.readline(), self._timeout_for(op))
+        except (ConnectionError, asyncio.TimeoutError) as e:
+            await self._discard(writer)
+            raise BrokerNoResponseError(
+                f"No answer from privileged broker for {op} {path}: {str(e) or 'timed out'}"
+            )
+        except BaseException:
+            # Cancelled mid-request: the late answer must not reach the next caller
+            writer.close()
+            raise
+        if line:
+            self._release((reader, writer))
+        else:
+            await self._discard(writer)
+        return self._parse_response(op, line)
+
+    def request_sync(self, op: str, path: Path, arg: Optional[str] = None) -> str:
+        """
+        Blocking variant of request for synchronous call sites.
+
+        Uses a short-lived connection rather than the pooled async ones.
+        """
+        payload = self._build_request(op, path, arg)
+        with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as sock:
+            try:
+                sock.settimeout(self.timeout)
+                sock.connect(str(self.socket_path))
+                sock.sendall(payload)
+            except OSError as e:
+                raise BrokerUnavailableError(f"Privileged broker unavailable: {e}")
+            try:
+                sock.settimeout(self._timeout_for(op))
+                with sock.makefile("rb") as stream:
+                    line = stream.readline()
+            except OSError as e:
+                raise BrokerNoResponseError(f"No answer from privileged broker for {op}: {e}")
+        return self._parse_response(op, line)
+
+
+_broker: Optional[PrivilegedBrokerClient] = None
+
+
+def get_privileged_broker() -> Optional[PrivilegedBrokerClient]:
+    """
+    Get the shared broker client, or None if the broker is not running.
+    """
+    global _broker
+    if not BROKER_SOCKET_PATH.exists():
+        return None
+    if _broker is None:
+        _broker = PrivilegedBrokerClient()
+    return _broker
@@ -1,14 +1,20 @@
 #!/bin/bash
 # Backup script for CIRIS Manager
 # Backs up configuration, agent data, and metadata
+#
+# Backups are incremental snapshots in a deduplicating repository
+# (python -m ciris_manager.backup): unchanged files are not re-read, only new
+# content-defined chunks are compressed and stored, and live SQLite databases
+# are captured through the online backup API.
 
 set -e
 
 # Configuration
 BACKUP_DIR="/var/backups/ciris-manager"
+REPOSITORY="$BACKUP_DIR/repository"
 RETENTION_DAYS=30
 TIMESTAMP=$(date +%Y%m%d_%H%M%S)
-BACKUP_NAME="ciris-backup-$TIMESTAMP"
+PYTHON="${CIRIS_PYTHON:-/opt/ciris-manager/venv/bin/python}"
 
 # Directories to backup
 BACKUP_PATHS=(
@@ -20,96 +26,64 @@ BACKUP_PATHS=(
 # Optional: Remote backup destination (configure as needed)
 # REMOTE_BACKUP="user@backup-server:/backups/ciris"
 
+if [ ! -x "$PYTHON" ]; then
+    PYTHON=python3
+fi
+ciris_backup() {
+    "$PYTHON" -m ciris_manager.backup --repo "$REPOSITORY" "$@"
+}
+
 # Create backup directory
 mkdir -p "$BACKUP_DIR"
 
 echo "Starting CIRIS Manager backup..."
 echo "Backup timestamp: $TIMESTAMP"
 
-# Create temporary directory for this backup
-TEMP_DIR="$BACKUP_DIR/$BACKUP_NAME"
-mkdir -p "$TEMP_DIR"
-
-# Function to backup a directory
-backup_directory() {
-    local src=$1
-    local name=$(basename "$src")
-
-    if [ -d "$src" ]; then
-        echo "Backing up $src..."
-        tar -czf "$TEMP_DIR/${name}.tar.gz" -C "$(dirname "$src")" "$name" 2>/dev/null || {
-            echo "Warning: Some files in $src could not be backed up"
-        }
-    else
-        echo "Warning: $src does not exist, skipping..."
-    fi
-}
-
-# Backup each directory
-for path in "${BACKUP_PATHS[@]}"; do
-    backup_directory "$path"
-done
+# Metadata that is not a file on disk is staged and backed up with the data
+STAGING_DIR="$BACKUP_DIR/metadata"
+mkdir -p "$STAGING_DIR"
 
 # Export Docker container list
 echo "Exporting Docker container information..."
-docker ps -a --filter "label=ciris.agent" --format json > "$TEMP_DIR/docker-containers.json" 2>/dev/null || true
+docker ps -a --filter "label=ciris.agent" --format json > "$STAGING_DIR/docker-containers.json" 2>/dev/null || true
 
-# Export Docker compose file if exists
-if [ -f "/opt/ciris/agents/docker-compose.yml" ]; then
-    cp "/opt/ciris/agents/docker-compose.yml" "$TEMP_DIR/docker-compose.yml"
-fi
-
-# Create backup metadata
-cat > "$TEMP_DIR/backup-metadata.json" << EOF
+cat > "$STAGING_DIR/backup-metadata.json" << EOF
 {
     "timestamp": "$TIMESTAMP",
     "date": "$(date -Iseconds)",
     "hostname": "$(hostname)",
     "version": "$(ciris-manager --version 2>/dev/null || echo 'unknown')",
-    "included_paths": $(printf '%s\n' "${BACKUP_PATHS[@]}" | jq -R . | jq -s .),
-    "backup_size": "pending"
+    "included_paths": $(printf '%s\n' "${BACKUP_PATHS[@]}" | jq -R . | jq -s .)
 }
 EOF
 
-# Create single archive
-echo "Creating backup archive..."
-cd "$BACKUP_DIR"
-tar -czf "$BACKUP_NAME.tar.gz" "$BACKUP_NAME"
-
-# Calculate final size
-BACKUP_SIZE=$(du -h "$BACKUP_NAME.tar.gz" | cut -f1)
-echo "Backup size: $BACKUP_SIZE"
+# Create snapshot
+echo "Creating backup snapshot..."
+ciris_backup create --label "ciris-backup-$TIMESTAMP" "${BACKUP_PATHS[@]}" "$STAGING_DIR"
 
-# Update metadata with size
-jq --arg size "$BACKUP_SIZE" '.backup_size = $size' "$TEMP_DIR/backup-metadata.json" > "$TEMP_DIR/backup-metadata.json.tmp"
-mv "$TEMP_DIR/backup-metadata.json.tmp" "$TEMP_DIR/backup-metadata.json"
+# Verify backup integrity (every chunk of every snapshot is present)
+echo "Verifying backup integrity..."
+ciris_backup verify || {
+    echo "ERROR: Backup verification failed!"
+    exit 1
+}
 
-# Clean up temporary directory
-rm -rf "$TEMP_DIR"
+# Clean up old backups (the newest snapshot is always kept)
+echo "Cleaning up old backups..."
+ciris_backup prune --keep-days "$RETENTION_DAYS"
 
-# Optional: Copy to remote backup location
+# Optional: Copy to remote backup location (only new chunks are transferred)
 if [ ! -z "$REMOTE_BACKUP" ]; then
     echo "Copying backup to remote location..."
-    scp "$BACKUP_DIR/$BACKUP_NAME.tar.gz" "$REMOTE_BACKUP/" || {
+    rsync -a --delete --exclude lock --exclude tmp/ "$REPOSITORY/" "$REMOTE_BACKUP/repository/" || {
         echo "Warning: Failed to copy backup to remote location"
     }
 fi
 
-# Clean up old backups
-echo "Cleaning up old backups..."
-find "$BACKUP_DIR" -name "ciris-backup-*.tar.gz" -mtime +$RETENTION_DAYS -delete
-
 # List remaining backups
 echo ""
 echo "Current backups:"
-ls -lh "$BACKUP_DIR"/ciris-backup-*.tar.gz 2>/dev/null | tail -5
+ciris_backup list | tail -5
 
 echo ""
-echo "Backup completed: $BACKUP_DIR/$BACKUP_NAME.tar.gz"
-
-# Verify backup integrity
-echo "Verifying backup integrity..."
-tar -tzf "$BACKUP_DIR/$BACKUP_NAME.tar.gz" > /dev/null && echo "Backup verification: OK" || {
-    echo "ERROR: Backup verification failed!"
-    exit 1
-}
+echo "Backup completed: $REPOSITORY ($(du -sh "$REPOSITORY" | cut -f1))"
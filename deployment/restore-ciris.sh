@@ -5,14 +5,31 @@
 set -e
 
 # Check arguments
+AGENT_ID=""
+if [ "$1" = "--agent" ] && [ $# -ge 2 ] && [ $# -le 3 ]; then
+    AGENT_ID=$2
+    set -- "${3:-latest}"
+fi
 if [ $# -ne 1 ]; then
-    echo "Usage: $0 <backup-file>"
-    echo "Example: $0 /var/backups/ciris-manager/ciris-backup-20240115_120000.tar.gz"
+    echo "Usage: $0 <snapshot-id|latest|backup-file>"
+    echo "       $0 --agent <agent-id> [snapshot-id|latest]"
+    echo "Example: $0 20240115T120000Z-3f2a"
+    echo "         $0 --agent datum"
+    echo "Legacy archives are still accepted:"
+    echo "         $0 /var/backups/ciris-manager/ciris-backup-20240115_120000.tar.gz"
     exit 1
 fi
 
 BACKUP_FILE=$1
 RESTORE_DIR="/tmp/ciris-restore-$$"
+REPOSITORY="/var/backups/ciris-manager/repository"
+PYTHON="${CIRIS_PYTHON:-/opt/ciris-manager/venv/bin/python}"
+if [ ! -x "$PYTHON" ]; then
+    PYTHON=python3
+fi
+ciris_backup() {
+    "$PYTHON" -m ciris_manager.backup --repo "$REPOSITORY" "$@"
+}
 
 # Check if running as root
 if [ "$EUID" -ne 0 ]; then
@@ -20,15 +37,59 @@ if [ "$EUID" -ne 0 ]; then
     exit 1
 fi
 
-# Verify backup file exists
+# Resolve the snapshot (or legacy archive) to restore
+SNAPSHOT=""
 if [ ! -f "$BACKUP_FILE" ]; then
-    echo "ERROR: Backup file not found: $BACKUP_FILE"
-    exit 1
+    if [ "$BACKUP_FILE" = "latest" ]; then
+        SNAPSHOT=$(ciris_backup list | tail -1 | cut -d' ' -f1)
+    elif ciris_backup list | cut -d' ' -f1 | grep -qx "$BACKUP_FILE"; then
+        SNAPSHOT=$BACKUP_FILE
+    fi
+    if [ -z "$SNAPSHOT" ]; then
+        echo "ERROR: Backup snapshot or file not found: $BACKUP_FILE"
+        echo "Available snapshots:"
+        ciris_backup list || true
+        exit 1
+    fi
+fi
+
+# Single agent: rebuild only its directory from the snapshot index beside the
+# live one and swap it in, so files created since the snapshot do not survive
+if [ -n "$AGENT_ID" ]; then
+    if [ -z "$SNAPSHOT" ]; then
+        echo "ERROR: Single-agent restore needs a snapshot, not a legacy archive"
+        exit 1
+    fi
+    CONTAINER="ciris-$AGENT_ID"
+    echo "Restoring agent $AGENT_ID from snapshot $SNAPSHOT..."
+    WAS_RUNNING=$(docker inspect -f '{{.State.Running}}' "$CONTAINER" 2>/dev/null || echo false)
+    start_agent() {
+        if [ "$WAS_RUNNING" = "true" ]; then
+            echo "Starting $CONTAINER..."
+            docker start "$CONTAINER" > /dev/null
+        fi
+    }
+    # A failed or interrupted restore leaves the live directory in place, so
+    # bring the agent back up on its current data rather than leave it stopped
+    trap 'start_agent || echo "ERROR: Failed to restart $CONTAINER"' EXIT
+    trap 'exit 1' INT TERM
+    if [ "$WAS_RUNNING" = "true" ]; then
+        echo "Stopping $CONTAINER..."
+        docker stop "$CONTAINER" > /dev/null
+    fi
+    ciris_backup restore "$SNAPSHOT" / --agent "$AGENT_ID" || {
+        echo "ERROR: Agent restore failed, restarting $AGENT_ID on its current data"
+        exit 1
+    }
+    trap - EXIT INT TERM
+    start_agent
+    echo "Agent $AGENT_ID restored."
+    exit 0
 fi
 
 echo "CIRIS Manager Restore Utility"
 echo "============================="
-echo "Backup file: $BACKUP_FILE"
+echo "Backup: ${SNAPSHOT:-$BACKUP_FILE}"
 echo ""
 echo "WARNING: This will restore CIRIS Manager configuration and data."
 echo "Current configuration will be backed up to /tmp/ciris-pre-restore-backup"
@@ -57,56 +118,67 @@ for dir in /etc/ciris-manager /opt/ciris/agents; do
     fi
 done
 
-# Extract backup
-echo "Extracting backup..."
-mkdir -p "$RESTORE_DIR"
-tar -xzf "$BACKUP_FILE" -C "$RESTORE_DIR"
-
-# Find the backup directory (should be named ciris-backup-TIMESTAMP)
-BACKUP_CONTENT=$(find "$RESTORE_DIR" -maxdepth 1 -name "ciris-backup-*" -type d | head -1)
+if [ -n "$SNAPSHOT" ]; then
+    # Snapshots record absolute paths, modes and mtimes; restore them in place
+    echo "Restoring snapshot $SNAPSHOT..."
+    # Restore checks every chunk first and applies modes and owners per file
+    ciris_backup restore "$SNAPSHOT" / || {
+        echo "ERROR: Snapshot restore failed"
+        exit 1
+    }
+else
+    # Extract backup
+    echo "Extracting backup..."
+    mkdir -p "$RESTORE_DIR"
+    tar -xzf "$BACKUP_FILE" -C "$RESTORE_DIR"
+
+    # Find the backup directory (should be named ciris-backup-TIMESTAMP)
+    BACKUP_CONTENT=$(find "$RESTORE_DIR" -maxdepth 1 -name "ciris-backup-*" -type d | head -1)
+
+    if [ -z "$BACKUP_CONTENT" ]; then
+        echo "ERROR: Invalid backup format"
+        rm -rf "$RESTORE_DIR"
+        exit 1
+    fi
 
-if [ -z "$BACKUP_CONTENT" ]; then
-    echo "ERROR: Invalid backup format"
-    rm -rf "$RESTORE_DIR"
-    exit 1
-fi
+    # Display backup metadata
+    if [ -f "$BACKUP_CONTENT/backup-metadata.json" ]; then
+        echo ""
+        echo "Backup metadata:"
+        jq . "$BACKUP_CONTENT/backup-metadata.json"
+        echo ""
+    fi
 
-# Display backup metadata
-if [ -f "$BACKUP_CONTENT/backup-metadata.json" ]; then
-    echo ""
-    echo "Backup metadata:"
-    jq . "$BACKUP_CONTENT/backup-metadata.json"
-    echo ""
-fi
+    # Restore configuration
+    if [ -f "$BACKUP_CONTENT/ciris-manager.tar.gz" ]; then
+        echo "Restoring configuration..."
+        mkdir -p /etc/ciris-manager
+        tar -xzf "$BACKUP_CONTENT/ciris-manager.tar.gz" -C /etc/
+        chown -R ciris-manager:ciris-manager /etc/ciris-manager
+        chmod 600 /etc/ciris-manager/environment
+    fi
 
-# Restore configuration
-if [ -f "$BACKUP_CONTENT/ciris-manager.tar.gz" ]; then
-    echo "Restoring configuration..."
-    mkdir -p /etc/ciris-manager
-    tar -xzf "$BACKUP_CONTENT/ciris-manager.tar.gz" -C /etc/
-    chown -R ciris-manager:ciris-manager /etc/ciris-manager
-    chmod 600 /etc/ciris-manager/environment
-fi
+    # Restore agent data
+    if [ -f "$BACKUP_CONTENT/agents.tar.gz" ]; then
+        echo "Restoring agent data..."
+        mkdir -p /opt/ciris
+        tar -xzf "$BACKUP_CONTENT/agents.tar.gz" -C /opt/ciris/
+        chown -R ciris-manager:ciris-manager /opt/ciris/agents
+    fi
 
-# Restore agent data
-if [ -f "$BACKUP_CONTENT/agents.tar.gz" ]; then
-    echo "Restoring agent data..."
-    mkdir -p /opt/ciris
-    tar -xzf "$BACKUP_CONTENT/agents.tar.gz" -C /opt/ciris/
-    chown -R ciris-manager:ciris-manager /opt/ciris/agents
-fi
+    # Restore templates
+    if [ -f "$BACKUP_CONTENT/agent_templates.tar.gz" ]; then
+        echo "Restoring agent templates..."
+        mkdir -p /opt/ciris-manager
+        tar -xzf "$BACKUP_CONTENT/agent_templates.tar.gz" -C /opt/ciris-manager/
+    fi
 
-# Restore templates
-if [ -f "$BACKUP_CONTENT/agent_templates.tar.gz" ]; then
-    echo "Restoring agent templates..."
-    mkdir -p /opt/ciris-manager
-    tar -xzf "$BACKUP_CONTENT/agent_templates.tar.gz" -C /opt/ciris-manager/
-fi
+    # Restore docker-compose.yml if present
+    if [ -f "$BACKUP_CONTENT/docker-compose.yml" ]; then
+        echo "Restoring docker-compose.yml..."
+        cp "$BACKUP_CONTENT/docker-compose.yml" /opt/ciris/agents/
+    fi
 
-# Restore docker-compose.yml if present
-if [ -f "$BACKUP_CONTENT/docker-compose.yml" ]; then
-    echo "Restoring docker-compose.yml..."
-    cp "$BACKUP_CONTENT/docker-compose.yml" /opt/ciris/agents/
 fi
 
 # Verify critical files
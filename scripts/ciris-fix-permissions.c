@@ -12,13 +12,86 @@
  *
  * Usage:
  *   ciris-fix-permissions /opt/ciris/agents/agent-id
+ *   ciris-fix-permissions --swap-data /opt/ciris/agents/agent-id
+ *   ciris-fix-permissions --restore-data /opt/ciris/agents/agent-id
+ *   ciris-fix-permissions --remove-tree /opt/ciris/agents/agent-id/.data.reap-XXXX
+ *   ciris-fix-permissions --serve /run/ciris/privileged.sock ciris-manager
+ *
+ * --swap-data replaces the agent's data directory with a fresh, correctly owned
+ * one and moves the old contents aside to a ".data.reap-*" tombstone, whose path
+ * is printed on stdout. The old tree is left for the caller to delete in the
+ * background (see --remove-tree), so a reset does not wait on a large rm -rf.
+ *
+ * --restore-data does the same, but the fresh directory is populated from the
+ * agent's ".data.golden" snapshot first, using reflinks (FICLONE) where the
+ * filesystem supports them and copy_file_range elsewhere.
+ *
+ * --serve runs the same operations as a persistent privileged broker (started
+ * as root by systemd, see deployment/ciris-privileged-broker.service). It listens
+ * on a unix socket that only the named user may connect to, so the manager pays
+ * one IPC round trip per privileged operation instead of fork/exec plus sudo.
+ * Each request is a single line, "<op> <path> [arg]", answered with
+ * "OK [payload]" or "ERR <message>":
+ *
+ *   fix-perms <agent-dir>          same as the default mode
+ *   create-agent-dirs <agent-dir>  create standard subdirectories, owned by 1000
+ *   swap-dir <agent-dir>           same as --swap-data, payload is the tombstone
+ *   restore-dir <agent-dir>        same as --restore-data
+ *   remove-tree <tombstone>        same as --remove-tree
+ *   chown-file <file> container|manager
+ *                                  hand a file directly inside an agent dir to
+ *                                  the container user (0644) or back to the
+ *                                  connecting user (0664)
+ *
+ * Every request is logged to syslog (authpriv) with the peer's pid and uid.
+ *
+ * --serve-remote runs on remote agent hosts as the agent-host sidecar (see
+ * deployment/ciris-agent-host.service) so the manager can write files, provision
+ * agent directories, fix permissions and tail logs without starting a container
+ * or exec session through the Docker API. It is only built with
+ * -DCIRIS_AGENT_HOST (links OpenSSL and pthreads), into a separate binary that
+ * is installed without the setuid bit:
+ *
+ *   gcc -DCIRIS_AGENT_HOST -o ciris-agent-host ciris-fix-permissions.c \
+ *       -lssl -lcrypto -pthread
+ *   ciris-agent-host --serve-remote 10.2.96.4:2378 CA CERT KEY
+ *
+ * Clients are authenticated with mutual TLS against CA, normally the Docker
+ * API's own CA and server certificate, so the manager's Docker client
+ * certificate is the only credential. Requests are multiplexed on one
+ * connection: each frame is "<id> <op> <path> <arg|-> <length>\n" followed by
+ * <length> body bytes, every request runs on its own thread, and responses
+ * ("<id> OK|ERR <length>\n" plus payload) are sent as they complete:
+ *
+ *   ping -                         payload is the protocol version
+ *   write-file <file> <mode>       atomically replace file with the body, owned
+ *                                  by 1000, creating missing parent directories
+ *   read-file <file>               payload is the file contents
+ *   provision-agent <agent-dir>    create the agent directory and its standard
+ *                                  subdirectories, owned by 1000
+ *   fix-perms <agent-dir>          same as the default mode
+ *   tail-log <file> <lines>        payload is the last lines of an agent log
+ *
+ * Files must be under /opt/ciris/agents/ (write-file and read-file also accept
+ * /home/ciris/shared/), and tail-log only reads from an agent's logs directory.
  *
  * Security notes:
  * - Only works on directories under /opt/ciris/agents/
+ * - --swap-data, --restore-data and --remove-tree may only be invoked by root or
+ *   the manager account (CIRIS_MANAGER_USER, default "ciris-manager")
+ * - --remove-tree only accepts ".data.reap-*" tombstones directly inside an agent dir
+ * - chown-file opens the file with O_NOFOLLOW below the agent directory's fd and
+ *   changes it with fchown/fchmod, so symlinks cannot redirect it
+ * - --serve must be started by root; peers are authenticated with SO_PEERCRED
+ * - --serve-remote must be started by root; peers need a certificate signed by CA
+ * - write-file walks its directory with O_NOFOLLOW and writes, chowns and renames
+ *   relative to that directory's fd
+ * - The -DCIRIS_AGENT_HOST build refuses to run setuid
  * - Sets ownership to uid 1000 (container user)
  * - Sets proper permissions for CIRIS requirements
  */
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -27,10 +100,54 @@
 #include <sys/types.h>
 #include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <linux/fs.h>
+#include <pwd.h>
+#include <signal.h>
+#include <syslog.h>
+
+#ifdef CIRIS_AGENT_HOST
+#include <limits.h>
+#include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <netinet/in.h>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#endif
 
 #define AGENT_BASE_PATH "/opt/ciris/agents/"
 #define CONTAINER_UID 1000
 #define CONTAINER_GID 1000
+#define REAP_PREFIX ".data.reap-"
+#define GOLDEN_DIR ".data.golden"
+#define MAX_REQUEST 1024
+
+// Only this account (and root) may use the destructive command line modes
+#ifndef CIRIS_MANAGER_USER
+#define CIRIS_MANAGER_USER "ciris-manager"
+#endif
+
+struct agent_subdir {
+    const char* name;
+    mode_t mode;
+};
+
+// Standard agent directories and their CIRIS-required permissions
+static const struct agent_subdir AGENT_SUBDIRS[] = {
+    {"data", 0755},       {"data_archive", 0755}, {"logs", 0755},
+    {"config", 0755},     {"audit_keys", 0700},   {".secrets", 0700},
+};
+#define AGENT_SUBDIR_COUNT (sizeof(AGENT_SUBDIRS) / sizeof(AGENT_SUBDIRS[0]))
+
+static int swap_sequence;
 
 int fix_directory_permissions_recursive(const char* path, mode_t dir_mode, mode_t file_mode) {
     // Set permissions on the directory itself
@@ -97,68 +214,1221 @@ int fix_directory_permissions(const char* path, mode_t mode) {
     return fix_directory_permissions_recursive(path, mode, file_mode);
 }
 
-int main(int argc, char *argv[]) {
-    if (argc != 2) {
-        fprintf(stderr, "Usage: %s /opt/ciris/agents/agent-id\n", argv[0]);
-        return 1;
+/*
+ * Validate that path is an existing directory under AGENT_BASE_PATH and does
+ * not try to escape it with "..".
+ */
+int validate_agent_path(const char* path) {
+    if (strncmp(path, AGENT_BASE_PATH, strlen(AGENT_BASE_PATH)) != 0) {
+        fprintf(stderr, "Error: Path must be under %s\n", AGENT_BASE_PATH);
+        return -1;
     }
 
-    const char* agent_dir = argv[1];
+    if (strstr(path, "..") != NULL) {
+        fprintf(stderr, "Error: Path must not contain '..'\n");
+        return -1;
+    }
 
-    // Security check: ensure path starts with /opt/ciris/agents/
-    if (strncmp(agent_dir, AGENT_BASE_PATH, strlen(AGENT_BASE_PATH)) != 0) {
-        fprintf(stderr, "Error: Path must be under %s\n", AGENT_BASE_PATH);
-        return 1;
+    struct stat st;
+    if (lstat(path, &st) != 0) {
+        fprintf(stderr, "Error: Directory %s does not exist\n", path);
+        return -1;
     }
 
-    // Check if directory exists
+    if (!S_ISDIR(st.st_mode)) {
+        fprintf(stderr, "Error: %s is not a directory\n", path);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Check that the real (invoking) user is root or the manager account.
+ *
+ * The binary is setuid root, so without this any local user could move aside,
+ * reset or delete another agent's data with --swap-data and friends.
+ */
+int caller_is_manager(void) {
+    uid_t uid = getuid();
+    if (uid == 0) {
+        return 0;
+    }
+
+    struct passwd* pw = getpwnam(CIRIS_MANAGER_USER);
+    if (pw == NULL || uid != pw->pw_uid || getgid() != pw->pw_gid) {
+        fprintf(stderr, "Error: Only root or %s may modify agent data\n", CIRIS_MANAGER_USER);
+        return -1;
+    }
+    return 0;
+}
+
+int remove_entry(const char* path, const struct stat* st, int type, struct FTW* ftw) {
+    (void)st;
+    (void)type;
+    (void)ftw;
+    if (remove(path) != 0 && errno != ENOENT) {
+        fprintf(stderr, "Failed to remove %s: %s\n", path, strerror(errno));
+    }
+    return 0;
+}
+
+/*
+ * Copy one regular file, sharing extents with the source when possible.
+ */
+int clone_file(const char* src, const char* dst, mode_t mode) {
+    int in = open(src, O_RDONLY | O_NOFOLLOW);
+    if (in < 0) {
+        fprintf(stderr, "Failed to open %s: %s\n", src, strerror(errno));
+        return -1;
+    }
+
+    int out = open(dst, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW, mode & 0777);
+    if (out < 0) {
+        fprintf(stderr, "Failed to create %s: %s\n", dst, strerror(errno));
+        close(in);
+        return -1;
+    }
+
+    int result = 0;
+    if (ioctl(out, FICLONE, in) != 0) {
+        // No reflink support (ext4, cross-device) - copy in the kernel instead
+        ssize_t n;
+        while ((n = copy_file_range(in, NULL, out, NULL, 1 << 30, 0)) > 0) {
+        }
+        if (n < 0) {
+            char buf[65536];
+            ssize_t r;
+            lseek(in, 0, SEEK_SET);
+            lseek(out, 0, SEEK_SET);
+            while ((r = read(in, buf, sizeof(buf))) > 0) {
+                if (write(out, buf, r) != r) {
+                    r = -1;
+                    break;
+                }
+            }
+            if (r < 0) {
+                fprintf(stderr, "Failed to copy %s: %s\n", src, strerror(errno));
+                result = -1;
+            }
+        }
+    }
+
+    if (fchown(out, CONTAINER_UID, CONTAINER_GID) != 0) {
+        result = -1;
+    }
+    close(out);
+    close(in);
+    return result;
+}
+
+static const char* clone_src_root;
+static const char* clone_dst_root;
+static int clone_failed;
+
+int clone_entry(const char* path, const struct stat* st, int type, struct FTW* ftw) {
+    (void)ftw;
+    char dst[1024];
+    const char* rel = path + strlen(clone_src_root);
+
+    if (*rel == '\0') {
+        return 0;  // Root is created by the caller
+    }
+    snprintf(dst, sizeof(dst), "%s%s", clone_dst_root, rel);
+
+    if (type == FTW_D) {
+        if (mkdir(dst, st->st_mode & 0777) != 0 ||
+            chown(dst, CONTAINER_UID, CONTAINER_GID) != 0) {
+            fprintf(stderr, "Failed to create %s: %s\n", dst, strerror(errno));
+            clone_failed = 1;
+        }
+    } else if (type == FTW_F && S_ISREG(st->st_mode)) {
+        if (clone_file(path, dst, st->st_mode) != 0) {
+            clone_failed = 1;
+        }
+    }
+    // Symlinks and special files are never copied out of a snapshot
+    return 0;
+}
+
+/*
+ * Populate dst_dir with a copy of src_dir owned by the container user.
+ */
+int clone_tree(const char* src_dir, const char* dst_dir) {
+    clone_src_root = src_dir;
+    clone_dst_root = dst_dir;
+    clone_failed = 0;
+
+    if (nftw(src_dir, clone_entry, 64, FTW_PHYS) != 0) {
+        fprintf(stderr, "Failed to walk %s: %s\n", src_dir, strerror(errno));
+        return -1;
+    }
+    return clone_failed ? -1 : 0;
+}
+
+/*
+ * Swap in a fresh data directory for an agent.
+ *
+ * The new directory is created and chowned under a temporary name first, then
+ * exchanged with the live one, so "data" never disappears. The old tree ends up
+ * at a ".data.reap-*" tombstone whose path is written to out (empty if there was
+ * no data directory) for the caller to reap. With from_golden set, the fresh
+ * directory is a clone of the golden snapshot.
+ */
+int swap_data_directory(const char* agent_dir, int from_golden, char* out, size_t out_len) {
+    char data_path[512];
+    char fresh_path[512];
+    char reap_path[512];
+    char golden_path[512];
     struct stat st;
-    if (stat(agent_dir, &st) != 0) {
-        fprintf(stderr, "Error: Directory %s does not exist\n", agent_dir);
+
+    snprintf(data_path, sizeof(data_path), "%s/data", agent_dir);
+    snprintf(fresh_path, sizeof(fresh_path), "%s/.data.fresh-%d", agent_dir, (int)getpid());
+    snprintf(reap_path, sizeof(reap_path), "%s/" REAP_PREFIX "%ld-%d-%d", agent_dir,
+             (long)time(NULL), (int)getpid(), swap_sequence++);
+
+    if (mkdir(fresh_path, 0755) != 0) {
+        fprintf(stderr, "Failed to create %s: %s\n", fresh_path, strerror(errno));
+        return 1;
+    }
+    if (chown(fresh_path, CONTAINER_UID, CONTAINER_GID) != 0 || chmod(fresh_path, 0755) != 0) {
+        fprintf(stderr, "Failed to set ownership on %s: %s\n", fresh_path, strerror(errno));
+        rmdir(fresh_path);
         return 1;
     }
 
+    if (from_golden) {
+        snprintf(golden_path, sizeof(golden_path), "%s/" GOLDEN_DIR, agent_dir);
+        if (lstat(golden_path, &st) != 0 || !S_ISDIR(st.st_mode)) {
+            fprintf(stderr, "Error: No golden snapshot at %s\n", golden_path);
+            rmdir(fresh_path);
+            return 1;
+        }
+        if (clone_tree(golden_path, fresh_path) != 0) {
+            fprintf(stderr, "Failed to restore golden snapshot for %s\n", agent_dir);
+            nftw(fresh_path, remove_entry, 64, FTW_DEPTH | FTW_PHYS);
+            return 1;
+        }
+    }
+
+    if (lstat(data_path, &st) != 0) {
+        // No existing data directory - just move the fresh one into place
+        if (rename(fresh_path, data_path) != 0) {
+            fprintf(stderr, "Failed to create %s: %s\n", data_path, strerror(errno));
+            nftw(fresh_path, remove_entry, 64, FTW_DEPTH | FTW_PHYS);
+            return 1;
+        }
+        out[0] = '\0';
+        return 0;
+    }
+
     if (!S_ISDIR(st.st_mode)) {
-        fprintf(stderr, "Error: %s is not a directory\n", agent_dir);
+        fprintf(stderr, "Error: %s is not a directory\n", data_path);
+        nftw(fresh_path, remove_entry, 64, FTW_DEPTH | FTW_PHYS);
         return 1;
     }
 
-    // Set effective uid to root for permission changes
-    if (setuid(0) != 0) {
-        fprintf(stderr, "Error: Failed to escalate privileges\n");
+    // Atomically exchange fresh and live directories; the old tree lands on fresh_path
+    if (renameat2(AT_FDCWD, fresh_path, AT_FDCWD, data_path, RENAME_EXCHANGE) == 0) {
+        if (rename(fresh_path, reap_path) != 0) {
+            fprintf(stderr, "Failed to move old data aside: %s\n", strerror(errno));
+            return 1;
+        }
+    } else {
+        // Filesystem without RENAME_EXCHANGE - fall back to two renames
+        if (rename(data_path, reap_path) != 0) {
+            fprintf(stderr, "Failed to move %s aside: %s\n", data_path, strerror(errno));
+            nftw(fresh_path, remove_entry, 64, FTW_DEPTH | FTW_PHYS);
+            return 1;
+        }
+        if (rename(fresh_path, data_path) != 0) {
+            fprintf(stderr, "Failed to install fresh data dir: %s\n", strerror(errno));
+            rename(reap_path, data_path);
+            nftw(fresh_path, remove_entry, 64, FTW_DEPTH | FTW_PHYS);
+            return 1;
+        }
+    }
+
+    snprintf(out, out_len, "%s", reap_path);
+    return 0;
+}
+
+/*
+ * Remove a tombstone left behind by --swap-data.
+ *
+ * Only paths of the form AGENT_BASE_PATH/<agent-id>/.data.reap-* are accepted.
+ */
+int remove_reaped_tree(const char* tree_path) {
+    const char* rel = tree_path + strlen(AGENT_BASE_PATH);
+    const char* slash = strchr(rel, '/');
+
+    if (slash == NULL || slash == rel ||
+        strncmp(slash + 1, REAP_PREFIX, strlen(REAP_PREFIX)) != 0 ||
+        strchr(slash + 1, '/') != NULL) {
+        fprintf(stderr, "Error: %s is not a reapable data tombstone\n", tree_path);
+        return 1;
+    }
+
+    if (nftw(tree_path, remove_entry, 64, FTW_DEPTH | FTW_PHYS) != 0) {
+        fprintf(stderr, "Failed to remove %s: %s\n", tree_path, strerror(errno));
         return 1;
     }
 
-    // Fix permissions for standard directories
+    return 0;
+}
+
+/*
+ * Fix ownership and permissions of an agent's standard directories.
+ */
+int fix_agent_permissions(const char* agent_dir) {
     char path[512];
     int failed = 0;
 
-    // data directory - 755
-    snprintf(path, sizeof(path), "%s/data", agent_dir);
-    if (fix_directory_permissions(path, 0755) != 0) failed = 1;
+    for (size_t i = 0; i < AGENT_SUBDIR_COUNT; i++) {
+        snprintf(path, sizeof(path), "%s/%s", agent_dir, AGENT_SUBDIRS[i].name);
+        if (fix_directory_permissions(path, AGENT_SUBDIRS[i].mode) != 0) failed = 1;
+    }
 
-    // data_archive directory - 755
-    snprintf(path, sizeof(path), "%s/data_archive", agent_dir);
-    if (fix_directory_permissions(path, 0755) != 0) failed = 1;
+    if (failed) {
+        fprintf(stderr, "Some permissions could not be fixed\n");
+        return 1;
+    }
+    return 0;
+}
 
-    // logs directory - 755
-    snprintf(path, sizeof(path), "%s/logs", agent_dir);
-    if (fix_directory_permissions(path, 0755) != 0) failed = 1;
+/*
+ * Create an agent's standard directories (if missing) owned by the container user.
+ */
+int create_agent_directories(const char* agent_dir) {
+    char path[512];
 
-    // config directory - 755
-    snprintf(path, sizeof(path), "%s/config", agent_dir);
-    if (fix_directory_permissions(path, 0755) != 0) failed = 1;
+    for (size_t i = 0; i < AGENT_SUBDIR_COUNT; i++) {
+        snprintf(path, sizeof(path), "%s/%s", agent_dir, AGENT_SUBDIRS[i].name);
+        if (mkdir(path, AGENT_SUBDIRS[i].mode) != 0 && errno != EEXIST) {
+            fprintf(stderr, "Failed to create %s: %s\n", path, strerror(errno));
+            return 1;
+        }
+    }
 
-    // audit_keys directory - 700
-    snprintf(path, sizeof(path), "%s/audit_keys", agent_dir);
-    if (fix_directory_permissions(path, 0700) != 0) failed = 1;
+    snprintf(path, sizeof(path), "%s/init_permissions.sh", agent_dir);
+    if (lchown(path, CONTAINER_UID, CONTAINER_GID) != 0 && errno != ENOENT) {
+        fprintf(stderr, "Failed to chown %s: %s\n", path, strerror(errno));
+    }
 
-    // .secrets directory - 700
-    snprintf(path, sizeof(path), "%s/.secrets", agent_dir);
-    if (fix_directory_permissions(path, 0700) != 0) failed = 1;
+    return fix_agent_permissions(agent_dir);
+}
 
-    if (failed) {
-        fprintf(stderr, "Some permissions could not be fixed\n");
+/*
+ * Change ownership of a regular file directly inside an agent directory.
+ *
+ * The file is opened relative to an O_DIRECTORY handle on the agent directory
+ * with O_NOFOLLOW and changed through its descriptor, so neither a symlinked
+ * path component nor a swap after the checks can redirect the root chown.
+ */
+int chown_agent_file(const char* file_path, uid_t uid, gid_t gid, mode_t mode) {
+    char agent[256];
+    const char* rel = file_path + strlen(AGENT_BASE_PATH);
+    const char* name;
+    struct stat st;
+    int base_fd = -1, agent_fd = -1, fd = -1, rc = 1;
+
+    if (strncmp(file_path, AGENT_BASE_PATH, strlen(AGENT_BASE_PATH)) != 0 ||
+        strstr(file_path, "..") != NULL) {
+        fprintf(stderr, "Error: Path must be under %s\n", AGENT_BASE_PATH);
+        return 1;
+    }
+    name = strchr(rel, '/');
+    if (name == NULL || name == rel || (size_t)(name - rel) >= sizeof(agent) ||
+        name[1] == '\0' || strchr(name + 1, '/') != NULL) {
+        fprintf(stderr, "Error: %s is not a file directly inside an agent directory\n", file_path);
+        return 1;
+    }
+    memcpy(agent, rel, name - rel);
+    agent[name - rel] = '\0';
+    name++;
+
+    base_fd = open(AGENT_BASE_PATH, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (base_fd >= 0) {
+        agent_fd = openat(base_fd, agent, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    }
+    if (agent_fd >= 0) {
+        // O_NONBLOCK so a FIFO planted in place of the file cannot stall the broker
+        fd = openat(agent_fd, name, O_RDONLY | O_NOFOLLOW | O_NONBLOCK | O_CLOEXEC);
+    }
+    if (fd < 0) {
+        fprintf(stderr, "Error: cannot open %s: %s\n", file_path, strerror(errno));
+    } else if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        fprintf(stderr, "Error: %s is not a regular file\n", file_path);
+        errno = EINVAL;
+    } else if (fchown(fd, uid, gid) != 0 || fchmod(fd, mode) != 0) {
+        fprintf(stderr, "Failed to set ownership on %s: %s\n", file_path, strerror(errno));
+    } else {
+        rc = 0;
+    }
+
+    int saved = errno;
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (agent_fd >= 0) {
+        close(agent_fd);
+    }
+    if (base_fd >= 0) {
+        close(base_fd);
+    }
+    errno = saved;
+    return rc;
+}
+
+/*
+ * Execute one broker request and write the response line into response.
+ */
+void handle_request(char* line, const struct ucred* peer, gid_t peer_gid, char* response,
+                    size_t response_len) {
+    char* saveptr = NULL;
+    char* op = strtok_r(line, " \t\r\n", &saveptr);
+    char* path = strtok_r(NULL, " \t\r\n", &saveptr);
+    char* arg = strtok_r(NULL, " \t\r\n", &saveptr);
+    char payload[512] = "";
+    int rc;
+
+    if (op == NULL || path == NULL) {
+        snprintf(response, response_len, "ERR malformed request\n");
+        return;
+    }
+
+    errno = 0;
+    if (strcmp(op, "chown-file") == 0) {
+        if (arg != NULL && strcmp(arg, "container") == 0) {
+            rc = chown_agent_file(path, CONTAINER_UID, CONTAINER_GID, 0644);
+        } else if (arg != NULL && strcmp(arg, "manager") == 0) {
+            rc = chown_agent_file(path, peer->uid, peer_gid, 0664);
+        } else {
+            snprintf(response, response_len, "ERR chown-file needs container|manager\n");
+            return;
+        }
+    } else if (validate_agent_path(path) != 0) {
+        rc = 1;
+    } else if (strcmp(op, "fix-perms") == 0) {
+        rc = fix_agent_permissions(path);
+    } else if (strcmp(op, "create-agent-dirs") == 0) {
+        rc = create_agent_directories(path);
+    } else if (strcmp(op, "swap-dir") == 0) {
+        rc = swap_data_directory(path, 0, payload, sizeof(payload));
+    } else if (strcmp(op, "restore-dir") == 0) {
+        rc = swap_data_directory(path, 1, payload, sizeof(payload));
+    } else if (strcmp(op, "remove-tree") == 0) {
+        rc = remove_reaped_tree(path);
+    } else {
+        snprintf(response, response_len, "ERR unknown operation %s\n", op);
+        syslog(LOG_WARNING, "pid=%d uid=%d rejected unknown op=%s", (int)peer->pid,
+               (int)peer->uid, op);
+        return;
+    }
+
+    syslog(rc == 0 ? LOG_INFO : LOG_WARNING, "pid=%d uid=%d op=%s path=%s result=%s",
+           (int)peer->pid, (int)peer->uid, op, path, rc == 0 ? "ok" : "error");
+
+    if (rc == 0) {
+        snprintf(response, response_len, "OK %s\n", payload);
+    } else {
+        snprintf(response, response_len, "ERR %s failed: %s\n", op,
+                 errno ? strerror(errno) : "see broker log");
+    }
+}
+
+/*
+ * Serve requests from one connected client until it disconnects.
+ */
+void serve_connection(int fd, const struct ucred* peer, gid_t peer_gid) {
+    FILE* in = fdopen(fd, "r");
+    char line[MAX_REQUEST];
+    char response[MAX_REQUEST];
+
+    if (in == NULL) {
+        close(fd);
+        return;
+    }
+
+    while (fgets(line, sizeof(line), in) != NULL) {
+        // A line without its newline was cut off (or the peer hung up mid-request);
+        // never act on a truncated path, and drop the connection since the rest of
+        // the line would be read as another request
+        int truncated = strchr(line, '\n') == NULL;
+        if (truncated) {
+            syslog(LOG_WARNING, "pid=%d uid=%d rejected unterminated request", (int)peer->pid,
+                   (int)peer->uid);
+            snprintf(response, sizeof(response), "ERR request too long or unterminated\n");
+        } else {
+            handle_request(line, peer, peer_gid, response, sizeof(response));
+        }
+        size_t len = strlen(response);
+        if (write(fd, response, len) != (ssize_t)len || truncated) {
+            break;
+        }
+    }
+    fclose(in);
+}
+
+/*
+ * Run as a persistent broker on a unix socket, accepting only allowed_user (and root).
+ */
+int serve(const char* socket_path, const char* allowed_user) {
+    struct passwd* pw = getpwnam(allowed_user);
+    struct sockaddr_un addr;
+
+    if (getuid() != 0) {
+        fprintf(stderr, "Error: --serve must be started by root\n");
+        return 1;
+    }
+    if (pw == NULL) {
+        fprintf(stderr, "Error: Unknown user %s\n", allowed_user);
+        return 1;
+    }
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Error: Socket path too long\n");
+        return 1;
+    }
+
+    int server = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (server < 0) {
+        fprintf(stderr, "Failed to create socket: %s\n", strerror(errno));
+        return 1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path);
+    unlink(socket_path);
+
+    if (bind(server, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        chown(socket_path, 0, pw->pw_gid) != 0 || chmod(socket_path, 0660) != 0 ||
+        listen(server, 16) != 0) {
+        fprintf(stderr, "Failed to listen on %s: %s\n", socket_path, strerror(errno));
+        return 1;
+    }
+
+    // Children handle one client each; let the kernel reap them
+    signal(SIGCHLD, SIG_IGN);
+    openlog("ciris-privileged-broker", LOG_PID, LOG_AUTHPRIV);
+    syslog(LOG_INFO, "listening on %s for user %s", socket_path, allowed_user);
+
+    for (;;) {
+        int client = accept(server, NULL, NULL);
+        if (client < 0) {
+            if (errno == EINTR) continue;
+            syslog(LOG_ERR, "accept failed: %s", strerror(errno));
+            continue;
+        }
+
+        struct ucred peer;
+        socklen_t peer_len = sizeof(peer);
+        if (getsockopt(client, SOL_SOCKET, SO_PEERCRED, &peer, &peer_len) != 0 ||
+            (peer.uid != 0 && peer.uid != pw->pw_uid)) {
+            syslog(LOG_WARNING, "rejected connection from pid=%d uid=%d", (int)peer.pid,
+                   (int)peer.uid);
+            close(client);
+            continue;
+        }
+
+        pid_t child = fork();
+        if (child == 0) {
+            close(server);
+            serve_connection(client, &peer, pw->pw_gid);
+            _exit(0);
+        }
+        close(client);
+    }
+}
+
+#ifdef CIRIS_AGENT_HOST
+
+#define SHARED_BASE_PATH "/home/ciris/shared/"
+#define HOST_PROTOCOL "ciris-agent-host 1"
+#define HOST_MAX_BODY (8 * 1024 * 1024)
+#define HOST_MAX_INFLIGHT 16
+#define HOST_MAX_TAIL_LINES 10000
+#define HOST_HANDSHAKE_TIMEOUT 10
+
+struct host_buf {
+    char* data;
+    size_t len;
+    size_t cap;
+};
+
+// One queued response frame
+struct host_frame {
+    struct host_frame* next;
+    size_t len;
+    size_t sent;
+    char data[];
+};
+
+// State shared between a connection's I/O loop and its request threads
+struct host_conn {
+    int wake[2];
+    pthread_mutex_t lock;
+    struct host_frame* out_head;
+    struct host_frame* out_tail;
+    int inflight;
+    const char* peer;
+};
+
+struct host_request {
+    struct host_conn* conn;
+    unsigned long id;
+    char op[32];
+    char path[512];
+    char arg[64];
+    char* body;
+    size_t len;
+};
+
+int buf_append(struct host_buf* buf, const char* data, size_t len) {
+    if (buf->len + len > buf->cap) {
+        size_t cap = buf->cap ? buf->cap : 4096;
+        while (cap < buf->len + len) cap *= 2;
+        char* grown = realloc(buf->data, cap);
+        if (grown == NULL) return -1;
+        buf->data = grown;
+        buf->cap = cap;
+    }
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+    return 0;
+}
+
+int host_fail(char* err, size_t err_len, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(err, err_len, fmt, args);
+    va_end(args);
+    return -1;
+}
+
+/*
+ * Check that path is under the agent base (or the shared directory when allowed).
+ */
+int host_path_allowed(const char* path, int allow_shared) {
+    if (strstr(path, "..") != NULL) return 0;
+    if (strncmp(path, AGENT_BASE_PATH, strlen(AGENT_BASE_PATH)) == 0) return 1;
+    return allow_shared && strncmp(path, SHARED_BASE_PATH, strlen(SHARED_BASE_PATH)) == 0;
+}
+
+/*
+ * Same check after resolving symlinks, so a link cannot point outside the base.
+ */
+int host_resolved_allowed(const char* path, int allow_shared, char* resolved) {
+    char real[PATH_MAX + 2];
+    if (realpath(path, real) == NULL) return 0;
+    if (resolved != NULL) strcpy(resolved, real);
+    strcat(real, "/");
+    return host_path_allowed(real, allow_shared);
+}
+
+/*
+ * Open dir (creating missing directories for the container user) without
+ * following symlinks, after checking its deepest existing ancestor against the
+ * allowlist. The ancestor is resolved once with realpath and then walked from
+ * "/" with O_NOFOLLOW, so a component swapped for a symlink fails the open
+ * instead of leading outside the base. Returns a directory fd or -1.
+ */
+int host_open_dir(const char* dir, int allow_shared, char* err, size_t err_len) {
+    char probe[512];
+    char walk[PATH_MAX + 520];
+    struct stat st;
+    snprintf(probe, sizeof(probe), "%s", dir);
+
+    // lstat: a dangling symlink counts as existing and then fails to resolve
+    while (lstat(probe, &st) != 0) {
+        char* slash = strrchr(probe, '/');
+        if (errno != ENOENT || slash == NULL || slash == probe) {
+            return host_fail(err, err_len, "path not allowed: %s", dir);
+        }
+        *slash = '\0';
+    }
+    if (!host_resolved_allowed(probe, allow_shared, walk)) {
+        return host_fail(err, err_len, "path not allowed: %s", dir);
+    }
+    strcat(walk, dir + strlen(probe));
+
+    int fd = open("/", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    char* saveptr = NULL;
+    for (char* part = strtok_r(walk, "/", &saveptr); part != NULL && fd >= 0;
+         part = strtok_r(NULL, "/", &saveptr)) {
+        int next = openat(fd, part, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (next < 0 && errno == ENOENT) {
+            if (mkdirat(fd, part, 0755) != 0 && errno != EEXIST) {
+                close(fd);
+                return host_fail(err, err_len, "cannot create %s: %s", dir, strerror(errno));
+            }
+            next = openat(fd, part, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            if (next >= 0 && fchown(next, CONTAINER_UID, CONTAINER_GID) != 0) {
+                close(next);
+                next = -1;
+            }
+        }
+        close(fd);
+        fd = next;
+    }
+    if (fd < 0) return host_fail(err, err_len, "cannot open %s: %s", dir, strerror(errno));
+    return fd;
+}
+
+int host_write_file(const struct host_request* req, char* err, size_t err_len) {
+    char dir[512];
+    char tmp[640];
+    char* end;
+    long mode = strtol(req->arg, &end, 8);
+
+    if (*end != '\0' || mode <= 0 || mode > 0777) {
+        return host_fail(err, err_len, "invalid mode %s", req->arg);
+    }
+    if (!host_path_allowed(req->path, 1)) {
+        return host_fail(err, err_len, "path not allowed: %s", req->path);
+    }
+
+    snprintf(dir, sizeof(dir), "%s", req->path);
+    char* name = strrchr(dir, '/');
+    *name++ = '\0';
+    if (*name == '\0') return host_fail(err, err_len, "missing file name");
+
+    // Everything below happens relative to this one directory handle
+    int dir_fd = host_open_dir(dir, 1, err, err_len);
+    if (dir_fd < 0) return -1;
+
+    snprintf(tmp, sizeof(tmp), ".%s.tmp-%d-%lu", name, (int)getpid(), req->id);
+    int fd = openat(dir_fd, tmp, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC,
+                    (mode_t)mode);
+    if (fd < 0) {
+        host_fail(err, err_len, "cannot create %s/%s: %s", dir, tmp, strerror(errno));
+        close(dir_fd);
+        return -1;
+    }
+
+    size_t written = 0;
+    while (written < req->len) {
+        ssize_t n = write(fd, req->body + written, req->len - written);
+        if (n < 0) break;
+        written += (size_t)n;
+    }
+    if (written != req->len || fchown(fd, CONTAINER_UID, CONTAINER_GID) != 0 ||
+        fchmod(fd, (mode_t)mode) != 0 || fsync(fd) != 0) {
+        host_fail(err, err_len, "cannot write %s/%s: %s", dir, tmp, strerror(errno));
+        close(fd);
+        unlinkat(dir_fd, tmp, 0);
+        close(dir_fd);
+        return -1;
+    }
+    close(fd);
+
+    if (renameat(dir_fd, tmp, dir_fd, name) != 0) {
+        host_fail(err, err_len, "cannot replace %s: %s", req->path, strerror(errno));
+        unlinkat(dir_fd, tmp, 0);
+        close(dir_fd);
+        return -1;
+    }
+    close(dir_fd);
+    return 0;
+}
+
+int host_read_file(const struct host_request* req, struct host_buf* out, char* err,
+                   size_t err_len) {
+    char resolved[PATH_MAX + 1];
+    char chunk[65536];
+    struct stat st;
+
+    if (!host_path_allowed(req->path, 1) || !host_resolved_allowed(req->path, 1, resolved)) {
+        return host_fail(err, err_len, "path not allowed: %s", req->path);
+    }
+
+    int fd = open(resolved, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return host_fail(err, err_len, "cannot open %s: %s", req->path, strerror(errno));
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size > HOST_MAX_BODY) {
+        close(fd);
+        return host_fail(err, err_len, "%s is not a regular file under %d bytes", req->path,
+                         HOST_MAX_BODY);
+    }
+
+    ssize_t n;
+    while ((n = read(fd, chunk, sizeof(chunk))) > 0) {
+        if (buf_append(out, chunk, (size_t)n) != 0) {
+            n = -1;
+            break;
+        }
+    }
+    close(fd);
+    return n < 0 ? host_fail(err, err_len, "cannot read %s", req->path) : 0;
+}
+
+/*
+ * Return the last lines of a log file, reading backwards from the end.
+ */
+int host_tail_log(const struct host_request* req, struct host_buf* out, char* err,
+                  size_t err_len) {
+    char resolved[PATH_MAX + 1];
+    struct stat st;
+    long lines = strtol(req->arg, NULL, 10);
+
+    if (lines <= 0 || lines > HOST_MAX_TAIL_LINES) {
+        return host_fail(err, err_len, "lines must be 1-%d", HOST_MAX_TAIL_LINES);
+    }
+    if (!host_path_allowed(req->path, 0) || !host_resolved_allowed(req->path, 0, resolved) ||
+        strstr(resolved, "/logs/") == NULL) {
+        return host_fail(err, err_len, "not an agent log: %s", req->path);
+    }
+
+    int fd = open(resolved, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return host_fail(err, err_len, "cannot open %s: %s", req->path, strerror(errno));
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return host_fail(err, err_len, "%s is not a regular file", req->path);
+    }
+
+    // Grow the window from the end until it holds enough lines (or the whole file)
+    off_t size = st.st_size;
+    off_t window = size < 65536 ? size : 65536;
+    char* data = NULL;
+    off_t start = 0;
+    for (;;) {
+        char* grown = realloc(data, (size_t)window);
+        if (grown == NULL && window > 0) {
+            free(data);
+            close(fd);
+            return host_fail(err, err_len, "out of memory");
+        }
+        data = grown;
+        if (pread(fd, data, (size_t)window, size - window) != (ssize_t)window) {
+            free(data);
+            close(fd);
+            return host_fail(err, err_len, "cannot read %s", req->path);
+        }
+
+        long seen = 0;
+        off_t pos = window;
+        if (pos > 0 && data[pos - 1] == '\n') pos--;
+        while (pos > 0) {
+            if (data[pos - 1] == '\n' && ++seen == lines) break;
+            pos--;
+        }
+        start = pos;
+        if (seen == lines || window == size || window >= HOST_MAX_BODY) break;
+        window = window * 4 > size ? size : window * 4;
+        if (window > HOST_MAX_BODY) window = HOST_MAX_BODY;
+    }
+    close(fd);
+
+    int rc = buf_append(out, data + start, (size_t)(window - start));
+    free(data);
+    return rc == 0 ? 0 : host_fail(err, err_len, "out of memory");
+}
+
+/*
+ * Create /opt/ciris/agents/<agent-id> and its standard subdirectories.
+ */
+int host_provision_agent(const char* agent_dir, char* err, size_t err_len) {
+    const char* agent_id = agent_dir + strlen(AGENT_BASE_PATH);
+
+    if (!host_path_allowed(agent_dir, 0) || *agent_id == '\0' || strchr(agent_id, '/') != NULL) {
+        return host_fail(err, err_len, "not an agent directory: %s", agent_dir);
+    }
+    if (mkdir(agent_dir, 0755) != 0 && errno != EEXIST) {
+        return host_fail(err, err_len, "cannot create %s: %s", agent_dir, strerror(errno));
+    }
+    if (validate_agent_path(agent_dir) != 0 ||
+        chown(agent_dir, CONTAINER_UID, CONTAINER_GID) != 0 ||
+        create_agent_directories(agent_dir) != 0) {
+        return host_fail(err, err_len, "provisioning %s failed: %s", agent_dir,
+                         errno ? strerror(errno) : "see agent host log");
+    }
+    return 0;
+}
+
+int host_execute(const struct host_request* req, struct host_buf* out, char* err,
+                 size_t err_len) {
+    errno = 0;
+    if (strcmp(req->op, "ping") == 0) {
+        return buf_append(out, HOST_PROTOCOL, strlen(HOST_PROTOCOL));
+    }
+    if (strcmp(req->op, "write-file") == 0) return host_write_file(req, err, err_len);
+    if (strcmp(req->op, "read-file") == 0) return host_read_file(req, out, err, err_len);
+    if (strcmp(req->op, "tail-log") == 0) return host_tail_log(req, out, err, err_len);
+    if (strcmp(req->op, "provision-agent") == 0) {
+        return host_provision_agent(req->path, err, err_len);
+    }
+    if (strcmp(req->op, "fix-perms") == 0) {
+        if (validate_agent_path(req->path) != 0 || fix_agent_permissions(req->path) != 0) {
+            return host_fail(err, err_len, "fix-perms failed: %s",
+                             errno ? strerror(errno) : "see agent host log");
+        }
+        return 0;
+    }
+    return host_fail(err, err_len, "unknown operation %s", req->op);
+}
+
+/*
+ * Queue a response frame and wake the connection's I/O loop.
+ */
+void host_respond(struct host_conn* conn, unsigned long id, int ok, const char* payload,
+                  size_t len) {
+    char header[64];
+    int header_len = snprintf(header, sizeof(header), "%lu %s %zu\n", id, ok ? "OK" : "ERR", len);
+    struct host_frame* frame = malloc(sizeof(*frame) + (size_t)header_len + len);
+    if (frame == NULL) return;
+
+    frame->next = NULL;
+    frame->len = (size_t)header_len + len;
+    frame->sent = 0;
+    memcpy(frame->data, header, (size_t)header_len);
+    if (len) memcpy(frame->data + header_len, payload, len);
+
+    pthread_mutex_lock(&conn->lock);
+    if (conn->out_tail) {
+        conn->out_tail->next = frame;
+    } else {
+        conn->out_head = frame;
+    }
+    conn->out_tail = frame;
+    pthread_mutex_unlock(&conn->lock);
+
+    if (write(conn->wake[1], "x", 1) < 0 && errno != EAGAIN) {
+        syslog(LOG_WARNING, "wake-up failed: %s", strerror(errno));
+    }
+}
+
+void* host_worker(void* arg) {
+    struct host_request* req = arg;
+    struct host_buf out = {0};
+    char err[512] = "";
+
+    int rc = host_execute(req, &out, err, sizeof(err));
+    syslog(rc == 0 ? LOG_INFO : LOG_WARNING, "peer=%s op=%s path=%s result=%s", req->conn->peer,
+           req->op, req->path, rc == 0 ? "ok" : err);
+    if (rc == 0) {
+        host_respond(req->conn, req->id, 1, out.data, out.len);
+    } else {
+        host_respond(req->conn, req->id, 0, err, strlen(err));
+    }
+
+    pthread_mutex_lock(&req->conn->lock);
+    req->conn->inflight--;
+    pthread_mutex_unlock(&req->conn->lock);
+
+    free(out.data);
+    free(req->body);
+    free(req);
+    return NULL;
+}
+
+/*
+ * Parse one request header line; the body follows it on the stream.
+ */
+int host_parse_header(const char* line, struct host_request* req) {
+    char arg[64];
+    if (sscanf(line, "%lu %31s %511s %63s %zu", &req->id, req->op, req->path, arg, &req->len) !=
+        5) {
+        return -1;
+    }
+    snprintf(req->arg, sizeof(req->arg), "%s", strcmp(arg, "-") == 0 ? "" : arg);
+    return req->len > HOST_MAX_BODY ? -1 : 0;
+}
+
+/*
+ * Start a request on its own thread (or reject it if too many are in flight).
+ */
+void host_dispatch(struct host_conn* conn, struct host_request* parsed, const char* body) {
+    struct host_request* req = malloc(sizeof(*req));
+    pthread_t thread;
+    pthread_attr_t attr;
+
+    if (req != NULL) {
+        *req = *parsed;
+        req->conn = conn;
+        req->body = malloc(parsed->len + 1);
+    }
+    if (req == NULL || req->body == NULL) {
+        if (req) free(req);
+        host_respond(conn, parsed->id, 0, "out of memory", 13);
+        return;
+    }
+    memcpy(req->body, body, parsed->len);
+
+    pthread_mutex_lock(&conn->lock);
+    int busy = conn->inflight >= HOST_MAX_INFLIGHT;
+    if (!busy) conn->inflight++;
+    pthread_mutex_unlock(&conn->lock);
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (busy || pthread_create(&thread, &attr, host_worker, req) != 0) {
+        if (!busy) {
+            pthread_mutex_lock(&conn->lock);
+            conn->inflight--;
+            pthread_mutex_unlock(&conn->lock);
+        }
+        host_respond(conn, req->id, 0, "busy", 4);
+        free(req->body);
+        free(req);
+    }
+    pthread_attr_destroy(&attr);
+}
+
+/*
+ * Serve one authenticated client: read frames, start requests, send responses.
+ *
+ * All TLS I/O happens on this thread; request threads only queue responses.
+ */
+void host_serve_connection(SSL* ssl, int fd, const char* peer) {
+    struct host_conn conn = {.lock = PTHREAD_MUTEX_INITIALIZER, .peer = peer};
+    struct host_buf in = {0};
+    char chunk[65536];
+
+    if (pipe2(conn.wake, O_CLOEXEC | O_NONBLOCK) != 0) return;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    for (;;) {
+        struct pollfd fds[2] = {{fd, POLLIN, 0}, {conn.wake[0], POLLIN, 0}};
+        pthread_mutex_lock(&conn.lock);
+        if (conn.out_head) fds[0].events |= POLLOUT;
+        pthread_mutex_unlock(&conn.lock);
+
+        if (!SSL_pending(ssl) && poll(fds, 2, -1) < 0 && errno != EINTR) break;
+        while (read(conn.wake[0], chunk, sizeof(chunk)) > 0) {
+        }
+
+        // Read everything available
+        for (;;) {
+            int n = SSL_read(ssl, chunk, sizeof(chunk));
+            if (n > 0) {
+                if (buf_append(&in, chunk, (size_t)n) != 0) goto done;
+                continue;
+            }
+            int e = SSL_get_error(ssl, n);
+            if (e == SSL_ERROR_WANT_READ || e == SSL_ERROR_WANT_WRITE) break;
+            goto done;
+        }
+
+        // Start every complete request
+        size_t consumed = 0;
+        for (;;) {
+            char* line = in.data + consumed;
+            size_t avail = in.len - consumed;
+            char* newline = avail ? memchr(line, '\n', avail) : NULL;
+            if (newline == NULL) {
+                if (avail >= MAX_REQUEST) goto done;
+                break;
+            }
+
+            struct host_request req;
+            *newline = '\0';
+            if (newline - line >= MAX_REQUEST || host_parse_header(line, &req) != 0) {
+                syslog(LOG_WARNING, "peer=%s sent a malformed request", peer);
+                goto done;
+            }
+            size_t header_len = (size_t)(newline - line) + 1;
+            if (avail < header_len + req.len) {
+                *newline = '\n';
+                break;
+            }
+            host_dispatch(&conn, &req, newline + 1);
+            consumed += header_len + req.len;
+        }
+        memmove(in.data, in.data + consumed, in.len - consumed);
+        in.len -= consumed;
+
+        // Send queued responses
+        pthread_mutex_lock(&conn.lock);
+        while (conn.out_head) {
+            struct host_frame* frame = conn.out_head;
+            int n = SSL_write(ssl, frame->data + frame->sent, (int)(frame->len - frame->sent));
+            if (n <= 0) {
+                int e = SSL_get_error(ssl, n);
+                if (e == SSL_ERROR_WANT_READ || e == SSL_ERROR_WANT_WRITE) break;
+                pthread_mutex_unlock(&conn.lock);
+                goto done;
+            }
+            frame->sent += (size_t)n;
+            if (frame->sent == frame->len) {
+                conn.out_head = frame->next;
+                if (conn.out_head == NULL) conn.out_tail = NULL;
+                free(frame);
+            }
+        }
+        pthread_mutex_unlock(&conn.lock);
+    }
+
+done:
+    // Request threads still running die with this process
+    free(in.data);
+}
+
+/*
+ * Run as the remote agent-host sidecar on listen_addr (HOST:PORT) with mutual TLS.
+ */
+int serve_remote(const char* listen_addr, const char* ca, const char* cert, const char* key) {
+    char host[256];
+    const char* port = strrchr(listen_addr, ':');
+    struct addrinfo hints = {0};
+    struct addrinfo* addr = NULL;
+
+    if (getuid() != 0) {
+        fprintf(stderr, "Error: --serve-remote must be started by root\n");
+        return 1;
+    }
+    if (port == NULL || (size_t)(port - listen_addr) >= sizeof(host)) {
+        fprintf(stderr, "Error: Listen address must be HOST:PORT\n");
+        return 1;
+    }
+    snprintf(host, sizeof(host), "%.*s", (int)(port - listen_addr), listen_addr);
+    port++;
+
+    SSL_CTX* ctx = SSL_CTX_new(TLS_server_method());
+    if (ctx == NULL || SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION) != 1 ||
+        SSL_CTX_use_certificate_chain_file(ctx, cert) != 1 ||
+        SSL_CTX_use_PrivateKey_file(ctx, key, SSL_FILETYPE_PEM) != 1 ||
+        SSL_CTX_check_private_key(ctx) != 1 || SSL_CTX_load_verify_locations(ctx, ca, NULL) != 1) {
+        fprintf(stderr, "Error: Could not load TLS certificates\n");
+        ERR_print_errors_fp(stderr);
+        return 1;
+    }
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT, NULL);
+    SSL_CTX_set_mode(ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    if (getaddrinfo(host, port, &hints, &addr) != 0) {
+        fprintf(stderr, "Error: Cannot resolve %s\n", listen_addr);
+        return 1;
+    }
+
+    int one = 1;
+    int server = socket(addr->ai_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (server < 0 || setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+        bind(server, addr->ai_addr, addr->ai_addrlen) != 0 || listen(server, 16) != 0) {
+        fprintf(stderr, "Failed to listen on %s: %s\n", listen_addr, strerror(errno));
+        return 1;
+    }
+    freeaddrinfo(addr);
+
+    // Children handle one client each; let the kernel reap them
+    signal(SIGCHLD, SIG_IGN);
+    signal(SIGPIPE, SIG_IGN);
+    openlog("ciris-agent-host", LOG_PID, LOG_AUTHPRIV);
+    syslog(LOG_INFO, "listening on %s", listen_addr);
+
+    for (;;) {
+        int client = accept(server, NULL, NULL);
+        if (client < 0) {
+            if (errno != EINTR) syslog(LOG_ERR, "accept failed: %s", strerror(errno));
+            continue;
+        }
+
+        pid_t child = fork();
+        if (child == 0) {
+            struct timeval timeout = {HOST_HANDSHAKE_TIMEOUT, 0};
+            char peer[256] = "unknown";
+            close(server);
+            setsockopt(client, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+            setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+            SSL* ssl = SSL_new(ctx);
+            SSL_set_fd(ssl, client);
+            if (SSL_accept(ssl) != 1) {
+                syslog(LOG_WARNING, "rejected connection: TLS handshake failed");
+                _exit(0);
+            }
+            X509* cert_peer = SSL_get_peer_certificate(ssl);
+            if (cert_peer != NULL) {
+                X509_NAME_get_text_by_NID(X509_get_subject_name(cert_peer), NID_commonName, peer,
+                                          sizeof(peer));
+                X509_free(cert_peer);
+            }
+            syslog(LOG_INFO, "accepted connection from %s", peer);
+
+            host_serve_connection(ssl, client, peer);
+            syslog(LOG_INFO, "connection from %s closed", peer);
+            _exit(0);
+        }
+        close(client);
+    }
+}
+
+#endif /* CIRIS_AGENT_HOST */
+
+int main(int argc, char *argv[]) {
+    const char* mode = NULL;
+    const char* agent_dir;
+
+#ifdef CIRIS_AGENT_HOST
+    // This build links OpenSSL and is started as root by systemd; never setuid
+    if (getuid() != geteuid() || getgid() != getegid()) {
+        fprintf(stderr, "Error: the agent-host build must not be installed setuid\n");
+        return 1;
+    }
+#endif
+
+    if (argc == 4 && strcmp(argv[1], "--serve") == 0) {
+        return serve(argv[2], argv[3]);
+    }
+#ifdef CIRIS_AGENT_HOST
+    if (argc == 6 && strcmp(argv[1], "--serve-remote") == 0) {
+        return serve_remote(argv[2], argv[3], argv[4], argv[5]);
+    }
+#endif
+
+    if (argc == 3 && argv[1][0] == '-') {
+        mode = argv[1];
+        agent_dir = argv[2];
+    } else if (argc == 2) {
+        agent_dir = argv[1];
+    } else {
+        fprintf(stderr,
+                "Usage: %s [--swap-data|--restore-data|--remove-tree] /opt/ciris/agents/agent-id\n"
+                "       %s --serve SOCKET_PATH USER\n"
+                "       %s --serve-remote HOST:PORT CA CERT KEY (built with CIRIS_AGENT_HOST)\n",
+                argv[0], argv[0], argv[0]);
+        return 1;
+    }
+
+    if (mode != NULL && strcmp(mode, "--swap-data") != 0 && strcmp(mode, "--restore-data") != 0 &&
+        strcmp(mode, "--remove-tree") != 0) {
+        fprintf(stderr, "Error: Unknown option %s\n", mode);
+        return 1;
+    }
+
+    // Security check: ensure path is an existing directory under /opt/ciris/agents/
+    if (validate_agent_path(agent_dir) != 0) {
+        return 1;
+    }
+
+    // Data-destroying modes are reserved for the manager; fixing permissions is not
+    if (mode != NULL && caller_is_manager() != 0) {
+        return 1;
+    }
+
+    // Set effective uid to root for permission changes
+    if (setuid(0) != 0) {
+        fprintf(stderr, "Error: Failed to escalate privileges\n");
+        return 1;
+    }
+
+    char tombstone[512];
+    if (mode != NULL && strcmp(mode, "--swap-data") == 0) {
+        int rc = swap_data_directory(agent_dir, 0, tombstone, sizeof(tombstone));
+        if (rc == 0) printf("%s\n", tombstone);
+        return rc;
+    }
+    if (mode != NULL && strcmp(mode, "--restore-data") == 0) {
+        int rc = swap_data_directory(agent_dir, 1, tombstone, sizeof(tombstone));
+        if (rc == 0) printf("%s\n", tombstone);
+        return rc;
+    }
+    if (mode != NULL && strcmp(mode, "--remove-tree") == 0) {
+        return remove_reaped_tree(agent_dir);
+    }
+
+    if (fix_agent_permissions(agent_dir) != 0) {
         return 1;
     }
 
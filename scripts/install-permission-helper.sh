@@ -1,9 +1,25 @@
 #!/bin/bash
 # Install CIRIS permission fix helper
 # This script must be run as root
+#
+# Usage: install-permission-helper.sh [--agent-host LISTEN_ADDR]
+#
+# --agent-host also builds the remote agent-host sidecar as a separate binary
+# (ciris-agent-host, not setuid) and runs it on LISTEN_ADDR (e.g. 10.2.96.4:2378)
+# using the Docker API TLS certificates. Use it on remote agent hosts; it needs
+# gcc and the OpenSSL headers.
 
 set -e
 
+AGENT_HOST_LISTEN=""
+if [ "$1" = "--agent-host" ]; then
+    if [ -z "$2" ]; then
+        echo "Usage: $0 [--agent-host LISTEN_ADDR]"
+        exit 1
+    fi
+    AGENT_HOST_LISTEN="$2"
+fi
+
 if [ "$EUID" -ne 0 ]; then
     echo "Please run as root (use sudo)"
     exit 1
@@ -13,6 +29,7 @@ SCRIPT_DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
 SOURCE_FILE="$SCRIPT_DIR/ciris-fix-permissions.c"
 BINARY_NAME="ciris-fix-permissions"
 INSTALL_PATH="/usr/local/bin/$BINARY_NAME"
+AGENT_HOST_PATH="/usr/local/bin/ciris-agent-host"
 
 echo "Installing CIRIS permission fix helper..."
 
@@ -22,7 +39,7 @@ if [ ! -f "$SOURCE_FILE" ]; then
     exit 1
 fi
 
-# Compile the helper
+# Compile the helper (never with the sidecar: OpenSSL stays out of the setuid binary)
 echo "Compiling $BINARY_NAME..."
 gcc -o "/tmp/$BINARY_NAME" "$SOURCE_FILE"
 
@@ -37,6 +54,34 @@ mv "/tmp/$BINARY_NAME" "$INSTALL_PATH"
 chown root:root "$INSTALL_PATH"
 chmod 4755 "$INSTALL_PATH"  # setuid bit + executable
 
+# Install and start the persistent privileged broker if systemd is available
+BROKER_UNIT="$SCRIPT_DIR/../deployment/ciris-privileged-broker.service"
+if command -v systemctl >/dev/null 2>&1 && [ -f "$BROKER_UNIT" ]; then
+    echo "Installing privileged broker service..."
+    cp "$BROKER_UNIT" /etc/systemd/system/
+    systemctl daemon-reload
+    systemctl enable ciris-privileged-broker
+    systemctl restart ciris-privileged-broker
+fi
+
+# Install and start the agent-host sidecar on remote agent hosts
+AGENT_HOST_UNIT="$SCRIPT_DIR/../deployment/ciris-agent-host.service"
+if [ -n "$AGENT_HOST_LISTEN" ] && [ -f "$AGENT_HOST_UNIT" ]; then
+    echo "Compiling agent host sidecar..."
+    gcc -DCIRIS_AGENT_HOST -o /tmp/ciris-agent-host "$SOURCE_FILE" -lssl -lcrypto -pthread
+    mv /tmp/ciris-agent-host "$AGENT_HOST_PATH"
+    chown root:root "$AGENT_HOST_PATH"
+    chmod 0755 "$AGENT_HOST_PATH"  # started as root by systemd, no setuid
+
+    echo "Installing agent host service on $AGENT_HOST_LISTEN..."
+    echo "CIRIS_AGENT_HOST_LISTEN=$AGENT_HOST_LISTEN" > /etc/ciris-agent-host.env
+    mkdir -p /home/ciris/shared
+    cp "$AGENT_HOST_UNIT" /etc/systemd/system/
+    systemctl daemon-reload
+    systemctl enable ciris-agent-host
+    systemctl restart ciris-agent-host
+fi
+
 echo "Testing installation..."
 if [ -x "$INSTALL_PATH" ]; then
     echo "✓ Helper installed successfully at $INSTALL_PATH"
@@ -11,6 +11,7 @@
 # - Sets up directory structure
 # - Generates TLS certificates for Docker API
 # - Configures firewall to restrict Docker API to VPC only
+# - Installs the agent-host sidecar (file operations for the manager, VPC only)
 # - Installs certbot and obtains Let's Encrypt SSL certificates
 # - Sets up automatic certificate renewal
 # - Deploys nginx container with SSL support
@@ -57,6 +58,11 @@ if ! ssh -i "$SSH_KEY" -o ConnectTimeout=5 root@"$PUBLIC_IP" 'echo "SSH OK"' >/d
 fi
 log_info "SSH access verified"
 
+# Upload the permission helper and agent-host unit for the sidecar
+SCRIPT_DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+scp -i "$SSH_KEY" "$SCRIPT_DIR/ciris-fix-permissions.c" \
+    "$SCRIPT_DIR/../deployment/ciris-agent-host.service" root@"$PUBLIC_IP":/tmp/
+
 # Execute remote setup
 ssh -i "$SSH_KEY" root@"$PUBLIC_IP" 'bash -s' <<EOF
 set -e
@@ -223,13 +229,32 @@ if command -v ufw &> /dev/null; then
     # IMPORTANT: ALLOW must come before DENY (UFW processes rules in order)
     ufw allow from 10.0.0.0/8 to any port 2376 proto tcp comment 'Docker API from VPC'
     ufw deny 2376/tcp comment 'Block Docker API from public'
+    ufw allow from 10.0.0.0/8 to any port 2378 proto tcp comment 'Agent host from VPC'
+    ufw deny 2378/tcp comment 'Block agent host from public'
 
     echo "✓ Firewall configured (Docker API restricted to VPC)"
     ufw status numbered
 else
-    echo "⚠ ufw not installed - manually configure firewall to restrict port 2376"
+    echo "⚠ ufw not installed - manually configure firewall to restrict ports 2376 and 2378"
 fi
 
+# 7b. Install the agent-host sidecar (mutual TLS with the Docker API certificates)
+echo "Installing agent host sidecar..."
+apt-get update -qq
+apt-get install -y -qq gcc libssl-dev
+# Separate binary without the setuid bit: systemd starts it as root
+gcc -DCIRIS_AGENT_HOST -o /usr/local/bin/ciris-agent-host /tmp/ciris-fix-permissions.c \
+    -lssl -lcrypto -pthread
+chown root:root /usr/local/bin/ciris-agent-host
+chmod 0755 /usr/local/bin/ciris-agent-host
+echo "CIRIS_AGENT_HOST_LISTEN=$VPC_IP:2378" > /etc/ciris-agent-host.env
+mv /tmp/ciris-agent-host.service /etc/systemd/system/
+rm -f /tmp/ciris-fix-permissions.c
+systemctl daemon-reload
+systemctl enable ciris-agent-host
+systemctl restart ciris-agent-host
+echo "✓ Agent host listening on $VPC_IP:2378"
+
 # 8. Test Docker API is working locally
 echo "Testing Docker API..."
 if docker -H unix:///var/run/docker.sock ps >/dev/null 2>&1; then
@@ -445,7 +470,8 @@ echo "Hostname: $HOSTNAME"
 echo "VPC IP: $VPC_IP"
 echo "Public IP: $PUBLIC_IP"
 echo "Docker API: tcp://$VPC_IP:2376 (TLS)"
-echo "Firewall: Port 2376 restricted to VPC (10.0.0.0/8)"
+echo "Agent host: $VPC_IP:2378 (TLS)"
+echo "Firewall: Ports 2376 and 2378 restricted to VPC (10.0.0.0/8)"
 echo "SSL: Let's Encrypt certificate installed"
 echo "Nginx: Container running with SSL support"
 echo ""
@@ -508,6 +534,7 @@ log_info "      docker_host: tcp://$VPC_IP:2376"
 log_info "      tls_ca: /etc/ciris-manager/docker-certs/$HOSTNAME/ca.pem"
 log_info "      tls_cert: /etc/ciris-manager/docker-certs/$HOSTNAME/client-cert.pem"
 log_info "      tls_key: /etc/ciris-manager/docker-certs/$HOSTNAME/client-key.pem"
+log_info "      agent_host_port: 2378"
 log_info ""
 log_info "After adding to config and restarting CIRISManager on main server:"
 log_info "  - Main CIRISManager will remotely manage agents on $HOSTNAME"
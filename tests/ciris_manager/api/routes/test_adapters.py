@@ -407,3 +407,126 @@ class TestRemoveAdapterConfig:
 
                 assert response.status_code == 404
                 assert "No configuration found" in response.json()["detail"]
+
+
+class TestFleetAdapterSync:
+    """Tests for POST /adapters/sync."""
+
+    @pytest.fixture
+    def mock_manager(self):
+        manager = Mock()
+        manager.config = Mock()
+        manager.config.running = True
+        manager.config.manager = Mock()
+        manager.config.manager.templates_directory = "/tmp/test-templates"
+        manager.agent_registry = Mock()
+        manager.agent_registry.list_agents = Mock(return_value=[])
+        manager.agent_registry.get_adapter_configs = Mock(return_value={"api": {}})
+        manager.agent_registry.set_adapter_configs_bulk = Mock(return_value=[])
+        manager.port_manager = Mock()
+        manager.docker_client = Mock()
+        server_config = Mock()
+        server_config.is_local = True
+        manager.docker_client.get_server_config = Mock(return_value=server_config)
+        return manager
+
+    @pytest.fixture
+    def mock_auth(self):
+        def override():
+            return {"id": "test-user", "email": "test@test.com", "name": "Test"}
+
+        return override
+
+    @staticmethod
+    def _agent(agent_id, port):
+        agent = Mock()
+        agent.agent_id = agent_id
+        agent.api_port = port
+        agent.occurrence_id = None
+        agent.server_id = "main"
+        agent.is_running = True
+        return agent
+
+    def _client(self, mock_manager, mock_auth):
+        app = FastAPI()
+        app.state.manager = mock_manager
+
+        from ciris_manager.api.routes.dependencies import _get_auth_dependency_runtime
+
+        app.dependency_overrides[_get_auth_dependency_runtime] = mock_auth
+
+        router = create_routes(mock_manager)
+        app.include_router(router, prefix="/manager/v1")
+        return TestClient(app)
+
+    @staticmethod
+    def _mock_httpx(mock_httpx):
+        def get(url, **kwargs):
+            response = Mock()
+            response.status_code = 200
+            response.raise_for_status = Mock()
+            if url.startswith("http://localhost:8002"):
+                response.raise_for_status.side_effect = Exception("connection refused")
+            if url.endswith("/v1/system/adapters"):
+                response.json.return_value = {
+                    "data": {"adapters": [{"adapter_type": "api"}, {"adapter_type": "discord"}]}
+                }
+            else:
+                response.json.return_value = {"data": {"adapter_config": {"channel": "1"}}}
+            return response
+
+        mock_client = MagicMock()
+        mock_client.get = AsyncMock(side_effect=get)
+        mock_httpx.return_value = mock_client
+
+    def test_fleet_sync_commits_once(self, mock_manager, mock_auth):
+        client = self._client(mock_manager, mock_auth)
+        agents = [self._agent("agent-a", 8001), self._agent("agent-b", 8002)]
+
+        with patch("ciris_manager.docker_discovery.DockerAgentDiscovery") as mock_discovery:
+            mock_discovery.return_value.discover_agents.return_value = agents
+
+            with patch("ciris_manager.agent_auth.get_agent_auth") as mock_auth_fn:
+                mock_auth_fn.return_value.get_auth_headers.return_value = {
+                    "Authorization": "Bearer test"
+                }
+
+                with patch("httpx.AsyncClient") as mock_httpx:
+                    self._mock_httpx(mock_httpx)
+                    response = client.post("/manager/v1/adapters/sync?concurrency=2")
+
+        assert response.status_code == 200
+        data = response.json()
+        assert data["summary"] == {
+            "agents_checked": 2,
+            "agents_failed": 1,
+            "synced_count": 1,
+            "skipped_count": 1,
+        }
+        mock_manager.agent_registry.set_adapter_configs_bulk.assert_called_once()
+        changes = mock_manager.agent_registry.set_adapter_configs_bulk.call_args[0][0]
+        assert [(c[0], c[3]) for c in changes] == [("agent-a", "discord")]
+        assert changes[0][4]["config"] == {"channel": "1"}
+        failed = next(a for a in data["agents"] if a["agent_id"] == "agent-b")
+        assert failed["summary"]["error_count"] == 1
+
+    def test_fleet_sync_dry_run(self, mock_manager, mock_auth):
+        client = self._client(mock_manager, mock_auth)
+
+        with patch("ciris_manager.docker_discovery.DockerAgentDiscovery") as mock_discovery:
+            mock_discovery.return_value.discover_agents.return_value = [
+                self._agent("agent-a", 8001)
+            ]
+
+            with patch("ciris_manager.agent_auth.get_agent_auth") as mock_auth_fn:
+                mock_auth_fn.return_value.get_auth_headers.return_value = {}
+
+                with patch("httpx.AsyncClient") as mock_httpx:
+                    self._mock_httpx(mock_httpx)
+                    response = client.post("/manager/v1/adapters/sync?dry_run=true")
+
+        assert response.status_code == 200
+        data = response.json()
+        assert data["dry_run"] is True
+        assert data["summary"]["synced_count"] == 1
+        mock_manager.agent_registry.set_adapter_configs_bulk.assert_not_called()
@@ -42,9 +42,9 @@ class TestLLMRoutes:
         # Mock docker_client to prevent discovery issues
         manager.docker_client = None
 
-        # Mock regenerate_agent_compose and restart_container
+        # Mock regenerate_agent_compose and recreate_agent_container
         manager.regenerate_agent_compose = AsyncMock()
-        manager.restart_container = AsyncMock(return_value=True)
+        manager.recreate_agent_container = AsyncMock(return_value=True)
 
         return manager
 
@@ -278,7 +278,28 @@ class TestLLMRoutes:
 
         # Verify restart was called
         mock_manager.regenerate_agent_compose.assert_called_once()
-        mock_manager.restart_container.assert_called_once()
+        mock_manager.recreate_agent_container.assert_called_once()
+
+    def test_restart_happens_when_compose_unchanged(
+        self, client, mock_manager, sample_agent, sample_llm_config
+    ):
+        """An up-to-date compose file does not skip the requested restart."""
+        mock_manager.agent_registry.get_agents_by_agent_id.return_value = [sample_agent]
+        mock_manager.agent_registry.get_llm_config.return_value = sample_llm_config
+        mock_manager.agent_registry.set_llm_config.return_value = True
+        mock_manager.regenerate_agent_compose.return_value = {
+            "compose_changed": False,
+            "live_applied": False,
+        }
+
+        response = client.patch(
+            "/manager/v1/agents/test-agent/llm",
+            json={"primary_model": "google/gemma-4-31B-it"},
+        )
+
+        assert response.status_code == 200
+        assert response.json()["restarted"] is True
+        mock_manager.recreate_agent_container.assert_called_once()
 
     def test_patch_llm_config_provider_change(
         self, client, mock_manager, sample_agent, sample_llm_config
@@ -327,3 +348,43 @@ class TestLLMRoutes:
         call_args = mock_manager.agent_registry.set_llm_config.call_args
         saved_config = call_args[0][1]
         assert "backup" not in saved_config
+
+    def test_validate_all_llm_configs(
+        self, client, mock_manager, sample_agent, sample_llm_config
+    ):
+        """Fleet validation reports each configured agent without exposing keys."""
+        from unittest.mock import patch
+
+        unconfigured = RegisteredAgent(
+            agent_id="no-llm",
+            name="NoLLM",
+            port=8082,
+            template="base",
+            compose_file="/path/to/other.yml",
+        )
+        mock_manager.agent_registry.list_agents.return_value = [sample_agent, unconfigured]
+        mock_manager.agent_registry.get_llm_config.side_effect = lambda agent_id, **kw: (
+            sample_llm_config if agent_id == "test-agent" else None
+        )
+
+        async def fake_validate(configs, concurrency):
+            assert concurrency == 4
+            return {
+                label: {
+                    "primary": {"provider": "together", "model": "m", "valid": True, "error": None},
+                    "backup": {"provider": "groq", "model": "m", "valid": False, "error": "bad"},
+                }
+                for label in configs
+            }
+
+        with patch(
+            "ciris_manager.api.routes.llm.validate_stored_llm_configs", side_effect=fake_validate
+        ):
+            response = client.post("/manager/v1/llm/validate-all?concurrency=4")
+
+        assert response.status_code == 200
+        data = response.json()
+        assert data["summary"] == {"agents_checked": 1, "agents_invalid": 1}
+        assert data["agents"][0]["agent_id"] == "test-agent"
+        assert data["agents"][0]["backup"]["valid"] is False
+        assert "test-together-key" not in response.text
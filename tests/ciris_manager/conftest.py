@@ -4,7 +4,18 @@ Shared fixtures for CIRISManager tests.
 
 import pytest
 from unittest.mock import Mock
+from ciris_manager.agent_http import reset_agent_http_client
 from ciris_manager.config.settings import CIRISManagerConfig
+from ciris_manager.manifest_cache import get_manifest_cache
+
+
+@pytest.fixture(autouse=True)
+def fresh_agent_http_state():
+    """Give each test fresh agent connection pools and manifest cache so mocks do not leak."""
+    reset_agent_http_client()
+    get_manifest_cache().invalidate()
+    yield
+    reset_agent_http_client()
 
 
 @pytest.fixture
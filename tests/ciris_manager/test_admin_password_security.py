@@ -105,7 +105,7 @@ class TestSetAdminPassword:
         mock_client.put.return_value = mock_password_response
 
         with patch("httpx.AsyncClient") as mock_async_client:
-            mock_async_client.return_value.__aenter__.return_value = mock_client
+            mock_async_client.return_value = mock_client
 
             await mock_manager._set_agent_admin_password(agent_id, port, new_password)
 
@@ -135,7 +135,7 @@ class TestSetAdminPassword:
         mock_client.post.return_value = mock_login_response
 
         with patch("httpx.AsyncClient") as mock_async_client:
-            mock_async_client.return_value.__aenter__.return_value = mock_client
+            mock_async_client.return_value = mock_client
 
             with pytest.raises(RuntimeError) as exc_info:
                 await mock_manager._set_agent_admin_password(agent_id, port, new_password)
@@ -168,7 +168,7 @@ class TestSetAdminPassword:
         mock_client.put.return_value = mock_password_response
 
         with patch("httpx.AsyncClient") as mock_async_client:
-            mock_async_client.return_value.__aenter__.return_value = mock_client
+            mock_async_client.return_value = mock_client
 
             with pytest.raises(RuntimeError) as exc_info:
                 await mock_manager._set_agent_admin_password(agent_id, port, new_password)
@@ -200,7 +200,7 @@ class TestSetAdminPassword:
         mock_client.put.return_value = mock_password_response
 
         with patch("httpx.AsyncClient") as mock_async_client:
-            mock_async_client.return_value.__aenter__.return_value = mock_client
+            mock_async_client.return_value = mock_client
 
             await mock_manager._set_agent_admin_password(agent_id, port, new_password, server_id)
 
@@ -0,0 +1,257 @@
+"""
+Tests for the agent-host sidecar client and the remote operations that use it.
+"""
+
+import asyncio
+from pathlib import Path
+from types import SimpleNamespace
+from unittest.mock import Mock
+
+import pytest
+import yaml
+
+from ciris_manager.manager import CIRISManager
+from ciris_manager.utils import agent_host
+from ciris_manager.utils.agent_host import (
+    AgentHostClient,
+    AgentHostError,
+    AgentHostUnavailableError,
+)
+
+
+class FakeAgentHost:
+    """Minimal stand-in for `ciris-fix-permissions --serve-remote` (without TLS)."""
+
+    def __init__(self):
+        self.files: dict[str, bytes] = {}
+        self.requests: list[tuple[str, str, str]] = []
+        self.completed: list[str] = []
+        self.connections = 0
+        self.server = None
+        self.port = 0
+
+    async def start(self):
+        self.server = await asyncio.start_server(self._handle, "127.0.0.1", 0)
+        self.port = self.server.sockets[0].getsockname()[1]
+
+    async def stop(self):
+        self.server.close()
+        await self.server.wait_closed()
+
+    async def _handle(self, reader, writer):
+        self.connections += 1
+        while line := await reader.readline():
+            request_id, op, path, arg, length = line.decode().split()
+            body = await reader.readexactly(int(length))
+            if path == "/drop":
+                break
+            self.requests.append((op, path, arg))
+            asyncio.create_task(self._respond(writer, request_id, op, path, arg, body))
+        writer.close()
+
+    async def _respond(self, writer, request_id, op, path, arg, body):
+        ok, payload = True, b""
+        if op == "tail-log":
+            # Slow enough that later requests overtake it
+            await asyncio.sleep(0.1)
+            payload = b"\n".join(self.files.get(path, b"").splitlines()[-int(arg) :])
+        elif op == "write-file":
+            self.files[path] = body
+        elif op == "read-file":
+            ok = path in self.files
+            payload = self.files[path] if ok else f"cannot open {path}".encode()
+        elif op == "ping":
+            payload = b"ciris-agent-host 1"
+        elif not path.startswith("/opt/ciris/agents/"):
+            ok, payload = False, f"not an agent directory: {path}".encode()
+
+        self.completed.append(op)
+        status = "OK" if ok else "ERR"
+        writer.write(f"{request_id} {status} {len(payload)}\n".encode() + payload)
+        await writer.drain()
+
+
+@pytest.fixture
+async def sidecar():
+    """Run a fake agent host on a free local port."""
+    fake = FakeAgentHost()
+    await fake.start()
+    yield fake
+    await fake.stop()
+
+
+@pytest.fixture(autouse=True)
+def clean_agent_hosts():
+    """Keep the module-level sidecar registry isolated."""
+    agent_host._hosts.clear()
+    yield
+    agent_host._hosts.clear()
+
+
+class TestAgentHostClient:
+    """Test the sidecar wire protocol."""
+
+    @pytest.mark.asyncio
+    async def test_requests_are_multiplexed(self, sidecar):
+        """Concurrent requests share one connection and complete out of order."""
+        client = AgentHostClient("127.0.0.1", sidecar.port, None)
+        sidecar.files["/opt/ciris/agents/a1/logs/latest.log"] = b"one\ntwo\nthree\n"
+
+        tail, version = await asyncio.gather(
+            client.tail_log(Path("/opt/ciris/agents/a1/logs/latest.log"), 2), client.ping()
+        )
+        await client.close()
+
+        assert tail == "two\nthree"
+        assert version == "ciris-agent-host 1"
+        assert sidecar.completed == ["ping", "tail-log"]
+        assert sidecar.connections == 1
+
+    @pytest.mark.asyncio
+    async def test_file_round_trip_and_errors(self, sidecar):
+        """Binary bodies survive framing; failures raise AgentHostError."""
+        client = AgentHostClient("127.0.0.1", sidecar.port, None)
+        content = b"services:\n  a1: {}\n\x00\xff\n"
+
+        await client.write_file(Path("/opt/ciris/agents/a1/docker-compose.yml"), content, 0o640)
+        assert await client.read_file(Path("/opt/ciris/agents/a1/docker-compose.yml")) == content
+        assert sidecar.requests[0] == (
+            "write-file",
+            "/opt/ciris/agents/a1/docker-compose.yml",
+            "640",
+        )
+
+        with pytest.raises(AgentHostError, match="not an agent directory"):
+            await client.fix_permissions(Path("/etc"))
+        with pytest.raises(AgentHostError, match="cannot open"):
+            await client.read_file(Path("/opt/ciris/agents/a1/missing.yml"))
+        await client.close()
+
+    @pytest.mark.asyncio
+    async def test_reconnects_after_connection_loss(self, sidecar):
+        """In-flight requests fail as unavailable and the next request reconnects."""
+        client = AgentHostClient("127.0.0.1", sidecar.port, None)
+        await client.ping()
+
+        with pytest.raises(AgentHostUnavailableError):
+            await client.read_file(Path("/drop"))
+        assert await client.ping() == "ciris-agent-host 1"
+        assert sidecar.connections == 2
+        await client.close()
+
+    @pytest.mark.asyncio
+    async def test_unreachable_sidecar_is_unavailable(self, sidecar):
+        """A closed port raises AgentHostUnavailableError so callers can fall back."""
+        port = sidecar.port
+        await sidecar.stop()
+        client = AgentHostClient("127.0.0.1", port, None, timeout=2)
+
+        with pytest.raises(AgentHostUnavailableError):
+            await client.ping()
+
+    @pytest.mark.asyncio
+    async def test_request_sync(self, sidecar):
+        """The blocking variant works from synchronous code."""
+        client = AgentHostClient("127.0.0.1", sidecar.port, None)
+        await asyncio.to_thread(
+            client.request_sync, "write-file", Path("/home/ciris/shared/x.sh"), "755", b"#!/bin/sh"
+        )
+        assert sidecar.files["/home/ciris/shared/x.sh"] == b"#!/bin/sh"
+
+    def test_invalid_requests_rejected(self):
+        """Unknown operations and whitespace in arguments never reach the wire."""
+        with pytest.raises(ValueError):
+            AgentHostClient._build_request(1, "rm-rf", Path("/opt/ciris/agents/a1"), None, b"")
+        with pytest.raises(ValueError):
+            AgentHostClient._build_request(1, "read-file", Path("/opt/ciris/a b"), None, b"")
+
+    def test_only_configured_remote_servers_get_a_client(self):
+        """Local servers and servers without a port or certificates use Docker."""
+        remote = dict(
+            server_id="scout",
+            is_local=False,
+            agent_host_port=None,
+            vpc_ip="10.2.96.4",
+            docker_host=None,
+            hostname="scoutapi.ciris.ai",
+            tls_ca=None,
+            tls_cert=None,
+            tls_key=None,
+        )
+        assert AgentHostClient.from_server_config(SimpleNamespace(**remote)) is None
+        remote["agent_host_port"] = 2378
+        assert AgentHostClient.from_server_config(SimpleNamespace(**remote)) is None
+        local = SimpleNamespace(**{**remote, "is_local": True})
+        assert AgentHostClient.from_server_config(local) is None
+
+
+class TestRemoteOperationsUseAgentHost:
+    """Test that manager remote file operations go through the sidecar."""
+
+    @pytest.fixture
+    def manager(self):
+        """Manager stand-in whose Docker client must not be used."""
+        manager = Mock(spec=CIRISManager)
+        manager.docker_client = Mock()
+        return manager
+
+    @pytest.mark.asyncio
+    async def test_compose_sync_and_fetch_skip_docker(self, sidecar, manager):
+        """Compose files are written and read through the sidecar."""
+        agent_host._hosts["scout"] = AgentHostClient("127.0.0.1", sidecar.port, None)
+        compose = {"services": {"a1": {"image": "ghcr.io/cirisai/ciris-agent:latest"}}}
+        path = "/opt/ciris/agents/a1/docker-compose.yml"
+
+        assert await CIRISManager._sync_compose_to_remote_server(manager, "scout", path, compose)
+        assert await CIRISManager._fetch_remote_compose(manager, "scout", path) == compose
+        assert yaml.safe_load(sidecar.files[path]) == compose
+        manager.docker_client.get_client.assert_not_called()
+        await agent_host._hosts["scout"].close()
+
+    @pytest.mark.asyncio
+    async def test_agent_directories_provisioned_by_sidecar(self, sidecar, manager):
+        """Directory provisioning is one sidecar request."""
+        agent_host._hosts["scout"] = AgentHostClient("127.0.0.1", sidecar.port, None)
+
+        await CIRISManager._create_remote_agent_directories(manager, "a1", "scout")
+
+        assert sidecar.requests == [("provision-agent", "/opt/ciris/agents/a1", "-")]
+        manager.docker_client.get_client.assert_not_called()
+        await agent_host._hosts["scout"].close()
+
+    @pytest.mark.asyncio
+    async def test_falls_back_to_docker_exec(self, sidecar, manager):
+        """An unreachable sidecar falls back to exec in the nginx container."""
+        port = sidecar.port
+        await sidecar.stop()
+        agent_host._hosts["scout"] = AgentHostClient("127.0.0.1", port, None, timeout=2)
+        nginx = manager.docker_client.get_client.return_value.containers.get.return_value
+        nginx.exec_run.return_value = Mock(exit_code=0, output=b"")
+
+        await CIRISManager._create_remote_agent_directories(manager, "a1", "scout")
+
+        nginx.exec_run.assert_called_once()
+        assert "mkdir -p /opt/ciris/agents/a1" in nginx.exec_run.call_args[0][0]
+
+    @pytest.mark.asyncio
+    async def test_identity_update_edits_compose_through_sidecar(self, sidecar, manager):
+        """The identity update reads and rewrites the remote compose without alpine containers."""
+        from ciris_manager.api.routes.admin import _handle_identity_update
+
+        agent_host._hosts["scout"] = AgentHostClient("127.0.0.1", sidecar.port, None)
+        path = "/opt/ciris/agents/a1/docker-compose.yml"
+        compose = {"services": {"a1": {"image": "agent:1", "command": ["python", "main.py"]}}}
+        sidecar.files[path] = yaml.dump(compose).encode()
+        manager.agent_registry = Mock()
+        manager.docker_client.get_server_config.return_value = SimpleNamespace(is_local=False)
+        docker = manager.docker_client.get_client.return_value
+        agent = SimpleNamespace(agent_id="a1", server_id="scout", occurrence_id=None)
+
+        await _handle_identity_update(manager, agent, {}, False)
+
+        images = [call.args[0] for call in docker.containers.run.call_args_list]
+        assert "alpine:latest" not in images
+        assert [op for op, _, _ in sidecar.requests] == ["read-file", "write-file", "write-file"]
+        final = yaml.safe_load(sidecar.files[path])
+        assert final["services"]["a1"]["command"] == ["python", "main.py"]
+        await agent_host._hosts["scout"].close()
@@ -0,0 +1,172 @@
+"""
+Tests for the shared pooled agent HTTP client.
+"""
+
+import asyncio
+from unittest.mock import AsyncMock, MagicMock, patch
+
+import pytest
+
+from ciris_manager.agent_http import AgentHTTPClient
+
+
+def _response(status_code=200, body=None):
+    response = MagicMock()
+    response.status_code = status_code
+    response.json.return_value = body or {}
+    return response
+
+
+def _pool_factory(get=None, post=None):
+    """Patch target for httpx.AsyncClient that records every pool created."""
+    pools = []
+
+    def make_pool(*args, **kwargs):
+        pool = MagicMock()
+        pool.is_closed = False
+        pool.get = get or AsyncMock(return_value=_response())
+        pool.post = post or AsyncMock(return_value=_response())
+        pool.aclose = AsyncMock()
+        pools.append(pool)
+        return pool
+
+    return make_pool, pools
+
+
+class TestAgentHTTPClient:
+    """Test pooling, coalescing, caching and latency tracking."""
+
+    @pytest.mark.asyncio
+    async def test_one_pool_per_agent_origin(self):
+        """Requests to the same agent reuse its pool; other agents get their own."""
+        make_pool, pools = _pool_factory()
+        client = AgentHTTPClient()
+        with patch("httpx.AsyncClient", side_effect=make_pool):
+            await client.get("http://localhost:8080/v1/system/health")
+            await client.post("http://localhost:8080/v1/system/shutdown", json={"reason": "x"})
+            await client.get("http://10.2.96.4:8081/v1/system/health")
+
+        assert len(pools) == 2
+        assert pools[0].get.await_count == 1
+        assert pools[0].post.await_args.kwargs == {"json": {"reason": "x"}}
+
+    @pytest.mark.asyncio
+    async def test_identical_concurrent_gets_are_coalesced(self):
+        """Concurrent identical GETs share one request; different headers do not."""
+        release = asyncio.Event()
+
+        async def slow_get(*args, **kwargs):
+            await release.wait()
+            return _response(body={"data": "types"})
+
+        get = AsyncMock(side_effect=slow_get)
+        make_pool, _ = _pool_factory(get=get)
+        client = AgentHTTPClient()
+        url = "http://localhost:8080/v1/system/adapters/types"
+        with patch("httpx.AsyncClient", side_effect=make_pool):
+            tasks = [
+                asyncio.create_task(client.get(url, headers={"Authorization": "Bearer a"}))
+                for _ in range(5)
+            ]
+            other = asyncio.create_task(client.get(url, headers={"Authorization": "Bearer b"}))
+            await asyncio.sleep(0)
+            release.set()
+            responses = await asyncio.gather(*tasks, other)
+
+        assert get.await_count == 2
+        assert all(r is responses[0] for r in responses[:5])
+
+    @pytest.mark.asyncio
+    async def test_errors_reach_every_waiter(self):
+        """A failed coalesced GET raises in every caller and is not remembered."""
+        release = asyncio.Event()
+
+        async def failing_get(*args, **kwargs):
+            await release.wait()
+            raise ConnectionError("refused")
+
+        get = AsyncMock(side_effect=failing_get)
+        make_pool, _ = _pool_factory(get=get)
+        client = AgentHTTPClient()
+        with patch("httpx.AsyncClient", side_effect=make_pool):
+            tasks = [asyncio.create_task(client.get("http://agent:1/x")) for _ in range(3)]
+            await asyncio.sleep(0)
+            release.set()
+            results = await asyncio.gather(*tasks, return_exceptions=True)
+
+        assert all(isinstance(r, ConnectionError) for r in results)
+        assert len(client._inflight) == 0
+        assert client.latency_stats()["http://agent:1"]["errors"] == 1
+
+    @pytest.mark.asyncio
+    async def test_cache_ttl(self):
+        """Successful responses are reused within the TTL and dropped on invalidate."""
+        get = AsyncMock(side_effect=[_response(), _response(404), _response()])
+        make_pool, _ = _pool_factory(get=get)
+        client = AgentHTTPClient()
+        url = "http://localhost:8080/v1/system/adapters/types"
+        with patch("httpx.AsyncClient", side_effect=make_pool):
+            first = await client.get(url, cache_ttl=30)
+            assert await client.get(url, cache_ttl=30) is first
+            client.invalidate("http://localhost:8080")
+            assert (await client.get(url, cache_ttl=30)).status_code == 404
+            # Non-200 responses are not cached
+            await client.get(url, cache_ttl=30)
+
+        assert get.await_count == 3
+
+    @pytest.mark.asyncio
+    async def test_latency_stats(self):
+        """Each agent origin gets its own request and error counters."""
+        get = AsyncMock(side_effect=[_response(), _response(503)])
+        make_pool, _ = _pool_factory(get=get)
+        client = AgentHTTPClient()
+        with patch("httpx.AsyncClient", side_effect=make_pool):
+            await client.get("http://localhost:8080/a")
+            await client.get("http://localhost:8080/b")
+
+        stats = client.latency_stats()["http://localhost:8080"]
+        assert stats["requests"] == 2
+        assert stats["errors"] == 1
+        assert stats["max_ms"] >= stats["last_ms"] >= 0
+
+    @pytest.mark.asyncio
+    async def test_least_recently_used_pool_is_closed(self):
+        """Pools beyond max_pools are closed, oldest first."""
+        make_pool, pools = _pool_factory()
+        client = AgentHTTPClient(max_pools=2)
+        with patch("httpx.AsyncClient", side_effect=make_pool):
+            for port in (8080, 8081, 8082):
+                await client.get(f"http://localhost:{port}/v1/system/health")
+            await asyncio.sleep(0)
+
+        pools[0].aclose.assert_awaited_once()
+        pools[2].aclose.assert_not_awaited()
+        await client.close()
+        pools[2].aclose.assert_awaited_once()
+
+    @pytest.mark.asyncio
+    async def test_evicted_pool_is_closed_after_its_requests(self):
+        """A pool evicted while a request runs on it is closed only once that request ends."""
+        release = asyncio.Event()
+
+        async def slow_get(*args, **kwargs):
+            await release.wait()
+            return _response()
+
+        make_pool, pools = _pool_factory(get=AsyncMock(side_effect=slow_get))
+        client = AgentHTTPClient(max_pools=1)
+        with patch("httpx.AsyncClient", side_effect=make_pool):
+            slow = asyncio.create_task(client.get("http://localhost:8080/v1/system/health"))
+            await asyncio.sleep(0)
+            other = asyncio.create_task(client.get("http://localhost:8081/v1/system/health"))
+            await asyncio.sleep(0)
+            await asyncio.sleep(0)
+            pools[0].aclose.assert_not_awaited()
+            release.set()
+            await asyncio.gather(slow, other)
+            await asyncio.sleep(0)
+
+        pools[0].aclose.assert_awaited_once()
+        await client.close()
+        pools[1].aclose.assert_awaited_once()
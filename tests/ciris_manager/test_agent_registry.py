@@ -416,6 +416,35 @@ class TestAgentRegistry:
             data = json.load(f)
             assert len(data["agents"]) == 5
 
+    def test_set_adapter_configs_bulk(self, registry):
+        """Test bulk adapter config updates are saved once and report unknown agents."""
+        from unittest.mock import patch
+
+        for i in range(3):
+            registry.register_agent(
+                agent_id=f"agent-{i}",
+                name=f"Agent{i}",
+                port=8080 + i,
+                template="scout",
+                compose_file=f"/path/{i}/compose.yml",
+            )
+
+        changes = [
+            (f"agent-{i}", None, None, "discord", {"config": {"channel": str(i)}})
+            for i in range(3)
+        ]
+        changes.append(("agent-missing", None, None, "discord", {"config": {}}))
+
+        with patch.object(registry, "_save_metadata", wraps=registry._save_metadata) as save:
+            missing = registry.set_adapter_configs_bulk(changes)
+
+        assert save.call_count == 1
+        assert missing == [("agent-missing", None, None, "discord")]
+        for i in range(3):
+            config = registry.get_adapter_configs(f"agent-{i}")["discord"]
+            assert config["config"] == {"channel": str(i)}
+            assert "configured_at" in config
+
     def test_occurrence_id_initialization(self):
         """Test RegisteredAgent initialization with occurrence_id."""
         agent = RegisteredAgent(
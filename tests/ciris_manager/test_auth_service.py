@@ -3,8 +3,8 @@ Tests for auth service components.
 """
 
 import pytest
-from unittest.mock import Mock, AsyncMock
-from datetime import datetime, timedelta
+from unittest.mock import Mock, AsyncMock, patch
+from datetime import datetime, timedelta, timezone
 import jwt
 import tempfile
 from pathlib import Path
@@ -337,3 +337,84 @@ class TestAuthService:
         # Should return None
         user = auth_service.get_current_user(f"Bearer {token}")
         assert user is None
+
+
+class TestVerifiedSessionCache:
+    """Test caching of verified sessions in AuthService.get_current_user."""
+
+    @pytest.fixture
+    def auth_service(self, tmp_path):
+        """Create auth service with a real SQLite user store."""
+        user_store = SQLiteUserStore(tmp_path / "test.db")
+        service = AuthService(
+            oauth_provider=Mock(),
+            session_store=InMemorySessionStore(),
+            user_store=user_store,
+            jwt_secret=os.environ.get("TEST_JWT_SECRET", "test-jwt-secret-for-testing-only"),
+            jwt_expiration_hours=1,
+        )
+        yield service
+        user_store.close()
+
+    def test_repeat_requests_skip_decode_and_database(self, auth_service):
+        """A verified token is served from cache without decoding or querying SQLite."""
+        auth_service.user_store.create_or_update_user("test@ciris.ai", {})
+        token = auth_service.create_jwt_token({"user_id": 1, "email": "test@ciris.ai"})
+        auth_service.get_current_user(f"Bearer {token}")
+
+        with patch.object(auth_service, "verify_jwt_token") as verify, patch.object(
+            auth_service.user_store, "is_user_authorized"
+        ) as authorized:
+            user = auth_service.get_current_user(f"Bearer {token}")
+
+        assert user["email"] == "test@ciris.ai"
+        verify.assert_not_called()
+        authorized.assert_not_called()
+
+        # Callers get their own copy
+        user["email"] = "changed@ciris.ai"
+        assert auth_service.get_current_user(f"Bearer {token}")["email"] == "test@ciris.ai"
+
+    def test_revoking_authorization_invalidates_cache(self, auth_service):
+        """Changing a user's authorization takes effect on the next request."""
+        auth_service.user_store.create_or_update_user("test@ciris.ai", {})
+        token = auth_service.create_jwt_token({"user_id": 1, "email": "test@ciris.ai"})
+        assert auth_service.get_current_user(f"Bearer {token}") is not None
+
+        assert auth_service.user_store.set_user_authorized("test@ciris.ai", False)
+        assert auth_service.get_current_user(f"Bearer {token}") is None
+
+        auth_service.user_store.set_user_authorized("test@ciris.ai", True)
+        assert auth_service.get_current_user(f"Bearer {token}") is not None
+
+    def test_cache_honors_token_expiry(self, auth_service):
+        """A cached session is not served past the token's exp claim."""
+        auth_service.user_store.create_or_update_user("test@ciris.ai", {})
+        exp = datetime.now(timezone.utc) + timedelta(seconds=30)
+        token = jwt.encode(
+            {"email": "test@ciris.ai", "exp": exp},
+            auth_service.jwt_secret,
+            algorithm=auth_service.jwt_algorithm,
+        )
+        assert auth_service.get_current_user(f"Bearer {token}") is not None
+
+        with patch("ciris_manager.api.auth_service.time.time", return_value=exp.timestamp() + 1):
+            assert auth_service.get_current_user(f"Bearer {token}") is None
+
+    def test_rejections_are_not_cached(self, auth_service):
+        """Unauthorized users are re-checked, so granting access applies immediately."""
+        token = auth_service.create_jwt_token({"user_id": 2, "email": "new@ciris.ai"})
+        assert auth_service.get_current_user(f"Bearer {token}") is None
+        assert auth_service._verified_sessions == {}
+
+        auth_service.user_store.create_or_update_user("new@ciris.ai", {})
+        assert auth_service.get_current_user(f"Bearer {token}") is not None
+
+    def test_user_store_reuses_connection(self, auth_service):
+        """The user store keeps one connection instead of opening one per query."""
+        store = auth_service.user_store
+        store.create_or_update_user("test@ciris.ai", {})
+        with patch("ciris_manager.api.auth_service.sqlite3.connect") as connect:
+            for _ in range(5):
+                assert store.is_user_authorized("test@ciris.ai")
+        connect.assert_not_called()
@@ -0,0 +1,412 @@
+"""
+Tests for the incremental deduplicating backup engine.
+"""
+
+import io
+import os
+import random
+import sqlite3
+from datetime import datetime, timedelta, timezone
+from hashlib import sha256
+from pathlib import Path
+
+import pytest
+
+from ciris_manager.backup import BackupEngine, BackupRepository, RepositoryError
+from ciris_manager.backup.__main__ import main
+from ciris_manager.backup import chunking
+from ciris_manager.backup.chunking import MAX_CHUNK_SIZE, MIN_CHUNK_SIZE, iter_chunks
+from ciris_manager.backup.repository import compress_chunk, decompress_chunk
+
+
+def _random_bytes(size: int, seed: int) -> bytes:
+    return random.Random(seed).randbytes(size)
+
+
+@pytest.fixture
+def source(tmp_path):
+    """Agent-like source tree."""
+    root = tmp_path / "agents"
+    (root / "datum" / "data").mkdir(parents=True)
+    (root / "datum" / "logs").mkdir()
+    (root / "datum" / "data" / "blob.bin").write_bytes(_random_bytes(600 * 1024, 1))
+    (root / "datum" / "logs" / "latest.log").write_text("started\n")
+    os.chmod(root / "datum" / "logs" / "latest.log", 0o640)
+    (root / "datum" / "current.log").symlink_to("logs/latest.log")
+    return root
+
+
+@pytest.fixture
+def engine(tmp_path):
+    """Engine over a fresh repository, chunking in-process."""
+    return BackupEngine(BackupRepository(tmp_path / "repository"), max_workers=1)
+
+
+class TestChunking:
+    """Test content-defined chunk boundaries."""
+
+    def test_chunks_cover_stream_within_size_bounds(self):
+        """Chunks reassemble the input and respect the size limits."""
+        data = _random_bytes(2 * 1024 * 1024, 2)
+        chunks = list(iter_chunks(io.BytesIO(data)))
+
+        assert b"".join(chunks) == data
+        assert all(MIN_CHUNK_SIZE <= len(c) <= MAX_CHUNK_SIZE for c in chunks[:-1])
+
+    def test_insertion_only_changes_nearby_chunks(self):
+        """Boundaries resynchronize after an insertion, so most chunks are shared."""
+        data = _random_bytes(2 * 1024 * 1024, 3)
+        edited = data[:700_000] + b"inserted bytes" + data[700_000:]
+
+        before = set(iter_chunks(io.BytesIO(data)))
+        after = list(iter_chunks(io.BytesIO(edited)))
+
+        changed = [c for c in after if c not in before]
+        assert len(changed) <= 2
+        assert len(after) - len(changed) >= len(before) - 2
+
+    def test_previous_chunks_skip_scanning_unchanged_regions(self, monkeypatch):
+        """Hints from the last backup give identical chunks and only rescan edits."""
+        data = bytearray(_random_bytes(4 * 1024 * 1024, 6))
+        previous = [
+            (sha256(c).hexdigest(), len(c)) for c in iter_chunks(io.BytesIO(bytes(data)))
+        ]
+        # Rewrite one 4 KiB page in place, then grow the file
+        data[2_000_000:2_004_096] = _random_bytes(4096, 7)
+        edited = bytes(data) + _random_bytes(100_000, 8)
+
+        scans = []
+        real_find_cut_point = chunking.find_cut_point
+        monkeypatch.setattr(
+            chunking,
+            "find_cut_point",
+            lambda buffer, length: scans.append(length) or real_find_cut_point(buffer, length),
+        )
+        hinted = list(iter_chunks(io.BytesIO(edited), previous))
+        hinted_scans = len(scans)
+        scans.clear()
+        full = list(iter_chunks(io.BytesIO(edited)))
+
+        assert hinted == full
+        # The edited chunk, the old tail and the appended data are scanned
+        assert hinted_scans <= 5
+        assert len(scans) == len(full)
+
+    def test_compression_round_trip(self):
+        """Compressible chunks shrink; incompressible ones are stored raw."""
+        text = b"agent log line\n" * 4096
+        noise = _random_bytes(4096, 4)
+
+        assert len(compress_chunk(text)) < len(text)
+        assert compress_chunk(noise) == b"\x00" + noise
+        assert decompress_chunk(compress_chunk(text)) == text
+
+
+class TestBackupEngine:
+    """Test snapshot creation, verification, pruning and restore."""
+
+    def test_unchanged_files_are_not_reread(self, engine, source):
+        """A second backup reuses chunk lists and stores nothing new."""
+        first = engine.create([source])
+        second = engine.create([source])
+
+        assert first["stats"]["files"] == 2
+        assert first["stats"]["new_chunks"] > 0
+        assert second["stats"]["files_read"] == 0
+        assert second["stats"]["files_reused"] == 2
+        assert second["stats"]["new_chunks"] == 0
+        assert second["parent"] == first["id"]
+
+    def test_modified_file_stores_only_changed_chunks(self, engine, source):
+        """Appending to a large file stores a few chunks, not the whole file."""
+        blob = source / "datum" / "data" / "blob.bin"
+        first = engine.create([source])
+        with open(blob, "ab") as f:
+            f.write(_random_bytes(1024, 5))
+
+        second = engine.create([source])
+
+        assert second["stats"]["files_read"] == 1
+        assert second["stats"]["new_chunks"] <= 2
+        assert second["stats"]["stored_bytes"] < first["stats"]["stored_bytes"] / 2
+
+    def test_live_sqlite_database_is_consistent(self, engine, tmp_path):
+        """Committed rows still in the WAL are included; sidecar files are not backed up."""
+        data = tmp_path / "live" / "data"
+        data.mkdir(parents=True)
+        db = data / "ciris_engine.db"
+        conn = sqlite3.connect(db)
+        conn.execute("PRAGMA journal_mode=WAL")
+        conn.execute("CREATE TABLE thoughts (id INTEGER PRIMARY KEY, content TEXT)")
+        conn.executemany(
+            "INSERT INTO thoughts (content) VALUES (?)", [(f"t{i}",) for i in range(500)]
+        )
+        conn.commit()
+        assert (data / "ciris_engine.db-wal").exists()
+
+        try:
+            snapshot = engine.create([tmp_path / "live"])
+        finally:
+            conn.close()
+        engine.restore(snapshot["id"], tmp_path / "restored")
+
+        restored = tmp_path / "restored" / str(data).lstrip("/")
+        assert sorted(p.name for p in restored.iterdir()) == ["ciris_engine.db"]
+        with sqlite3.connect(restored / "ciris_engine.db") as check:
+            assert check.execute("SELECT COUNT(*) FROM thoughts").fetchone()[0] == 500
+
+    def test_restore_round_trips_content_modes_and_links(self, engine, source, tmp_path):
+        """Files, modes, mtimes and symlinks are restored under the target root."""
+        log = source / "datum" / "logs" / "latest.log"
+        os.utime(log, ns=(1_700_000_000_000_000_000, 1_700_000_000_000_000_000))
+        snapshot = engine.create([source], label="nightly")
+
+        assert engine.restore(snapshot["id"], tmp_path / "restored") == 2
+
+        restored = tmp_path / "restored" / str(source).lstrip("/") / "datum"
+        assert (restored / "data" / "blob.bin").read_bytes() == (
+            source / "datum" / "data" / "blob.bin"
+        ).read_bytes()
+        assert (restored / "logs" / "latest.log").stat().st_mode & 0o777 == 0o640
+        assert (restored / "logs" / "latest.log").stat().st_mtime_ns == 1_700_000_000_000_000_000
+        assert os.readlink(restored / "current.log") == "logs/latest.log"
+        assert engine.repository.list_snapshots()[0]["label"] == "nightly"
+
+    def test_verify_detects_missing_chunk(self, engine, source):
+        """Verification reports snapshots that reference a missing chunk."""
+        snapshot = engine.create([source])
+        assert engine.verify(full=True) == []
+
+        manifest = engine.repository.load_snapshot(snapshot["id"])
+        digest = next(e for e in manifest["files"] if e.get("chunks"))["chunks"][0]
+        engine.repository.chunk_path(digest).unlink()
+
+        problems = engine.verify()
+        assert problems and digest in problems[0]
+
+    def test_corrupt_chunk_is_rejected_on_read(self, engine, source):
+        """A chunk whose content no longer matches its digest is never returned."""
+        snapshot = engine.create([source])
+        manifest = engine.repository.load_snapshot(snapshot["id"])
+        digest = next(e for e in manifest["files"] if e.get("chunks"))["chunks"][0]
+        engine.repository.chunk_path(digest).write_bytes(compress_chunk(b"not the original"))
+
+        with pytest.raises(RepositoryError, match="Corrupt chunk"):
+            engine.repository.read_chunk(digest)
+        problems = engine.verify(full=True)
+        assert problems and digest in problems[0]
+
+    def test_prune_reclaims_unreferenced_chunks(self, engine, source):
+        """Expired snapshots are deleted with the chunks only they used."""
+        blob = source / "datum" / "data" / "blob.bin"
+        old = engine.create([source])
+        manifest = engine.repository.load_snapshot(old["id"])
+        manifest["created_at"] = (datetime.now(timezone.utc) - timedelta(days=40)).isoformat()
+        engine.repository.save_snapshot(manifest)
+        blob.write_bytes(_random_bytes(300 * 1024, 6))
+        new = engine.create([source])
+
+        result = engine.prune(keep_days=30)
+
+        assert result["snapshots"] == 1
+        assert result["chunks"] > 0
+        assert [s["id"] for s in engine.repository.list_snapshots()] == [new["id"]]
+        assert engine.verify(full=True) == []
+
+    def test_prune_keeps_last_snapshot(self, engine, source):
+        """The newest snapshot survives even when it is past retention."""
+        snapshot = engine.create([source])
+        manifest = engine.repository.load_snapshot(snapshot["id"])
+        manifest["created_at"] = (datetime.now(timezone.utc) - timedelta(days=40)).isoformat()
+        engine.repository.save_snapshot(manifest)
+
+        assert engine.prune(keep_days=30) == {"snapshots": 0, "chunks": 0}
+
+    def test_worker_processes(self, tmp_path, source):
+        """Chunking in worker processes produces the same snapshot contents."""
+        for i in range(3):
+            (source / f"extra{i}.bin").write_bytes(_random_bytes(100 * 1024, 10 + i))
+        engine = BackupEngine(BackupRepository(tmp_path / "repository"), max_workers=2)
+
+        snapshot = engine.create([source])
+
+        assert snapshot["stats"]["files_read"] == 5
+        assert engine.verify(full=True) == []
+
+    def test_locked_repository_is_rejected(self, engine, source):
+        """Only one backup or prune may write to a repository at a time."""
+        engine.repository.init()
+        with engine.repository.lock():
+            with pytest.raises(RepositoryError):
+                engine.create([source])
+
+    def test_restore_holds_repository_against_prune(self, engine, source, tmp_path):
+        """Restores share the lock with each other but exclude prune and backup."""
+        snapshot = engine.create([source])
+        with engine.repository.lock():
+            with pytest.raises(RepositoryError, match="locked"):
+                engine.restore(snapshot["id"], tmp_path / "restored")
+        with engine.repository.lock(shared=True):
+            assert engine.restore(snapshot["id"], tmp_path / "restored") > 0
+            with pytest.raises(RepositoryError, match="locked"):
+                engine.prune(keep_days=0, keep_last=0)
+
+
+class TestSelectiveRestore:
+    """Test indexed single-agent restores."""
+
+    @pytest.fixture
+    def fleet(self, source):
+        """Agents whose ids share a prefix."""
+        (source / "datum-2" / "data").mkdir(parents=True)
+        (source / "datum-2" / "data" / "other.bin").write_bytes(_random_bytes(50 * 1024, 7))
+        (source / "docker-compose.yml").write_text("services: {}\n")
+        return source
+
+    def test_index_covers_each_agent(self, engine, fleet):
+        """Snapshots index every top-level entry of a source."""
+        snapshot = engine.create([fleet])
+
+        index = engine.repository.load_summary(snapshot["id"])["index"]
+        assert index[str(fleet)]["files"] == 4
+        assert index[f"{fleet}/datum"]["files"] == 2
+        assert index[f"{fleet}/datum-2"] == {
+            "offset": index[f"{fleet}/datum-2"]["offset"],
+            "length": index[f"{fleet}/datum-2"]["length"],
+            "files": 1,
+            "bytes": 50 * 1024,
+        }
+        assert "index" not in engine.repository.list_snapshots()[0]
+
+    def test_restore_single_agent(self, engine, fleet, tmp_path):
+        """Only the requested agent's subtree is restored."""
+        snapshot = engine.create([fleet])
+
+        restored = engine.restore(snapshot["id"], tmp_path / "out", [f"{fleet}/datum"])
+
+        root = tmp_path / "out" / str(fleet).lstrip("/")
+        assert restored == 2
+        assert sorted(p.name for p in root.iterdir()) == ["datum"]
+        assert (root / "datum" / "current.log").is_symlink()
+
+    def test_restore_replaces_corrupted_agent_files(self, engine, fleet):
+        """Restoring in place replaces damaged files and reapplies their modes."""
+        snapshot = engine.create([fleet])
+        log = fleet / "datum" / "logs" / "latest.log"
+        log.write_text("corrupted")
+        os.chmod(log, 0o777)
+
+        engine.restore(snapshot["id"], Path("/"), [f"{fleet}/datum"])
+
+        assert log.read_text() == "started\n"
+        assert log.stat().st_mode & 0o777 == 0o640
+        assert not [p for p in log.parent.iterdir() if p.name.startswith(".")]
+
+    def test_restore_clears_stale_sqlite_sidecars(self, engine, fleet):
+        """A restored database is not paired with the damaged database's WAL."""
+        db = fleet / "datum" / "data" / "ciris_engine.db"
+        with sqlite3.connect(db) as conn:
+            conn.execute("CREATE TABLE thoughts (id INTEGER PRIMARY KEY)")
+            conn.execute("INSERT INTO thoughts DEFAULT VALUES")
+        conn.close()
+        snapshot = engine.create([fleet])
+        (fleet / "datum" / "data" / "ciris_engine.db-wal").write_bytes(b"garbage")
+
+        engine.restore(snapshot["id"], Path("/"), [f"{fleet}/datum"])
+
+        assert not (fleet / "datum" / "data" / "ciris_engine.db-wal").exists()
+        with sqlite3.connect(db) as check:
+            assert check.execute("SELECT COUNT(*) FROM thoughts").fetchone()[0] == 1
+
+    def test_missing_chunk_aborts_before_writing(self, engine, fleet):
+        """A restore that cannot complete leaves the target untouched."""
+        snapshot = engine.create([fleet])
+        blob = fleet / "datum" / "data" / "blob.bin"
+        manifest = engine.repository.load_snapshot(snapshot["id"])
+        entry = next(e for e in manifest["files"] if e["path"] == str(blob))
+        engine.repository.chunk_path(entry["chunks"][-1]).unlink()
+        blob.write_bytes(b"current")
+
+        with pytest.raises(RepositoryError):
+            engine.restore(snapshot["id"], Path("/"), [f"{fleet}/datum"])
+        assert blob.read_bytes() == b"current"
+
+    def test_agent_restore_drops_files_not_in_snapshot(self, engine, fleet):
+        """An agent restore replaces its directory; other agents are not touched."""
+        snapshot = engine.create([fleet])
+        (fleet / "datum" / "data" / "created_later.db").write_bytes(b"after the snapshot")
+        (fleet / "datum" / "extra").mkdir()
+        (fleet / "datum-2" / "data" / "keep.txt").write_text("other agent")
+
+        engine.restore(snapshot["id"], Path("/"), [f"{fleet}/datum"])
+
+        assert not (fleet / "datum" / "data" / "created_later.db").exists()
+        assert not (fleet / "datum" / "extra").exists()
+        assert (fleet / "datum" / "logs" / "latest.log").read_text() == "started\n"
+        assert (fleet / "datum-2" / "data" / "keep.txt").read_text() == "other agent"
+        assert not [p for p in fleet.iterdir() if p.name.startswith(".")]
+
+    def test_corrupt_chunk_leaves_agent_directory_untouched(self, engine, fleet):
+        """A restore that fails while writing discards its staging directory."""
+        snapshot = engine.create([fleet])
+        blob = fleet / "datum" / "data" / "blob.bin"
+        manifest = engine.repository.load_snapshot(snapshot["id"])
+        entry = next(e for e in manifest["files"] if e["path"] == str(blob))
+        engine.repository.chunk_path(entry["chunks"][-1]).write_bytes(compress_chunk(b"bad"))
+        (fleet / "datum" / "data" / "created_later.db").write_bytes(b"kept")
+
+        with pytest.raises(RepositoryError):
+            engine.restore(snapshot["id"], Path("/"), [f"{fleet}/datum"])
+        assert (fleet / "datum" / "data" / "created_later.db").read_bytes() == b"kept"
+        assert not [p for p in fleet.iterdir() if p.name.startswith(".")]
+
+    def test_unknown_path_is_rejected(self, engine, fleet, tmp_path):
+        """Restoring a path the snapshot does not contain is an error."""
+        snapshot = engine.create([fleet])
+
+        with pytest.raises(RepositoryError):
+            engine.restore(snapshot["id"], tmp_path / "out", [f"{fleet}/missing"])
+
+
+class TestBackupCli:
+    """Test the command-line entry point."""
+
+    def test_create_list_verify(self, tmp_path, source, capsys):
+        """The CLI creates, lists and verifies snapshots."""
+        repo = str(tmp_path / "repository")
+
+        assert main(["--repo", repo, "--workers", "1", "create", str(source)]) == 0
+        assert main(["--repo", repo, "list"]) == 0
+        assert main(["--repo", repo, "verify", "--full"]) == 0
+
+        output = capsys.readouterr().out
+        assert "2 files" in output
+        assert "Backup verification: OK" in output
+
+    def test_restore_agent_from_latest(self, tmp_path, source, capsys):
+        """restore --agent resolves the agent directory and the latest snapshot."""
+        repo = str(tmp_path / "repository")
+        main(["--repo", repo, "create", str(source)])
+
+        code = main(
+            [
+                "--repo",
+                repo,
+                "restore",
+                "latest",
+                str(tmp_path / "out"),
+                "--agent",
+                "datum",
+                "--agents-dir",
+                str(source),
+            ]
+        )
+
+        assert code == 0
+        assert "Restored 2 files" in capsys.readouterr().out
+        assert (tmp_path / "out" / str(source).lstrip("/") / "datum" / "data").is_dir()
+
+    def test_unknown_snapshot_fails(self, tmp_path):
+        """Repository errors are reported with a non-zero exit status."""
+        repo = str(tmp_path / "repository")
+        assert main(["--repo", repo, "restore", "missing", str(tmp_path / "out")]) == 1
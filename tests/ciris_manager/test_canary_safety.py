@@ -17,6 +17,7 @@ from ciris_manager.models import (
     DeploymentStatus,
 )
 
+AGENT_HTTP_CLIENT = "ciris_manager.deployment.orchestrator.get_agent_http_client"
 
 class TestCanaryGroupHealth:
     """Test the _check_canary_group_health method."""
@@ -64,7 +65,7 @@ class TestCanaryGroupHealth:
         # Mock sleep to speed up tests
         with patch("asyncio.sleep", new_callable=AsyncMock):
             # Mock HTTP responses
-            with patch("httpx.AsyncClient") as mock_client_class:
+            with patch(AGENT_HTTP_CLIENT) as mock_client_class:
                 mock_client = AsyncMock()
                 mock_client_class.return_value.__aenter__.return_value = mock_client
 
@@ -126,7 +127,7 @@ class TestCanaryGroupHealth:
         """Test timeout when agent never reaches WORK state."""
         deployment_id = "test-deploy-2"
 
-        with patch("httpx.AsyncClient") as mock_client_class:
+        with patch(AGENT_HTTP_CLIENT) as mock_client_class:
             mock_client = AsyncMock()
             mock_client_class.return_value.__aenter__.return_value = mock_client
 
@@ -157,7 +158,7 @@ class TestCanaryGroupHealth:
         """Test failure when agent has critical incident during stability period."""
         deployment_id = "test-deploy-3"
 
-        with patch("httpx.AsyncClient") as mock_client_class:
+        with patch(AGENT_HTTP_CLIENT) as mock_client_class:
             mock_client = AsyncMock()
             mock_client_class.return_value.__aenter__.return_value = mock_client
 
@@ -208,7 +209,7 @@ class TestCanaryGroupHealth:
         """Test when agent reaches WORK but then leaves it."""
         deployment_id = "test-deploy-4"
 
-        with patch("httpx.AsyncClient") as mock_client_class:
+        with patch(AGENT_HTTP_CLIENT) as mock_client_class:
             mock_client = AsyncMock()
             mock_client_class.return_value.__aenter__.return_value = mock_client
 
@@ -257,7 +258,7 @@ class TestCanaryGroupHealth:
         """Test graceful handling of network errors."""
         deployment_id = "test-deploy-5"
 
-        with patch("httpx.AsyncClient") as mock_client_class:
+        with patch(AGENT_HTTP_CLIENT) as mock_client_class:
             mock_client = AsyncMock()
             mock_client_class.return_value.__aenter__.return_value = mock_client
 
@@ -322,7 +323,7 @@ class TestCanaryGroupHealth:
 
         # Mock asyncio.sleep to speed up test
         with patch("asyncio.sleep", new_callable=AsyncMock):
-            with patch("httpx.AsyncClient") as mock_client_class:
+            with patch(AGENT_HTTP_CLIENT) as mock_client_class:
                 mock_client = AsyncMock()
                 mock_client_class.return_value.__aenter__.return_value = mock_client
 
@@ -368,6 +369,71 @@ class TestCanaryGroupHealth:
                     # Should succeed because at least one agent reached WORK
                     assert result[0] is True  # First element is success boolean
 
+    @pytest.mark.asyncio
+    async def test_quorum_requires_multiple_stable_agents(self, orchestrator):
+        """Test that a phase waits until required_stable agents are stable."""
+        agents = []
+        for i, port in enumerate([8081, 8082, 8083]):
+            agent = Mock(spec=AgentInfo)
+            agent.agent_id = f"agent-{i}"
+            agent.agent_name = f"Agent {i}"
+            agent.api_port = port
+            agent.is_running = True
+            agent.occurrence_id = None
+            agent.server_id = "main"
+            agents.append(agent)
+
+        with patch("asyncio.sleep", new_callable=AsyncMock):
+            with patch(AGENT_HTTP_CLIENT) as mock_client_class:
+                mock_client = AsyncMock()
+                mock_client_class.return_value.__aenter__.return_value = mock_client
+
+                with patch("ciris_manager.agent_auth.get_agent_auth") as mock_auth:
+                    mock_auth.return_value.get_auth_headers.return_value = {
+                        "Authorization": "Bearer test"
+                    }
+
+                    def get_response(url, *args, **kwargs):
+                        if "telemetry" in url:
+                            return Mock(
+                                status_code=200, json=lambda: {"data": {"recent_incidents": []}}
+                            )
+                        # Agent on 8083 never leaves WAKEUP
+                        state = "wakeup" if "8083" in url else "work"
+                        return Mock(
+                            status_code=200,
+                            json=lambda: {"data": {"cognitive_state": state, "version": "2.0.0"}},
+                        )
+
+                    mock_client.get.side_effect = get_response
+
+                    success, results = await orchestrator._check_canary_group_health(
+                        "test-deploy-7",
+                        agents,
+                        "test",
+                        wait_for_work_minutes=0.05,
+                        stability_minutes=0,
+                        required_stable=2,
+                    )
+                    assert success is True
+                    assert sorted(results["stable_agents"]) == ["agent-0", "agent-1"]
+                    assert len(results["time_to_work_samples"]) == 2
+                    # The agent still in WAKEUP is kept as a censored sample
+                    assert len(results["censored_time_to_work"]) == 1
+
+                    # Three stable agents can never be reached
+                    success, results = await orchestrator._check_canary_group_health(
+                        "test-deploy-8",
+                        agents,
+                        "test",
+                        wait_for_work_minutes=0.01,
+                        stability_minutes=0,
+                        required_stable=3,
+                    )
+                    assert success is False
+                    assert len(results["stable_agents"]) == 2
+                    assert results["censored_time_to_work"] == [0.01]
+
 
 class TestCanaryDeploymentFlow:
     """Test the complete canary deployment flow with safety checks."""
@@ -651,6 +717,51 @@ class TestCanaryDeploymentFlow:
             # Verify update_agent_group was called for all phases
             assert orchestrator._update_agent_group.call_count == 3
 
+    @pytest.mark.asyncio
+    async def test_general_waves_halt_on_failed_wave(self, orchestrator, tmp_path):
+        """Test that a failed general wave stops the remaining waves."""
+        from ciris_manager.agent_registry import AgentRegistry
+
+        registry = AgentRegistry(tmp_path / "waves.json")
+        agents = []
+        for i in range(12):
+            agent = Mock(spec=AgentInfo)
+            agent.agent_id = f"general-{i}"
+            agent.is_running = True
+            registry.register_agent(agent.agent_id, agent.agent_id, 8100 + i, "test", "test.yml")
+            registry.set_canary_group(agent.agent_id, "general")
+            agents.append(agent)
+        orchestrator.manager.agent_registry = registry
+
+        notification = UpdateNotification(
+            agent_image="test:v2", message="Test update", strategy="canary"
+        )
+        orchestrator._check_canary_group_health = AsyncMock(
+            return_value=(False, {"failed": True, "reason": "timeout"})
+        )
+
+        with patch("ciris_manager.audit.audit_deployment_action"):
+            deployment_id = "test-deploy"
+            orchestrator.deployments[deployment_id] = DeploymentStatus(
+                deployment_id=deployment_id,
+                notification=notification,
+                status="in_progress",
+                message="Starting deployment",
+                agents_total=12,
+                started_at=datetime.now(timezone.utc).isoformat(),
+            )
+
+            await orchestrator._run_canary_deployment(deployment_id, notification, agents)
+
+            status = orchestrator.deployments[deployment_id]
+            assert status.status == "failed"
+            assert "7 agents not updated" in status.message
+
+            # Only the first wave was updated and checked
+            assert orchestrator._update_agent_group.call_count == 1
+            assert len(orchestrator._update_agent_group.call_args[0][2]) == 5
+            assert orchestrator._check_canary_group_health.call_count == 1
+
     @pytest.mark.asyncio
     async def test_empty_canary_groups(self, orchestrator):
         """Test deployment with no agents assigned to canary groups."""
@@ -0,0 +1,89 @@
+"""
+Tests for adaptive canary scheduling.
+"""
+
+from ciris_manager.deployment.canary_schedule import (
+    ADAPTIVE_MIN_SAMPLES,
+    MIN_STABILITY_MINUTES,
+    MIN_WAIT_FOR_WORK_MINUTES,
+    CanarySchedule,
+)
+
+
+class TestCanarySchedule:
+    """Test CanarySchedule timing and wave sizing."""
+
+    def test_defaults_without_history(self):
+        """Test that the fixed defaults apply until enough samples exist."""
+        schedule = CanarySchedule([2.0] * (ADAPTIVE_MIN_SAMPLES - 1), 15)
+
+        assert not schedule.confident
+        assert schedule.wait_for_work_minutes() == 15
+        assert schedule.stability_minutes(0) == 1
+        assert schedule.stability_minutes(2) == 1
+
+    def test_wait_follows_observed_p95(self):
+        """Test that the wait is the p95 with margin, clamped to the defaults."""
+        schedule = CanarySchedule([4.0, 5.0, 5.5, 6.0, 7.0, 8.0], 15)
+        assert schedule.confident
+        assert schedule.percentile(0.95) == 8.0
+        assert schedule.wait_for_work_minutes() == 12
+
+        # Never above the default, never below the floor
+        assert CanarySchedule([30.0] * 10, 15).wait_for_work_minutes() == 15
+        fast = CanarySchedule([0.5] * 10, 15)
+        assert fast.wait_for_work_minutes() == MIN_WAIT_FOR_WORK_MINUTES
+
+    def test_later_waves_shorten_stability_when_confident(self):
+        """Test that only later waves shorten the stability window, never to zero."""
+        schedule = CanarySchedule([5.0] * 10, 15)
+
+        assert schedule.stability_minutes(0) == 1
+        assert schedule.stability_minutes(1) == MIN_STABILITY_MINUTES
+        assert MIN_STABILITY_MINUTES > 0
+
+    def test_censored_agents_keep_the_wait_long(self):
+        """Agents that never reached WORK stop fast agents from shrinking the wait."""
+        fast = [1.0] * 6
+        # The phase ended at 2 minutes with four agents still starting
+        schedule = CanarySchedule(fast, 15, censored_samples=[2.0] * 4)
+
+        assert schedule.confident
+        assert schedule.percentile(0.5) == 1.0
+        assert schedule.percentile(0.95) is None
+        assert schedule.wait_for_work_minutes() == 15
+
+        # Later observations beyond the censoring time carry the censored mass
+        schedule = CanarySchedule(fast + [8.0, 9.0], 15, censored_samples=[2.0] * 2)
+        assert schedule.percentile(0.95) == 9.0
+        assert schedule.wait_for_work_minutes() == 14
+
+    def test_required_stable_quorum(self):
+        """Test quorum sizing for small and large groups."""
+        schedule = CanarySchedule([], 15)
+
+        assert schedule.required_stable(0) == 1
+        assert schedule.required_stable(1) == 1
+        assert schedule.required_stable(15) == 2
+        assert schedule.required_stable(500) == 3
+
+    def test_plan_waves_grow(self):
+        """Test that waves grow geometrically and cover every agent once."""
+        agents = list(range(200))
+
+        waves = CanarySchedule([], 15).plan_waves(agents)
+        assert [len(w) for w in waves] == [20, 60, 120]
+        assert [a for w in waves for a in w] == agents
+
+        confident = CanarySchedule([5.0] * 10, 15).plan_waves(agents)
+        assert [len(w) for w in confident] == [40, 160]
+
+        many = CanarySchedule([], 15).plan_waves(list(range(1000)))
+        assert [len(w) for w in many] == [100, 300, 600]
+
+    def test_small_groups_single_wave(self):
+        """Test that small groups deploy in one wave."""
+        schedule = CanarySchedule([], 15)
+
+        assert schedule.plan_waves([1, 2, 3]) == [[1, 2, 3]]
+        assert schedule.plan_waves([]) == []
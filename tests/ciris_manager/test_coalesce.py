@@ -0,0 +1,106 @@
+"""
+Tests for request coalescing and the bounded TTL cache.
+"""
+
+import asyncio
+from unittest.mock import patch
+
+import pytest
+
+from ciris_manager.utils import coalesce
+from ciris_manager.utils.coalesce import Coalescer, TTLCache
+
+
+class TestCoalescer:
+    """Test sharing of concurrent fetches."""
+
+    @pytest.mark.asyncio
+    async def test_concurrent_fetches_share_one_call(self):
+        """Callers with the same key wait for the first caller's fetch."""
+        coalescer: Coalescer[str, int] = Coalescer()
+        release = asyncio.Event()
+        calls = []
+
+        async def fetch():
+            calls.append(1)
+            await release.wait()
+            return 42
+
+        tasks = [asyncio.create_task(coalescer.run("k", fetch)) for _ in range(4)]
+        await asyncio.sleep(0)
+        release.set()
+
+        assert await asyncio.gather(*tasks) == [42, 42, 42, 42]
+        assert len(calls) == 1
+        assert len(coalescer) == 0
+
+    @pytest.mark.asyncio
+    async def test_cancelled_leader_does_not_cancel_waiters(self):
+        """When the fetching caller is cancelled, a waiter fetches again instead."""
+        coalescer: Coalescer[str, str] = Coalescer()
+        started = asyncio.Event()
+        calls = []
+
+        async def fetch():
+            calls.append(1)
+            started.set()
+            await asyncio.sleep(0.05 if len(calls) == 1 else 0)
+            return "value"
+
+        leader = asyncio.create_task(coalescer.run("k", fetch))
+        await started.wait()
+        waiters = [asyncio.create_task(coalescer.run("k", fetch)) for _ in range(3)]
+        await asyncio.sleep(0)
+        leader.cancel()
+
+        assert await asyncio.gather(*waiters) == ["value"] * 3
+        assert leader.cancelled()
+        assert len(calls) == 2
+
+    @pytest.mark.asyncio
+    async def test_cancelled_waiter_leaves_fetch_running(self):
+        """Cancelling a waiter does not affect the fetch or the other callers."""
+        coalescer: Coalescer[str, str] = Coalescer()
+        release = asyncio.Event()
+
+        async def fetch():
+            await release.wait()
+            return "value"
+
+        leader = asyncio.create_task(coalescer.run("k", fetch))
+        waiter = asyncio.create_task(coalescer.run("k", fetch))
+        await asyncio.sleep(0)
+        waiter.cancel()
+        await asyncio.sleep(0)
+        release.set()
+
+        assert await leader == "value"
+        assert waiter.cancelled()
+
+
+class TestTTLCache:
+    """Test expiry and the entry bound."""
+
+    def test_expired_entries_are_dropped_on_read(self):
+        """An expired entry is removed when it is read."""
+        cache: TTLCache[str, int] = TTLCache(max_entries=4)
+        cache.put("a", 1, ttl=0.0)
+
+        assert cache.get("a") is None
+        assert len(cache) == 0
+
+    def test_size_is_bounded(self):
+        """Beyond max_entries, expired entries go first, then the oldest."""
+        cache: TTLCache[str, int] = TTLCache(max_entries=3)
+        with patch.object(coalesce.time, "monotonic", return_value=100.0):
+            cache.put("old", 0, ttl=60)
+            cache.put("short", 1, ttl=1)
+            cache.put("b", 2, ttl=60)
+        with patch.object(coalesce.time, "monotonic", return_value=110.0):
+            cache.put("c", 3, ttl=60)
+            assert len(cache) == 3
+            assert cache.get("short") is None
+            cache.put("d", 4, ttl=60)
+            assert len(cache) == 3
+            assert cache.get("old") is None
+            assert [cache.get(k) for k in ("b", "c", "d")] == [2, 3, 4]
@@ -6,7 +6,11 @@ import pytest
 import tempfile
 import yaml
 from pathlib import Path
-from ciris_manager.compose_generator import ComposeGenerator
+from ciris_manager.compose_generator import (
+    ComposeGenerator,
+    ComposeRequest,
+    carry_over_volatile_fields,
+)
 
 
 class TestComposeGenerator:
@@ -543,3 +547,135 @@ class TestComposeGenerator:
         # Should use default callback hostname (agents.ciris.ai)
         assert env["OAUTH_CALLBACK_BASE_URL"] == "https://agents.ciris.ai"
         assert env["OAUTH_ALLOWED_REDIRECT_DOMAINS"] == "agents.ciris.ai"
+
+
+class TestDiffAwareWrites:
+    """Test that unchanged compose files are not rewritten."""
+
+    @pytest.fixture
+    def generator(self):
+        """Create ComposeGenerator instance."""
+        return ComposeGenerator(
+            docker_registry="ghcr.io/cirisai", default_image="ciris-agent:latest"
+        )
+
+    def _generate(self, generator, agent_dir: Path, **params):
+        return generator.generate_compose(
+            agent_id="agent-scout",
+            agent_name="Scout",
+            port=8081,
+            template="scout",
+            agent_dir=agent_dir,
+            **params,
+        )
+
+    def test_write_compose_file_skips_identical_content(self, generator, tmp_path):
+        """Rewriting the same config leaves the file untouched."""
+        compose = self._generate(generator, tmp_path)
+        compose_path = tmp_path / "docker-compose.yml"
+
+        assert generator.write_compose_file(compose, compose_path)
+        mtime = compose_path.stat().st_mtime_ns
+        assert not generator.write_compose_file(compose, compose_path)
+        assert compose_path.stat().st_mtime_ns == mtime
+
+    def test_regenerating_unchanged_agent_writes_nothing(self, generator, tmp_path):
+        """Generation timestamps are carried over, so regenerating is a no-op."""
+        compose_path = tmp_path / "docker-compose.yml"
+        generator.write_compose_file(self._generate(generator, tmp_path), compose_path)
+
+        regenerated = self._generate(generator, tmp_path)
+        carry_over_volatile_fields(regenerated, yaml.safe_load(compose_path.read_text()))
+
+        assert not generator.write_compose_file(regenerated, compose_path)
+
+    def test_changed_config_is_written(self, generator, tmp_path):
+        """A real change is still written after carrying over timestamps."""
+        compose_path = tmp_path / "docker-compose.yml"
+        generator.write_compose_file(self._generate(generator, tmp_path), compose_path)
+
+        regenerated = self._generate(generator, tmp_path, use_mock_llm=False)
+        carry_over_volatile_fields(regenerated, yaml.safe_load(compose_path.read_text()))
+
+        assert generator.write_compose_file(regenerated, compose_path)
+        loaded = yaml.safe_load(compose_path.read_text())
+        assert "CIRIS_MOCK_LLM" not in loaded["services"]["agent-scout"]["environment"]
+
+
+class TestComposeBatch:
+    """Test batched generation for deployment groups."""
+
+    @pytest.fixture
+    def generator(self):
+        """Create a compose generator."""
+        return ComposeGenerator(
+            docker_registry="ghcr.io/cirisai", default_image="ciris-agent:latest"
+        )
+
+    def _request(self, root: Path, agent_id: str, port: int, **params) -> ComposeRequest:
+        agent_dir = root / agent_id
+        return ComposeRequest(
+            agent_id=agent_id,
+            compose_path=agent_dir / "docker-compose.yml",
+            params={
+                "agent_name": agent_id,
+                "port": port,
+                "template": "scout",
+                "agent_dir": agent_dir,
+                **params,
+            },
+        )
+
+    def test_regenerating_unchanged_agents_writes_nothing(self, generator, tmp_path):
+        """Generation timestamps are carried over, so a second pass is a no-op."""
+        requests = [self._request(tmp_path, f"agent-{i}", 8080 + i) for i in range(3)]
+
+        first = generator.generate_batch(requests)
+        mtimes = [r.compose_path.stat().st_mtime_ns for r in requests]
+        second = generator.generate_batch(requests)
+
+        assert first.changed == ["agent-0", "agent-1", "agent-2"]
+        assert second.changed == []
+        assert second.unchanged == ["agent-0", "agent-1", "agent-2"]
+        assert second.hashes == first.hashes
+        assert [r.compose_path.stat().st_mtime_ns for r in requests] == mtimes
+
+    def test_only_changed_agents_are_reported(self, generator, tmp_path):
+        """A change to one agent leaves the others reported unchanged."""
+        requests = [self._request(tmp_path, f"agent-{i}", 8080 + i) for i in range(3)]
+        generator.generate_batch(requests)
+
+        requests[1] = self._request(tmp_path, "agent-1", 8080 + 1, use_mock_llm=False)
+        changes = generator.generate_batch(requests)
+
+        assert changes.changed == ["agent-1"]
+        assert changes.unchanged == ["agent-0", "agent-2"]
+        assert changes.is_changed("agent-1")
+        assert not changes.is_changed("agent-0")
+        loaded = yaml.safe_load((tmp_path / "agent-1" / "docker-compose.yml").read_text())
+        assert "CIRIS_MOCK_LLM" not in loaded["services"]["agent-1"]["environment"]
+
+    def test_dry_run_and_env_files(self, generator, tmp_path):
+        """Dry runs report changes without writing; .env changes count as changes."""
+        request = self._request(tmp_path, "agent-a", 8080)
+        request.env_path = tmp_path / "agent-a" / ".env"
+        request.env_vars = {"OPENAI_API_KEY": "sk-1"}
+
+        dry = generator.generate_batch([request], dry_run=True)
+        assert dry.changed == ["agent-a"]
+        assert not request.compose_path.exists()
+
+        generator.generate_batch([request])
+        request.env_vars = {"OPENAI_API_KEY": "sk-2"}
+        changes = generator.generate_batch([request])
+
+        assert changes.changed == ["agent-a"]
+        assert request.env_path.read_text() == "OPENAI_API_KEY=sk-2\n"
+
+    def test_failures_are_isolated(self, generator, tmp_path):
+        """A request that cannot be generated does not stop the batch."""
+        bad = ComposeRequest(agent_id="broken", compose_path=tmp_path / "x.yml", params={})
+        changes = generator.generate_batch([bad, self._request(tmp_path, "agent-ok", 8080)])
+
+        assert "broken" in changes.failed
+        assert changes.changed == ["agent-ok"]
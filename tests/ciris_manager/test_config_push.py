@@ -0,0 +1,245 @@
+"""
+Tests for live agent configuration push.
+"""
+
+from unittest.mock import AsyncMock, MagicMock, patch
+
+import pytest
+
+from ciris_manager.config_push import (
+    LIVE_CONFIG_ENDPOINT,
+    AgentConfigPusher,
+    diff_service_config,
+)
+
+
+def _service(env, image="ghcr.io/cirisai/ciris-agent:1.0", ports=("8080:8080",)):
+    return {
+        "image": image,
+        "ports": list(ports),
+        "volumes": ["./data:/app/data"],
+        "environment": env,
+    }
+
+
+class TestDiffServiceConfig:
+    """Test compose service diffing."""
+
+    def test_env_only_change(self):
+        """Changed, added and removed env vars are reported without needing a recreate."""
+        old = _service({"OPENAI_MODEL": "gpt-4o", "DISCORD_TOKEN": "x", "KEEP": "1"})
+        new = _service(["OPENAI_MODEL=gpt-4o-mini", "KEEP=1", "CIRIS_ADAPTER=api"])
+
+        change = diff_service_config(old, new)
+
+        assert change.env_changes == {
+            "OPENAI_MODEL": "gpt-4o-mini",
+            "CIRIS_ADAPTER": "api",
+            "DISCORD_TOKEN": None,
+        }
+        assert not change.requires_recreate
+
+    def test_image_and_port_changes_require_recreate(self):
+        """Image, volume and port changes cannot be applied live."""
+        old = _service({"A": "1"})
+        new = _service({"A": "1"}, image="ghcr.io/cirisai/ciris-agent:1.1", ports=("8081:8080",))
+
+        change = diff_service_config(old, new)
+
+        assert change.recreate_fields == ["image", "ports"]
+        assert change.requires_recreate
+        assert change.env_changes == {}
+
+    def test_any_non_env_change_requires_recreate(self):
+        """Labels, healthchecks, env_file and unknown keys are not pushed live."""
+        old = {**_service({"A": "1"}), "labels": {"a": "1"}, "healthcheck": {"interval": "30s"}}
+        new = {
+            **_service({"A": "2"}),
+            "labels": {"a": "2"},
+            "healthcheck": {"interval": "10s"},
+            "env_file": [".env"],
+            "deploy": {"resources": {"limits": {"memory": "1g"}}},
+        }
+
+        change = diff_service_config(old, new)
+
+        assert change.recreate_fields == ["deploy", "env_file", "healthcheck", "labels"]
+        assert change.requires_recreate
+        assert change.env_changes == {"A": "2"}
+
+
+def _mock_client(response):
+    client = MagicMock()
+    client.__aenter__ = AsyncMock(return_value=client)
+    client.__aexit__ = AsyncMock(return_value=None)
+    client.put = AsyncMock(return_value=response)
+    return client
+
+
+def _response(status_code, body=None):
+    response = MagicMock()
+    response.status_code = status_code
+    response.json.return_value = body or {}
+    response.text = ""
+    return response
+
+
+class TestAgentConfigPusher:
+    """Test delivery and acknowledgment of config documents."""
+
+    @pytest.mark.asyncio
+    async def test_acknowledged_push(self):
+        """The agent echoing the version counts as an acknowledgment."""
+        client = _mock_client(_response(200, {"data": {"applied_version": 3}}))
+        with patch("httpx.AsyncClient", return_value=client):
+            result = await AgentConfigPusher().push(
+                "http://localhost:8080", {"Authorization": "Bearer t"}, 3, {"A": "1", "B": None}
+            )
+
+        assert result.acknowledged
+        url = client.put.call_args[0][0]
+        document = client.put.call_args[1]["json"]
+        assert url == f"http://localhost:8080{LIVE_CONFIG_ENDPOINT}"
+        assert document["version"] == 3
+        assert document["environment"] == {"A": "1"}
+        assert document["removed"] == ["B"]
+
+    @pytest.mark.asyncio
+    async def test_version_mismatch_is_not_acknowledged(self):
+        """A stale acknowledgment is rejected."""
+        client = _mock_client(_response(200, {"applied_version": 2}))
+        with patch("httpx.AsyncClient", return_value=client):
+            result = await AgentConfigPusher().push("http://agent", {}, 3, {"A": "1"})
+
+        assert not result.acknowledged
+        assert result.supported
+
+    @pytest.mark.asyncio
+    async def test_old_agent_is_unsupported(self):
+        """Agents without the endpoint are reported as unsupported."""
+        client = _mock_client(_response(404))
+        with patch("httpx.AsyncClient", return_value=client):
+            result = await AgentConfigPusher().push("http://agent", {}, 1, {"A": "1"})
+
+        assert not result.acknowledged
+        assert not result.supported
+
+
+class TestApplyConfigLive:
+    """Test that live config is persisted before it is pushed."""
+
+    @pytest.fixture
+    def manager(self):
+        """Manager stand-in with a remote agent."""
+        from ciris_manager.manager import CIRISManager
+
+        manager = MagicMock(spec=CIRISManager)
+        manager.docker_client = MagicMock()
+        manager.docker_client.get_server_config.return_value = MagicMock(is_local=False)
+        manager._push_live_config = AsyncMock(return_value="pushed")
+        return manager
+
+    @pytest.mark.asyncio
+    async def test_remote_compose_synced_before_push(self, manager):
+        """The remote compose file gets the new env before the agent does."""
+        from ciris_manager.manager import CIRISManager
+
+        agent = MagicMock(agent_id="a1", server_id="scout", compose_file="/opt/x.yml")
+        compose = {"services": {"a1": {"environment": {"A": "2"}}}}
+        manager._sync_compose_to_remote_server = AsyncMock(return_value=True)
+
+        result = await CIRISManager.apply_config_live(manager, agent, {"A": "2"}, compose)
+
+        assert result == "pushed"
+        manager._sync_compose_to_remote_server.assert_awaited_once_with(
+            "scout", "/opt/x.yml", compose
+        )
+
+    @pytest.mark.asyncio
+    async def test_no_push_without_persisted_compose(self, manager):
+        """If the compose file cannot be written, nothing is applied live."""
+        from ciris_manager.manager import CIRISManager
+
+        agent = MagicMock(agent_id="a1", server_id="scout", compose_file="/opt/x.yml")
+        manager._sync_compose_to_remote_server = AsyncMock(return_value=False)
+
+        assert await CIRISManager.apply_config_live(manager, agent, {"A": "2"}, {}) is None
+        manager._push_live_config.assert_not_called()
+
+
+class TestLiveConfigSurvivesRestart:
+    """Test that live-pushed agents are recreated rather than restarted."""
+
+    @pytest.fixture
+    def registry(self, tmp_path):
+        """Registry with one agent."""
+        from ciris_manager.agent_registry import AgentRegistry
+
+        registry = AgentRegistry(tmp_path / "metadata.json")
+        registry.register_agent(
+            agent_id="a1", name="A1", port=8001, template="scout", compose_file="/opt/x.yml"
+        )
+        return registry
+
+    @pytest.fixture
+    def manager(self, registry):
+        """Manager stand-in around a real registry."""
+        from ciris_manager.manager import CIRISManager
+
+        manager = MagicMock(spec=CIRISManager)
+        manager.agent_registry = registry
+        manager.config_pusher = MagicMock()
+        manager.config_pusher.push = AsyncMock(
+            return_value=MagicMock(acknowledged=True, version=1)
+        )
+        return manager
+
+    @pytest.mark.asyncio
+    async def test_acknowledged_push_marks_agent(self, manager, registry):
+        """An acknowledged push is recorded on the agent."""
+        from ciris_manager.manager import CIRISManager
+
+        agent = registry.get_agent("a1")
+        with patch("ciris_manager.agent_auth.get_agent_auth") as mock_auth:
+            mock_auth.return_value.get_auth_headers.return_value = {}
+            await CIRISManager._push_live_config(
+                manager, agent, MagicMock(is_local=True), {"A": "2"}
+            )
+
+        assert "live_config_applied_at" in registry.get_agent("a1").metadata
+
+    def test_only_containers_older_than_the_push_need_recreate(self, manager, registry):
+        """Containers created after the push already carry the pushed values."""
+        from ciris_manager.manager import CIRISManager
+
+        agent = registry.get_agent("a1")
+        old = MagicMock(attrs={"Created": "2020-01-01T00:00:00.123456789Z"})
+        new = MagicMock(attrs={"Created": "2999-01-01T00:00:00Z"})
+
+        assert not CIRISManager.needs_recreate_for_live_config(manager, agent, old)
+        registry.mark_live_config_applied("a1")
+        assert CIRISManager.needs_recreate_for_live_config(manager, agent, old)
+        assert not CIRISManager.needs_recreate_for_live_config(manager, agent, new)
+
+    @pytest.mark.asyncio
+    async def test_recreate_clears_mark(self, manager, registry):
+        """A successful recreate forgets the push."""
+        from ciris_manager.manager import CIRISManager
+
+        registry.mark_live_config_applied("a1")
+        manager.docker_client = MagicMock()
+        manager.docker_client.get_server_config.return_value = MagicMock(is_local=False)
+        orchestrator = MagicMock()
+        orchestrator._recreate_agent_container = AsyncMock(return_value=True)
+
+        with patch(
+            "ciris_manager.deployment.get_deployment_orchestrator", return_value=orchestrator
+        ):
+            assert await CIRISManager.recreate_agent_container(
+                manager, registry.get_agent("a1")
+            )
+
+        orchestrator._recreate_agent_container.assert_awaited_once_with(
+            "a1", server_id="main", new_image=None
+        )
+        assert "live_config_applied_at" not in registry.get_agent("a1").metadata
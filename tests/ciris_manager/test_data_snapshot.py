@@ -0,0 +1,120 @@
+"""
+Tests for golden data snapshots.
+"""
+
+import shutil
+import sqlite3
+import tempfile
+from pathlib import Path
+from unittest.mock import patch
+
+import pytest
+
+from ciris_manager.utils import permission_helper
+from ciris_manager.utils.data_snapshot import (
+    GoldenSnapshot,
+    copy_tree,
+    is_sqlite_database,
+)
+from ciris_manager.utils.permission_helper import swap_data_directory
+
+
+@pytest.fixture
+def agent_path():
+    """Create a temporary agent directory with some data."""
+    temp_dir = Path(tempfile.mkdtemp())
+    agent = temp_dir / "test-agent"
+    data = agent / "data"
+    (data / "nested").mkdir(parents=True)
+    (data / "nested" / "config.json").write_text('{"a": 1}')
+
+    conn = sqlite3.connect(data / "ciris_engine.db")
+    conn.execute("PRAGMA journal_mode=WAL")
+    conn.execute("CREATE TABLE t (v TEXT)")
+    conn.execute("INSERT INTO t VALUES ('initialized')")
+    conn.commit()
+    conn.close()
+
+    yield agent
+    shutil.rmtree(temp_dir)
+
+
+@pytest.fixture(autouse=True)
+def no_helper(tmp_path):
+    """Force the local (non-setuid) code paths."""
+    with patch.object(permission_helper, "PERMISSION_HELPER_PATH", tmp_path / "missing-helper"):
+        yield
+
+
+class TestCopyTree:
+    """Test tree copying."""
+
+    def test_copies_all_files(self, agent_path, tmp_path):
+        """Every regular file is copied with its contents."""
+        dst = tmp_path / "copy"
+        count = copy_tree(agent_path / "data", dst, max_workers=2)
+
+        assert count >= 2
+        assert (dst / "nested" / "config.json").read_text() == '{"a": 1}'
+
+    def test_consistent_sqlite_skips_side_files(self, agent_path, tmp_path):
+        """Databases are backed up and WAL/SHM files are not copied."""
+        (agent_path / "data" / "ciris_engine.db-wal").write_bytes(b"stale")
+        dst = tmp_path / "copy"
+        copy_tree(agent_path / "data", dst, consistent_sqlite=True)
+
+        assert not (dst / "ciris_engine.db-wal").exists()
+        assert is_sqlite_database(dst / "ciris_engine.db")
+        conn = sqlite3.connect(dst / "ciris_engine.db")
+        assert conn.execute("SELECT v FROM t").fetchone() == ("initialized",)
+        conn.close()
+
+
+class TestGoldenSnapshot:
+    """Test capture, validation and restore of golden snapshots."""
+
+    @pytest.mark.asyncio
+    async def test_capture_and_validity(self, agent_path):
+        """A captured snapshot is only valid for the version that produced it."""
+        snapshot = GoldenSnapshot(agent_path)
+        assert not snapshot.exists
+
+        assert await snapshot.capture("1.4.2") is True
+
+        assert snapshot.exists
+        assert snapshot.metadata["version"] == "1.4.2"
+        assert snapshot.is_valid_for("1.4.2")
+        assert not snapshot.is_valid_for("1.4.3")
+        assert not snapshot.is_valid_for(None)
+
+    @pytest.mark.asyncio
+    async def test_invalidate(self, agent_path):
+        """Invalidation removes both the tree and its metadata."""
+        snapshot = GoldenSnapshot(agent_path)
+        await snapshot.capture("1.0.0")
+
+        snapshot.invalidate()
+
+        assert not snapshot.exists
+        assert not snapshot.snapshot_path.exists()
+        assert snapshot.metadata is None
+
+    @pytest.mark.asyncio
+    async def test_restore_from_golden(self, agent_path):
+        """Restoring swaps out current data for a copy of the snapshot."""
+        snapshot = GoldenSnapshot(agent_path)
+        await snapshot.capture("1.0.0")
+        (agent_path / "data" / "user-conversation.txt").write_text("jailbreak attempt")
+
+        tombstone = await swap_data_directory(agent_path, from_golden=True)
+
+        data = agent_path / "data"
+        assert tombstone is not None
+        assert (tombstone / "user-conversation.txt").exists()
+        assert not (data / "user-conversation.txt").exists()
+        assert (data / "nested" / "config.json").exists()
+        conn = sqlite3.connect(data / "ciris_engine.db")
+        assert conn.execute("SELECT v FROM t").fetchone() == ("initialized",)
+        conn.close()
+        # The snapshot itself is untouched
+        assert snapshot.exists
@@ -0,0 +1,172 @@
+"""
+Tests for deployment history archiving and queries.
+"""
+
+import json
+from unittest.mock import Mock
+
+import pytest
+
+from ciris_manager.deployment import DeploymentOrchestrator
+from ciris_manager.deployment.history import HOT_DEPLOYMENTS, DeploymentHistoryArchive
+from ciris_manager.deployment.state import DeploymentState
+from ciris_manager.models import DeploymentStatus
+
+
+def _deployment(index: int, month: int = 10, status: str = "completed", agents=None):
+    return DeploymentStatus(
+        deployment_id=f"deploy-{month:02d}-{index:03d}",
+        agents_total=2,
+        agents_updated=2 if status == "completed" else 0,
+        started_at=f"2026-{month:02d}-{1 + index % 28:02d}T{index % 24:02d}:00:00+00:00",
+        completed_at=f"2026-{month:02d}-{1 + index % 28:02d}T{index % 24:02d}:30:00+00:00",
+        status=status,
+        message=f"Deployment {index}",
+        events=[{"type": "agent_updated", "details": {"agent_id": a}} for a in agents or []],
+        canary_assignments={"explorers": ["scout"], "early_adopters": [], "general": []},
+    )
+
+
+class TestDeploymentHistoryArchive:
+    """Test the month-partitioned history archive."""
+
+    def test_archive_partitions_by_month_and_pages_newest_first(self, tmp_path):
+        """Deployments land in month partitions and queries page newest first."""
+        archive = DeploymentHistoryArchive(tmp_path)
+        archive.archive([_deployment(i, month=m) for m in (8, 9, 10) for i in range(5)])
+
+        assert sorted(p.name for p in tmp_path.glob("*.index.jsonl")) == [
+            "2026-08.index.jsonl",
+            "2026-09.index.jsonl",
+            "2026-10.index.jsonl",
+        ]
+
+        first = archive.query(limit=4)
+        second = archive.query(limit=4, offset=4)
+        assert [s["deployment_id"] for s in first] == [
+            "deploy-10-004",
+            "deploy-10-003",
+            "deploy-10-002",
+            "deploy-10-001",
+        ]
+        assert [s["deployment_id"] for s in second] == [
+            "deploy-10-000",
+            "deploy-09-004",
+            "deploy-09-003",
+            "deploy-09-002",
+        ]
+
+    def test_query_filters(self, tmp_path):
+        """Status, agent and time range filters combine."""
+        archive = DeploymentHistoryArchive(tmp_path)
+        archive.archive(
+            [
+                _deployment(1, month=9, agents=["datum"]),
+                _deployment(2, month=9, status="failed", agents=["sage"]),
+                _deployment(3, month=10, agents=["sage"]),
+            ]
+        )
+
+        assert [s["deployment_id"] for s in archive.query(status="failed")] == ["deploy-09-002"]
+        assert [s["deployment_id"] for s in archive.query(agent_id="sage")] == [
+            "deploy-10-003",
+            "deploy-09-002",
+        ]
+        # Canary assignments count as touched agents
+        assert len(archive.query(agent_id="scout")) == 3
+        window = archive.query(since="2026-09-03T00:00:00", until="2026-10-01T00:00:00")
+        assert [s["deployment_id"] for s in window] == ["deploy-09-002"]
+
+    def test_get_loads_full_record_and_duplicates_resolve(self, tmp_path):
+        """Archived records keep their events; re-archiving the same id is de-duplicated."""
+        archive = DeploymentHistoryArchive(tmp_path)
+        deployment = _deployment(1, agents=["datum"])
+        archive.archive([deployment])
+        deployment.message = "Archived twice"
+        archive.archive([deployment])
+
+        assert len(archive.query()) == 1
+        loaded = archive.get(deployment.deployment_id)
+        assert loaded.message == "Archived twice"
+        assert loaded.events[0]["details"]["agent_id"] == "datum"
+        assert archive.get("missing") is None
+
+
+class TestOrchestratorHistory:
+    """Test hot/archived deployment handling in the orchestrator."""
+
+    @pytest.fixture
+    def orchestrator(self, tmp_path):
+        """Create an orchestrator with isolated state and history."""
+        orchestrator = DeploymentOrchestrator(manager=Mock())
+        (tmp_path / "state").mkdir()
+        orchestrator._state_manager = DeploymentState(tmp_path / "state")
+        orchestrator._history = DeploymentHistoryArchive(tmp_path / "history")
+        orchestrator.deployments = {}
+        orchestrator.pending_deployments = {}
+        orchestrator.current_deployment = None
+        return orchestrator
+
+    @pytest.mark.asyncio
+    async def test_save_keeps_only_hot_deployments(self, orchestrator):
+        """State saves archive finished deployments beyond the hot set."""
+        for i in range(HOT_DEPLOYMENTS + 10):
+            d = _deployment(i, month=9 + i % 2)
+            orchestrator.deployments[d.deployment_id] = d
+        active = _deployment(99, month=1, status="in_progress")
+        orchestrator.deployments[active.deployment_id] = active
+
+        orchestrator._save_state()
+
+        # Active deployments stay hot no matter how old
+        assert len(orchestrator.deployments) == HOT_DEPLOYMENTS + 1
+        assert active.deployment_id in orchestrator.deployments
+        state = json.loads(orchestrator._state_manager.deployment_state_file.read_text())
+        assert len(state["deployments"]) == HOT_DEPLOYMENTS + 1
+        assert len(orchestrator._history.query(limit=100)) == 10
+
+        # Saving again does not re-archive
+        orchestrator._save_state()
+        assert len(orchestrator._history.query(limit=100)) == 10
+
+    @pytest.mark.asyncio
+    async def test_history_pages_across_hot_and_archive(self, orchestrator):
+        """History queries merge hot and archived deployments in time order."""
+        archived = [_deployment(i, month=8) for i in range(5)]
+        orchestrator._history.archive(archived)
+        for i in range(3):
+            d = _deployment(i, month=10, status="failed" if i == 1 else "completed")
+            orchestrator.deployments[d.deployment_id] = d
+
+        page = await orchestrator.get_deployment_history(limit=4)
+        assert [d["deployment_id"] for d in page] == [
+            "deploy-10-002",
+            "deploy-10-001",
+            "deploy-10-000",
+            "deploy-08-004",
+        ]
+        assert set(page[0]) == {
+            "deployment_id",
+            "started_at",
+            "completed_at",
+            "status",
+            "message",
+            "agents_total",
+            "agents_updated",
+            "agents_failed",
+        }
+
+        page = await orchestrator.get_deployment_history(limit=4, offset=4)
+        assert [d["deployment_id"] for d in page] == [
+            "deploy-08-003",
+            "deploy-08-002",
+            "deploy-08-001",
+            "deploy-08-000",
+        ]
+
+        failed = await orchestrator.get_deployment_history(status="failed")
+        assert [d["deployment_id"] for d in failed] == ["deploy-10-001"]
+
+        # Archived deployments are still available by id
+        status = await orchestrator.get_deployment_status("deploy-08-001")
+        assert status is not None and status.message == "Deployment 1"
@@ -5,7 +5,9 @@ Tests for deployment orchestrator.
 import pytest
 from unittest.mock import Mock, AsyncMock, patch
 import asyncio
+import time
 from datetime import datetime, timezone
+from pathlib import Path
 
 from ciris_manager.deployment import DeploymentOrchestrator
 from ciris_manager.models import (
@@ -877,6 +879,286 @@ class TestDeploymentOrchestrator:
 
                 assert result is False
 
+    @pytest.mark.asyncio
+    async def test_container_prestage_runs_only_when_enabled(self, orchestrator):
+        """Test that replacement containers are pre-staged only when configured."""
+        orchestrator._prestage_agent_container = AsyncMock(
+            return_value={"local": True, "image": "ghcr.io/cirisai/ciris-agent:v2.0"}
+        )
+
+        # Unset (Mock) config leaves pre-staging off
+        assert orchestrator._start_container_prestage("test-agent", "main", "img") is None
+
+        orchestrator.manager.config.updates.prestage_containers = True
+        task = orchestrator._start_container_prestage(
+            "test-agent", "main", "ghcr.io/cirisai/ciris-agent:v2.0"
+        )
+        await task
+
+        orchestrator._prestage_agent_container.assert_awaited_once_with(
+            "test-agent", "main", "ghcr.io/cirisai/ciris-agent:v2.0"
+        )
+        assert orchestrator._prestaged_containers[("main", "test-agent")]["local"] is True
+
+    @pytest.mark.asyncio
+    async def test_remote_prestage_does_not_block_event_loop(self, orchestrator):
+        """Test that a slow blocking image pull leaves other coroutines running."""
+        orchestrator.manager.docker_client.get_server_config.return_value.is_local = False
+        orchestrator._find_agent_container_name = Mock(return_value="ciris-test-agent")
+        orchestrator._regenerated_environment = AsyncMock(return_value=["CIRIS_AGENT_ID=a"])
+
+        old_container = Mock()
+        old_container.image.tags = ["ghcr.io/cirisai/ciris-agent:v1.0"]
+        old_container.attrs = {}
+        pulling = {"active": False, "ticks": 0}
+
+        class BlockingImages:
+            """docker-py style client: synchronous calls that take real time."""
+
+            def pull(self, image):
+                pulling["active"] = True
+                time.sleep(0.3)
+                pulling["active"] = False
+
+        docker_client = Mock()
+        docker_client.images = BlockingImages()
+        docker_client.containers.get.side_effect = lambda name: (
+            old_container if name == "ciris-test-agent" else Mock()
+        )
+        orchestrator.manager.docker_client.get_client.return_value = docker_client
+
+        async def ticker():
+            while True:
+                if pulling["active"]:
+                    pulling["ticks"] += 1
+                await asyncio.sleep(0.01)
+
+        ticks = asyncio.create_task(ticker())
+        try:
+            prestaged = await orchestrator._prestage_agent_container(
+                "test-agent", "scout", "ghcr.io/cirisai/ciris-agent:v2.0"
+            )
+        finally:
+            ticks.cancel()
+
+        assert prestaged["staged_name"] == "ciris-test-agent-next"
+        docker_client.containers.create.assert_called_once()
+        # A blocking pull on the event loop would leave the ticker frozen
+        assert pulling["ticks"] >= 5
+
+    @pytest.mark.asyncio
+    async def test_recreate_uses_prestaged_local_container(self, orchestrator):
+        """Test that a pre-staged local agent only needs compose up."""
+        new_image = "ghcr.io/cirisai/ciris-agent:v2.0"
+        staged = "/opt/ciris/agents/test-agent/docker-compose.next.yml"
+        orchestrator._prestaged_containers[("main", "test-agent")] = {
+            "local": True,
+            "image": new_image,
+            "staged_compose": staged,
+        }
+        orchestrator.manager.regenerate_agent_compose = AsyncMock()
+
+        async def mock_subprocess_exec(*args, **kwargs):
+            process = AsyncMock()
+            process.returncode = 0
+            output = b"running" if "inspect" in args else b""
+            process.communicate.return_value = (output, b"")
+            return process
+
+        with (
+            patch("pathlib.Path.exists", return_value=True),
+            patch("asyncio.create_subprocess_exec", side_effect=mock_subprocess_exec) as mock_exec,
+            patch(
+                "ciris_manager.deployment.orchestrator.fix_agent_permissions",
+                new_callable=AsyncMock,
+            ) as mock_permissions,
+            patch("asyncio.sleep", new_callable=AsyncMock),
+            patch("os.replace") as mock_replace,
+        ):
+            result = await orchestrator._recreate_agent_container("test-agent", "main", new_image)
+
+        assert result is True
+        # The staged compose only replaces the live one once the agent has stopped
+        mock_replace.assert_called_once_with(
+            staged, Path("/opt/ciris/agents/test-agent/docker-compose.yml")
+        )
+        compose_calls = [c[0] for c in mock_exec.call_args_list if "docker-compose" in c[0]]
+        assert len(compose_calls) == 1
+        assert compose_calls[0][-2:] == ("--pull", "missing")
+        orchestrator.manager.regenerate_agent_compose.assert_not_awaited()
+        mock_permissions.assert_not_awaited()
+        assert orchestrator._prestaged_containers == {}
+
+    @pytest.mark.asyncio
+    async def test_local_prestage_leaves_live_compose_untouched(self, orchestrator, tmp_path):
+        """Test that local pre-staging writes a side file and discarding removes it."""
+        agent_dir = tmp_path / "test-agent"
+        agent_dir.mkdir()
+        compose_file = agent_dir / "docker-compose.yml"
+        compose_file.write_text("services:\n  test-agent:\n    image: agent:v1\n")
+        original = compose_file.read_text()
+
+        async def regenerate(agent_id):
+            # Regeneration rewrites the live file (env changes etc.)
+            compose_file.write_text(original.replace("v1", "v1-regenerated"))
+
+        orchestrator.manager.regenerate_agent_compose = AsyncMock(side_effect=regenerate)
+        orchestrator.manager.config.updates.prestage_containers = True
+        process = AsyncMock(returncode=0)
+        process.communicate.return_value = (b"", b"")
+
+        orchestrator.agent_dir = tmp_path
+        orchestrator._is_local_server = Mock(return_value=True)
+
+        with (
+            patch("asyncio.create_subprocess_exec", return_value=process) as mock_exec,
+            patch(
+                "ciris_manager.deployment.orchestrator.fix_agent_permissions",
+                new_callable=AsyncMock,
+            ),
+        ):
+            task = orchestrator._start_container_prestage(
+                "test-agent", "main", "agent:v2", deployment_id="dep-1"
+            )
+            await task
+
+        staged = agent_dir / "docker-compose.next.yml"
+        assert compose_file.read_text() == original
+        assert "agent:v2" in staged.read_text()
+        assert str(staged) in mock_exec.call_args[0]
+
+        await orchestrator._discard_prestage(deployment_id="dep-1")
+        assert not staged.exists()
+        assert compose_file.read_text() == original
+        assert orchestrator._prestaged_containers == {}
+
+    @pytest.mark.asyncio
+    async def test_group_regenerates_local_composes_in_one_batch(
+        self, orchestrator, update_notification, sample_agents, tmp_path
+    ):
+        """Test that a group's local agents are regenerated once, not per agent."""
+        from ciris_manager.compose_generator import ComposeChangeSet
+
+        agents = sample_agents[:3]
+        orchestrator.deployments["dep-1"] = DeploymentStatus(
+            deployment_id="dep-1",
+            notification=update_notification,
+            agents_total=3,
+            started_at=datetime.now(timezone.utc).isoformat(),
+            status="in_progress",
+            message="Updating",
+        )
+        orchestrator._is_local_server = Mock(return_value=True)
+        orchestrator.manager.regenerate_local_composes = AsyncMock(
+            return_value=ComposeChangeSet(changed=["agent-0"], unchanged=["agent-1"])
+        )
+        orchestrator.manager.regenerate_agent_compose = AsyncMock()
+        seen_covered = []
+
+        async def update(deployment_id, notification, agent, peer_results=None):
+            seen_covered.append(agent.agent_id in orchestrator._regenerated_composes)
+            await orchestrator._prepare_local_compose(
+                agent.agent_id, tmp_path / "docker-compose.yml", None
+            )
+
+        with patch.object(orchestrator, "_update_single_agent", side_effect=update):
+            await orchestrator._update_agent_group("dep-1", update_notification, agents)
+
+        orchestrator.manager.regenerate_local_composes.assert_awaited_once_with(
+            ["agent-0", "agent-1", "agent-2"]
+        )
+        # agent-2 failed in the batch, so only it is regenerated individually
+        assert seen_covered == [True, True, False]
+        orchestrator.manager.regenerate_agent_compose.assert_awaited_once_with("agent-2")
+        assert orchestrator._regenerated_composes == set()
+
+    @pytest.mark.asyncio
+    async def test_discard_removes_remote_staging_container(self, orchestrator):
+        """Test that cancelling a deployment removes its remote "-next" containers."""
+        docker_client = Mock()
+        orchestrator.manager.docker_client.get_client.return_value = docker_client
+        orchestrator._prestaged_containers[("scout", "test-agent")] = {
+            "local": False,
+            "image": "agent:v2",
+            "container_name": "ciris-test-agent",
+            "staged_name": "ciris-test-agent-next",
+            "deployment_id": "dep-1",
+        }
+        orchestrator._prestaged_containers[("scout", "other")] = {
+            "local": False,
+            "image": "agent:v2",
+            "staged_name": "ciris-other-next",
+            "deployment_id": "dep-2",
+        }
+
+        await orchestrator._discard_prestage(deployment_id="dep-1")
+
+        docker_client.containers.get.assert_called_once_with("ciris-test-agent-next")
+        docker_client.containers.get.return_value.remove.assert_called_once_with(force=True)
+        assert list(orchestrator._prestaged_containers) == [("scout", "other")]
+
+    @pytest.mark.asyncio
+    async def test_prestage_discarded_while_running_cleans_up(self, orchestrator):
+        """Test that staging finished after a discard removes its own container."""
+        orchestrator.manager.config.updates.prestage_containers = True
+        docker_client = Mock()
+        orchestrator.manager.docker_client.get_client.return_value = docker_client
+        release = asyncio.Event()
+
+        async def slow_prestage(agent_id, server_id, new_image):
+            await release.wait()
+            return {"local": False, "image": new_image, "staged_name": "ciris-a1-next"}
+
+        orchestrator._prestage_agent_container = slow_prestage
+        task = orchestrator._start_container_prestage("a1", "scout", "agent:v2", "dep-1")
+        await asyncio.sleep(0)
+        await orchestrator._discard_prestage("a1", "scout")
+        release.set()
+        await task
+
+        assert orchestrator._prestaged_containers == {}
+        docker_client.containers.get.assert_called_once_with("ciris-a1-next")
+
+    @pytest.mark.asyncio
+    async def test_recreate_promotes_prestaged_remote_container(self, orchestrator):
+        """Test that a pre-staged remote container is renamed and started."""
+        new_image = "ghcr.io/cirisai/ciris-agent:v2.0"
+        orchestrator.manager.docker_client.get_server_config.return_value.is_local = False
+
+        old_container = Mock()
+        old_container.image.tags = ["ghcr.io/cirisai/ciris-agent:v1.0"]
+        old_container.attrs = {}
+        staged_container = Mock(status="running")
+        containers = {"ciris-test-agent": old_container, "ciris-test-agent-next": staged_container}
+
+        def rename(name):
+            containers[name] = staged_container
+
+        staged_container.rename.side_effect = rename
+        docker_client = Mock()
+        docker_client.containers.get.side_effect = lambda name: containers[name]
+        orchestrator.manager.docker_client.get_client.return_value = docker_client
+        orchestrator._sync_compose_to_remote_server = AsyncMock(return_value=True)
+
+        orchestrator._prestaged_containers[("scout", "test-agent")] = {
+            "local": False,
+            "image": new_image,
+            "container_name": "ciris-test-agent",
+            "staged_name": "ciris-test-agent-next",
+            "target_image": new_image,
+            "environment": {"CIRIS_AGENT_ID": "test-agent"},
+        }
+
+        with patch("asyncio.sleep", new_callable=AsyncMock):
+            result = await orchestrator._recreate_agent_container("test-agent", "scout", new_image)
+
+        assert result is True
+        old_container.remove.assert_called_once()
+        staged_container.rename.assert_called_once_with("ciris-test-agent")
+        staged_container.start.assert_called_once()
+        docker_client.containers.create.assert_not_called()
+        docker_client.images.pull.assert_not_called()
+
     @pytest.mark.asyncio
     async def test_pull_single_image_with_retry_success_first_attempt(self, orchestrator):
         """Test successful image pull on first attempt."""
@@ -0,0 +1,71 @@
+"""
+Tests for the deployment simulator harness.
+"""
+
+import pytest
+
+from ciris_manager.deployment.simulator import SimulationConfig, main, run_simulation
+
+
+def _config(**overrides):
+    base = dict(agents=12, time_scale=600.0, explorer_share=0.1, early_adopter_share=0.2)
+    base.update(overrides)
+    return SimulationConfig(**base)
+
+
+class TestDeploymentSimulator:
+    """Drive the real orchestrator against the simulated fleet."""
+
+    @pytest.mark.asyncio
+    async def test_canary_deployment_completes(self):
+        """Every phase runs and every agent is shut down, recreated and reaches WORK."""
+        report = await run_simulation(_config())
+
+        assert report.status == "completed"
+        assert report.agents_updated == 12
+        assert report.agents_failed == 0
+        assert report.http_calls["POST /v1/system/shutdown"] == 12
+        assert report.docker_calls["pull"] == 1
+        assert report.docker_calls["create"] == 12
+        for phase in ("explorer", "early adopter", "general"):
+            assert report.stages[f"health_check:{phase}"]["count"] == 1
+        assert report.stages["time_to_work"]["count"] == 12
+        assert report.state_saves["count"] > 0
+        assert report.simulated_seconds > report.wall_clock_seconds
+
+    @pytest.mark.asyncio
+    async def test_failures_are_injected(self):
+        """Rejected shutdowns fail agents without any container being recreated."""
+        report = await run_simulation(_config(strategy="immediate", shutdown_reject_rate=1.0))
+
+        assert report.status == "failed"
+        assert report.agents_failed == 12
+        assert "create" not in report.docker_calls
+
+    @pytest.mark.asyncio
+    async def test_pull_failure_aborts_deployment(self):
+        """A failed image pull stops the deployment before any agent is contacted."""
+        report = await run_simulation(_config(pull_failure_rate=1.0))
+
+        assert report.status == "failed"
+        assert report.http_calls == {}
+
+    @pytest.mark.asyncio
+    async def test_prestaging_shortens_downtime(self):
+        """Pre-staged containers only pay the start time once the old one stops."""
+        # A slower clock keeps event-loop scheduling delays from inflating downtime
+        timings = dict(
+            strategy="immediate", stop_seconds=10.0, recreate_seconds=8.0, time_scale=100.0
+        )
+        cold = await run_simulation(_config(**timings))
+        warm = await run_simulation(_config(prestage=True, **timings))
+
+        assert warm.status == "completed"
+        assert warm.stages["prestage"]["count"] == 12
+        assert warm.stages["downtime"]["mean"] < cold.stages["downtime"]["mean"] / 2
+
+    def test_cli_json_report(self, capsys):
+        """The CLI prints a JSON report and exits 0 on success."""
+        argv = ["--agents", "4", "--time-scale", "600", "--strategy", "immediate", "--json"]
+        assert main(argv) == 0
+        assert '"agents_updated": 4' in capsys.readouterr().out
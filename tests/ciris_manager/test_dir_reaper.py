@@ -0,0 +1,151 @@
+"""
+Tests for data directory swapping and background reaping.
+"""
+
+import shutil
+import tempfile
+from pathlib import Path
+from unittest.mock import AsyncMock, patch
+
+import pytest
+
+from ciris_manager.utils import permission_helper
+from ciris_manager.utils.dir_reaper import DirectoryReaper
+from ciris_manager.utils.permission_helper import REAP_PREFIX, swap_data_directory
+
+
+@pytest.fixture
+def agent_path():
+    """Create a temporary agent directory."""
+    temp_dir = Path(tempfile.mkdtemp())
+    agent = temp_dir / "test-agent"
+    agent.mkdir()
+    yield agent
+    shutil.rmtree(temp_dir)
+
+
+@pytest.fixture(autouse=True)
+def no_helper(tmp_path):
+    """Point the helper path somewhere that does not exist."""
+    with patch.object(permission_helper, "PERMISSION_HELPER_PATH", tmp_path / "missing-helper"):
+        yield
+
+
+class TestSwapDataDirectory:
+    """Test swapping in a fresh data directory."""
+
+    @pytest.mark.asyncio
+    async def test_swap_moves_old_data_aside(self, agent_path):
+        """Old data ends up in a tombstone and data/ is empty."""
+        data = agent_path / "data"
+        (data / "sub").mkdir(parents=True)
+        (data / "sub" / "db.sqlite").write_text("old")
+
+        tombstone = await swap_data_directory(agent_path)
+
+        assert tombstone is not None
+        assert tombstone.name.startswith(REAP_PREFIX)
+        assert (tombstone / "sub" / "db.sqlite").read_text() == "old"
+        assert data.is_dir()
+        assert list(data.iterdir()) == []
+
+    @pytest.mark.asyncio
+    async def test_swap_without_existing_data(self, agent_path):
+        """A missing data dir is simply created."""
+        tombstone = await swap_data_directory(agent_path)
+
+        assert tombstone is None
+        assert (agent_path / "data").is_dir()
+
+    @pytest.mark.asyncio
+    async def test_swap_fails_when_container_cannot_own_data(self, agent_path):
+        """Without privileges the swap is undone instead of leaving a manager-owned data/."""
+        data = agent_path / "data"
+        data.mkdir()
+        (data / "db.sqlite").write_text("old")
+
+        with (
+            patch("os.geteuid", return_value=1500),
+            patch("os.chown", side_effect=PermissionError("not permitted")),
+        ):
+            with pytest.raises(RuntimeError, match="fresh data directory"):
+                await swap_data_directory(agent_path)
+
+        assert (data / "db.sqlite").read_text() == "old"
+        assert not list(agent_path.glob(f"{REAP_PREFIX}*"))
+
+    @pytest.mark.asyncio
+    async def test_swap_uses_helper_when_installed(self, agent_path, tmp_path):
+        """The setuid helper is preferred and its stdout names the tombstone."""
+        helper = tmp_path / "helper"
+        helper.write_text("")
+        reap = agent_path / f"{REAP_PREFIX}123"
+        with (
+            patch.object(permission_helper, "PERMISSION_HELPER_PATH", helper),
+            patch.object(
+                permission_helper, "_run_helper", AsyncMock(return_value=(0, str(reap), ""))
+            ) as mock_run,
+        ):
+            tombstone = await swap_data_directory(agent_path)
+
+        mock_run.assert_called_once_with("--swap-data", str(agent_path))
+        assert tombstone == reap
+
+
+class TestDirectoryReaper:
+    """Test background deletion of tombstones."""
+
+    @pytest.mark.asyncio
+    async def test_reaps_scheduled_tree(self, agent_path):
+        """Scheduled trees are deleted in the background."""
+        tree = agent_path / f"{REAP_PREFIX}1"
+        for i in range(5):
+            (tree / f"dir{i}").mkdir(parents=True)
+            (tree / f"dir{i}" / "file").write_text("x")
+        (tree / "top-file").write_text("x")
+
+        reaper = DirectoryReaper(max_workers=2)
+        reaper.schedule(tree)
+        await reaper.drain()
+        await reaper.close()
+
+        assert not tree.exists()
+        assert reaper.reaped == 1
+        assert reaper.failed == 0
+
+    @pytest.mark.asyncio
+    async def test_reap_stale_only_picks_tombstones(self, agent_path):
+        """Leftover tombstones are found, live directories are untouched."""
+        (agent_path / f"{REAP_PREFIX}old").mkdir()
+        (agent_path / "data").mkdir()
+
+        reaper = DirectoryReaper()
+        assert reaper.reap_stale(agent_path) == 1
+        await reaper.drain()
+        await reaper.close()
+
+        assert not (agent_path / f"{REAP_PREFIX}old").exists()
+        assert (agent_path / "data").exists()
+
+    @pytest.mark.asyncio
+    async def test_permission_error_falls_back_to_helper(self, agent_path):
+        """Trees the manager cannot delete are handed to the helper."""
+        tree = agent_path / f"{REAP_PREFIX}2"
+        (tree / "locked").mkdir(parents=True)
+
+        reaper = DirectoryReaper()
+        with (
+            patch(
+                "ciris_manager.utils.dir_reaper._remove_entry",
+                side_effect=PermissionError("denied"),
+            ),
+            patch(
+                "ciris_manager.utils.dir_reaper.remove_tree", AsyncMock(return_value=True)
+            ) as mock_remove,
+        ):
+            reaper.schedule(tree)
+            await reaper.drain()
+        await reaper.close()
+
+        mock_remove.assert_called_once_with(tree)
+        assert reaper.reaped == 1
@@ -0,0 +1,171 @@
+"""
+Tests for LLM configuration validation.
+"""
+
+import asyncio
+from unittest.mock import MagicMock, patch
+
+import pytest
+
+from ciris_manager import llm_validator
+from ciris_manager.llm_validator import (
+    INVALID_KEY_ERROR,
+    LLMProbe,
+    clear_validation_cache,
+    validate_llm_config,
+    validate_llm_configs,
+    validate_stored_llm_configs,
+)
+
+
+class MockProvider:
+    """Local OpenAI-compatible provider standing in for httpx.AsyncClient."""
+
+    def __init__(self, keys=("sk-good-key",), models=("gpt-4o", "gpt-4o-mini"), delay=0.0):
+        self.keys = set(keys)
+        self.models = list(models)
+        self.delay = delay
+        self.requests = []
+        self.in_flight = 0
+        self.max_in_flight = 0
+
+    def client(self, *args, **kwargs):
+        client = MagicMock()
+        client.__aenter__ = self._enter(client)
+        client.__aexit__ = self._exit
+        client.get = self.get
+        return client
+
+    @staticmethod
+    def _enter(client):
+        async def enter(*args):
+            return client
+
+        return enter
+
+    async def _exit(self, *args):
+        return None
+
+    async def get(self, url, headers=None, **kwargs):
+        self.requests.append(url)
+        self.in_flight += 1
+        self.max_in_flight = max(self.max_in_flight, self.in_flight)
+        try:
+            await asyncio.sleep(self.delay)
+        finally:
+            self.in_flight -= 1
+
+        response = MagicMock()
+        if headers["Authorization"].removeprefix("Bearer ") not in self.keys:
+            response.status_code = 401
+        elif "rate-limited" in url:
+            response.status_code = 429
+        else:
+            response.status_code = 200
+            response.json.return_value = {"data": [{"id": m} for m in self.models]}
+        return response
+
+
+@pytest.fixture(autouse=True)
+def fresh_validation_cache():
+    clear_validation_cache()
+    yield
+    clear_validation_cache()
+
+
+class TestValidationCache:
+    """Test caching and coalescing of provider probes."""
+
+    @pytest.mark.asyncio
+    async def test_identical_validations_probe_once(self):
+        """Repeated and concurrent validations of the same key and model share a probe."""
+        provider = MockProvider(delay=0.01)
+        with patch("httpx.AsyncClient", side_effect=provider.client):
+            results = await asyncio.gather(
+                *(validate_llm_config("openai", "sk-good-key", "gpt-4o") for _ in range(5))
+            )
+            again = await validate_llm_config("openai", "sk-good-key", "gpt-4o")
+
+        assert len(provider.requests) == 1
+        assert all(r == (True, None, ["gpt-4o", "gpt-4o-mini"]) for r in results)
+        assert again == results[0]
+
+    @pytest.mark.asyncio
+    async def test_cache_key_includes_key_model_and_base(self):
+        """A different key, model or base URL is probed separately."""
+        provider = MockProvider(keys=("sk-good-key", "sk-other-key"))
+        with patch("httpx.AsyncClient", side_effect=provider.client):
+            await validate_llm_config("openai", "sk-good-key", "gpt-4o")
+            await validate_llm_config("openai", "sk-other-key", "gpt-4o")
+            await validate_llm_config("openai", "sk-good-key", "gpt-4o-mini")
+            await validate_llm_config("custom", "sk-good-key", "gpt-4o", "http://127.0.0.1:9/v1")
+
+        assert len(provider.requests) == 4
+        assert provider.requests[-1] == "http://127.0.0.1:9/v1/models"
+
+    @pytest.mark.asyncio
+    async def test_invalid_key_cached_but_transient_errors_not(self):
+        """Auth failures are definitive; rate limits are retried on the next call."""
+        provider = MockProvider()
+        with patch("httpx.AsyncClient", side_effect=provider.client):
+            for _ in range(2):
+                result = await validate_llm_config("openai", "sk-bad-key", "gpt-4o")
+            for _ in range(2):
+                await validate_llm_config(
+                    "custom", "sk-good-key", "gpt-4o", "http://rate-limited.local/v1"
+                )
+
+        assert result == (False, INVALID_KEY_ERROR, None)
+        assert len(provider.requests) == 3
+
+    @pytest.mark.asyncio
+    async def test_expired_entries_are_reprobed(self):
+        """Results older than the TTL are not reused."""
+        provider = MockProvider()
+        with patch("httpx.AsyncClient", side_effect=provider.client):
+            with patch.object(llm_validator, "VALIDATION_CACHE_TTL", 0.0):
+                await validate_llm_config("openai", "sk-good-key", "gpt-4o")
+                await validate_llm_config("openai", "sk-good-key", "gpt-4o")
+            await validate_llm_config("openai", "sk-good-key", "gpt-4o", use_cache=False)
+
+        assert len(provider.requests) == 3
+
+
+class TestBulkValidation:
+    """Test concurrent validation of many configs."""
+
+    @pytest.mark.asyncio
+    async def test_concurrency_is_bounded(self):
+        """No more than `concurrency` probes are in flight."""
+        provider = MockProvider(models=[f"m{i}" for i in range(6)], delay=0.01)
+        probes = [LLMProbe("openai", "sk-good-key", f"m{i}") for i in range(6)]
+        with patch("httpx.AsyncClient", side_effect=provider.client):
+            results = await validate_llm_configs(probes, concurrency=2)
+
+        assert all(valid for valid, _, _ in results)
+        assert provider.max_in_flight == 2
+        assert len(provider.requests) == 6
+
+    @pytest.mark.asyncio
+    async def test_stored_configs_report(self):
+        """Fleet validation reports primary and backup per agent without API keys."""
+        provider = MockProvider()
+        shared = {"provider": "openai", "api_key": "sk-good-key", "model": "gpt-4o"}
+        configs = {
+            "a": {"primary": shared, "backup": {**shared, "api_key": "sk-revoked"}},
+            "b": {"primary": shared},
+            "c": {"primary": {"provider": "openai", "api_key": "", "model": "gpt-4o"}},
+        }
+        with patch("httpx.AsyncClient", side_effect=provider.client):
+            report = await validate_stored_llm_configs(configs, concurrency=4)
+
+        assert len(provider.requests) == 2
+        assert report["a"]["primary"]["valid"] is True
+        assert report["a"]["backup"] == {
+            "provider": "openai",
+            "model": "gpt-4o",
+            "valid": False,
+            "error": INVALID_KEY_ERROR,
+        }
+        assert report["b"] == {"primary": report["a"]["primary"]}
+        assert report["c"] == {}
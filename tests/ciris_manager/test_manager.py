@@ -1327,6 +1327,46 @@ class TestRegenerateAgentCompose:
         assert "discord" in env["CIRIS_ADAPTER"]
         assert env["DISCORD_BOT_TOKEN"] == "test_token_123"
 
+    @pytest.mark.asyncio
+    async def test_regenerate_local_composes_reports_unchanged_agents(
+        self, manager, temp_dirs
+    ):
+        """Test that a batch regeneration only rewrites agents whose config changed."""
+        import yaml
+
+        compose_paths = {}
+        for i, agent_id in enumerate(["agent-a", "agent-b"]):
+            compose_path = temp_dirs["agents"] / agent_id / "docker-compose.yml"
+            compose_path.parent.mkdir()
+            env = {"CIRIS_AGENT_ID": agent_id, "CIRIS_ADAPTER": "api"}
+            compose_path.write_text(yaml.dump({"services": {agent_id: {"environment": env}}}))
+            manager.agent_registry.register_agent(
+                agent_id=agent_id,
+                name=agent_id,
+                port=8001 + i,
+                template="scout",
+                compose_file=str(compose_path),
+            )
+            compose_paths[agent_id] = compose_path
+
+        first = await manager.regenerate_local_composes(["agent-a", "agent-b", "missing"])
+        assert first.changed == ["agent-a", "agent-b"]
+        assert "missing" in first.failed
+
+        manager.agent_registry.set_adapter_config(
+            "agent-b", "discord", {"enabled": True, "env_vars": {"DISCORD_BOT_TOKEN": "t"}}
+        )
+        mtime = compose_paths["agent-a"].stat().st_mtime_ns
+        second = await manager.regenerate_local_composes(["agent-a", "agent-b"])
+
+        assert second.changed == ["agent-b"]
+        assert second.unchanged == ["agent-a"]
+        assert compose_paths["agent-a"].stat().st_mtime_ns == mtime
+        env = yaml.safe_load(compose_paths["agent-b"].read_text())["services"]["agent-b"][
+            "environment"
+        ]
+        assert env["DISCORD_BOT_TOKEN"] == "t"
+
     @pytest.mark.asyncio
     async def test_regenerate_compose_agent_not_found(self, manager):
         """Test error when agent is not found."""
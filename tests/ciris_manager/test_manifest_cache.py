@@ -0,0 +1,89 @@
+"""
+Tests for the image-keyed adapter manifest cache.
+"""
+
+import asyncio
+from unittest.mock import AsyncMock
+
+import pytest
+
+from ciris_manager.manifest_cache import AdapterManifestCache
+
+
+class TestAdapterManifestCache:
+    """Test sharing, coalescing and invalidation."""
+
+    @pytest.mark.asyncio
+    async def test_agents_on_same_image_fetch_once(self):
+        """Concurrent requests from many agents on one image share a single fetch."""
+        cache = AdapterManifestCache()
+        release = asyncio.Event()
+        calls = 0
+
+        async def fetch():
+            nonlocal calls
+            calls += 1
+            await release.wait()
+            return {"data": {"adapters": ["discord"]}}
+
+        tasks = [
+            asyncio.create_task(cache.get_or_fetch("sha256:aaa", "types", fetch))
+            for _ in range(50)
+        ]
+        await asyncio.sleep(0)
+        release.set()
+        results = await asyncio.gather(*tasks)
+
+        assert calls == 1
+        assert all(r == {"data": {"adapters": ["discord"]}} for r in results)
+        assert await cache.get_or_fetch("sha256:aaa", "types", fetch) == results[0]
+        assert calls == 1
+        assert cache.stats()["hits"] == 1
+
+    @pytest.mark.asyncio
+    async def test_images_and_keys_are_separate(self):
+        """A different image or adapter type is a separate entry."""
+        cache = AdapterManifestCache()
+        fetch = AsyncMock(side_effect=[{"v": 1}, {"v": 2}, {"v": 3}])
+
+        assert await cache.get_or_fetch("sha256:aaa", "manifest:discord", fetch) == {"v": 1}
+        assert await cache.get_or_fetch("sha256:bbb", "manifest:discord", fetch) == {"v": 2}
+        assert await cache.get_or_fetch("sha256:aaa", "manifest:api", fetch) == {"v": 3}
+        assert fetch.await_count == 3
+
+    @pytest.mark.asyncio
+    async def test_unknown_image_and_none_results_are_not_cached(self):
+        """Without an image ID, or when the agent has no document, every call fetches."""
+        cache = AdapterManifestCache()
+        fetch = AsyncMock(return_value=None)
+
+        await cache.get_or_fetch(None, "types", AsyncMock(return_value={"v": 1}))
+        await cache.get_or_fetch("sha256:aaa", "manifest:x", fetch)
+        await cache.get_or_fetch("sha256:aaa", "manifest:x", fetch)
+
+        assert fetch.await_count == 2
+        assert cache.stats()["entries"] == 0
+
+    @pytest.mark.asyncio
+    async def test_errors_are_not_cached(self):
+        """A failed fetch propagates and the next request retries."""
+        cache = AdapterManifestCache()
+        fetch = AsyncMock(side_effect=[RuntimeError("agent down"), {"v": 1}])
+
+        with pytest.raises(RuntimeError):
+            await cache.get_or_fetch("sha256:aaa", "types", fetch)
+        assert await cache.get_or_fetch("sha256:aaa", "types", fetch) == {"v": 1}
+
+    def test_invalidate_and_eviction(self):
+        """Invalidation drops one or all images; old images are evicted past the limit."""
+        cache = AdapterManifestCache(max_images=2)
+        cache.put("sha256:aaa", "types", {"v": 1})
+        cache.put("sha256:bbb", "types", {"v": 2})
+        cache.put("sha256:ccc", "types", {"v": 3})
+
+        assert cache.get("sha256:aaa", "types") is None
+        cache.invalidate("sha256:bbb")
+        assert cache.get("sha256:bbb", "types") is None
+        assert cache.get("sha256:ccc", "types") == {"v": 3}
+        cache.invalidate()
+        assert cache.stats()["images"] == 0
@@ -175,12 +175,13 @@ class TestMultiServerAgentCreation:
             agent_info = agents[0]
             assert agent_info.server_id == "scout"
 
-            # Verify Docker API was called multiple times:
-            # - 1 time for base directory creation
-            # - 6 times for subdirectories (data, data_archive, logs, config, audit_keys, .secrets)
+            # Verify Docker API was called twice:
+            # - 1 time for the whole directory skeleton (batched into one command)
             # - 1 time for the actual agent container
-            # Note: Permission fix was consolidated or optimized out
-            assert mock_remote_docker.containers.run.call_count == 8
+            assert mock_remote_docker.containers.run.call_count == 2
+            skeleton_cmd = mock_remote_docker.containers.run.call_args_list[0][1]["command"]
+            for dir_name in ["data", "data_archive", "logs", "config", "audit_keys", ".secrets"]:
+                assert f"/{dir_name} " in skeleton_cmd
 
             # Verify the last call (the agent container) has the expected image
             last_call = mock_remote_docker.containers.run.call_args_list[-1]
@@ -6,7 +6,9 @@ import pytest
 import tempfile
 import json
 from pathlib import Path
-from ciris_manager.port_manager import PortManager
+from unittest.mock import patch
+from ciris_manager import port_manager as port_manager_module
+from ciris_manager.port_manager import PortManager, listening_ports
 
 
 class TestPortManager:
@@ -187,3 +189,95 @@ class TestPortManager:
         # Should work normally
         port = pm.allocate_port("agent-1")
         assert port == 8080
+
+    def test_reverse_index(self, port_manager):
+        """Ports map back to their owning agent until released."""
+        port = port_manager.allocate_port("agent-1")
+        assert port_manager.get_port_owner(port) == "agent-1"
+
+        port_manager.release_port("agent-1")
+        assert port_manager.get_port_owner(port) is None
+        assert port_manager.is_port_available(port)
+
+    def test_released_port_is_reused_first(self, port_manager):
+        """The lowest free port is handed out after a release."""
+        port_manager.allocate_port("agent-1")
+        port_manager.allocate_port("agent-2")
+        port_manager.release_port("agent-1")
+
+        assert port_manager.allocate_port("agent-3") == 8080
+
+    def test_skips_ports_listening_on_host(self, port_manager):
+        """Ports bound by other processes are skipped using one socket snapshot."""
+        with (
+            patch.object(
+                port_manager_module, "listening_ports", return_value={8080, 8081}
+            ) as mock_snapshot,
+            patch.object(port_manager, "_is_port_in_use") as mock_probe,
+        ):
+            assert port_manager.allocate_port("agent-1") == 8082
+
+        mock_snapshot.assert_called_once()
+        mock_probe.assert_not_called()
+        # Skipped ports were not recorded as allocated
+        assert port_manager.is_port_available(8080)
+
+    def test_per_server_port_spaces(self, port_manager):
+        """Each server allocates from its own range and skips the host socket check."""
+        with patch.object(port_manager_module, "listening_ports", return_value={8080}):
+            assert port_manager.allocate_port("agent-1") == 8081
+            assert port_manager.allocate_port("agent-2", server_id="scout") == 8080
+
+        assert port_manager.get_port("agent-2") is None
+        assert port_manager.get_port("agent-2", server_id="scout") == 8080
+        assert port_manager.get_port_owner(8080, server_id="scout") == "agent-2"
+        assert port_manager.release_port("agent-2", server_id="scout") == 8080
+
+    def test_reserved_ports_apply_to_all_servers(self, port_manager):
+        """Reserving a port excludes it on existing and new server spaces."""
+        port_manager.allocate_port("agent-1", server_id="scout")
+        port_manager.add_reserved_port(8081)
+
+        assert not port_manager.is_port_available(8081, server_id="scout")
+        assert not port_manager.is_port_available(8081, server_id="scout2")
+
+    def test_load_metadata_per_server(self, temp_metadata_path):
+        """Persisted allocations are loaded into their server's space."""
+        metadata = {
+            "agents": {
+                "agent-1-main": {"port": 8080, "server_id": "main"},
+                "agent-2-scout": {"port": 8080, "server_id": "scout"},
+            }
+        }
+        temp_metadata_path.write_text(json.dumps(metadata))
+
+        pm = PortManager(8080, 8090, temp_metadata_path)
+
+        assert pm.get_port("agent-1") == 8080
+        assert pm.get_port("agent-2", server_id="scout") == 8080
+        assert pm.allocate_port("agent-3", server_id="scout") != 8080
+
+
+class TestListeningPorts:
+    """Test the /proc/net/tcp snapshot."""
+
+    def test_parses_listening_sockets(self, tmp_path):
+        """Only LISTEN entries are reported, from both IPv4 and IPv6 tables."""
+        header = "  sl  local_address rem_address   st tx_queue rx_queue\n"
+        tcp = tmp_path / "tcp"
+        tcp.write_text(
+            header
+            + "   0: 00000000:1F90 00000000:0000 0A 00000000:00000000\n"
+            + "   1: 0100007F:1F91 0100007F:C350 01 00000000:00000000\n"
+        )
+        tcp6 = tmp_path / "tcp6"
+        tcp6.write_text(
+            header + "   0: 00000000000000000000000000000000:1F92 "
+            "00000000000000000000000000000000:0000 0A 00000000:00000000\n"
+        )
+
+        assert listening_ports([tcp, tcp6]) == {8080, 8082}
+
+    def test_unreadable_tables(self, tmp_path):
+        """Missing tables yield None so callers fall back to probing."""
+        assert listening_ports([tmp_path / "missing"]) is None
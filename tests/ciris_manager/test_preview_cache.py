@@ -0,0 +1,181 @@
+"""
+Tests for the deployment preview cache.
+"""
+
+import json
+from unittest.mock import AsyncMock, Mock, patch
+
+import pytest
+
+from ciris_manager.deployment import DeploymentOrchestrator
+from ciris_manager.deployment.preview_cache import (
+    PreviewCache,
+    agent_fingerprint,
+    agent_key,
+    fleet_version,
+)
+from ciris_manager.models import AgentInfo, DeploymentStatus, UpdateNotification
+
+
+def _agent(
+    agent_id: str,
+    version: str = "1.0.0",
+    occurrence_id: str | None = None,
+    server_id: str = "main",
+) -> AgentInfo:
+    return AgentInfo(
+        agent_id=agent_id,
+        agent_name=agent_id.title(),
+        container_name=f"ciris-{agent_id}" + (f"-{occurrence_id}" if occurrence_id else ""),
+        api_port=8080,
+        status="running",
+        version=version,
+        occurrence_id=occurrence_id,
+        server_id=server_id,
+    )
+
+
+class FakeClock:
+    def __init__(self):
+        self.now = 1000.0
+
+    def __call__(self) -> float:
+        return self.now
+
+
+class TestPreviewCache:
+    """Test preview row and serialized preview caching."""
+
+    def test_fleet_version_tracks_agent_changes(self):
+        """The fleet version changes with any agent, independent of order."""
+        a, b = agent_fingerprint(_agent("a"), "general"), agent_fingerprint(_agent("b"), "general")
+        assert fleet_version([a, b]) == fleet_version([b, a])
+        assert fleet_version([a, b]) != fleet_version([a])
+
+        upgraded = agent_fingerprint(_agent("b", version="2.0.0"), "general")
+        assert fleet_version([a, b]) != fleet_version([a, upgraded])
+        regrouped = agent_fingerprint(_agent("b"), "explorer")
+        assert fleet_version([a, b]) != fleet_version([a, regrouped])
+
+    def test_rows_reused_until_state_changes_or_ttl(self):
+        """Rows are served while the fingerprint matches and the TTL has not passed."""
+        clock = FakeClock()
+        cache = PreviewCache(ttl_seconds=60, clock=clock)
+        fingerprint = agent_fingerprint(_agent("a"), "general")
+        cache.store_row("d1", fingerprint, {"agent_id": "a"})
+
+        assert cache.get_row("d1", fingerprint) == {"agent_id": "a"}
+        assert cache.get_row("d2", fingerprint) is None
+        assert cache.get_row("d1", agent_fingerprint(_agent("a", "2.0.0"), "general")) is None
+
+        clock.now += 60
+        assert cache.get_row("d1", fingerprint) is None
+
+    def test_serialized_preview_expires_with_oldest_row(self):
+        """A stored preview is served for its fleet version until its oldest row expires."""
+        clock = FakeClock()
+        cache = PreviewCache(ttl_seconds=60, clock=clock)
+        fingerprint = agent_fingerprint(_agent("a"), "general")
+        cache.store_row("d1", fingerprint, {"agent_id": "a"})
+        clock.now += 30
+
+        keys = [agent_key(_agent("a"))]
+        serialized = cache.store_preview("d1", "v1", keys, {"agent_details": []})
+        assert serialized == b'{"agent_details": []}'
+        assert cache.get_preview("d1", "v1") is serialized
+        assert cache.get_preview("d1", "v2") is None
+
+        clock.now += 30
+        assert cache.get_preview("d1", "v1") is None
+
+    def test_occurrences_have_separate_rows(self):
+        """Two occurrences of one agent_id on different servers never share a row."""
+        cache = PreviewCache()
+        first = agent_fingerprint(_agent("a", occurrence_id="001"), "general")
+        second = agent_fingerprint(_agent("a", occurrence_id="002", server_id="scout"), "general")
+        cache.store_row("d1", first, {"version": "1.0.0"})
+        cache.store_row("d1", second, {"version": "2.0.0"})
+
+        assert cache.get_row("d1", first) == {"version": "1.0.0"}
+        assert cache.get_row("d1", second) == {"version": "2.0.0"}
+        assert fleet_version([first, second]) != fleet_version([first])
+
+        # Pruning on store keeps both occurrences; invalidating the agent drops both
+        cache.store_preview("d1", "v1", [first[0], second[0]], {})
+        assert cache.get_row("d1", second) == {"version": "2.0.0"}
+        cache.invalidate_agent("a")
+        assert cache.get_row("d1", first) is None
+        assert cache.get_row("d1", second) is None
+
+    def test_invalidate_agent_and_retain(self):
+        """Invalidating an agent drops its rows and previews; retain drops stale deployments."""
+        cache = PreviewCache()
+        fingerprint = agent_fingerprint(_agent("a"), "general")
+        for deployment_id in ("d1", "d2"):
+            cache.store_row(deployment_id, fingerprint, {"agent_id": "a"})
+            cache.store_preview(deployment_id, "v1", [agent_key(_agent("a"))], {})
+            cache.store_shutdown_reasons(deployment_id, (True, False), {"reasons": {}})
+
+        cache.invalidate_agent("a")
+        assert cache.get_row("d1", fingerprint) is None
+        assert cache.get_preview("d1", "v1") is None
+        assert cache.get_shutdown_reasons("d1", (True, False)) == {"reasons": {}}
+
+        cache.retain(["d2"])
+        assert cache.get_shutdown_reasons("d1", (True, False)) is None
+        assert cache.get_shutdown_reasons("d2", (True, False)) == {"reasons": {}}
+
+
+class TestDeploymentPreviewOccurrences:
+    """Test that the orchestrator preview lists every occurrence of an agent."""
+
+    @pytest.mark.asyncio
+    async def test_preview_has_a_row_per_occurrence(self, tmp_path):
+        """Occurrences of one agent_id get their own rows, computed once each."""
+        orchestrator = DeploymentOrchestrator(manager=Mock())
+        orchestrator.pending_deployments["d1"] = DeploymentStatus(
+            deployment_id="d1",
+            notification=UpdateNotification(
+                agent_image="ghcr.io/cirisai/ciris-agent:v2.0", version="2.0.0"
+            ),
+            agents_total=2,
+            agents_updated=0,
+            agents_deferred=0,
+            agents_failed=0,
+            started_at=None,
+            staged_at="2026-01-01T00:00:00+00:00",
+            status="pending",
+            message="pending",
+            canary_phase=None,
+        )
+        fleet = [
+            _agent("a", "2.0.0", occurrence_id="001"),
+            _agent("a", "1.0.0", occurrence_id="002", server_id="scout"),
+        ]
+
+        async def detail(client, agent, notification, digest):
+            return {
+                "agent_id": agent.agent_id,
+                "occurrence_id": agent.occurrence_id,
+                "server_id": agent.server_id,
+                "needs_update": agent.version != notification.version,
+            }
+
+        orchestrator._preview_agent_detail = AsyncMock(side_effect=detail)
+        orchestrator._check_gui_needs_update = AsyncMock(return_value=False)
+        orchestrator._get_local_image_digest = AsyncMock(return_value=None)
+        orchestrator._get_agent_canary_group = Mock(return_value="general")
+
+        with patch("ciris_manager.docker_discovery.DockerAgentDiscovery") as discovery:
+            discovery.return_value.discover_agents.return_value = fleet
+            preview = json.loads(await orchestrator.get_deployment_preview_json("d1"))
+            # A second call is served entirely from the cache
+            again = json.loads(await orchestrator.get_deployment_preview_json("d1"))
+
+        rows = {(d["occurrence_id"], d["server_id"]): d for d in preview["agent_details"]}
+        assert preview["total_agents"] == 2
+        assert preview["agents_to_update"] == 1
+        assert rows[("002", "scout")]["needs_update"] is True
+        assert rows[("001", "main")]["needs_update"] is False
+        assert again == preview
+        assert orchestrator._preview_agent_detail.await_count == 2
@@ -0,0 +1,249 @@
+"""
+Tests for the privileged broker client and its use by the permission helper wrappers.
+"""
+
+import asyncio
+import tempfile
+from pathlib import Path
+from unittest.mock import AsyncMock, patch
+
+import pytest
+
+from ciris_manager.utils import permission_helper, privileged_broker
+from ciris_manager.utils.privileged_broker import (
+    BrokerError,
+    BrokerNoResponseError,
+    BrokerUnavailableError,
+    PrivilegedBrokerClient,
+)
+
+
+class FakeBroker:
+    """Minimal stand-in for `ciris-fix-permissions --serve`."""
+
+    def __init__(self, socket_path: Path):
+        self.socket_path = socket_path
+        self.requests: list[str] = []
+        self.connections = 0
+        self.delay = 0.0
+        self.server = None
+
+    async def start(self):
+        self.server = await asyncio.start_unix_server(self._handle, path=str(self.socket_path))
+
+    async def stop(self):
+        self.server.close()
+        await self.server.wait_closed()
+
+    async def _handle(self, reader, writer):
+        self.connections += 1
+        while line := await reader.readline():
+            request = line.decode().strip()
+            self.requests.append(request)
+            op, path, *_ = request.split(" ")
+            if path.endswith("/hangup"):
+                break
+            if op == "remove-tree":
+                await asyncio.sleep(self.delay)
+            if op == "swap-dir":
+                writer.write(f"OK {path}/.data.reap-1\n".encode())
+            elif path.startswith("/etc"):
+                writer.write(f"ERR {op} failed: Permission denied\n".encode())
+            else:
+                writer.write(b"OK \n")
+            await writer.drain()
+        writer.close()
+
+
+@pytest.fixture
+async def broker():
+    """Run a fake broker on a temporary socket."""
+    socket_dir = Path(tempfile.mkdtemp())
+    fake = FakeBroker(socket_dir / "privileged.sock")
+    await fake.start()
+    yield fake
+    await fake.stop()
+
+
+class TestPrivilegedBrokerClient:
+    """Test the broker wire protocol."""
+
+    @pytest.mark.asyncio
+    async def test_requests_share_one_connection(self, broker):
+        """Several requests reuse the persistent connection."""
+        client = PrivilegedBrokerClient(broker.socket_path)
+
+        tombstone = await client.request("swap-dir", Path("/opt/ciris/agents/a1"))
+        await client.request("fix-perms", Path("/opt/ciris/agents/a1"))
+        await client.request("chown-file", Path("/opt/ciris/agents/a1/x.yml"), "manager")
+        await client.close()
+
+        assert tombstone == "/opt/ciris/agents/a1/.data.reap-1"
+        assert broker.connections == 1
+        assert broker.requests[-1] == "chown-file /opt/ciris/agents/a1/x.yml manager"
+
+    @pytest.mark.asyncio
+    async def test_error_response_raises(self, broker):
+        """ERR responses surface as BrokerError with the broker's message."""
+        client = PrivilegedBrokerClient(broker.socket_path)
+
+        with pytest.raises(BrokerError, match="Permission denied"):
+            await client.request("fix-perms", Path("/etc/ciris"))
+        await client.close()
+
+    @pytest.mark.asyncio
+    async def test_missing_socket_is_unavailable(self, tmp_path):
+        """A missing broker raises BrokerUnavailableError so callers can fall back."""
+        client = PrivilegedBrokerClient(tmp_path / "nope.sock")
+
+        with pytest.raises(BrokerUnavailableError):
+            await client.request("fix-perms", Path("/opt/ciris/agents/a1"))
+
+    @pytest.mark.asyncio
+    async def test_reconnects_when_idle_connection_was_closed(self, broker):
+        """A broker restart between requests is handled by reconnecting before sending."""
+        client = PrivilegedBrokerClient(broker.socket_path)
+        await client.request("fix-perms", Path("/opt/ciris/agents/a1"))
+        client._idle[0][1].close()
+        await client.request("fix-perms", Path("/opt/ciris/agents/a1"))
+        await client.close()
+
+        assert broker.connections == 2
+        assert len(broker.requests) == 2
+
+    @pytest.mark.asyncio
+    async def test_long_request_does_not_block_others(self, broker):
+        """A slow remove-tree runs on its own connection while other requests proceed."""
+        client = PrivilegedBrokerClient(broker.socket_path)
+        broker.delay = 1.0
+
+        reap = asyncio.create_task(
+            client.request("remove-tree", Path("/opt/ciris/agents/a1/.data.reap-1"))
+        )
+        await asyncio.sleep(0.05)
+        await asyncio.wait_for(client.request("fix-perms", Path("/opt/ciris/agents/a2")), 0.5)
+        assert not reap.done()
+        await reap
+        await client.close()
+
+        assert broker.connections == 2
+
+    @pytest.mark.asyncio
+    async def test_delivered_request_is_never_resent(self, broker):
+        """Once a request is written, a hang-up or timeout is reported, not retried."""
+        client = PrivilegedBrokerClient(broker.socket_path, timeout=0.1)
+
+        with pytest.raises(BrokerNoResponseError):
+            await client.request("swap-dir", Path("/opt/ciris/agents/hangup"))
+        broker.delay = 1.0
+        with (
+            patch.dict(privileged_broker.OPERATION_TIMEOUTS, {"remove-tree": 0.1}),
+            pytest.raises(BrokerNoResponseError),
+        ):
+            await client.request("remove-tree", Path("/opt/ciris/agents/a1/.data.reap-1"))
+        await client.close()
+
+        assert broker.requests == [
+            "swap-dir /opt/ciris/agents/hangup",
+            "remove-tree /opt/ciris/agents/a1/.data.reap-1",
+        ]
+
+    def test_rejects_overlong_requests(self, tmp_path):
+        """Paths the broker would truncate are rejected before sending."""
+        client = PrivilegedBrokerClient(tmp_path / "nope.sock")
+
+        with pytest.raises(ValueError, match="too long"):
+            client._build_request("fix-perms", Path("/opt/ciris/agents/" + "a" * 1024), None)
+
+    def test_rejects_unknown_operations_and_whitespace(self, tmp_path):
+        """Requests are validated before anything is sent."""
+        client = PrivilegedBrokerClient(tmp_path / "nope.sock")
+
+        with pytest.raises(ValueError):
+            client._build_request("rm-rf", Path("/opt/ciris/agents/a1"), None)
+        with pytest.raises(ValueError):
+            client._build_request("fix-perms", Path("/opt/ciris/agents/a 1"), None)
+
+    @pytest.mark.asyncio
+    async def test_request_sync(self, broker):
+        """The blocking variant speaks the same protocol."""
+        client = PrivilegedBrokerClient(broker.socket_path)
+
+        result = await asyncio.to_thread(
+            client.request_sync, "swap-dir", Path("/opt/ciris/agents/a2")
+        )
+
+        assert result == "/opt/ciris/agents/a2/.data.reap-1"
+
+
+class TestPermissionHelperRouting:
+    """Test that privileged operations prefer the broker."""
+
+    @pytest.mark.asyncio
+    async def test_fix_permissions_uses_broker_before_helper(self, broker):
+        """With a broker running, the setuid helper is never executed."""
+        client = PrivilegedBrokerClient(broker.socket_path)
+        with (
+            patch.object(permission_helper, "get_privileged_broker", return_value=client),
+            patch.object(permission_helper, "_run_helper", AsyncMock()) as mock_helper,
+        ):
+            assert await permission_helper.fix_agent_permissions(Path("/opt/ciris/agents/a1"))
+        await client.close()
+
+        mock_helper.assert_not_called()
+        assert broker.requests == ["fix-perms /opt/ciris/agents/a1"]
+
+    @pytest.mark.asyncio
+    async def test_falls_back_to_helper_when_broker_down(self, tmp_path):
+        """An unreachable broker falls back to the setuid helper."""
+        client = PrivilegedBrokerClient(tmp_path / "gone.sock")
+        helper = tmp_path / "helper"
+        helper.write_text("")
+        with (
+            patch.object(permission_helper, "get_privileged_broker", return_value=client),
+            patch.object(permission_helper, "PERMISSION_HELPER_PATH", helper),
+            patch.object(
+                permission_helper, "_run_helper", AsyncMock(return_value=(0, "done", ""))
+            ) as mock_helper,
+        ):
+            assert await permission_helper.fix_agent_permissions(Path("/opt/ciris/agents/a1"))
+
+        mock_helper.assert_called_once_with("/opt/ciris/agents/a1")
+
+    @pytest.mark.asyncio
+    async def test_unanswered_request_does_not_fall_back(self, broker, tmp_path):
+        """A swap the broker received is not run again through the setuid helper."""
+        client = PrivilegedBrokerClient(broker.socket_path)
+        helper = tmp_path / "helper"
+        helper.write_text("")
+        with (
+            patch.object(permission_helper, "get_privileged_broker", return_value=client),
+            patch.object(permission_helper, "PERMISSION_HELPER_PATH", helper),
+            patch.object(permission_helper, "_run_helper", AsyncMock()) as mock_helper,
+        ):
+            assert not await permission_helper.remove_tree(Path("/opt/ciris/agents/hangup"))
+        await client.close()
+
+        mock_helper.assert_not_called()
+
+    @pytest.mark.asyncio
+    async def test_unanswered_swap_does_not_fall_back(self, broker, tmp_path):
+        """A swap the broker received is neither retried via the helper nor run locally."""
+        client = PrivilegedBrokerClient(broker.socket_path)
+        helper = tmp_path / "helper"
+        helper.write_text("")
+        agent_path = tmp_path / "hangup"
+        (agent_path / "data").mkdir(parents=True)
+        (agent_path / "data" / "memory.db").write_text("state")
+        with (
+            patch.object(permission_helper, "get_privileged_broker", return_value=client),
+            patch.object(permission_helper, "PERMISSION_HELPER_PATH", helper),
+            patch.object(permission_helper, "_run_helper", AsyncMock()) as mock_helper,
+        ):
+            with pytest.raises(RuntimeError, match="Privileged swap failed"):
+                await permission_helper.swap_data_directory(agent_path)
+        await client.close()
+
+        mock_helper.assert_not_called()
+        assert (agent_path / "data" / "memory.db").read_text() == "state"
+        assert [p.name for p in agent_path.iterdir()] == ["data"]
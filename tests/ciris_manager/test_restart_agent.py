@@ -3,7 +3,7 @@ Test agent restart functionality.
 """
 
 import pytest
-from unittest.mock import Mock, patch, MagicMock
+from unittest.mock import AsyncMock, Mock, patch, MagicMock
 from fastapi.testclient import TestClient
 
 from ciris_manager.api.routes import create_routes
@@ -35,6 +35,8 @@ class TestRestartAgent:
 
         manager.config = Mock()
         manager.docker_client = Mock()
+        manager.needs_recreate_for_live_config = Mock(return_value=False)
+        manager.recreate_agent_container = AsyncMock(return_value=True)
 
         # Mock get_server_config for multi-server support
         mock_server_config = Mock()
@@ -103,6 +105,28 @@ class TestRestartAgent:
             # Verify Docker restart was called
             mock_container.restart.assert_called_once_with(timeout=30)
 
+    def test_restart_recreates_after_live_config_push(self, client, mock_manager):
+        """Test that a container predating a live config push is recreated, not restarted."""
+        mock_manager.needs_recreate_for_live_config.return_value = True
+        with patch("ciris_manager.docker_discovery.DockerAgentDiscovery") as MockDiscovery:
+            mock_agent = Mock()
+            mock_agent.agent_id = "test-agent"
+            mock_agent.server_id = "main"
+            mock_agent.container_name = "ciris-agent-test-agent"
+            mock_agent.occurrence_id = None
+            MockDiscovery.return_value.discover_agents.return_value = [mock_agent]
+
+            mock_client = MagicMock()
+            mock_container = MagicMock()
+            mock_manager.docker_client.get_client.return_value = mock_client
+            mock_client.containers.get.return_value = mock_container
+
+            response = client.post("/manager/v1/agents/test-agent/restart")
+
+            assert response.status_code == 200
+            mock_manager.recreate_agent_container.assert_awaited_once()
+            mock_container.restart.assert_not_called()
+
     def test_restart_nonexistent_agent(self, client, mock_manager):
         """Test restarting a non-existent agent."""
         # Agent not in registry
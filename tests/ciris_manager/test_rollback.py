@@ -2,6 +2,8 @@
 Tests for rollback and image retention functionality.
 """
 
+import asyncio
+
 import pytest
 from unittest.mock import Mock, AsyncMock, patch, MagicMock
 from datetime import datetime, timezone
@@ -162,18 +164,28 @@ class TestRollbackProposal:
             }
         }
 
-        orchestrator.manager.agent_registry.get_agent.side_effect = [agent1, agent2]
+        # Agent 3 has a known tag, so its digest is pinned like the rollback would
+        agent3 = Mock(spec=AgentInfo, agent_id="agent-3")
+        agent3.metadata = {
+            "current_images": {"agent_tag": "ghcr.io/cirisai/ciris-agent:v1.4.0"},
+            "previous_images": {"n-1": "sha256:previous3"},
+        }
+
+        registry = {"agent-1": agent1, "agent-2": agent2, "agent-3": agent3}
+        orchestrator.manager.agent_registry.get_agent.side_effect = registry.get
 
-        agents = [
-            Mock(agent_id="agent-1"),
-            Mock(agent_id="agent-2"),
-        ]
+        agents = [Mock(agent_id=agent_id) for agent_id in ("agent-1", "agent-2", "agent-3", "gone")]
 
-        # Get previous versions
-        previous = await orchestrator._get_previous_versions(agents)
+        # Get previous versions through the same plan the rollback executes
+        with patch("ciris_manager.version_tracker.get_version_tracker") as tracker:
+            tracker.return_value.get_rollback_options = AsyncMock(return_value={})
+            previous = await orchestrator._get_previous_versions(agents)
 
         assert previous["agent-1"] == "sha256:previous1"
         assert previous["agent-2"] == "sha256:previous2"
+        assert previous["agent-3"] == "ghcr.io/cirisai/ciris-agent@sha256:previous3"
+        assert previous["gone"] == "unknown"
+        assert orchestrator.manager.agent_registry.get_agent.call_count == 4
 
 
 class TestImageVersionRotation:
@@ -309,7 +321,7 @@ class TestRollbackExecution:
         # Set up agent with N-1 version
         test_agent = Mock()
         test_agent.agent_id = "agent-1"
-        test_agent.container_name = "ciris-agent-1"
+        test_agent.server_id = "main"
         test_agent.metadata = {
             "previous_images": {
                 "n-1": "ghcr.io/cirisai/ciris-agent:v1.3.0",
@@ -318,30 +330,110 @@ class TestRollbackExecution:
         }
 
         orchestrator.manager.agent_registry.get_agent.return_value = test_agent
-        orchestrator.manager.agent_registry.update_agent = Mock()
-
-        # Mock docker commands
-        with patch("asyncio.create_subprocess_exec", new_callable=AsyncMock) as mock_exec:
-            mock_process = AsyncMock()
-            mock_process.communicate.return_value = (b"", b"")
-            mock_exec.return_value = mock_process
-
-            await orchestrator._rollback_agents(deployment)
+        orchestrator._ensure_rollback_image = AsyncMock(return_value=True)
+        orchestrator._recreate_agent_container = AsyncMock(return_value=True)
 
-            # Verify docker commands
-            calls = mock_exec.call_args_list
+        await orchestrator._rollback_agents(deployment)
 
-            # Should stop container
-            assert any("stop" in str(call) for call in calls)
-            assert any("ciris-agent-1" in str(call) for call in calls)
-
-            # Should run with N-1 image
-            assert any("run" in str(call) for call in calls)
-            assert any("v1.3.0" in str(call) for call in calls)
+        # Container recreated on the N-1 image after the image was confirmed
+        orchestrator._ensure_rollback_image.assert_awaited_once_with(
+            "main", "ghcr.io/cirisai/ciris-agent:v1.3.0"
+        )
+        orchestrator._recreate_agent_container.assert_awaited_once_with(
+            "agent-1", "main", "ghcr.io/cirisai/ciris-agent:v1.3.0"
+        )
+        assert test_agent.metadata["current_images"]["agent"] == (
+            "ghcr.io/cirisai/ciris-agent:v1.3.0"
+        )
 
         # Check deployment status
         assert deployment.status == "rolled_back"
         assert deployment.completed_at is not None
+        assert any(e["type"] == "agent_rolled_back" for e in deployment.events)
+
+    @pytest.mark.asyncio
+    async def test_parallel_rollback_limits_per_server(self, orchestrator):
+        """Test that agents restart concurrently, limited per server."""
+        from ciris_manager.deployment.rollback import ROLLBACK_CONCURRENCY_PER_SERVER
+
+        agent_ids = [f"agent-{i}" for i in range(12)]
+        deployment = DeploymentStatus(
+            deployment_id="rollback-parallel",
+            notification=UpdateNotification(
+                agent_image="ghcr.io/cirisai/ciris-agent:v1.4.0",
+                strategy="canary",
+                message="Failed deployment",
+                metadata={"affected_agents": agent_ids},
+            ),
+            agents_total=12,
+            status="rolling_back",
+            message="Rolling back",
+        )
+
+        agents = {}
+        for i, agent_id in enumerate(agent_ids):
+            agent = Mock()
+            agent.agent_id = agent_id
+            agent.server_id = "main" if i % 2 else "scout"
+            agent.metadata = {
+                "previous_images": {"n-1": "sha256:abc"},
+                "current_images": {"agent_tag": "ghcr.io/cirisai/ciris-agent:v1.4.0"},
+            }
+            agents[agent_id] = agent
+        orchestrator.manager.agent_registry.get_agent.side_effect = agents.get
+        orchestrator._ensure_rollback_image = AsyncMock(return_value=True)
+
+        active = {"main": 0, "scout": 0}
+        peak = {"main": 0, "scout": 0}
+
+        async def recreate(agent_id, server_id, image):
+            active[server_id] += 1
+            peak[server_id] = max(peak[server_id], active[server_id])
+            await asyncio.sleep(0.01)
+            active[server_id] -= 1
+            return agent_id != "agent-3"
+
+        orchestrator._recreate_agent_container = recreate
+
+        await orchestrator._rollback_agents(deployment)
+
+        # Digest history is pinned to the agent's repository, one check per server
+        assert orchestrator._ensure_rollback_image.await_count == 2
+        orchestrator._ensure_rollback_image.assert_any_await(
+            "main", "ghcr.io/cirisai/ciris-agent@sha256:abc"
+        )
+        assert peak["main"] == peak["scout"] == ROLLBACK_CONCURRENCY_PER_SERVER
+        assert deployment.status == "rollback_failed"
+        assert deployment.message == "Rolled back 11 agents; failed: 1, skipped: 0"
+        assert deployment.agents_in_progress == {}
+        orchestrator.manager.agent_registry._save_metadata.assert_called_once()
+
+    @pytest.mark.asyncio
+    async def test_rollback_skips_agents_when_image_unavailable(self, orchestrator):
+        """Test that no container is touched when its rollback image is missing."""
+        deployment = DeploymentStatus(
+            deployment_id="rollback-missing",
+            notification=UpdateNotification(
+                agent_image="ghcr.io/cirisai/ciris-agent:v1.4.0",
+                strategy="canary",
+                message="Failed deployment",
+                metadata={"affected_agents": ["agent-1"]},
+            ),
+            agents_total=1,
+            status="rolling_back",
+            message="Rolling back",
+        )
+        test_agent = Mock()
+        test_agent.server_id = "main"
+        test_agent.metadata = {"previous_images": {"n-1": "ghcr.io/cirisai/ciris-agent:v1.3.0"}}
+        orchestrator.manager.agent_registry.get_agent.return_value = test_agent
+        orchestrator._ensure_rollback_image = AsyncMock(return_value=False)
+        orchestrator._recreate_agent_container = AsyncMock(return_value=True)
+
+        await orchestrator._rollback_agents(deployment)
+
+        orchestrator._recreate_agent_container.assert_not_awaited()
+        assert deployment.status == "rollback_failed"
 
     @pytest.mark.asyncio
     async def test_rollback_failure_handling(self, orchestrator):
@@ -0,0 +1,53 @@
+"""
+Tests for agent rollback planning.
+"""
+
+from unittest.mock import Mock
+
+from ciris_manager.deployment.rollback import (
+    build_rollback_plan,
+    pin_image,
+    resolve_rollback_image,
+)
+
+
+class TestRollbackPlan:
+    """Test rollback image resolution."""
+
+    def test_pin_image(self):
+        """Test that bare digests are pinned to the agent's repository."""
+        tag = "ghcr.io/cirisai/ciris-agent:v1.4.0"
+        assert pin_image("sha256:abc", tag) == "ghcr.io/cirisai/ciris-agent@sha256:abc"
+        assert pin_image("sha256:abc", "registry:5000/agent") == "registry:5000/agent@sha256:abc"
+        assert pin_image("sha256:abc", None) == "sha256:abc"
+        assert pin_image("ghcr.io/cirisai/ciris-agent:v1.3.0", tag) == (
+            "ghcr.io/cirisai/ciris-agent:v1.3.0"
+        )
+
+    def test_metadata_wins_over_tracker(self):
+        """Test that per-agent history is preferred to fleet history."""
+        tracker = {"n_minus_1": {"image": "ghcr.io/cirisai/ciris-agent:v1.2.0"}}
+        metadata = {"previous_images": {"n-1": "ghcr.io/cirisai/ciris-agent:v1.3.0"}}
+
+        assert resolve_rollback_image(metadata, "n-1", tracker).endswith("v1.3.0")
+        assert resolve_rollback_image({}, "n-1", tracker).endswith("v1.2.0")
+        assert resolve_rollback_image({}, "n-2", tracker) is None
+        assert resolve_rollback_image({}, "custom:tag", tracker) == "custom:tag"
+
+    def test_build_plan(self):
+        """Test that unknown agents and missing versions are skipped with a reason."""
+        known = Mock(server_id="scout", metadata={"previous_images": {"n-1": "agent:v1"}})
+        no_history = Mock(server_id="main", metadata={})
+
+        plan = build_rollback_plan(
+            [("known", known), ("gone", None), ("new", no_history)],
+            "n-1",
+            {"new": "n-2"},
+            {},
+        )
+
+        assert [(a.agent_id, a.server_id, a.image) for a in plan.agents] == [
+            ("known", "scout", "agent:v1")
+        ]
+        assert plan.skipped == {"gone": "not registered", "new": "no n-2 version available"}
+        assert plan.server_images() == {("scout", "agent:v1")}
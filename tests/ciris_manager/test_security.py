@@ -8,7 +8,7 @@ import pytest
 import os
 from unittest.mock import Mock, patch
 from ciris_manager.agent_auth import AgentAuth
-from ciris_manager.crypto import TokenEncryption
+from ciris_manager.crypto import DecryptedTokenCache, TokenEncryption
 from ciris_manager.api.routes import create_routes
 
 
@@ -106,6 +106,59 @@ class TestEncryptionSecurity:
         assert encryption.decrypt_token(encrypted1) == token
         assert encryption.decrypt_token(encrypted2) == token
 
+    def test_key_derivation_runs_once(self):
+        """Instances sharing a secret and salt reuse the derived cipher."""
+        os.environ.pop("CIRIS_ENCRYPTION_KEY", None)
+        os.environ["MANAGER_JWT_SECRET"] = "test-secret-key-for-testing-only"
+        os.environ["CIRIS_ENCRYPTION_SALT"] = "test-salt-sixteen-chars"
+
+        first = TokenEncryption()
+        with patch("ciris_manager.crypto.PBKDF2HMAC") as mock_kdf:
+            second = TokenEncryption()
+
+        mock_kdf.assert_not_called()
+        assert second.cipher is first.cipher
+
+    def test_decryption_is_cached(self):
+        """Repeated decryption of the same ciphertext is served from the cache."""
+        os.environ["MANAGER_JWT_SECRET"] = "test-secret-key-for-testing-only"
+        os.environ["CIRIS_ENCRYPTION_SALT"] = "test-salt-sixteen-chars"
+        encryption = TokenEncryption()
+        encrypted = encryption.encrypt_token("cached-token")
+
+        assert encryption.decrypt_token(encrypted) == "cached-token"
+        with patch.object(encryption, "cipher") as mock_cipher:
+            assert encryption.decrypt_token(encrypted) == "cached-token"
+        mock_cipher.decrypt.assert_not_called()
+
+
+class TestDecryptedTokenCache:
+    """Test the bounded decrypted-token cache."""
+
+    def test_evicts_least_recently_used_and_zeroizes(self):
+        """Evicted plaintexts are overwritten before being dropped."""
+        cache = DecryptedTokenCache(max_entries=2)
+        cache.put("cipher-a", "token-a")
+        evicted_buffer = cache._entries[cache._key("cipher-a")]
+        cache.put("cipher-b", "token-b")
+        cache.put("cipher-c", "token-c")
+
+        assert len(cache) == 2
+        assert cache.get("cipher-a") is None
+        assert cache.get("cipher-c") == "token-c"
+        assert evicted_buffer == bytearray(len("token-a"))
+
+    def test_clear_zeroizes_everything(self):
+        """Clearing leaves no plaintext behind."""
+        cache = DecryptedTokenCache()
+        cache.put("cipher-a", "token-a")
+        buffer = cache._entries[cache._key("cipher-a")]
+
+        cache.clear()
+
+        assert len(cache) == 0
+        assert not any(buffer)
+
 
 class TestInputValidation:
     """Test input validation for security."""
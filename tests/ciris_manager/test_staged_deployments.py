@@ -273,7 +273,9 @@ class TestStagedDeploymentAPI:
         assert len(result["deployments"]) == 2
         assert result["deployments"][0]["status"] == "completed"
         assert result["deployments"][1]["status"] == "failed"
-        mock_orchestrator.get_deployment_history.assert_called_once_with(10)
+        mock_orchestrator.get_deployment_history.assert_called_once_with(
+            10, offset=0, status=None, agent_id=None, since=None, until=None
+        )
 
 
 class TestDeploymentOrchestratorStaging:
@@ -0,0 +1,291 @@
+"""
+Tests for the startup snapshot and fast manager startup.
+"""
+
+import json
+import os
+import time
+from pathlib import Path
+from unittest.mock import AsyncMock, Mock, patch
+
+import pytest
+
+from ciris_manager.agent_registry import AgentRegistry
+from ciris_manager.config.settings import (
+    CIRISManagerConfig,
+    ManagerConfig,
+    NginxConfig,
+    PortConfig,
+    ServerConfig,
+)
+from ciris_manager.deployment import DeploymentOrchestrator
+from ciris_manager.deployment.state import DeploymentState
+from ciris_manager.docker_discovery import (
+    DockerAgentDiscovery,
+    get_cached_discovery,
+    invalidate_discovery_cache,
+    seed_discovery_cache,
+)
+from ciris_manager.manager import CIRISManager
+from ciris_manager.models import AgentInfo
+from ciris_manager.port_manager import PortManager
+from ciris_manager.startup_snapshot import StartupProgress, StartupSnapshot
+
+
+def _touch(path: Path, content: str) -> None:
+    path.write_text(content)
+    # Make sure a rewrite is visible even on coarse-mtime filesystems
+    st = path.stat()
+    os.utime(path, ns=(st.st_atime_ns, st.st_mtime_ns + 1_000_000))
+
+
+class TestStartupSnapshot:
+    """Test the snapshot file format and validation."""
+
+    def test_round_trip_and_source_validation(self, tmp_path):
+        """Sections survive a save/load and go stale when their source changes."""
+        source = tmp_path / "metadata.json"
+        source.write_text("{}")
+        snapshot = StartupSnapshot()
+        assert snapshot.capture("registry", source, lambda: {"scout": {"port": 8081}})
+        snapshot.add("discovery", [{"agent_id": "scout"}])
+        snapshot.save(tmp_path / "snap")
+
+        loaded = StartupSnapshot.load(tmp_path / "snap")
+        assert loaded.section("registry", source) == {"scout": {"port": 8081}}
+        assert loaded.section("discovery", max_age=60) == [{"agent_id": "scout"}]
+
+        _touch(source, '{"agents": {}}')
+        assert loaded.section("registry", source) is None
+
+    def test_corrupt_snapshot_is_ignored(self, tmp_path):
+        """A flipped byte or foreign file falls back to a cold start."""
+        path = tmp_path / "snap"
+        StartupSnapshot(sections={"a": {"source": None, "data": 1}}).save(path)
+        blob = bytearray(path.read_bytes())
+        blob[-1] ^= 0xFF
+        path.write_bytes(bytes(blob))
+        assert StartupSnapshot.load(path) is None
+
+        path.write_bytes(b"not a snapshot at all, just some bytes of text data")
+        assert StartupSnapshot.load(path) is None
+        assert StartupSnapshot.load(tmp_path / "missing") is None
+
+    def test_capture_skips_source_changed_while_capturing(self, tmp_path):
+        """State captured while its file was rewritten is not trusted."""
+        source = tmp_path / "state.json"
+        source.write_text("{}")
+        snapshot = StartupSnapshot()
+
+        def produce():
+            _touch(source, '{"changed": true}')
+            return {}
+
+        assert not snapshot.capture("deployments", source, produce)
+        assert "deployments" not in snapshot.sections
+
+    def test_sections_age_out(self):
+        """Sections without a source file expire by snapshot age."""
+        snapshot = StartupSnapshot(
+            sections={"discovery": {"source": None, "data": []}}, created_at=time.time() - 3600
+        )
+        assert snapshot.section("discovery", max_age=600) is None
+
+    def test_progress_reporting(self):
+        """Progress reports step status, counts and failures."""
+        progress = StartupProgress(mode="fast", sections=["registry"])
+        assert progress.to_dict()["reconciliation"] == "pending"
+        progress.begin(["agent_directories", "nginx"])
+        progress.start_step("agent_directories")
+        progress.finish_step("agent_directories")
+        progress.start_step("nginx")
+
+        report = progress.to_dict()
+        assert report["steps_done"] == 1 and report["steps_total"] == 2
+        assert report["steps"][1]["status"] == "running"
+
+        progress.finish_step("nginx", error="reload failed")
+        progress.finish()
+        assert progress.to_dict()["reconciliation"] == "failed"
+        assert StartupProgress().to_dict()["reconciliation"] == "complete"
+
+
+class TestComponentRestore:
+    """Test registry, port and deployment state restored from snapshot sections."""
+
+    def test_registry_entries_round_trip(self, tmp_path):
+        """Exported entries rebuild the same registry without reading metadata.json."""
+        registry = AgentRegistry(tmp_path / "metadata.json")
+        registry.register_agent("scout", "Scout", 8081, "scout", "/a/scout.yml")
+        registry.register_agent(
+            "sage", "Sage", 8082, "sage", "/a/sage.yml", server_id="scout", occurrence_id="002"
+        )
+
+        with patch.object(AgentRegistry, "_load_metadata") as load:
+            restored = AgentRegistry(tmp_path / "metadata.json", entries=registry.export_entries())
+        load.assert_not_called()
+
+        assert set(restored.agents) == set(registry.agents)
+        sage = restored.get_agent("sage", occurrence_id="002", server_id="scout")
+        assert sage.port == 8082 and sage.server_id == "scout"
+
+    def test_port_allocations_round_trip(self, tmp_path):
+        """Allocations per server are restored without reading metadata."""
+        ports = PortManager(8080, 8090)
+        ports.allocate_port("scout", "main")
+        ports.allocate_port("sage", "remote")
+
+        restored = PortManager(8080, 8090, allocations=ports.export_allocations())
+
+        assert restored.get_port("scout", "main") == ports.get_port("scout", "main")
+        assert restored.get_port("sage", "remote") == ports.get_port("sage", "remote")
+        assert not restored.is_port_available(ports.get_port("scout", "main"), "main")
+
+    def test_orchestrator_loads_deployments_from_snapshot(self, tmp_path):
+        """Deployment state comes from the snapshot while the state file is unchanged."""
+        orchestrator = DeploymentOrchestrator(manager=Mock())
+        orchestrator._state_manager = DeploymentState(tmp_path)
+        orchestrator.deployment_state_file = orchestrator._state_manager.deployment_state_file
+        orchestrator.deployment_state_file.write_text(json.dumps({"deployments": {}}))
+        state = {
+            "deployments": {
+                "d1": {
+                    "deployment_id": "d1",
+                    "agents_total": 1,
+                    "started_at": "2026-10-01T00:00:00+00:00",
+                    "status": "completed",
+                    "message": "from snapshot",
+                }
+            },
+            "pending_deployments": {},
+            "current_deployment": None,
+        }
+        snapshot = StartupSnapshot()
+        snapshot.capture("deployments", orchestrator.deployment_state_file, lambda: state)
+        orchestrator.manager.startup_snapshot = snapshot
+        orchestrator.deployments = {}
+
+        orchestrator._load_state()
+
+        assert orchestrator.deployments["d1"].message == "from snapshot"
+        assert orchestrator.export_state()["deployments"]["d1"]["message"] == "from snapshot"
+
+
+class TestFastStartup:
+    """Test CIRISManager startup from a snapshot."""
+
+    @pytest.fixture(autouse=True)
+    def clean_discovery_cache(self):
+        """Keep the module-level discovery cache isolated."""
+        invalidate_discovery_cache()
+        yield
+        invalidate_discovery_cache()
+
+    @pytest.fixture
+    def config(self, tmp_path):
+        """Fast-startup configuration with one registered agent on disk."""
+        agents_dir = tmp_path / "agents"
+        (agents_dir / "scout").mkdir(parents=True)
+        (agents_dir / "scout" / "docker-compose.yml").write_text("services: {}\n")
+        metadata = {
+            "agents": {
+                "scout": {
+                    "name": "Scout",
+                    "port": 8081,
+                    "template": "scout",
+                    "compose_file": str(agents_dir / "scout" / "docker-compose.yml"),
+                }
+            }
+        }
+        (agents_dir / "metadata.json").write_text(json.dumps(metadata))
+        (tmp_path / "nginx").mkdir()
+        return CIRISManagerConfig(
+            manager=ManagerConfig(
+                agents_directory=str(agents_dir),
+                manifest_path=str(tmp_path / "manifest.json"),
+                fast_startup=True,
+            ),
+            ports=PortConfig(start=8080, end=8090, reserved=[8888]),
+            nginx=NginxConfig(config_dir=str(tmp_path / "nginx"), container_name="test-nginx"),
+            servers=[ServerConfig(server_id="main", hostname="agents.ciris.ai", is_local=True)],
+        )
+
+    def _create_manager(self, config):
+        docker_client = Mock()
+        docker_client.test_connection = Mock(return_value=True)
+        with patch("ciris_manager.manager.MultiServerDockerClient", return_value=docker_client):
+            with patch("ciris_manager.manager.NginxManager"):
+                with patch("ciris_manager.manager.DockerImageCleanup"):
+                    return CIRISManager(config)
+
+    def test_first_start_without_snapshot_defers_reconciliation(self, config):
+        """Without a snapshot, state is read from disk but Docker work is deferred."""
+        manager = self._create_manager(config)
+
+        assert manager.agent_registry.get_agent("scout").port == 8081
+        manager.docker_client.test_connection.assert_not_called()
+        status = manager.startup_progress.to_dict()
+        assert status["mode"] == "fast"
+        assert status["snapshot_sections"] == []
+        assert status["reconciliation"] == "pending"
+
+    @pytest.mark.asyncio
+    async def test_restart_serves_from_snapshot_then_reconciles(self, config):
+        """A restart restores registry, ports and discovery from the snapshot."""
+        first = self._create_manager(config)
+        seed_discovery_cache(
+            [AgentInfo(agent_id="scout", agent_name="Scout", container_name="ciris-scout")]
+        )
+        assert first.save_startup_snapshot()
+        invalidate_discovery_cache()
+
+        with patch.object(AgentRegistry, "_load_metadata") as load:
+            manager = self._create_manager(config)
+        load.assert_not_called()
+        assert manager.agent_registry.get_agent("scout").port == 8081
+        assert manager.port_manager.get_port("scout", "main") == 8081
+        assert [a.agent_id for a in get_cached_discovery()] == ["scout"]
+        assert manager.startup_progress.sections == ["registry", "ports", "discovery"]
+
+        manager.update_nginx_config = AsyncMock(return_value=True)
+        with patch("ciris_manager.docker_discovery.DockerAgentDiscovery") as discovery:
+            await manager._reconcile_startup()
+
+        discovery.return_value.discover_agents.assert_called_once_with(force_refresh=True)
+        manager.docker_client.test_connection.assert_called_once_with("main")
+        report = manager.get_status()["startup"]
+        assert report["reconciliation"] == "complete"
+        assert [s["status"] for s in report["steps"]] == ["done"] * 4
+        assert manager.startup_snapshot is None
+
+    def test_seeded_discovery_keeps_snapshot_age(self, config):
+        """Snapshot discovery is as old as the snapshot, so it is refreshed, not trusted."""
+        first = self._create_manager(config)
+        seed_discovery_cache(
+            [AgentInfo(agent_id="scout", agent_name="Scout", container_name="ciris-scout")]
+        )
+        assert first.save_startup_snapshot()
+        invalidate_discovery_cache()
+        snapshot_path = first.startup_snapshot_path
+        snapshot = StartupSnapshot.load(snapshot_path)
+        snapshot.created_at -= 120
+        snapshot.save(snapshot_path)
+
+        self._create_manager(config)
+
+        assert [a.agent_id for a in get_cached_discovery()] == ["scout"]
+        discovery = DockerAgentDiscovery(docker_client_manager=Mock())
+        with patch.object(discovery, "_discover_multi_server", return_value=[]) as live:
+            assert discovery.discover_agents() == []
+        live.assert_called_once()
+
+    def test_stale_snapshot_falls_back_to_metadata(self, config):
+        """Agents registered after the snapshot was taken are not lost."""
+        first = self._create_manager(config)
+        first.save_startup_snapshot()
+        first.agent_registry.register_agent("sage", "Sage", 8082, "sage", "/a/sage.yml")
+
+        manager = self._create_manager(config)
+
+        assert manager.agent_registry.get_agent("sage") is not None
+        assert manager.startup_progress.sections == []
@@ -5,8 +5,11 @@ Unit tests for TemplateVerifier.
 import pytest
 import tempfile
 import json
+import os
 import base64
+import hashlib
 from pathlib import Path
+from unittest.mock import patch
 from nacl.signing import SigningKey
 from ciris_manager.template_verifier import TemplateVerifier
 import asyncio
@@ -228,3 +231,56 @@ settings:
         verifier = TemplateVerifier(temp_manifest_path)
         assert verifier.manifest is None
         assert not asyncio.run(verifier.is_pre_approved("any", Path("/any")))
+
+    def test_checksum_cached_until_file_changes(self, temp_manifest_path, temp_template_path):
+        """An unchanged template is not re-read; an edit invalidates the cache."""
+        verifier = TemplateVerifier(temp_manifest_path)
+
+        first = asyncio.run(verifier.calculate_template_checksum(temp_template_path))
+        with patch("ciris_manager.template_verifier._sha256_file") as mock_hash:
+            assert asyncio.run(verifier.calculate_template_checksum(temp_template_path)) == first
+            mock_hash.assert_not_called()
+
+        with open(temp_template_path, "a") as f:
+            f.write("\n# Modified!\n")
+        second = asyncio.run(verifier.calculate_template_checksum(temp_template_path))
+
+        assert second != first
+        assert second == hashlib.sha256(temp_template_path.read_bytes()).hexdigest()
+
+    def test_same_size_edit_with_restored_mtime_is_detected(
+        self, temp_manifest_path, temp_template_path
+    ):
+        """Restoring the mtime after a same-size edit does not serve the cached checksum."""
+        verifier = TemplateVerifier(temp_manifest_path)
+        first = asyncio.run(verifier.calculate_template_checksum(temp_template_path))
+        st = temp_template_path.stat()
+
+        content = temp_template_path.read_bytes()
+        temp_template_path.write_bytes(content[:-1] + (b"X" if content[-1:] != b"X" else b"Y"))
+        os.utime(temp_template_path, ns=(st.st_atime_ns, st.st_mtime_ns))
+        second = asyncio.run(verifier.calculate_template_checksum(temp_template_path))
+
+        assert second != first
+        assert second == hashlib.sha256(temp_template_path.read_bytes()).hexdigest()
+
+    def test_large_template_checksum(self, temp_manifest_path, tmp_path):
+        """Large files are hashed through mmap with the same result."""
+        large = tmp_path / "large.yaml"
+        large.write_bytes(b"x" * (3 * 1024 * 1024 + 17))
+        verifier = TemplateVerifier(temp_manifest_path)
+
+        checksum = asyncio.run(verifier.calculate_template_checksum(large))
+        assert checksum == hashlib.sha256(large.read_bytes()).hexdigest()
+
+    def test_prewarm(self, temp_manifest_path, tmp_path):
+        """Prewarming hashes every template so later checks hit the cache."""
+        for name in ("scout", "sage", "echo"):
+            (tmp_path / f"{name}.yaml").write_text(f"name: {name}\n")
+        verifier = TemplateVerifier(temp_manifest_path)
+
+        assert asyncio.run(verifier.prewarm(tmp_path)) == 3
+        with patch("ciris_manager.template_verifier._sha256_file") as mock_hash:
+            asyncio.run(verifier.calculate_template_checksum(tmp_path / "sage.yaml"))
+            mock_hash.assert_not_called()
+        assert asyncio.run(verifier.prewarm(tmp_path / "missing")) == 0
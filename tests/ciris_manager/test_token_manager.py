@@ -2,6 +2,7 @@
 Tests for service token management.
 """
 
+import asyncio
 import json
 from unittest.mock import AsyncMock, Mock, patch
 import pytest
@@ -44,7 +45,7 @@ def mock_registry():
     )
 
     registry.list_agents.return_value = [agent1, agent2, agent3]
-    registry.get_agent.side_effect = lambda aid: {
+    registry.get_agent.side_effect = lambda aid, *args, **kwargs: {
         "test-agent-1": agent1,
         "test-agent-2": agent2,
         "test-agent-3": agent3,
@@ -94,13 +95,13 @@ async def test_verify_token_success(token_manager):
         mock_auth.get_auth_headers.return_value = {"Authorization": "Bearer token"}
         mock_get_auth.return_value = mock_auth
 
-        with patch("ciris_manager.token_manager.AsyncClient") as mock_client:
+        with patch("httpx.AsyncClient") as mock_client:
             mock_response = Mock()
             mock_response.status_code = 200
 
             mock_client_instance = AsyncMock()
             mock_client_instance.get = AsyncMock(return_value=mock_response)
-            mock_client.return_value.__aenter__.return_value = mock_client_instance
+            mock_client.return_value = mock_client_instance
 
             success, message = await token_manager.verify_token("test-agent-1")
 
@@ -116,13 +117,13 @@ async def test_verify_token_unauthorized(token_manager):
         mock_auth.get_auth_headers.return_value = {"Authorization": "Bearer bad_token"}
         mock_get_auth.return_value = mock_auth
 
-        with patch("ciris_manager.token_manager.AsyncClient") as mock_client:
+        with patch("httpx.AsyncClient") as mock_client:
             mock_response = Mock()
             mock_response.status_code = 401
 
             mock_client_instance = AsyncMock()
             mock_client_instance.get = AsyncMock(return_value=mock_response)
-            mock_client.return_value.__aenter__.return_value = mock_client_instance
+            mock_client.return_value = mock_client_instance
 
             success, message = await token_manager.verify_token("test-agent-1")
 
@@ -240,9 +241,9 @@ async def test_rotate_all_tokens_immediate(token_manager, mock_registry):
         results = await token_manager.rotate_all_tokens(strategy="immediate")
 
         assert len(results) == 3
-        assert results["test-agent-1"].success is True
-        assert results["test-agent-2"].success is True
-        assert results["test-agent-3"].success is False
+        assert results[("test-agent-1", None, "main")].success is True
+        assert results[("test-agent-2", None, "main")].success is True
+        assert results[("test-agent-3", None, "main")].success is False
 
         # All agents should be rotated with immediate strategy
         assert mock_regen.call_count == 3
@@ -271,6 +272,213 @@ async def test_rotate_all_tokens_canary(token_manager, mock_registry):
             assert all(r.success for r in results.values())
 
 
+def _rotated(agent_id, success=True):
+    return TokenRotationResult(agent_id, success, True, True, success, success)
+
+
+def _fleet(count, servers=("main",), groups=None):
+    """Build registered agents spread over servers, optionally with canary groups."""
+    groups = groups or {}
+    return [
+        RegisteredAgent(
+            agent_id=f"agent-{i}",
+            name=f"Agent {i}",
+            port=8000 + i,
+            template="scout",
+            compose_file=f"/opt/ciris/agents/agent-{i}/docker-compose.yml",
+            server_id=servers[i % len(servers)],
+            metadata={"canary_group": groups[i]} if i in groups else None,
+        )
+        for i in range(count)
+    ]
+
+
+@pytest.mark.asyncio
+async def test_rotation_concurrency_is_per_server(token_manager, mock_registry):
+    """Restarts overlap across servers but never exceed the per-server limit."""
+    mock_registry.list_agents.return_value = _fleet(8, servers=("main", "scout"))
+    active = {"main": 0, "scout": 0}
+    peak = {"main": 0, "scout": 0}
+
+    async def regenerate(agent_id, server_id=None, occurrence_id=None):
+        server = "main" if int(agent_id.split("-")[1]) % 2 == 0 else "scout"
+        active[server] += 1
+        peak[server] = max(peak[server], active[server])
+        await asyncio.sleep(0.01)
+        active[server] -= 1
+        return _rotated(agent_id)
+
+    with patch.object(token_manager, "regenerate_token", side_effect=regenerate):
+        results = await token_manager.rotate_all_tokens(per_server_concurrency=2)
+
+    assert len(results) == 8
+    assert peak == {"main": 2, "scout": 2}
+    assert not token_manager.rotation_checkpoint_path.exists()
+
+
+@pytest.mark.asyncio
+async def test_canary_rotation_follows_canary_groups(token_manager, mock_registry):
+    """Explorers rotate first and a failed health gate stops later waves."""
+    mock_registry.list_agents.return_value = _fleet(
+        4, groups={2: "explorer", 3: "early_adopter"}
+    )
+    token_manager.WAVE_SETTLE_SECONDS = 0
+
+    with (
+        patch.object(
+            token_manager, "regenerate_token", side_effect=lambda aid, **kw: _rotated(aid)
+        ) as mock_regen,
+        patch.object(
+            token_manager, "verify_token", new_callable=AsyncMock, return_value=(False, "401")
+        ),
+    ):
+        results = await token_manager.rotate_all_tokens(strategy="canary")
+
+    assert list(results) == [("agent-2", None, "main")]
+    mock_regen.assert_called_once_with("agent-2", server_id="main", occurrence_id=None)
+
+
+@pytest.mark.asyncio
+async def test_interrupted_rotation_resumes(token_manager, mock_registry):
+    """Agents rotated before a failure are skipped when the rotation is re-run."""
+    mock_registry.list_agents.return_value = _fleet(3)
+
+    first_run = {"agent-0": True, "agent-1": False, "agent-2": True}
+    with patch.object(
+        token_manager,
+        "regenerate_token",
+        side_effect=lambda aid, **kw: _rotated(aid, first_run[aid]),
+    ):
+        await token_manager.rotate_all_tokens(per_server_concurrency=1)
+
+    checkpoint = json.loads(token_manager.rotation_checkpoint_path.read_text())
+    assert checkpoint["completed"] == [["agent-0", None, "main"], ["agent-2", None, "main"]]
+
+    with patch.object(
+        token_manager, "regenerate_token", side_effect=lambda aid, **kw: _rotated(aid)
+    ) as mock_regen:
+        results = await token_manager.rotate_all_tokens(resume=True)
+
+    assert list(results) == [("agent-1", None, "main")]
+    mock_regen.assert_called_once_with("agent-1", server_id="main", occurrence_id=None)
+    assert not token_manager.rotation_checkpoint_path.exists()
+
+
+@pytest.mark.asyncio
+@pytest.mark.parametrize(
+    "checkpoint",
+    [
+        {"strategy": "immediate", "updated_at": "2020-01-01T00:00:00+00:00"},
+        {"strategy": "canary", "updated_at": None},
+    ],
+    ids=["stale", "other-strategy"],
+)
+async def test_rotation_ignores_stale_or_foreign_checkpoints(
+    token_manager, mock_registry, checkpoint
+):
+    """Old checkpoints and those from another strategy never exempt agents from rotation."""
+    from datetime import datetime, timezone
+
+    mock_registry.list_agents.return_value = _fleet(2)
+    checkpoint["completed"] = [["agent-0", None, "main"]]
+    checkpoint["updated_at"] = checkpoint["updated_at"] or datetime.now(timezone.utc).isoformat()
+    token_manager.rotation_checkpoint_path.write_text(json.dumps(checkpoint))
+
+    with patch.object(
+        token_manager, "regenerate_token", side_effect=lambda aid, **kw: _rotated(aid)
+    ):
+        results = await token_manager.rotate_all_tokens(resume=True)
+
+    assert sorted(key.agent_id for key in results) == ["agent-0", "agent-1"]
+
+
+@pytest.mark.asyncio
+async def test_rotation_tracks_each_occurrence(token_manager, mock_registry):
+    """Occurrences of one agent on several servers are rotated and checkpointed separately."""
+    occurrences = [
+        RegisteredAgent(
+            agent_id="scout",
+            name="Scout",
+            port=8001,
+            template="scout",
+            compose_file="/opt/ciris/agents/scout/docker-compose.yml",
+            occurrence_id=occurrence_id,
+            server_id=server_id,
+        )
+        for occurrence_id, server_id in [("lb_1", "main"), ("lb_2", "scout")]
+    ]
+    mock_registry.list_agents.return_value = occurrences
+
+    with patch.object(
+        token_manager,
+        "regenerate_token",
+        side_effect=lambda aid, **kw: _rotated(aid, kw["occurrence_id"] == "lb_1"),
+    ) as mock_regen:
+        results = await token_manager.rotate_all_tokens()
+
+    assert results[("scout", "lb_1", "main")].success
+    assert not results[("scout", "lb_2", "scout")].success
+    mock_regen.assert_any_call("scout", server_id="scout", occurrence_id="lb_2")
+    checkpoint = json.loads(token_manager.rotation_checkpoint_path.read_text())
+    assert checkpoint["completed"] == [["scout", "lb_1", "main"]]
+
+    with patch.object(
+        token_manager, "regenerate_token", side_effect=lambda aid, **kw: _rotated(aid)
+    ) as mock_regen:
+        results = await token_manager.rotate_all_tokens(resume=True)
+
+    assert list(results) == [("scout", "lb_2", "scout")]
+
+
+@pytest.mark.asyncio
+async def test_remote_agent_restarts_on_its_server(mock_registry, tmp_path):
+    """A remote agent's container is recreated through its own server's Docker client."""
+    agent = _fleet(2, servers=("main", "scout"))[1]
+    mock_registry.get_agent.side_effect = lambda aid, *args, **kwargs: agent
+    docker_manager = Mock()
+    docker_manager.get_server_config.return_value = Mock(is_local=False)
+    client = docker_manager.get_client.return_value
+    old = Mock()
+    old.name = "ciris-agent-1"
+    old.image.tags = ["ghcr.io/cirisai/ciris-agent:latest"]
+    healthcheck = {"Test": ["CMD", "curl", "-f", "http://localhost:8080/v1/system/health"]}
+    old.attrs = {
+        "Config": {
+            "Image": "ghcr.io/cirisai/ciris-agent:latest",
+            "Env": ["CIRIS_AGENT_ID=agent-1", "CIRIS_SERVICE_TOKEN=old"],
+            "Cmd": ["python", "main.py", "--template", "scout"],
+            "Entrypoint": ["/init_permissions.sh"],
+            "Healthcheck": healthcheck,
+        },
+        "HostConfig": {
+            "Binds": [],
+            "PortBindings": {},
+            "RestartPolicy": {},
+            "Memory": 2 * 1024**3,
+            "NanoCpus": 0,
+        },
+        "NetworkSettings": {"Networks": {"bridge": {}, "ciris-internal": {}}},
+    }
+    client.containers.list.return_value = [old]
+    manager = TokenManager(mock_registry, tmp_path, docker_manager)
+
+    assert await manager._restart_agent_with_token("agent-1", "new", server_id="scout")
+
+    docker_manager.get_client.assert_called_with("scout")
+    old.remove.assert_called_once()
+    create = client.containers.create.call_args.kwargs
+    assert create["environment"] == ["CIRIS_AGENT_ID=agent-1", "CIRIS_SERVICE_TOKEN=new"]
+    # The rest of the container's configuration is carried over
+    assert create["command"] == ["python", "main.py", "--template", "scout"]
+    assert create["entrypoint"] == ["/init_permissions.sh"]
+    assert create["healthcheck"] == healthcheck
+    assert create["mem_limit"] == 2 * 1024**3
+    assert "nano_cpus" not in create
+    assert create["network"] == "bridge"
+    client.networks.get.assert_called_once_with("ciris-internal")
+    client.containers.create.return_value.start.assert_called_once()
+
+
 def test_backup_metadata(token_manager, tmp_path):
     """Test backing up metadata."""
     # Create a mock metadata file
@@ -5,17 +5,30 @@ Tests that deployments correctly show which agents need updates
 and can handle scale with many agents.
 """
 
+import asyncio
+
 import pytest
 from datetime import datetime, timezone
 from unittest.mock import AsyncMock, MagicMock, patch
 
 from ciris_manager.deployment import DeploymentOrchestrator
+from ciris_manager.docker_discovery import invalidate_discovery_cache, seed_discovery_cache
 from ciris_manager.models import (
     UpdateNotification,
     DeploymentStatus,
     AgentInfo,
 )
 
+AGENT_HTTP_CLIENT = "ciris_manager.deployment.orchestrator.get_agent_http_client"
+
+
+@pytest.fixture(autouse=True)
+def clear_discovery_cache():
+    """Keep discovery results from other tests out of the preview."""
+    invalidate_discovery_cache()
+    yield
+    invalidate_discovery_cache()
+
 
 class TestDeploymentPreview:
     """Test deployment preview functionality."""
@@ -87,10 +100,10 @@ class TestDeploymentPreview:
                 }
 
                 # Mock agent health checks for versions
-                with patch("httpx.AsyncClient") as MockClient:
+                with patch(AGENT_HTTP_CLIENT) as MockClient:
                     mock_client = MockClient.return_value.__aenter__.return_value
 
-                    async def mock_get(url, headers):
+                    async def mock_get(url, headers, timeout=None):
                         response = MagicMock()
                         response.status_code = 200
 
@@ -214,10 +227,10 @@ class TestDeploymentPreview:
                 }
 
                 # Mock agent health checks - use fast timeout
-                with patch("httpx.AsyncClient") as MockClient:
+                with patch(AGENT_HTTP_CLIENT) as MockClient:
                     mock_client = MockClient.return_value.__aenter__.return_value
 
-                    async def mock_get(url, headers):
+                    async def mock_get(url, headers, timeout=None):
                         response = MagicMock()
                         # Simulate some agents being unreachable
                         port = int(url.split(":")[2].split("/")[0])
@@ -402,7 +415,7 @@ class TestDeploymentPreview:
                     "Authorization": "Bearer test"
                 }
 
-                with patch("httpx.AsyncClient") as MockClient:
+                with patch(AGENT_HTTP_CLIENT) as MockClient:
                     mock_client = MockClient.return_value.__aenter__.return_value
                     response = MagicMock()
                     response.status_code = 200
@@ -443,3 +456,102 @@ class TestDeploymentPreview:
         # Then general
         assert agent_details[5]["canary_group"] == "general"
         assert agent_details[6]["canary_group"] == "general"
+
+    @pytest.mark.asyncio
+    async def test_preview_recomputes_only_changed_agents(self, tmp_path):
+        """Repeat previews are served from cache; only changed agents are re-checked."""
+        orchestrator = DeploymentOrchestrator(tmp_path)
+        orchestrator.manager = MagicMock()
+        orchestrator.manager.agent_registry = MagicMock()
+
+        notification = UpdateNotification(
+            agent_image="ghcr.io/cirisai/ciris-agent:latest",
+            message="Test update",
+            version="2.0.0",
+        )
+        deployment_id = "test-preview-cache"
+        orchestrator.pending_deployments[deployment_id] = DeploymentStatus(
+            deployment_id=deployment_id,
+            notification=notification,
+            agents_total=3,
+            status="pending",
+            message="Test deployment",
+            staged_at=datetime.now(timezone.utc).isoformat(),
+        )
+
+        mock_agents = [
+            AgentInfo(
+                agent_id=f"agent{i}",
+                agent_name=f"Agent {i}",
+                container_name=f"ciris-agent{i}",
+                api_port=8001 + i,
+                status="running",
+                version="1.0.0",
+            )
+            for i in range(3)
+        ]
+        versions = {8001: "1.0.0", 8002: "1.0.0", 8003: "1.0.0"}
+        requested = []
+
+        async def mock_get(url, headers, timeout=None):
+            port = int(url.split(":")[2].split("/")[0])
+            requested.append(port)
+            response = MagicMock()
+            response.status_code = 200
+            response.json.return_value = {"data": {"version": versions[port]}}
+            return response
+
+        with patch("ciris_manager.docker_discovery.DockerAgentDiscovery") as MockDiscovery, patch(
+            "ciris_manager.agent_auth.get_agent_auth"
+        ), patch(AGENT_HTTP_CLIENT) as MockClient, patch.object(
+            orchestrator, "_get_container_image_digest", AsyncMock(return_value="sha256:old")
+        ), patch.object(
+            orchestrator, "_get_local_image_digest", AsyncMock(return_value="sha256:new")
+        ):
+            MockDiscovery.return_value.discover_agents.return_value = mock_agents
+            MockClient.return_value.__aenter__.return_value.get = mock_get
+
+            first = await orchestrator.get_deployment_preview_json(deployment_id)
+            assert len(requested) == 3
+
+            # Unchanged fleet: served pre-serialized without touching agents
+            assert await orchestrator.get_deployment_preview_json(deployment_id) is first
+            assert len(requested) == 3
+
+            # One agent moves to the new version: only it is re-checked
+            versions[8002] = "2.0.0"
+            mock_agents[1].version = "2.0.0"
+            preview = await orchestrator.get_deployment_preview(deployment_id)
+            assert requested[3:] == [8002]
+            assert preview["agents_to_update"] == 2
+            updated = next(d for d in preview["agent_details"] if d["agent_id"] == "agent1")
+            assert updated["needs_update"] is False
+            assert updated["current_version"] == "2.0.0"
+
+            # Recreating an agent drops its row even if discovery looks the same
+            orchestrator._preview_cache.invalidate_agent("agent0")
+            await orchestrator.get_deployment_preview(deployment_id)
+            assert requested[4:] == [8001]
+
+
+    @pytest.mark.asyncio
+    async def test_preview_discovery_stays_off_the_event_loop(self, tmp_path):
+        """A fresh discovery result is reused; otherwise discovery runs in a worker thread."""
+        orchestrator = DeploymentOrchestrator(tmp_path)
+        orchestrator.manager = MagicMock()
+        discovered = [
+            AgentInfo(agent_id="datum", agent_name="Datum", container_name="ciris-datum")
+        ]
+        cached = [AgentInfo(agent_id="sage", agent_name="Sage", container_name="ciris-sage")]
+
+        with patch("ciris_manager.docker_discovery.DockerAgentDiscovery") as MockDiscovery, patch(
+            "asyncio.to_thread", wraps=asyncio.to_thread
+        ) as to_thread:
+            MockDiscovery.return_value.discover_agents.return_value = discovered
+            assert await orchestrator._discover_preview_agents() == discovered
+            to_thread.assert_called_once()
+
+            seed_discovery_cache(cached, cache_key="local")
+            assert await orchestrator._discover_preview_agents() is cached
+
+        MockDiscovery.assert_called_once()